@@ -77,6 +77,8 @@ const conf_t conf_flash_default = {
         // Image settings
         .res = RES_VGA,
         .quality = 4,
+        .packet_budget = 0,
+        .preview = false,
         .buf_size = 50 * 1024,
         .redundantTx = false
     },
@@ -102,6 +104,8 @@ const conf_t conf_flash_default = {
         // Image settings
         .res = RES_QVGA,
         .quality = 4,
+        .packet_budget = 0,
+        .preview = false,
         .buf_size = 15 * 1024,
         .redundantTx = false
     },
@@ -147,6 +151,7 @@ const conf_t conf_flash_default = {
         },
         .aprs_msg = true, // Set true to enable messages to be accepted on RX call sign
         .digi = true,
+        .filter = false, // Set true to drop frames not for us or digipeat early
         .tx = {
            // Transmit radio configuration
            .radio_conf = {
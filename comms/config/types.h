@@ -133,6 +133,8 @@ typedef struct {
   char              path[16];
   resolution_t      res;					// Picture resolution
   uint8_t           quality;				// SSDV Quality ranging from 0-7
+  uint16_t          packet_budget;          // SSDV packets per image, quality and resolution are adapted (0: fixed)
+  bool              preview;                // Send a DC only SSDV preview ahead of each image, taken from packet_budget
   bool              flip;                   // 180 image rotation
   uint32_t          buf_size;		    	// SRAM buffer size for the picture
 } img_app_conf_t;
@@ -176,6 +178,7 @@ typedef struct {
   thd_rx_conf_t     rx;
   bool              aprs_msg;
   bool              digi;
+  bool              filter;                 // Drop frames of no interest early in RX
   bcn_app_conf_t    tx;
 } thd_aprs_conf_t;
 
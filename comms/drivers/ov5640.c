@@ -1327,6 +1327,23 @@ void OV5640_SetResolution(resolution_t res)
 	}
 }
 
+/**
+  * Size of the JPEG image output for a resolution (0x3808-0x380b in the
+  * register tables). Returns 0x0 if the size is not known.
+  */
+void OV5640_getResolutionSize(resolution_t res, uint16_t *width, uint16_t *height)
+{
+	switch(res) {
+		case RES_QQVGA:	*width = 160;	*height = 112;	break;
+		case RES_VGA:	*width = 640;	*height = 480;	break;
+		case RES_XGA:	*width = 1024;	*height = 768;	break;
+		case RES_UXGA:
+		case RES_MAX:	*width = 1600;	*height = 1200;	break; // Snapshot uses UXGA for RES_MAX
+		case RES_NONE:	*width = 0;		*height = 0;	break; // Last configuration is kept
+		default:		*width = 320;	*height = 240;	break; // Default QVGA
+	}
+}
+
 void OV5640_powerup(void) {
   // Configure pins
     OV5640_InitGPIO();
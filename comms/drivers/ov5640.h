@@ -36,6 +36,7 @@ uint32_t    OV5640_Capture(uint8_t* buffer, uint32_t size);
 void        OV5640_InitGPIO(void);
 void        OV5640_TransmitConfig(void);
 void        OV5640_SetResolution(resolution_t res);
+void        OV5640_getResolutionSize(resolution_t res, uint16_t *width, uint16_t *height);
 void        OV5640_init(void);
 void        OV5640_deinit(void);
 bool        OV5640_isAvailable(void);
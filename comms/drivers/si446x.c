@@ -68,6 +68,128 @@ static SPIDriver *Si446x_spiSetupBus(const radio_unit_t radio,
   return spip;
 }
 
+/**
+ * Acquire the bus and start SPI for a command.
+ * Nothing to do if the calling thread holds a command sequence.
+ */
+static SPIDriver *Si446x_spiAcquire(const radio_unit_t radio) {
+  if(Si446x_getData(radio)->spi_owner == chThdGetSelfX())
+    return Si446x_getConfig(radio)->spi;
+  SPIDriver *spip = Si446x_spiSetupBus(radio, &ls_spicfg);
+  spiStart(spip, &ls_spicfg);
+  return spip;
+}
+
+/**
+ * Stop SPI and release the bus after a command.
+ * Nothing to do if the calling thread holds a command sequence.
+ */
+static void Si446x_spiRelease(const radio_unit_t radio, SPIDriver *spip) {
+  if(Si446x_getData(radio)->spi_owner == chThdGetSelfX())
+    return;
+  spiStop(spip);
+  spiReleaseBus(spip);
+}
+
+/**
+ * Start a sequence of commands.
+ * The bus is held and SPI kept started until the matching end.
+ * Sequences may be nested by the same thread.
+ */
+static void Si446x_beginSequence(const radio_unit_t radio) {
+  si446x_data_t *dat = Si446x_getData(radio);
+  if(dat->spi_owner == chThdGetSelfX()) {
+    dat->spi_depth++;
+    return;
+  }
+  SPIDriver *spip = Si446x_spiSetupBus(radio, &ls_spicfg);
+  spiStart(spip, &ls_spicfg);
+  dat->spi_owner = chThdGetSelfX();
+  dat->spi_depth = 1;
+}
+
+/**
+ * End a sequence of commands.
+ */
+static void Si446x_endSequence(const radio_unit_t radio) {
+  si446x_data_t *dat = Si446x_getData(radio);
+  chDbgAssert(dat->spi_owner == chThdGetSelfX(), "not sequence owner");
+  if(--dat->spi_depth > 0)
+    return;
+  dat->spi_owner = NULL;
+  SPIDriver *spip = Si446x_getConfig(radio)->spi;
+  spiStop(spip);
+  spiReleaseBus(spip);
+}
+
+#if Si446x_USE_CTS_GPIO == TRUE
+/**
+ * GPIO0 CTS rising edge. Wake any thread waiting for a command to finish.
+ */
+static void Si446x_CTSCallback(void *arg) {
+  chSysLockFromISR();
+  chThdResumeI((thread_reference_t *)arg, MSG_OK);
+  chSysUnlockFromISR();
+}
+
+/**
+ * Wait for CTS on radio GPIO0.
+ * Spin briefly as most commands complete in a few microseconds.
+ * Then sleep until the CTS edge or timeout.
+ *
+ * @return  true if CTS is asserted.
+ * @retval  false if CTS did not assert or GPIO0 CTS is not enabled.
+ * @notes   CTS is confirmed by the caller with READ_CMD_BUFF.
+ */
+static bool Si446x_waitCTS(const radio_unit_t radio) {
+  si446x_data_t *dat = Si446x_getData(radio);
+  if(!dat->cts_gpio)
+    return false;
+  ioline_t cts = Si446x_getConfig(radio)->gpio0;
+  for(uint16_t i = 0; i < Si446x_CTS_SPIN; i++) {
+    if(palReadLine(cts) == PAL_HIGH)
+      return true;
+  }
+  chSysLock();
+  if(palReadLine(cts) != PAL_HIGH)
+    (void)chThdSuspendTimeoutS(&dat->cts_wait, TIME_MS2I(100));
+  chSysUnlock();
+  return palReadLine(cts) == PAL_HIGH;
+}
+#else
+#define Si446x_waitCTS(radio)       false
+#endif /* Si446x_USE_CTS_GPIO == TRUE */
+
+/**
+ * Poll READ_CMD_BUFF until the radio reports CTS.
+ * Between polls wait for the CTS edge on GPIO0 if available else sleep.
+ * Polls sleep once GPIO0 has shown CTS while the radio reported busy.
+ * Timeout after 100mS of polling.
+ *
+ * @return  true if CTS was received.
+ * @notes   rxData receives the command, CTS and response bytes.
+ */
+static bool Si446x_pollCTS(const radio_unit_t radio, SPIDriver *spip,
+                           uint8_t *rxData, uint32_t rxlen) {
+  uint8_t txData[rxlen];
+  memset(txData, 0, rxlen);
+  txData[0] = Si446x_READ_CMD_BUFF;
+
+  bool cts = Si446x_waitCTS(radio);
+  systime_t start = chVTGetSystemTimeX();
+  while(true) {
+    spiSelect(spip);
+    spiExchange(spip, rxlen, txData, rxData);
+    spiUnselect(spip);
+    if(rxData[1] == Si446x_COMMAND_CTS)
+      return true;
+    if(chVTTimeElapsedSinceX(start) >= TIME_MS2I(100))
+      return false;
+    if(cts || !(cts = Si446x_waitCTS(radio)))
+      chThdSleep(TIME_MS2I(1));
+  }
+}
+
 /**
  * SPI write which uses CTS presented on radio GPIO1.
  * Used when starting the radio up from shutdown state.
@@ -117,26 +239,18 @@ static bool Si446x_write(const radio_unit_t radio,
     /* Transmit data by SPI with CTS polling by command. */
     uint8_t null_spi[len];
 
-    /* Acquire bus, get SPI Driver object and then start SPI. */
-    SPIDriver *spip = Si446x_spiSetupBus(radio, &ls_spicfg);
-    spiStart(spip, &ls_spicfg);
-
-    /* Poll for CTS with timeout of 100mS. */
-    uint8_t timeout = 100;
-    uint8_t rx_ready[] = {Si446x_READ_CMD_BUFF, 0x00};
-    do {
-      spiSelect(spip);
-      spiExchange(spip, 1, rx_ready, &rx_ready[1]);
-      spiUnselect(spip);
-      if(timeout != 100)
-        chThdSleep(TIME_MS2I(1));
-    } while(rx_ready[1] != Si446x_COMMAND_CTS && timeout--);
+    /* Get SPI Driver object ready for use. */
+    SPIDriver *spip = Si446x_spiAcquire(radio);
 
-    if(!timeout) {
+    /*
+     * Wait for CTS from the previous command.
+     * With GPIO0 CTS the first poll normally confirms CTS.
+     */
+    uint8_t rx_ready[2];
+    if(!Si446x_pollCTS(radio, spip, rx_ready, sizeof(rx_ready))) {
       TRACE_ERROR("SI   > CTS not received");
       /* Stop SPI and relinquish bus. */
-      spiStop(spip);
-      spiReleaseBus(spip);
+      Si446x_spiRelease(radio, spip);
       return false;
     }
     
@@ -146,8 +260,7 @@ static bool Si446x_write(const radio_unit_t radio,
     spiUnselect(spip);
 
     /* Stop SPI and relinquish bus. */
-    spiStop(spip);
-    spiReleaseBus(spip);
+    Si446x_spiRelease(radio, spip);
     
     return true;
 }
@@ -220,32 +333,18 @@ static bool Si446x_read(const radio_unit_t radio,
 		                const uint8_t* txData, uint32_t txlen,
                         uint8_t* rxData, uint32_t rxlen) {
 
-    /* Acquire bus and then start SPI. */
-    SPIDriver *spip = Si446x_spiSetupBus(radio, &ls_spicfg);
-    spiStart(spip, &ls_spicfg);
+    /* Get SPI Driver object ready for use. */
+    SPIDriver *spip = Si446x_spiAcquire(radio);
 
     /*
-     * Poll command buffer waiting for CTS from the READ_CMD_BUFF command.
-     * This command does not itself cause CTS to report busy.
-     * Allocate a buffer to use for CTS check.
-     * Timeout after 100mS waiting for CTS.
+     * Wait for CTS from the previous command.
+     * The READ_CMD_BUFF command does not itself cause CTS to report busy.
      */
-    uint8_t timeout = 100;
-    uint8_t rx_ready[] = {Si446x_READ_CMD_BUFF, 0x00};
-    do {
-      if(timeout != 100)
-        chThdSleep(TIME_MS2I(1));
-      spiSelect(spip);
-      spiExchange(spip, 1, rx_ready, &rx_ready[1]);
-      spiUnselect(spip);
-
-    } while(rx_ready[1] != Si446x_COMMAND_CTS && timeout--);
-
-    if(!timeout) {
+    uint8_t rx_ready[2];
+    if(!Si446x_pollCTS(radio, spip, rx_ready, sizeof(rx_ready))) {
       TRACE_ERROR("SI   > CTS not received");
       /* Stop SPI and relinquish bus. */
-      spiStop(spip);
-      spiReleaseBus(spip);
+      Si446x_spiRelease(radio, spip);
       return false;
     }
 
@@ -256,61 +355,222 @@ static bool Si446x_read(const radio_unit_t radio,
     spiSend(spip, txlen, txData);
     spiUnselect(spip);
     /*
-     * Poll waiting for CTS again using the READ_CMD_BUFF command.
+     * Wait for the command to complete then read the response.
+     * With GPIO0 CTS the first poll normally returns the response.
      * Once CTS is received the response data is ready in the rx data buffer.
      * The buffer contains the command, CTS and 0 - 16 bytes of response.
-     * Timeout after 100mS waiting for CTS.
      */
-    timeout = 100;
-    do {
-      if(timeout != 100)
-        chThdSleep(TIME_MS2I(1));
-      spiSelect(spip);
-      spiExchange(spip, rxlen, rx_ready, rxData);
-      spiUnselect(spip);
-    } while(rxData[1] != Si446x_COMMAND_CTS && timeout--);
+    bool cts = Si446x_pollCTS(radio, spip, rxData, rxlen);
 
     /* Stop SPI and relinquish bus. */
-    spiStop(spip);
-    spiReleaseBus(spip);
+    Si446x_spiRelease(radio, spip);
     
-   if(!timeout) {
+   if(!cts) {
       TRACE_ERROR("SI   > CTS not received");
       return false;
     }
     return true;
 }
 
-/* TODO: Make set property a single func with size parameter. */
+#if Si446x_USE_CTS_GPIO == TRUE
+/**
+ * Switch radio GPIO0 to output CTS and enable the MCU edge event.
+ */
+static void Si446x_enableCTSGPIO(const radio_unit_t radio) {
+  si446x_data_t *dat = Si446x_getData(radio);
+  ioline_t cts = Si446x_getConfig(radio)->gpio0;
+
+  /* GPIO0 GPIO_MODE = CTS. Other pins unchanged. */
+  const uint8_t gpio_cts[] = {Si446x_GPIO_PIN_CFG, 0x08, 0x00, 0x00, 0x00,
+                              0x00, 0x00, 0x00};
+  Si446x_write(radio, gpio_cts, sizeof(gpio_cts));
+
+  pktSetGPIOlineMode(cts, PAL_MODE_INPUT_PULLDOWN);
+  palSetLineCallback(cts, Si446x_CTSCallback, &dat->cts_wait);
+  palEnableLineEvent(cts, PAL_EVENT_MODE_RISING_EDGE);
+  dat->cts_gpio = true;
+}
+
+/**
+ * Disable use of GPIO0 CTS. Commands revert to READ_CMD_BUFF polling.
+ */
+static void Si446x_disableCTSGPIO(const radio_unit_t radio) {
+  si446x_data_t *dat = Si446x_getData(radio);
+  if(!dat->cts_gpio)
+    return;
+  dat->cts_gpio = false;
+  palDisableLineEvent(Si446x_getConfig(radio)->gpio0);
+}
+
+#endif /* Si446x_USE_CTS_GPIO == TRUE */
+
+/*
+ * Property shadow groups.
+ * Only groups and ranges written by this driver are shadowed.
+ * Properties outside these ranges are always written.
+ */
+static const struct {
+  uint8_t   group;
+  uint8_t   size;
+  uint8_t   offset;
+} si446x_prop_groups[] = {
+  {0x00, 0x04, 0},                  /* GLOBAL.        */
+  {0x01, 0x04, 4},                  /* INT_CTL.       */
+  {0x02, 0x04, 8},                  /* FRR_CTL.       */
+  {0x10, 0x06, 12},                 /* PREAMBLE.      */
+  {0x11, 0x01, 18},                 /* SYNC.          */
+  {0x12, 0x0C, 19},                 /* PKT.           */
+  {0x20, 0x60, 31},                 /* MODEM.         */
+  {0x21, 0x24, 127},                /* MODEM_CHFLT.   */
+  {0x22, 0x04, 163},                /* PA.            */
+  {0x23, 0x07, 167},                /* SYNTH.         */
+  {0x40, 0x08, 174}                 /* FREQ_CONTROL.  */
+};
+
+/**
+ * Get the shadow slot of a property.
+ *
+ * @return  slot index.
+ * @retval  -1 if the property is not shadowed.
+ */
+static int16_t Si446x_getPropertySlot(uint16_t prop) {
+  uint8_t group = prop >> 8;
+  uint8_t index = prop & 0xFF;
+  for(uint8_t i = 0; i < sizeof(si446x_prop_groups)
+                          / sizeof(si446x_prop_groups[0]); i++) {
+    if(si446x_prop_groups[i].group != group)
+      continue;
+    if(index >= si446x_prop_groups[i].size)
+      return -1;
+    return si446x_prop_groups[i].offset + index;
+  }
+  return -1;
+}
+
+/**
+ * Forget all shadowed property values.
+ * Used when the radio is reset to its default properties.
+ */
+static void Si446x_invalidateProperties(const radio_unit_t radio) {
+  memset(Si446x_getData(radio)->prop_valid, 0,
+         sizeof(Si446x_getData(radio)->prop_valid));
+}
+
+/**
+ * Check if a property value matches the shadow.
+ */
+static bool Si446x_isPropertyCurrent(si446x_data_t *dat, uint16_t prop,
+                                     uint8_t val) {
+  int16_t slot = Si446x_getPropertySlot(prop);
+  if(slot < 0)
+    return false;
+  if(!(dat->prop_valid[slot >> 3] & (1 << (slot & 7))))
+    return false;
+  return dat->prop_shadow[slot] == val;
+}
+
+/**
+ * Write a run of contiguous properties in one group.
+ * Leading and trailing values which match the shadow are not sent.
+ * The rest is sent in SET_PROPERTY commands of up to 12 values.
+ */
+static void Si446x_setPropertyRun(const radio_unit_t radio, uint16_t prop,
+                                  const uint8_t *val, uint8_t len) {
+  si446x_data_t *dat = Si446x_getData(radio);
+
+  while(len > 0 && Si446x_isPropertyCurrent(dat, prop, val[0])) {
+    prop++;
+    val++;
+    len--;
+  }
+  while(len > 0 && Si446x_isPropertyCurrent(dat, prop + len - 1,
+                                            val[len - 1]))
+    len--;
+
+  while(len > 0) {
+    uint8_t n = (len > Si446x_PROP_MAX_WRITE) ? Si446x_PROP_MAX_WRITE : len;
+    uint8_t msg[4 + Si446x_PROP_MAX_WRITE];
+    msg[0] = Si446x_SET_PROPERTY;
+    msg[1] = (prop >> 8) & 0xFF;
+    msg[2] = n;
+    msg[3] = prop & 0xFF;
+    memcpy(&msg[4], val, n);
+    bool ok = Si446x_write(radio, msg, 4 + n);
+
+    /* Update the shadow. A failed write leaves the values unknown. */
+    for(uint8_t i = 0; i < n; i++) {
+      int16_t slot = Si446x_getPropertySlot(prop + i);
+      if(slot < 0)
+        continue;
+      dat->prop_shadow[slot] = val[i];
+      if(ok)
+        dat->prop_valid[slot >> 3] |= (1 << (slot & 7));
+      else
+        dat->prop_valid[slot >> 3] &= ~(1 << (slot & 7));
+    }
+    prop += n;
+    val += n;
+    len -= n;
+  }
+}
+
+/**
+ * Write a property list with values replaced from an overlay list.
+ * Both lists are sorted by property. Overlay entries not in the list are
+ * ignored. Contiguous entries are coalesced.
+ */
+static void Si446x_setPropertiesOver(const radio_unit_t radio,
+                                     const si446x_prop_t *list, size_t n,
+                                     const si446x_prop_t *over, size_t m) {
+  uint8_t val[Si446x_PROP_MAX_WRITE];
+  size_t i = 0, j = 0;
+  while(i < n) {
+    uint16_t prop = list[i].prop;
+    uint8_t len = 0;
+    do {
+      while(j < m && over[j].prop < list[i].prop)
+        j++;
+      val[len++] = (j < m && over[j].prop == list[i].prop)
+                   ? over[j].value : list[i].value;
+      i++;
+    } while(i < n && len < Si446x_PROP_MAX_WRITE
+            && list[i].prop == prop + len);
+    Si446x_setPropertyRun(radio, prop, val, len);
+  }
+}
+
+/**
+ * Write a property list.
+ * The list is sorted by property. Contiguous entries are coalesced.
+ */
+static void Si446x_setProperties(const radio_unit_t radio,
+                                 const si446x_prop_t *list, size_t n) {
+  Si446x_setPropertiesOver(radio, list, n, NULL, 0);
+}
+
 static void Si446x_setProperty8(const radio_unit_t radio,
 		uint16_t reg, uint8_t val) {
-    uint8_t msg[] = {Si446x_SET_PROPERTY,
-                     (reg >> 8) & 0xFF, 0x01, reg & 0xFF, val};
-    Si446x_write(radio, msg, sizeof(msg));
+    Si446x_setPropertyRun(radio, reg, &val, 1);
 }
 
 static void Si446x_setProperty16(const radio_unit_t radio,
 		uint16_t reg, uint8_t val1, uint8_t val2) {
-    uint8_t msg[] = {Si446x_SET_PROPERTY,
-                     (reg >> 8) & 0xFF, 0x02, reg & 0xFF, val1, val2};
-    Si446x_write(radio, msg, sizeof(msg));
+    const uint8_t val[] = {val1, val2};
+    Si446x_setPropertyRun(radio, reg, val, sizeof(val));
 }
 
 static void Si446x_setProperty24(const radio_unit_t radio,
 		                         uint16_t reg, uint8_t val1,
                                  uint8_t val2, uint8_t val3) {
-    uint8_t msg[] = {Si446x_SET_PROPERTY,
-                     (reg >> 8) & 0xFF, 0x03, reg & 0xFF, val1, val2, val3};
-    Si446x_write(radio, msg, sizeof(msg));
+    const uint8_t val[] = {val1, val2, val3};
+    Si446x_setPropertyRun(radio, reg, val, sizeof(val));
 }
 
 static void Si446x_setProperty32(const radio_unit_t radio,
 		                         uint16_t reg, uint8_t val1,
                                  uint8_t val2, uint8_t val3, uint8_t val4) {
-    uint8_t msg[] = {Si446x_SET_PROPERTY,
-                     (reg >> 8) & 0xFF, 0x04, reg & 0xFF,
-                     val1, val2, val3, val4};
-    Si446x_write(radio, msg, sizeof(msg));
+    const uint8_t val[] = {val1, val2, val3, val4};
+    Si446x_setPropertyRun(radio, reg, val, sizeof(val));
 }
 
 /**
@@ -343,6 +603,9 @@ static bool Si446x_init(const radio_unit_t radio) {
     return false;
   }
 
+  /* The radio is powered up with default properties. */
+  Si446x_invalidateProperties(radio);
+
   /* Calculate clock source parameters. */
   const uint8_t x3 = (Si446x_CCLK >> 24) & 0x0FF;
   const uint8_t x2 = (Si446x_CCLK >> 16) & 0x0FF;
@@ -426,8 +689,16 @@ static bool Si446x_init(const radio_unit_t radio) {
       0x00    // GEN_CONFIG
   };
 
+  /* Keep SPI started for the remaining setup commands. */
+  Si446x_beginSequence(radio);
+
   Si446x_write(radio, gpio_pin_cfg_command2, sizeof(gpio_pin_cfg_command2));
 
+#if Si446x_USE_CTS_GPIO == TRUE
+  /* Command CTS is now taken from GPIO0. */
+  Si446x_enableCTSGPIO(radio);
+#endif
+
   /* TODO: We should clear interrupts here with a GET_INT_STATUS. */
 
   /* If Si446x is using its own xtal set the trim capacitor value. */
@@ -514,6 +785,7 @@ static bool Si446x_init(const radio_unit_t radio) {
 
   /* Measure the chip temperature and save initial measurement. */
   Si446x_getTemperature(radio);
+  Si446x_endSequence(radio);
   handler->radio_init = true;
   return true;
 }
@@ -557,12 +829,12 @@ bool Si446x_setBandParameters(const radio_unit_t radio,
    */
   //Si446x_conditional_init(radio);
 
+  /* Keep SPI started for the sequence of commands. */
+  Si446x_beginSequence(radio);
+
   /* Set the band parameter. */
   uint32_t sy_sel = 8;
-  uint8_t set_band_property_command[] = {Si446x_SET_PROPERTY,
-                                         0x20, 0x01, 0x51, (band + sy_sel)};
-  Si446x_write(radio, set_band_property_command,
-		  sizeof(set_band_property_command));
+  Si446x_setProperty8(radio, Si446x_MODEM_CLKGEN_BAND, (band + sy_sel));
 
   /* Set the PLL parameters. */
   uint32_t f_pfd = 2 * Si446x_CCLK / outdiv;
@@ -575,25 +847,23 @@ bool Si446x_setBandParameters(const radio_unit_t radio,
   uint32_t m1 = (m - m2 * 0x10000) >> 8;
   uint32_t m0 = (m - m2 * 0x10000 - (m1 << 8));
 
-  uint32_t channel_increment = 524288 * outdiv * step / (2 * Si446x_CCLK);
-  uint8_t c1 = channel_increment / 0x100;
-  uint8_t c0 = channel_increment - (0x100 * c1);
-
-  uint8_t set_frequency_property_command[] = {Si446x_SET_PROPERTY,
-                                              0x40, 0x04, 0x00, n,
-                                              m2, m1, m0, c1, c0};
-  Si446x_write(radio, set_frequency_property_command,
-               sizeof(set_frequency_property_command));
+  /*
+   * Only the integer and fractional dividers are set.
+   * The channel step size has never been written and is left as it is.
+   */
+  const uint8_t freq_control[] = {n, m2, m1, m0};
+  Si446x_setPropertyRun(radio, Si446x_FREQ_CONTROL_INTE, freq_control,
+                        sizeof(freq_control));
 
   uint32_t x = ((((uint32_t)1 << 19) * outdiv * 1300.0)/(2*Si446x_CCLK))*2;
   uint8_t x2 = (x >> 16) & 0xFF;
   uint8_t x1 = (x >>  8) & 0xFF;
   uint8_t x0 = (x >>  0) & 0xFF;
-  uint8_t set_deviation[] = {Si446x_SET_PROPERTY, 0x20, 0x03, 0x0a, x2, x1, x0};
-  Si446x_write(radio, set_deviation, sizeof(set_deviation));
+  Si446x_setProperty24(radio, Si446x_MODEM_FREQ_DEV, x2, x1, x0);
 
   /* Measure the chip temperature and update saved value. */
   Si446x_getTemperature(radio);
+  Si446x_endSequence(radio);
   return true;
 }
 
@@ -617,10 +887,7 @@ bool Si446x_setBandParameters(const radio_unit_t radio,
 static void Si446x_setPowerLevel(const radio_unit_t radio,
 								 const radio_pwr_t level) {
     // Set the Power
-    uint8_t set_pa_pwr_lvl_property_command[] = {Si446x_SET_PROPERTY,
-                                                 0x22, 0x01, 0x01, level};
-    Si446x_write(radio, set_pa_pwr_lvl_property_command,
-                 sizeof(set_pa_pwr_lvl_property_command));
+    Si446x_setProperty8(radio, Si446x_PA_PWR_LVL, level);
 }
 
 
@@ -629,7 +896,35 @@ static void Si446x_setPowerLevel(const radio_unit_t radio,
  *  Radio modulation settings
  */
 
+/*
+ * AFSK TX property list (sorted by property).
+ * The NCO modulo depends on the oscillator and is set separately.
+ */
+static const si446x_prop_t Si446x_afsk_tx_props[] = {
+    /* Set PH bit order for AFSK. */
+    {Si446x_PKT_CONFIG1,            0x01},
+    /* Use up-sampled AFSK from FIFO (PH). */
+    {Si446x_MODEM_MOD_TYPE,         0x02},
+    /* NCO data rate for APRS. */
+    {Si446x_MODEM_DATA_RATE,        0x00},
+    {Si446x_MODEM_DATA_RATE + 1,    0x33},
+    {Si446x_MODEM_DATA_RATE + 2,    0x90},
+    /* AFSK TX filter. */
+    {Si446x_MODEM_TX_FILTER_COEFF_8, 0x76},
+    {Si446x_MODEM_TX_FILTER_COEFF_8 + 1, 0x70},
+    {Si446x_MODEM_TX_FILTER_COEFF_8 + 2, 0x5c},
+    {Si446x_MODEM_TX_FILTER_COEFF_8 + 3, 0x3e},
+    {Si446x_MODEM_TX_FILTER_COEFF_8 + 4, 0x18},
+    {Si446x_MODEM_TX_FILTER_COEFF_8 + 5, 0xee},
+    {Si446x_MODEM_TX_FILTER_COEFF_8 + 6, 0xc4},
+    {Si446x_MODEM_TX_FILTER_COEFF_8 + 7, 0x9f},
+    {Si446x_MODEM_TX_FILTER_COEFF_8 + 8, 0x81}
+};
+
 static void Si446x_setModemAFSK_TX(const radio_unit_t radio) {
+    /* Keep SPI started for the sequence of commands. */
+    Si446x_beginSequence(radio);
+
     // Setup the NCO modulo and oversampling mode
     uint32_t s = Si446x_CCLK / 10;
     uint8_t f3 = (s >> 24) & 0xFF;
@@ -638,28 +933,13 @@ static void Si446x_setModemAFSK_TX(const radio_unit_t radio) {
     uint8_t f0 = (s >>  0) & 0xFF;
     Si446x_setProperty32(radio, Si446x_MODEM_TX_NCO_MODE, f3, f2, f1, f0);
 
-    // Setup the NCO data rate for APRS
-    Si446x_setProperty24(radio, Si446x_MODEM_DATA_RATE, 0x00, 0x33, 0x90);
-
-    // Use up-sampled AFSK from FIFO (PH)
-    Si446x_setProperty8(radio, Si446x_MODEM_MOD_TYPE, 0x02);
-
-    /* Set PH bit order for AFSK. */
-    Si446x_setProperty8(radio, Si446x_PKT_CONFIG1, 0x01);
-
-    // Set AFSK filter
-    const uint8_t coeff[] = {0x81, 0x9f, 0xc4, 0xee, 0x18, 0x3e, 0x5c, 0x70, 0x76};
-    uint8_t i;
-    for(i = 0; i < sizeof(coeff); i++) {
-        uint8_t msg[] = {0x11, 0x20, 0x01, 0x17-i, coeff[i]};
-        Si446x_write(radio, msg, 5);
-    }
+    /* Data rate, modulation and filter. Only changes are sent. */
+    Si446x_setProperties(radio, Si446x_afsk_tx_props,
+                         sizeof(Si446x_afsk_tx_props)
+                         / sizeof(Si446x_afsk_tx_props[0]));
+    Si446x_endSequence(radio);
 }
 
-static void Si446x_setModemAFSK_RX(const radio_unit_t radio) {
-
-  packet_svc_t *handler = pktGetServiceObject(radio);
-
 /*
 # BatchName Si4464
 # Crys_freq(Hz): 26000000    Crys_tol(ppm): 20    IF_mode: 2
@@ -675,150 +955,256 @@ static void Si446x_setModemAFSK_RX(const radio_unit_t radio) {
 #
 # Modulation index: 0.833
 */
-
-  /* Set DIRECT_MODE (asynchronous mode as 2FSK). */
-  Si446x_setProperty8(radio, Si446x_MODEM_MOD_TYPE, 0x0A);
-
+static const si446x_prop_t Si446x_afsk_rx_props[] = {
+  {Si446x_PREAMBLE_CONFIG,          0x21},
   /* Packet handler disabled in RX. */
-  Si446x_setProperty8(radio, Si446x_PKT_CONFIG1, 0x41);
-
-  if(is_part_Si4463(handler->radio_part)) {
-    /* Run 4463 in 4464 compatibility mode (set SEARCH2 to zero). */
-    Si446x_setProperty8(radio, Si446x_MODEM_RAW_SEARCH2, 0x00);
-  }
-  Si446x_setProperty8(radio, Si446x_MODEM_RAW_CONTROL, 0x8F);
-  Si446x_setProperty8(radio, Si446x_MODEM_RAW_SEARCH, 0xD6);
-  Si446x_setProperty16(radio, Si446x_MODEM_RAW_EYE, 0x00, 0x3B);
-
+  {Si446x_PKT_CONFIG1,              0x41},
+  /* Set DIRECT_MODE (asynchronous mode as 2FSK). */
+  {Si446x_MODEM_MOD_TYPE,           0x0A},
+  /* RX Bit clock recovery control. */
+  {Si446x_MODEM_MDM_CTRL,           0x80},
+  /* RX IF controls. */
+  {Si446x_MODEM_IF_CONTROL,         0x08},
+  {Si446x_MODEM_IF_FREQ,            0x02},
+  {Si446x_MODEM_IF_FREQ + 1,        0x80},
+  {Si446x_MODEM_IF_FREQ + 2,        0x00},
+  /* RX IF filter decimation controls. */
+  {Si446x_MODEM_DECIMATION_CFG1,    0x70},
+  {Si446x_MODEM_DECIMATION_CFG0,    0x10},
+  /* RX Bit clock recovery control. */
+  {Si446x_MODEM_BCR_OSR,            0x01},
+  {Si446x_MODEM_BCR_OSR + 1,        0xC3},
+  {Si446x_MODEM_BCR_NCO_OFFSET,     0x01},
+  {Si446x_MODEM_BCR_NCO_OFFSET + 1, 0x22},
+  {Si446x_MODEM_BCR_NCO_OFFSET + 2, 0x60},
+  {Si446x_MODEM_BCR_GAIN,           0x00},
+  {Si446x_MODEM_BCR_GAIN + 1,       0x91},
+  {Si446x_MODEM_BCR_GEAR,           0x00},
+  {Si446x_MODEM_BCR_MISC1,          0xC2},
+  /* RX AFC control. */
+  {Si446x_MODEM_AFC_GEAR,           0x54},
+  {Si446x_MODEM_AFC_WAIT,           0x36},
+  {Si446x_MODEM_AFC_GAIN,           0x80},
+  {Si446x_MODEM_AFC_GAIN + 1,       0xAB},
+  {Si446x_MODEM_AFC_LIMITER,        0x02},
+  {Si446x_MODEM_AFC_LIMITER + 1,    0x50},
+  {Si446x_MODEM_AFC_MISC,           0xC0}, // 0x80
+  /* RX AGC control. */
+  {Si446x_MODEM_AGC_CONTROL,        0xE0}, // 0xE2 (bit 1 not used in 4464. It is used in 4463.)
+  {Si446x_MODEM_AGC_WINDOW_SIZE,    0x11},
+  {Si446x_MODEM_AGC_RFPD_DECAY,     0x63},
+  {Si446x_MODEM_AGC_IFPD_DECAY,     0x63},
   /*
    * OOK_MISC settings include parameters related to asynchronous mode.
    * Asynchronous mode is used for AFSK reception passed to DSP decode.
    */
-  Si446x_setProperty8(radio, Si446x_MODEM_OOK_PDTC, 0x2A);
-  Si446x_setProperty8(radio, Si446x_MODEM_OOK_CNT1, 0x85);
-  Si446x_setProperty8(radio, Si446x_MODEM_OOK_MISC, 0x23);
+  {Si446x_MODEM_OOK_PDTC,           0x2A},
+  {Si446x_MODEM_OOK_CNT1,           0x85},
+  {Si446x_MODEM_OOK_MISC,           0x23},
+  {Si446x_MODEM_RAW_SEARCH,         0xD6},
+  {Si446x_MODEM_RAW_CONTROL,        0x8F},
+  {Si446x_MODEM_RAW_EYE,            0x00},
+  {Si446x_MODEM_RAW_EYE + 1,        0x3B},
+  /* RSSI latching disabled. */
+  {Si446x_MODEM_RSSI_CONTROL,       0x00},
+  /* RX IF filter coefficients. */
+  {Si446x_MODEM_CHFLT_RX1_CHFLT_COE13_7_0, 0xFF},
+  {Si446x_MODEM_CHFLT_RX1_CHFLT_COE13_7_0 + 1, 0xC4},
+  {Si446x_MODEM_CHFLT_RX1_CHFLT_COE13_7_0 + 2, 0x30},
+  {Si446x_MODEM_CHFLT_RX1_CHFLT_COE13_7_0 + 3, 0x7F},
+  {Si446x_MODEM_CHFLT_RX1_CHFLT_COE13_7_0 + 4, 0x5F},
+  {Si446x_MODEM_CHFLT_RX1_CHFLT_COE13_7_0 + 5, 0xB5},
+  {Si446x_MODEM_CHFLT_RX1_CHFLT_COE13_7_0 + 6, 0xB8},
+  {Si446x_MODEM_CHFLT_RX1_CHFLT_COE13_7_0 + 7, 0xDE},
+  {Si446x_MODEM_CHFLT_RX1_CHFLT_COE13_7_0 + 8, 0x05},
+  {Si446x_MODEM_CHFLT_RX1_CHFLT_COE13_7_0 + 9, 0x17},
+  {Si446x_MODEM_CHFLT_RX1_CHFLT_COE13_7_0 + 10, 0x16},
+  {Si446x_MODEM_CHFLT_RX1_CHFLT_COE13_7_0 + 11, 0x0C},
+  {Si446x_MODEM_CHFLT_RX1_CHFLT_COE13_7_0 + 12, 0x03},
+  {Si446x_MODEM_CHFLT_RX1_CHFLT_COE13_7_0 + 13, 0x00},
+  {Si446x_MODEM_CHFLT_RX1_CHFLT_COE13_7_0 + 14, 0x15},
+  {Si446x_MODEM_CHFLT_RX1_CHFLT_COE13_7_0 + 15, 0xFF},
+  {Si446x_MODEM_CHFLT_RX1_CHFLT_COE13_7_0 + 16, 0x00},
+  {Si446x_MODEM_CHFLT_RX1_CHFLT_COE13_7_0 + 17, 0x00},
+  {Si446x_MODEM_CHFLT_RX2_CHFLT_COE13_7_0, 0xFF},
+  {Si446x_MODEM_CHFLT_RX2_CHFLT_COE13_7_0 + 1, 0xC4},
+  {Si446x_MODEM_CHFLT_RX2_CHFLT_COE13_7_0 + 2, 0x30},
+  {Si446x_MODEM_CHFLT_RX2_CHFLT_COE13_7_0 + 3, 0x7F},
+  {Si446x_MODEM_CHFLT_RX2_CHFLT_COE13_7_0 + 4, 0x5F},
+  {Si446x_MODEM_CHFLT_RX2_CHFLT_COE13_7_0 + 5, 0xB5},
+  {Si446x_MODEM_CHFLT_RX2_CHFLT_COE13_7_0 + 6, 0xB8},
+  {Si446x_MODEM_CHFLT_RX2_CHFLT_COE13_7_0 + 7, 0xDE},
+  {Si446x_MODEM_CHFLT_RX2_CHFLT_COE13_7_0 + 8, 0x05},
+  {Si446x_MODEM_CHFLT_RX2_CHFLT_COE13_7_0 + 9, 0x17},
+  {Si446x_MODEM_CHFLT_RX2_CHFLT_COE13_7_0 + 10, 0x16},
+  {Si446x_MODEM_CHFLT_RX2_CHFLT_COE13_7_0 + 11, 0x0C},
+  {Si446x_MODEM_CHFLT_RX2_CHFLT_COE13_7_0 + 12, 0x03},
+  {Si446x_MODEM_CHFLT_RX2_CHFLT_COE13_7_0 + 13, 0x00},
+  {Si446x_MODEM_CHFLT_RX2_CHFLT_COE13_7_0 + 14, 0x15},
+  {Si446x_MODEM_CHFLT_RX2_CHFLT_COE13_7_0 + 15, 0xFF},
+  {Si446x_MODEM_CHFLT_RX2_CHFLT_COE13_7_0 + 16, 0x00},
+  {Si446x_MODEM_CHFLT_RX2_CHFLT_COE13_7_0 + 17, 0x00}
+};
 
-  /* RX AFC control. */
-  Si446x_setProperty8(radio, Si446x_MODEM_AFC_GEAR, 0x54);
-  Si446x_setProperty8(radio, Si446x_MODEM_AFC_WAIT, 0x36);
-  Si446x_setProperty16(radio, Si446x_MODEM_AFC_GAIN, 0x80, 0xAB);
-  Si446x_setProperty16(radio, Si446x_MODEM_AFC_LIMITER, 0x02, 0x50);
-  Si446x_setProperty8(radio, Si446x_MODEM_AFC_MISC, 0xC0); // 0x80
+/*
+ * AFSK RX property list for Si4463 only (sorted by property).
+ */
+static const si446x_prop_t Si446x_afsk_rx_4463_props[] = {
+  {Si446x_MODEM_DECIMATION_CFG2,    0x0C},
+  /* Run 4463 in 4464 compatibility mode (set SEARCH2 to zero). */
+  {Si446x_MODEM_RAW_SEARCH2,        0x00},
+  /* Unused Si4463 features for AFSK RX. */
+  {Si446x_MODEM_SPIKE_DET,          0x00}, // 0x03
+  {Si446x_MODEM_ONE_SHOT_AFC,       0x00}, // 0x07
+  {Si446x_MODEM_RSSI_MUTE,          0x00},
+  /* DSA is not enabled. */
+  {Si446x_MODEM_DSA_CTRL1,          0x00}, // 0xA0
+  {Si446x_MODEM_DSA_CTRL2,          0x00}, // 0x04
+  {Si446x_MODEM_DSA_QUAL,           0x00}, // 0x06
+  {Si446x_MODEM_DSA_RSSI,           0x00}, // 0x78
+  {Si446x_MODEM_DSA_MISC,           0x00}  // 0x20
+};
 
-  /* RX AGC control. */
-  Si446x_setProperty8(radio, Si446x_MODEM_AGC_CONTROL, 0xE0); // 0xE2 (bit 1 not used in 4464. It is used in 4463.)
-  Si446x_setProperty8(radio, Si446x_MODEM_AGC_WINDOW_SIZE, 0x11);
-  Si446x_setProperty8(radio, Si446x_MODEM_AGC_RFPD_DECAY, 0x63);
-  Si446x_setProperty8(radio, Si446x_MODEM_AGC_IFPD_DECAY, 0x63);
+static void Si446x_setModemAFSK_RX(const radio_unit_t radio) {
 
-  /* RX Bit clock recovery control. */
-  Si446x_setProperty8(radio, Si446x_MODEM_MDM_CTRL, 0x80);
-  Si446x_setProperty16(radio, Si446x_MODEM_BCR_OSR, 0x01, 0xC3);
-  Si446x_setProperty24(radio, Si446x_MODEM_BCR_NCO_OFFSET, 0x01, 0x22, 0x60);
-  Si446x_setProperty16(radio, Si446x_MODEM_BCR_GAIN, 0x00, 0x91);
-  Si446x_setProperty8(radio, Si446x_MODEM_BCR_GEAR, 0x00);
-  Si446x_setProperty8(radio, Si446x_MODEM_BCR_MISC1, 0xC2);
+  packet_svc_t *handler = pktGetServiceObject(radio);
 
-  /* RX IF controls. */
-  Si446x_setProperty8(radio, Si446x_MODEM_IF_CONTROL, 0x08);
-  Si446x_setProperty24(radio, Si446x_MODEM_IF_FREQ, 0x02, 0x80, 0x00);
+  /* Keep SPI started for the sequence of commands. */
+  Si446x_beginSequence(radio);
 
-  /* RX IF filter decimation controls. */
-  Si446x_setProperty8(radio, Si446x_MODEM_DECIMATION_CFG1, 0x70);
-  Si446x_setProperty8(radio, Si446x_MODEM_DECIMATION_CFG0, 0x10);
+  /* Only changes are sent. */
+  Si446x_setProperties(radio, Si446x_afsk_rx_props,
+                       sizeof(Si446x_afsk_rx_props)
+                       / sizeof(Si446x_afsk_rx_props[0]));
   if(is_part_Si4463(handler->radio_part)) {
-    Si446x_setProperty8(radio, Si446x_MODEM_DECIMATION_CFG2, 0x0C);
+    Si446x_setProperties(radio, Si446x_afsk_rx_4463_props,
+                         sizeof(Si446x_afsk_rx_4463_props)
+                         / sizeof(Si446x_afsk_rx_4463_props[0]));
   }
+  Si446x_endSequence(radio);
+}
 
-  /* RSSI latching disabled. */
-  Si446x_setProperty8(radio, Si446x_MODEM_RSSI_CONTROL, 0x00);
+/*
+ * 2FSK RX property list (sorted by property).
+ * Overlaid on the AFSK RX setup which has a channel filter (14.89 kHz)
+ * wide enough for 9600 baud G3RUH. The radio outputs the sliced data level
+ * in asynchronous mode. Clock recovery and descrambling are done by the uC.
+ * Experimental: the filter and clock recovery have not been confirmed
+ * against WDS on hardware. Receive is only used with PKT_RX_USE_2FSK.
+ */
+static const si446x_prop_t Si446x_2fsk_rx_props[] = {
+  /* Slicer eye threshold scaled by deviation (3 kHz versus 500 Hz). */
+  {Si446x_MODEM_RAW_EYE,            0x01},
+  {Si446x_MODEM_RAW_EYE + 1,        0x62}
+};
 
-  /* RX IF filter coefficients. */
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX1_CHFLT_COE13_7_0, 0xFF);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX1_CHFLT_COE12_7_0, 0xC4);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX1_CHFLT_COE11_7_0, 0x30);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX1_CHFLT_COE10_7_0, 0x7F);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX1_CHFLT_COE9_7_0, 0x5F);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX1_CHFLT_COE8_7_0, 0xB5);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX1_CHFLT_COE7_7_0, 0xB8);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX1_CHFLT_COE6_7_0, 0xDE);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX1_CHFLT_COE5_7_0, 0x05);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX1_CHFLT_COE4_7_0, 0x17);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX1_CHFLT_COE3_7_0, 0x16);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX1_CHFLT_COE2_7_0, 0x0C);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX1_CHFLT_COE1_7_0, 0x03);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX1_CHFLT_COE0_7_0, 0x00);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX1_CHFLT_COEM0, 0x15);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX1_CHFLT_COEM1, 0xFF);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX1_CHFLT_COEM2, 0x00);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX1_CHFLT_COEM3, 0x00);
-
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX2_CHFLT_COE13_7_0, 0xFF);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX2_CHFLT_COE12_7_0, 0xC4);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX2_CHFLT_COE11_7_0, 0x30);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX2_CHFLT_COE10_7_0, 0x7F);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX2_CHFLT_COE9_7_0, 0x5F);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX2_CHFLT_COE8_7_0, 0xB5);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX2_CHFLT_COE7_7_0, 0xB8);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX2_CHFLT_COE6_7_0, 0xDE);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX2_CHFLT_COE5_7_0, 0x05);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX2_CHFLT_COE4_7_0, 0x17);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX2_CHFLT_COE3_7_0, 0x16);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX2_CHFLT_COE2_7_0, 0x0C);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX2_CHFLT_COE1_7_0, 0x03);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX2_CHFLT_COE0_7_0, 0x00);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX2_CHFLT_COEM0, 0x15);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX2_CHFLT_COEM1, 0xFF);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX2_CHFLT_COEM2, 0x00);
-  Si446x_setProperty8(radio, Si446x_MODEM_CHFLT_RX2_CHFLT_COEM3, 0x00);
+/*
+ * Bit clock recovery for a data rate.
+ * The modem samples at Fxtal / Si446x_RX_SAMPLE_DIV with the AFSK
+ * decimation. The OSR is in 1/8 samples per bit. At 1200 baud these are
+ * the AFSK values from the calculator.
+ * OSR, NCO offset and gain are contiguous and are returned as one run.
+ */
+static void Si446x_getModemBCR(const uint32_t speed,
+                               uint8_t bcr[Si446x_BCR_RUN_SIZE]) {
+  uint32_t fs = Si446x_CCLK / Si446x_RX_SAMPLE_DIV;
+  uint16_t osr = (8 * fs + speed / 2) / speed;
+  uint32_t nco = (uint32_t)(((uint64_t)speed << 22) / fs);
+  uint16_t gain = nco >> 9;
+  bcr[0] = (uint8_t)(osr >> 8);
+  bcr[1] = (uint8_t)osr;
+  bcr[2] = (uint8_t)(nco >> 16);
+  bcr[3] = (uint8_t)(nco >> 8);
+  bcr[4] = (uint8_t)nco;
+  bcr[5] = (uint8_t)(gain >> 8);
+  bcr[6] = (uint8_t)gain;
+}
 
-  Si446x_setProperty8(radio, Si446x_PREAMBLE_CONFIG, 0x21);
+static void Si446x_setModem2FSK_RX(const radio_unit_t radio,
+                                   const uint32_t speed) {
+  packet_svc_t *handler = pktGetServiceObject(radio);
 
-  /* Unused Si4463 features for AFSK RX. */
+  /*
+   * Filter, AGC and slicer are shared with AFSK.
+   * Clock recovery and the 2FSK list replace the AFSK values so a setup
+   * which is already current sends nothing.
+   */
+  const size_t n = sizeof(Si446x_2fsk_rx_props)
+                   / sizeof(Si446x_2fsk_rx_props[0]);
+  si446x_prop_t over[Si446x_BCR_RUN_SIZE + n];
+  uint8_t bcr[Si446x_BCR_RUN_SIZE];
+  Si446x_getModemBCR(speed, bcr);
+  for(uint8_t i = 0; i < Si446x_BCR_RUN_SIZE; i++) {
+    over[i].prop = Si446x_MODEM_BCR_OSR + i;
+    over[i].value = bcr[i];
+  }
+  memcpy(&over[Si446x_BCR_RUN_SIZE], Si446x_2fsk_rx_props,
+         sizeof(Si446x_2fsk_rx_props));
+
+  /* Keep SPI started for the sequence of commands. */
+  Si446x_beginSequence(radio);
+
+  Si446x_setPropertiesOver(radio, Si446x_afsk_rx_props,
+                           sizeof(Si446x_afsk_rx_props)
+                           / sizeof(Si446x_afsk_rx_props[0]),
+                           over, sizeof(over) / sizeof(over[0]));
   if(is_part_Si4463(handler->radio_part)) {
-   /* DSA is not enabled. */
-   Si446x_setProperty8(radio, Si446x_MODEM_DSA_CTRL1, 0x00); // 0xA0
-   Si446x_setProperty8(radio, Si446x_MODEM_DSA_CTRL2, 0x00); // 0x04
-   Si446x_setProperty8(radio, Si446x_MODEM_SPIKE_DET, 0x00); // 0x03
-   Si446x_setProperty8(radio, Si446x_MODEM_ONE_SHOT_AFC, 0x00); // 0x07
-   Si446x_setProperty8(radio, Si446x_MODEM_DSA_QUAL, 0x00); // 0x06
-   Si446x_setProperty8(radio, Si446x_MODEM_DSA_RSSI, 0x00); // 0x78
-   Si446x_setProperty8(radio, Si446x_MODEM_RSSI_MUTE, 0x00);
-   Si446x_setProperty8(radio, Si446x_MODEM_DSA_MISC, 0x00); // 0x20
+    Si446x_setProperties(radio, Si446x_afsk_rx_4463_props,
+                         sizeof(Si446x_afsk_rx_4463_props)
+                         / sizeof(Si446x_afsk_rx_4463_props[0]));
   }
+  Si446x_endSequence(radio);
 }
 
 /**
  *
  */
+/*
+ * 2FSK TX property list (sorted by property).
+ * The data rate and NCO modulo are set separately.
+ */
+static const si446x_prop_t Si446x_2fsk_tx_props[] = {
+    /* Set PH bit order for 2FSK. */
+    {Si446x_PKT_CONFIG1,            0x01},
+    /* Use 2GFSK from FIFO (PH). */
+    {Si446x_MODEM_MOD_TYPE,         0x03},
+    /* 2GFSK TX filter (default per Si). */
+    {Si446x_MODEM_TX_FILTER_COEFF_8, 0x67},
+    {Si446x_MODEM_TX_FILTER_COEFF_8 + 1, 0x60},
+    {Si446x_MODEM_TX_FILTER_COEFF_8 + 2, 0x4d},
+    {Si446x_MODEM_TX_FILTER_COEFF_8 + 3, 0x36},
+    {Si446x_MODEM_TX_FILTER_COEFF_8 + 4, 0x21},
+    {Si446x_MODEM_TX_FILTER_COEFF_8 + 5, 0x11},
+    {Si446x_MODEM_TX_FILTER_COEFF_8 + 6, 0x08},
+    {Si446x_MODEM_TX_FILTER_COEFF_8 + 7, 0x03},
+    {Si446x_MODEM_TX_FILTER_COEFF_8 + 8, 0x01}
+};
+
 static void Si446x_setModem2FSK_TX(const radio_unit_t radio,
 		const uint32_t speed) {
-    // Setup the NCO modulo and oversampling mode
-    uint32_t s = Si446x_CCLK / 10;
-    uint8_t f3 = (s >> 24) & 0xFF;
-    uint8_t f2 = (s >> 16) & 0xFF;
-    uint8_t f1 = (s >>  8) & 0xFF;
-    uint8_t f0 = (s >>  0) & 0xFF;
-    Si446x_setProperty32(radio, Si446x_MODEM_TX_NCO_MODE, f3, f2, f1, f0);
-
-    // Setup the NCO data rate for 2GFSK
-    Si446x_setProperty24(radio, Si446x_MODEM_DATA_RATE,
-                         (uint8_t)(speed >> 16),
-                         (uint8_t)(speed >> 8), (uint8_t)speed);
+    /* Keep SPI started for the sequence of commands. */
+    Si446x_beginSequence(radio);
 
-    // Use 2GFSK from FIFO (PH)
-    Si446x_setProperty8(radio, Si446x_MODEM_MOD_TYPE, 0x03);
-
-    /* Set PH bit order for 2FSK. */
-    Si446x_setProperty8(radio, Si446x_PKT_CONFIG1, 0x01);
-
-    // Set 2GFSK filter (default per Si).
-    const uint8_t coeff[] = {0x01, 0x03, 0x08, 0x11, 0x21, 0x36, 0x4d, 0x60, 0x67};
-    uint8_t i;
-    for(i = 0; i < sizeof(coeff); i++) {
-        uint8_t msg[] = {0x11, 0x20, 0x01, 0x17-i, coeff[i]};
-        Si446x_write(radio, msg, sizeof(msg));
-    }
+    /*
+     * Setup the NCO data rate for 2GFSK and the NCO modulo and oversampling
+     * mode. These are contiguous so are sent as one run.
+     */
+    uint32_t s = Si446x_CCLK / 10;
+    const uint8_t rate_nco[] = {(uint8_t)(speed >> 16),
+                                (uint8_t)(speed >> 8),
+                                (uint8_t)speed,
+                                (s >> 24) & 0xFF,
+                                (s >> 16) & 0xFF,
+                                (s >>  8) & 0xFF,
+                                (s >>  0) & 0xFF};
+    Si446x_setPropertyRun(radio, Si446x_MODEM_DATA_RATE, rate_nco,
+                          sizeof(rate_nco));
+
+    /* Modulation and filter. Only changes are sent. */
+    Si446x_setProperties(radio, Si446x_2fsk_tx_props,
+                         sizeof(Si446x_2fsk_tx_props)
+                         / sizeof(Si446x_2fsk_tx_props[0]));
+    Si446x_endSequence(radio);
 }
 
 
@@ -941,6 +1327,9 @@ void Si446x_radioShutdown(const radio_unit_t radio) {
   TRACE_INFO("SI   > Disable radio %i", radio);
   packet_svc_t *handler = pktGetServiceObject(radio);
 
+#if Si446x_USE_CTS_GPIO == TRUE
+  Si446x_disableCTSGPIO(radio);
+#endif
   palSetLine(Si446x_getConfig(radio)->sdn);
   handler->radio_init = false;
   chThdSleep(TIME_MS2I(1));
@@ -951,23 +1340,114 @@ void Si446x_radioShutdown(const radio_unit_t radio) {
  */
 
 
+/*
+ * NIRQ line callback saved while the driver borrows the line for CCA
+ * timing or the TX FIFO interrupt.
+ */
+typedef struct {
+  palcallback_t     cb;
+  void              *arg;
+} si446x_nirq_save_t;
+
 /**
- * Get CCA over measurement interval.
- * Algorithm counts CCA pulses per millisecond (in systick time slices).
- * If more than one pulse per millisecond is counted then CCA is not true.
+ * Disable NIRQ line events and save the line callback.
+ */
+static void Si446x_saveNIRQ(const radio_unit_t radio,
+                            si446x_nirq_save_t *save) {
+  ioline_t line = Si446x_getConfig(radio)->nirq;
+
+  palDisableLineEvent(line);
+  chSysLock();
+  palevent_t *pep = pal_lld_get_line_event(line);
+  save->cb = pep->cb;
+  save->arg = pep->arg;
+  chSysUnlock();
+}
+
+/**
+ * Restore the saved NIRQ line callback.
+ * Edge events are re-enabled only if receive has them enabled.
+ */
+static void Si446x_restoreNIRQ(const radio_unit_t radio,
+                               const si446x_nirq_save_t *save) {
+  ioline_t line = Si446x_getConfig(radio)->nirq;
+
+  palDisableLineEvent(line);
+  palSetLineCallback(line, save->cb, save->arg);
+  if(Si446x_getData(radio)->nirq_events)
+    palEnableLineEvent(line, PAL_EVENT_MODE_BOTH_EDGES);
+}
+
+/*
+ * CCA high time accumulated from NIRQ edges.
+ */
+typedef struct {
+  ioline_t          line;
+  bool              high;
+  rtcnt_t           last;
+  rtcnt_t           busy;
+} si446x_cca_meter_t;
+
+/**
+ * NIRQ edge while measuring CCA. Add the high time which just ended.
+ * The line level is read so a missed edge is corrected on the next one.
+ */
+static void Si446x_CCAEdgeCallback(void *arg) {
+  si446x_cca_meter_t *meter = arg;
+  rtcnt_t now = chSysGetRealtimeCounterX();
+  chSysLockFromISR();
+  if(meter->high)
+    meter->busy += now - meter->last;
+  meter->last = now;
+  meter->high = Si446x_getCCA(meter->line) == PAL_HIGH;
+  chSysUnlockFromISR();
+}
+
+/**
+ * Measure the fraction of time CCA is high over an interval.
+ * CCA edges are timed with the cycle counter so the calling thread sleeps
+ * once for the whole interval. NIRQ is restored as receive had it after.
+ *
+ * @return  busy time in 1/1000 of the interval.
+ */
+static uint16_t Si446x_measureCCA(const radio_unit_t radio, uint8_t ms) {
+  ioline_t line = Si446x_getConfig(radio)->nirq;
+  si446x_cca_meter_t meter = {.line = line};
+  si446x_nirq_save_t save;
+
+  Si446x_saveNIRQ(radio, &save);
+  palSetLineCallback(line, Si446x_CCAEdgeCallback, &meter);
+
+  chSysLock();
+  rtcnt_t start = chSysGetRealtimeCounterX();
+  meter.last = start;
+  meter.high = Si446x_getCCA(line) == PAL_HIGH;
+  palEnableLineEventI(line, PAL_EVENT_MODE_BOTH_EDGES);
+  chSysUnlock();
+
+  chThdSleep(TIME_MS2I(ms));
+
+  chSysLock();
+  palDisableLineEventI(line);
+  rtcnt_t now = chSysGetRealtimeCounterX();
+  if(meter.high)
+    meter.busy += now - meter.last;
+  chSysUnlock();
+
+  Si446x_restoreNIRQ(radio, &save);
+
+  rtcnt_t window = now - start;
+  if(window == 0)
+    return 0;
+  return (uint16_t)(((uint64_t)meter.busy * 1000) / window);
+}
+
+/**
+ * Check if the channel is busy over the measurement interval.
+ * The channel is busy if CCA is high for more than Si446x_CCA_BUSY_LIMIT.
  */
 static bool Si446x_checkCCAthreshold(const radio_unit_t radio, uint8_t ms) {
-  /* Get the CCA line. */
-  ioline_t cca_line = Si446x_getConfig(radio)->nirq;
-  uint16_t cca = 0;
-  /* Measure sliced CCA instances in period. */
-  for(uint16_t i = 0; i < (ms * TIME_MS2I(1)); i++) {
-    cca += Si446x_getCCA(cca_line);
-    /* Sleep one tick. */
-    chThdSleep(1);
-  }
-  /* Return result. */
-  return cca > ms;
+  return Si446x_measureCCA(radio, ms) > Si446x_CCA_BUSY_LIMIT;
 }
 
 /**
@@ -1091,6 +1571,8 @@ bool Si446x_receiveNoLock(const radio_unit_t radio,
   /* Configure radio for modulation type. */
   if(mod == MOD_AFSK) {
       Si446x_setModemAFSK_RX(radio);
+  } else if(mod == MOD_2FSK && PKT_RX_USE_2FSK == TRUE) {
+      Si446x_setModem2FSK_RX(radio, Si446x_2FSK_RX_SPEED);
   } else {
       TRACE_ERROR("SI   > Modulation type not supported in receive");
       TRACE_ERROR("SI   > abort reception");
@@ -1185,32 +1667,90 @@ void Si446x_waitTransmitEnd(const radio_unit_t radio) {
  */
 
 /*
+ * Upsampler lookup tables indexed by [NRZI bit][phase].
+ * A bit of 1 is the 1200Hz tone and 0 the 2200Hz tone.
+ * Each symbol entry holds the SAMPLES_PER_BAUD modulation bits for one baud
+ * (first sample in bit 0) starting from that phase.
  *
+ * The tables give the exact tones. The previous per sample accumulator
+ * truncated its phase steps (11915 and 21845 of 2^17) so its tones ran
+ * 53ppm (1200Hz) and 15ppm (2200Hz) low. Its phase slipped behind the
+ * exact tone by at most 0.33 cycle over a maximum length frame (67584
+ * samples) and its output differs only where that slip moves a sample
+ * across a tone edge. See comms/test/test_si446x.c.
  */
-static uint8_t Si446x_getUpsampledNRZIbits(up_sampler_t *upsampler,
-                                           uint8_t *buf) {
-  uint8_t b = 0;
-  for(uint8_t i = 0; i < 8; i++) {
-    if(upsampler->current_sample_in_baud == 0) {
-      if((upsampler->packet_pos & 7) == 0) { // Load up next byte
-        upsampler->current_byte = buf[upsampler->packet_pos >> 3];
-      } else { // Load up next bit
-        upsampler->current_byte >>= 1;
+static uint16_t afsk_symbol_bits[2][PHASE_STEPS];
+static uint8_t afsk_next_phase[2][PHASE_STEPS];
+static bool afsk_lut_ready = false;
+
+/*
+ * Build the upsampler tables.
+ * The tone output is a square wave, high in the second half of the cycle.
+ */
+static void Si446x_initUpsampler(void) {
+  if(afsk_lut_ready)
+    return;
+  for(uint8_t tone = 0; tone < 2; tone++) {
+    uint8_t delta = tone ? PHASE_DELTA_1200 : PHASE_DELTA_2200;
+    for(uint8_t start = 0; start < PHASE_STEPS; start++) {
+      uint8_t phase = start;
+      uint16_t bits = 0;
+      for(uint8_t i = 0; i < SAMPLES_PER_BAUD; i++) {
+        phase = (phase + delta) % PHASE_STEPS;
+        /* High for phase in (PI, 2PI]. */
+        if(phase == 0 || phase > PHASE_STEPS / 2)
+          bits |= 1 << i;
       }
+      afsk_symbol_bits[tone][start] = bits;
+      afsk_next_phase[tone][start] = phase;
     }
+  }
+  afsk_lut_ready = true;
+}
 
-    // Toggle tone (1200 <> 2200)
-    upsampler->phase_delta = (upsampler->current_byte & 1)
-        ? PHASE_DELTA_1200 : PHASE_DELTA_2200;
-    /* Add delta-phase (position within SAMPLES_PER_BAUD). */
-    upsampler->phase += upsampler->phase_delta;
-    b |= ((upsampler->phase >> 16) & 1) << i;  // Set modulation bit
+/*
+ * Top up the up-sampler NRZI ring from the HDLC encoding iterator.
+ * The iterator writes from the start of the buffer it is given so each
+ * request is limited to the contiguous space up to the end of the ring.
+ * Once encoding has ended the ring is padded with a steady NRZI level.
+ */
+static void Si446x_fillUpsampler(up_sampler_t *upsampler,
+                                 tx_iterator_t *iterator) {
+  uint32_t tail = upsampler->packet_pos >> 3;
+  while((upsampler->ring_head - tail) < AFSK_NRZI_RING_SIZE) {
+    uint16_t index = upsampler->ring_head & AFSK_NRZI_RING_MASK;
+    uint16_t space = AFSK_NRZI_RING_SIZE - (upsampler->ring_head - tail);
+    uint16_t run = AFSK_NRZI_RING_SIZE - index;
+    if(run > space)
+      run = space;
+    uint16_t n = pktStreamEncodingIterator(iterator,
+                                           &upsampler->ring[index], run);
+    if(n < run)
+      /* Encoding has ended. Fill the rest of the ring at steady level. */
+      memset(&upsampler->ring[index + n], 0, run - n);
+    upsampler->ring_head += run;
+  }
+}
 
-    if(++upsampler->current_sample_in_baud == SAMPLES_PER_BAUD) {
-      upsampler->current_sample_in_baud = 0;
-      upsampler->packet_pos++;
-    }
+/*
+ * Get the next byte of upsampled AFSK modulation.
+ * Whole symbols are taken from the lookup table and packed into bytes.
+ * Phase carries across symbols so tone changes are continuous.
+ */
+static uint8_t Si446x_getUpsampledNRZIbits(up_sampler_t *upsampler) {
+  while(upsampler->bit_count < 8) {
+    uint8_t byte = upsampler->ring[(upsampler->packet_pos >> 3)
+                                   & AFSK_NRZI_RING_MASK];
+    uint8_t bit = (byte >> (upsampler->packet_pos & 7)) & 1;
+    upsampler->packet_pos++;
+    upsampler->bits |= (uint32_t)afsk_symbol_bits[bit][upsampler->phase]
+                                                  << upsampler->bit_count;
+    upsampler->phase = afsk_next_phase[bit][upsampler->phase];
+    upsampler->bit_count += SAMPLES_PER_BAUD;
   }
+  uint8_t b = upsampler->bits;
+  upsampler->bits >>= 8;
+  upsampler->bit_count -= 8;
   return b;
 }
 
@@ -1224,10 +1764,93 @@ static void Si446x_transmitTimeoutI(thread_t *tp) {
   chSysUnlockFromISR();
 }
 
+#if Si446x_USE_TX_FIFO_IRQ == TRUE
+/* Free FIFO level above which the feeder is considered late. */
+#define Si446x_TX_FIFO_LATE(size)   (((size) + Si446x_TX_FIFO_THRESHOLD) / 2)
+
+/*
+ * Poll interval used if the interrupt is missed.
+ * Half the threshold worth of data remains in the FIFO when it expires.
+ */
+#define Si446x_TX_FIFO_POLL(byte_us)                                         \
+  chTimeUS2I((byte_us) * (Si446x_FIFO_COMBINED_SIZE                          \
+                          - Si446x_TX_FIFO_THRESHOLD / 2))
+
+/**
+ * NIRQ falling edge. Wake the feeder thread to refill the TX FIFO.
+ */
+static void Si446x_TXFIFOCallback(void *arg) {
+  chSysLockFromISR();
+  chEvtSignalI((thread_t *)arg, SI446X_EVT_TX_FIFO);
+  chSysUnlockFromISR();
+}
+
+/**
+ * Clear a pending TX FIFO almost empty interrupt which releases NIRQ.
+ * Other pending interrupts are left intact.
+ */
+static void Si446x_clearTXFIFOInterrupt(const radio_unit_t radio) {
+  const uint8_t clear_int[] = {Si446x_GET_INT_STATUS, 0xFD, 0xFF, 0xFF};
+  Si446x_write(radio, clear_int, sizeof(clear_int));
+}
+
+/**
+ * Switch NIRQ from CCA output to the TX FIFO almost empty interrupt.
+ * The interrupt is raised when Si446x_TX_FIFO_THRESHOLD bytes are free.
+ * The CCA line callback is saved and the calling thread is signalled instead.
+ * Must be called after CCA for the transmission has completed.
+ */
+static void Si446x_enableTXFIFOInterrupt(const radio_unit_t radio,
+                                         si446x_nirq_save_t *save) {
+  ioline_t line = Si446x_getConfig(radio)->nirq;
+
+  Si446x_saveNIRQ(radio, save);
+
+  Si446x_setProperty8(radio, Si446x_PKT_TX_THRESHOLD,
+                      Si446x_TX_FIFO_THRESHOLD);
+  /* TX_FIFO_ALMOST_EMPTY only in the packet handler group. */
+  Si446x_setProperty8(radio, Si446x_INT_CTL_PH_ENABLE, 0x02);
+  Si446x_setProperty8(radio, Si446x_INT_CTL_ENABLE, 0x01);
+  Si446x_clearTXFIFOInterrupt(radio);
+
+  /* NIRQ_MODE = NIRQ. Other pins unchanged. */
+  const uint8_t gpio_nirq[] = {Si446x_GPIO_PIN_CFG, 0x00, 0x00, 0x00, 0x00,
+                               0x27, 0x00, 0x00};
+  Si446x_write(radio, gpio_nirq, sizeof(gpio_nirq));
+
+  palSetLineCallback(line, Si446x_TXFIFOCallback, chThdGetSelfX());
+  palEnableLineEvent(line, PAL_EVENT_MODE_FALLING_EDGE);
+}
+
+/**
+ * Return NIRQ to CCA output and restore the saved line callback.
+ * CCA edge events are re-enabled if receive had them enabled.
+ */
+static void Si446x_disableTXFIFOInterrupt(const radio_unit_t radio,
+                                          const si446x_nirq_save_t *save) {
+  ioline_t line = Si446x_getConfig(radio)->nirq;
+
+  palDisableLineEvent(line);
+
+  /* Disable interrupts globally. NIRQ pin is used for CCA. */
+  Si446x_setProperty8(radio, Si446x_INT_CTL_ENABLE, 0x00);
+  Si446x_clearTXFIFOInterrupt(radio);
+
+  /* NIRQ_MODE = CCA. Other pins unchanged. */
+  const uint8_t gpio_cca[] = {Si446x_GPIO_PIN_CFG, 0x00, 0x00, 0x00, 0x00,
+                              0x1B, 0x00, 0x00};
+  Si446x_write(radio, gpio_cca, sizeof(gpio_cca));
+
+  Si446x_restoreNIRQ(radio, save);
+}
+#else
+#define Si446x_TX_FIFO_LATE(size)   ((size) / 2)
+#endif /* Si446x_USE_TX_FIFO_IRQ == TRUE */
+
 /*
  * Simple AFSK send thread with minimized buffering and burst send capability.
- * Uses an iterator to size NRZI output and allocate suitable size buffer.
- *
+ * NRZI data is encoded on demand into a small ring as the FIFO drains.
+ * Memory use is constant regardless of frame or burst length.
  */
 THD_FUNCTION(bloc_si_fifo_feeder_afsk, arg) {
   radio_task_object_t *rto = arg;
@@ -1291,7 +1914,11 @@ THD_FUNCTION(bloc_si_fifo_feeder_afsk, arg) {
      */
     pktStreamIteratorInit(&iterator, pp, 30, 10, 10, false);
 
-    uint16_t all = pktStreamEncodingIterator(&iterator, NULL, 0);
+    /*
+     * The transmit length is the exact stream length.
+     * It is counted without encoding so key up does not wait for the frame.
+     */
+    uint16_t all = pktStreamEncodingLength(&iterator);
 
     if(all == 0) {
       /* Nothing encoded. Release packet send object. */
@@ -1311,17 +1938,15 @@ THD_FUNCTION(bloc_si_fifo_feeder_afsk, arg) {
       chThdExit(MSG_ERROR);
       /* We never arrive here. */
     }
-    /* Allocate buffer and perform NRZI encoding. */
-    uint8_t layer0[all];
-    pktStreamEncodingIterator(&iterator, layer0, all);
 
     all *= SAMPLES_PER_BAUD;
     /* Reset TX FIFO in case some remnant unsent data is left there. */
     const uint8_t reset_fifo[] = {0x15, 0x01};
     Si446x_write(radio, reset_fifo, 2);
 
+    /* NRZI encoding is pulled from the iterator as the FIFO is loaded. */
     up_sampler_t upsampler = {0};
-    upsampler.phase_delta = PHASE_DELTA_1200;
+    Si446x_initUpsampler();
 
     /* Maximum amount of FIFO data when using combined TX+RX (safe size). */
     uint8_t localBuffer[Si446x_FIFO_COMBINED_SIZE];
@@ -1343,8 +1968,9 @@ THD_FUNCTION(bloc_si_fifo_feeder_afsk, arg) {
     exit_msg = MSG_OK;
 
     /* Initial FIFO load. */
+    Si446x_fillUpsampler(&upsampler, &iterator);
     for(uint16_t i = 0;  i < c; i++)
-      localBuffer[i] = Si446x_getUpsampledNRZIbits(&upsampler, layer0);
+      localBuffer[i] = Si446x_getUpsampledNRZIbits(&upsampler);
     Si446x_writeFIFO(radio, localBuffer, c);
 
     uint8_t lower = 0;
@@ -1358,6 +1984,10 @@ THD_FUNCTION(bloc_si_fifo_feeder_afsk, arg) {
                        all,
                        rssi,
                        TIME_S2I(10))) {
+#if Si446x_USE_TX_FIFO_IRQ == TRUE
+      si446x_nirq_save_t nirq;
+      Si446x_enableTXFIFOInterrupt(radio, &nirq);
+#endif
 
       /* Feed the FIFO while data remains to be sent. */
       while((all - c) > 0) {
@@ -1370,11 +2000,22 @@ THD_FUNCTION(bloc_si_fifo_feeder_afsk, arg) {
         more = (more > (all - c)) ? (all - c) : more;
 
         /* Load the FIFO. */
+        Si446x_fillUpsampler(&upsampler, &iterator);
         for(uint16_t i = 0; i < more; i++)
-          localBuffer[i] = Si446x_getUpsampledNRZIbits(&upsampler, layer0);
+          localBuffer[i] = Si446x_getUpsampledNRZIbits(&upsampler);
         Si446x_writeFIFO(radio, localBuffer, more); // Write into FIFO
         c += more;
 
+#if Si446x_USE_TX_FIFO_IRQ == TRUE
+        /*
+         * Re-arm the almost empty interrupt and wait for it.
+         * If the interrupt is missed the FIFO is polled before it drains.
+         */
+        Si446x_clearTXFIFOInterrupt(radio);
+        eventmask_t evt = chEvtWaitAnyTimeout(SI446X_EVT_TX_TIMEOUT
+                                              | SI446X_EVT_TX_FIFO,
+                        Si446x_TX_FIFO_POLL(833 * 8 / SAMPLES_PER_BAUD));
+#else
         /*
          * Wait for a timeout event during up-sampled NRZI send.
          * Time delay allows ~SAMPLES_PER_BAUD bytes to be consumed from FIFO.
@@ -1382,13 +2023,17 @@ THD_FUNCTION(bloc_si_fifo_feeder_afsk, arg) {
          */
         eventmask_t evt = chEvtWaitAnyTimeout(SI446X_EVT_TX_TIMEOUT,
                                               chTimeUS2I(833 * 8));
-        if(evt) {
+#endif
+        if(evt & SI446X_EVT_TX_TIMEOUT) {
           /* Force 446x out of TX state. */
           Si446x_setReadyState(radio);
           exit_msg = MSG_TIMEOUT;
           break;
         }
       }
+#if Si446x_USE_TX_FIFO_IRQ == TRUE
+      Si446x_disableTXFIFOInterrupt(radio, &nirq);
+#endif
     } else {
       /* Transmit start failed. */
       TRACE_ERROR("SI   > Transmit start failed");
@@ -1410,9 +2055,9 @@ THD_FUNCTION(bloc_si_fifo_feeder_afsk, arg) {
     /* No CCA on subsequent packet sends. */
     rssi = PKT_SI446X_NO_CCA_RSSI;
 
-    if(lower > (free / 2)) {
+    if(lower > Si446x_TX_FIFO_LATE(free)) {
       /*
-       *  Warn when free level is more than 50% of FIFO size.
+       *  Warn when free level shows the FIFO was refilled late.
        *  This means the FIFO is not being filled fast enough.
        */
       TRACE_WARN("SI   > AFSK TX FIFO dropped below safe threshold %i", lower);
@@ -1613,6 +2258,10 @@ THD_FUNCTION(bloc_si_fifo_feeder_fsk, arg) {
                        all,
                        rssi,
                        TIME_S2I(10))) {
+#if Si446x_USE_TX_FIFO_IRQ == TRUE
+      si446x_nirq_save_t nirq;
+      Si446x_enableTXFIFOInterrupt(radio, &nirq);
+#endif
       /* Feed the FIFO while data remains to be sent. */
       while((all - c) > 0) {
         /* Get TX FIFO free count. */
@@ -1628,6 +2277,16 @@ THD_FUNCTION(bloc_si_fifo_feeder_fsk, arg) {
         bufp += more;
         c += more;
 
+#if Si446x_USE_TX_FIFO_IRQ == TRUE
+        /*
+         * Re-arm the almost empty interrupt and wait for it.
+         * If the interrupt is missed the FIFO is polled before it drains.
+         */
+        Si446x_clearTXFIFOInterrupt(radio);
+        eventmask_t evt = chEvtWaitAnyTimeout(SI446X_EVT_TX_TIMEOUT
+                                              | SI446X_EVT_TX_FIFO,
+                                              Si446x_TX_FIFO_POLL(104 * 8));
+#else
         /*
          * Wait for a timeout event during up-sampled NRZI send.
          * Time delay allows ~10 bytes to be consumed from FIFO.
@@ -1635,13 +2294,17 @@ THD_FUNCTION(bloc_si_fifo_feeder_fsk, arg) {
          */
         eventmask_t evt = chEvtWaitAnyTimeout(SI446X_EVT_TX_TIMEOUT,
                                               chTimeUS2I(104 * 8 * 10));
-        if(evt) {
+#endif
+        if(evt & SI446X_EVT_TX_TIMEOUT) {
           /* Force 446x out of TX state. */
           Si446x_setReadyState(radio);
           exit_msg = MSG_TIMEOUT;
           break;
         }
       }
+#if Si446x_USE_TX_FIFO_IRQ == TRUE
+      Si446x_disableTXFIFOInterrupt(radio, &nirq);
+#endif
     } else {
       /* Transmit start failed. */
       TRACE_ERROR("SI   > 2FSK transmit start failed");
@@ -1663,8 +2326,8 @@ THD_FUNCTION(bloc_si_fifo_feeder_fsk, arg) {
     /* No CCA on subsequent packet sends. */
     rssi = PKT_SI446X_NO_CCA_RSSI;
 
-    if(lower > (free / 2)) {
-      /* Warn when free level is > 50% of FIFO size. */
+    if(lower > Si446x_TX_FIFO_LATE(free)) {
+      /* Warn when free level shows the FIFO was refilled late. */
       TRACE_WARN("SI   > AFSK TX FIFO dropped below safe threshold %i", lower);
     }
     /* Get the next linked packet to send. */
@@ -1779,6 +2442,7 @@ const ICUConfig *Si446x_enablePWMevents(const radio_unit_t radio,
   /* Enabling events on both edges of CCA.*/
   palEnableLineEvent(Si446x_getConfig(radio)->nirq,
                      PAL_EVENT_MODE_BOTH_EDGES);
+  Si446x_getData(radio)->nirq_events = true;
 
   return &Si446x_getConfig(radio)->cfg;
 }
@@ -1787,6 +2451,7 @@ const ICUConfig *Si446x_enablePWMevents(const radio_unit_t radio,
  *
  */
 void Si446x_disablePWMevents(radio_unit_t radio) {
+  Si446x_getData(radio)->nirq_events = false;
   palDisableLineEvent(Si446x_getConfig(radio)->nirq);
 }
 /**
@@ -16,9 +16,54 @@
 /*===========================================================================*/
 
 #define SI446X_EVT_TX_TIMEOUT                   EVENT_MASK(0)
+#define SI446X_EVT_TX_FIFO                      EVENT_MASK(1)
 
 #define Si446x_LOCK_BY_SEMAPHORE                TRUE
 
+/*
+ * Refill the TX FIFO when the TX_FIFO_ALMOST_EMPTY interrupt is raised on
+ * NIRQ. When FALSE the feeders poll the FIFO on a fixed schedule.
+ */
+#if !defined(Si446x_USE_TX_FIFO_IRQ)
+#define Si446x_USE_TX_FIFO_IRQ                  TRUE
+#endif
+
+/* Free TX FIFO bytes at which the almost empty interrupt is raised. */
+#define Si446x_TX_FIFO_THRESHOLD                64
+
+/*
+ * Wait for command CTS on radio GPIO0 using an edge event instead of
+ * sleeping between READ_CMD_BUFF polls. GPIO1 is CTS only until init as it
+ * then carries RAW_RX_DATA to the ICU. So GPIO0 is set to output CTS.
+ */
+#if !defined(Si446x_USE_CTS_GPIO)
+#define Si446x_USE_CTS_GPIO                     TRUE
+#endif
+
+/* CTS line reads before waiting for the edge. Most commands finish here. */
+#define Si446x_CTS_SPIN                         64
+
+/* Shadowed property bytes (sum of group sizes in the driver table). */
+#define Si446x_PROP_SHADOW_SIZE                 182
+
+/* Maximum property values in one SET_PROPERTY command. */
+#define Si446x_PROP_MAX_WRITE                   12
+
+/*
+ * Channel busy limit for CCA in 1/1000 of the measurement window.
+ * CCA high time is taken from NIRQ edges timed by the cycle counter.
+ */
+#define Si446x_CCA_BUSY_LIMIT                   100
+
+/* 2FSK receive data rate (G3RUH). */
+#define Si446x_2FSK_RX_SPEED                    9600
+
+/* Crystal to modem sample rate divider with the RX decimation in use. */
+#define Si446x_RX_SAMPLE_DIV                    384
+
+/* Bytes of the BCR OSR, NCO offset and gain property run. */
+#define Si446x_BCR_RUN_SIZE                     7
+
 /* Si4464 States. */
 #define Si446x_STATE_NOCHANGE                   0
 #define Si446x_STATE_SLEEP                      1
@@ -68,6 +113,7 @@
 #define Si446x_GLOBAL_CONFIG                    0x0003
 
 #define Si446x_INT_CTL_ENABLE                   0x0100
+#define Si446x_INT_CTL_PH_ENABLE                0x0101
 #define Si446x_INT_CTL_MODEM_ENABLE             0x0102
 
 #define Si446x_FRR_CTL_A_MODE                   0x0200
@@ -86,6 +132,7 @@
 #define Si446x_SYNC_CONFIG                      0x1100
 
 #define Si446x_PKT_CONFIG1                      0x1206
+#define Si446x_PKT_TX_THRESHOLD                 0x120B
 #define Si446x_PKT_LEN                          0x1208
 #define Si446x_PKT_LEN_FIELD_SOURCE             0x1209
 
@@ -95,6 +142,8 @@
 #define Si446x_MODEM_DATA_RATE                  0x2003
 #define Si446x_MODEM_TX_NCO_MODE                0x2006
 #define Si446x_MODEM_FREQ_DEV                   0x200A
+#define Si446x_MODEM_TX_FILTER_COEFF_8          0x200F
+#define Si446x_MODEM_TX_FILTER_COEFF_0          0x2017
 #define Si446x_MODEM_TX_RAMP_DELAY              0x2018
 #define Si446x_MODEM_MDM_CTRL                   0x2019
 #define Si446x_MODEM_IF_CONTROL                 0x201A
@@ -214,8 +263,19 @@
 #define PLAYBACK_RATE       13200
 #define BAUD_RATE           1200                                    /* APRS AFSK baudrate */
 #define SAMPLES_PER_BAUD    (PLAYBACK_RATE / BAUD_RATE)             /* Samples per baud (13200Hz / 1200baud = 11samp/baud) */
-#define PHASE_DELTA_1200    (((2 * 1200) << 16) / PLAYBACK_RATE)    /* Delta-phase per sample for 1200Hz tone */
-#define PHASE_DELTA_2200    (((2 * 2200) << 16) / PLAYBACK_RATE)    /* Delta-phase per sample for 2200Hz tone */
+/*
+ * Tone phase resolution. Both tones advance a whole number of steps per sample.
+ * 1200Hz = 6 and 2200Hz = 11 steps per sample of a 66 step cycle at 13200Hz.
+ */
+#define PHASE_STEPS         66
+#define PHASE_DELTA_1200    ((PHASE_STEPS * 1200) / PLAYBACK_RATE)  /* Delta-phase per sample for 1200Hz tone */
+#define PHASE_DELTA_2200    ((PHASE_STEPS * 2200) / PLAYBACK_RATE)  /* Delta-phase per sample for 2200Hz tone */
+/*
+ * NRZI bytes held ahead of the up-sampler. Must be a power of 2.
+ * 32 bytes up-sample to 352 FIFO bytes which covers a full FIFO load.
+ */
+#define AFSK_NRZI_RING_SIZE 32
+#define AFSK_NRZI_RING_MASK (AFSK_NRZI_RING_SIZE - 1)
 
 /*===========================================================================*/
 /* Module macros.                                                            */
@@ -239,11 +299,12 @@
 /*===========================================================================*/
 
 typedef struct {
-  uint32_t  phase_delta;            // 1200/2200 for standard AX.25
-  uint32_t  phase;                  // Fixed point 9.7 (2PI = TABLE_SIZE)
-  uint32_t  packet_pos;             // Index of next bit to be sent out
-  uint32_t  current_sample_in_baud; // 1 bit = SAMPLES_PER_BAUD samples
-  uint8_t   current_byte;
+  uint8_t   ring[AFSK_NRZI_RING_SIZE]; // NRZI bytes from the HDLC iterator
+  uint32_t  ring_head;              // Free running count of NRZI bytes encoded
+  uint32_t  packet_pos;             // Index of next NRZI bit to be sent out
+  uint32_t  bits;                   // Upsampled bits not yet output
+  uint8_t   bit_count;              // Number of valid bits in bits
+  uint8_t   phase;                  // Tone phase (0..PHASE_STEPS-1)
 } up_sampler_t;
 
 /* MCU IO configuration for a specific radio. */
@@ -287,8 +348,21 @@ typedef struct {
 /* Data associated with a specific radio. */
 typedef struct Si446x_DAT {
   si446x_temp_t lastTemp;
+  thread_t      *spi_owner;         /* Thread holding a command sequence. */
+  uint8_t       spi_depth;          /* Command sequence nesting. */
+  bool          cts_gpio;           /* GPIO0 is outputting CTS. */
+  thread_reference_t cts_wait;      /* Thread waiting for the CTS edge. */
+  bool          nirq_events;        /* NIRQ CCA edge events enabled. */
+  uint8_t       prop_shadow[Si446x_PROP_SHADOW_SIZE];
+  uint8_t       prop_valid[(Si446x_PROP_SHADOW_SIZE + 7) / 8];
 } si446x_data_t;
 
+/* Property value for a static property list. */
+typedef struct {
+  uint16_t      prop;               /* Property 0xGGNN. */
+  uint8_t       value;
+} si446x_prop_t;
+
 /* External. */
 typedef struct radioTask radio_task_object_t;
 
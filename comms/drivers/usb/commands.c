@@ -10,6 +10,7 @@
 #include "commands.h"
 #include "pflash.h"
 #include "ublox.h"
+#include "usb.h"
 #include <string.h>
 #include <time.h>
 
@@ -31,6 +32,7 @@ const ShellCommand commands[] = {
     {"error_list", usb_cmd_get_error_list},
     {"time", usb_cmd_time},
     {"radio", usb_cmd_radio},
+    {"kiss", usb_cmd_kiss},
 	{NULL, NULL}
 };
 
@@ -301,14 +303,7 @@ void usb_cmd_get_error_list(BaseSequentialStream *chp, int argc, char *argv[])
 	(void)argc;
 	(void)argv;
 
-	uint8_t cntr = 0;
-	for(uint8_t i=0; i<ERROR_LIST_SIZE; i++)
-	{
-		if(strlen((char*)error_list[i]) > 0) {
-			chprintf(chp, "%s\r\n", error_list[i]);
-			cntr++;
-		}
-	}
+	uint8_t cntr = debug_print_errors(chp);
 
 	if(!cntr) {
 		chprintf(chp, "No errors recorded\r\n");
@@ -393,3 +388,19 @@ void usb_cmd_radio(BaseSequentialStream *chp, int argc, char *argv[]) {
                    radio, handler->radio_part,
                    handler->radio_rom_rev, handler->radio_patch);
 }
+
+/*
+ * Leave the shell and bridge the USB channel as a KISS TNC.
+ * The host sends FEND 0xFF FEND to return to trace output.
+ */
+void usb_cmd_kiss(BaseSequentialStream *chp, int argc, char *argv[]) {
+  (void)argv;
+
+  if(argc > 0) {
+    shellUsage(chp, "kiss");
+    return;
+  }
+  chprintf(chp, "Entering KISS mode, send C0 FF C0 to exit\r\n");
+  pktRequestKISSMode();
+  shellExit(MSG_OK);
+}
@@ -16,6 +16,7 @@ void usb_cmd_get_gps_sat_info(BaseSequentialStream *chp, int argc, char *argv[])
 void usb_cmd_get_error_list(BaseSequentialStream *chp, int argc, char *argv[]);
 void usb_cmd_time(BaseSequentialStream *chp, int argc, char *argv[]);
 void usb_cmd_radio(BaseSequentialStream *chp, int argc, char *argv[]);
+void usb_cmd_kiss(BaseSequentialStream *chp, int argc, char *argv[]);
 
 extern const ShellCommand commands[];
 
@@ -5,8 +5,9 @@
 
 mutex_t mtx; // Used internal to synchronize multiple chprintf in debug.h
 
-char error_list[ERROR_LIST_SIZE][ERROR_LIST_LENGTH];
-uint8_t error_counter;
+static error_record_t error_list[ERROR_LIST_SIZE];
+static uint8_t error_counter;
+static MUTEX_DECL(error_mtx);
 
 static const SerialConfig debug_config = {
 	115200,
@@ -21,6 +22,12 @@ uint8_t usb_trace_level = USB_TRACE_LEVEL; // Set in makefile UDEFS
 uint8_t usb_trace_level = 2; // Level: Errors + Warnings
 #endif
 
+#ifdef SERIAL_TRACE_LEVEL
+uint8_t serial_trace_level = SERIAL_TRACE_LEVEL; // Set in makefile UDEFS
+#else
+uint8_t serial_trace_level = 2; // Level: Errors + Warnings
+#endif
+
 
 void debug_init(void) {
 	chMtxObjectInit(&mtx);
@@ -30,19 +37,34 @@ void debug_init(void) {
 	palSetLineMode(LINE_IO_RXD, PAL_MODE_ALTERNATE(7));
 }
 
-void debug_print(char *type, char* filename, uint32_t line, char* format, ...)
+/**
+ * Check if a trace consumer wants output at a level.
+ * The serial debug port has its own level so raising the USB level does not
+ * cause formatting while no USB console is connected.
+ */
+bool debug_output_active(uint8_t level) {
+	return serial_trace_level > level
+			|| (usb_trace_level > level && isConsoleOutputAvailable());
+}
+
+void debug_print(uint8_t level, char *type, char* filename, uint32_t line, char* format, ...)
 {
+	bool usb = usb_trace_level > level && isConsoleOutputAvailable();
+	bool serial = serial_trace_level > level;
+	if(!usb && !serial)
+		return;
+
 	chMtxLock(&mtx);
 
 	uint8_t str[256];
 
 	va_list args;
 	va_start(args, format);
-	chsnprintf((char*)str, sizeof(str), format, args);
+	chvsnprintf((char*)str, sizeof(str), format, args);
 	va_end(args);
 
 
-	if(isConsoleOutputAvailable()) {
+	if(usb) {
 		if(TRACE_TIME) {
 			chprintf((BaseSequentialStream*)&SDU1, "[%8d.%03d]", chVTGetSystemTime()/CH_CFG_ST_FREQUENCY, (chVTGetSystemTime()*1000/CH_CFG_ST_FREQUENCY)%1000);
 		}
@@ -53,15 +75,208 @@ void debug_print(char *type, char* filename, uint32_t line, char* format, ...)
 		chprintf((BaseSequentialStream*)&SDU1, " %s\r\n", str);
 	}
 
-	if(TRACE_TIME) {
-		chprintf((BaseSequentialStream*)&SD3, "[%8d.%03d]", chVTGetSystemTime()/CH_CFG_ST_FREQUENCY, (chVTGetSystemTime()*1000/CH_CFG_ST_FREQUENCY)%1000);
-	}
-	chprintf((BaseSequentialStream*)&SD3, "[%s]", type);
-	if(TRACE_FILE) {
-		chprintf((BaseSequentialStream*)&SD3, "[%12s %04d]", filename, line);
+	if(serial) {
+		if(TRACE_TIME) {
+			chprintf((BaseSequentialStream*)&SD3, "[%8d.%03d]", chVTGetSystemTime()/CH_CFG_ST_FREQUENCY, (chVTGetSystemTime()*1000/CH_CFG_ST_FREQUENCY)%1000);
+		}
+		chprintf((BaseSequentialStream*)&SD3, "[%s]", type);
+		if(TRACE_FILE) {
+			chprintf((BaseSequentialStream*)&SD3, "[%12s %04d]", filename, line);
+		}
+		chprintf((BaseSequentialStream*)&SD3, " %s\r\n", str);
 	}
-	chprintf((BaseSequentialStream*)&SD3, " %s\r\n", str);
 
 	chMtxUnlock(&mtx);
 }
 
+/**
+ * Skip flags, width, precision and length of a conversion specification.
+ * Returns pointer to the conversion character.
+ * Each '*' takes an int argument which is counted in stars.
+ */
+static const char *debug_skip_spec(const char *p, uint8_t *stars) {
+	*stars = 0;
+	while(*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0'
+			|| *p == '.' || *p == '*' || (*p >= '0' && *p <= '9')
+			|| *p == 'l') {
+		if(*p == '*')
+			(*stars)++;
+		p++;
+	}
+	return p;
+}
+
+/**
+ * Record an error as a binary record.
+ * Only the arguments are captured. Strings are copied (truncated if needed).
+ * Formatting is done when the list is printed.
+ */
+void debug_error_record(const char *file, uint32_t line, const char *format, ...)
+{
+	chMtxLock(&error_mtx);
+	error_record_t *rec = &error_list[error_counter];
+	error_counter = (error_counter+1)%ERROR_LIST_SIZE;
+
+	rec->time = chVTGetSystemTime();
+	rec->file = file;
+	rec->line = line;
+	rec->format = format;
+	rec->len = 0;
+
+	va_list args;
+	va_start(args, format);
+	for(const char *p = format; *p; p++) {
+		if(*p != '%')
+			continue;
+		if(*++p == '%')
+			continue;
+		uint8_t stars;
+		p = debug_skip_spec(p, &stars);
+		if(*p == 0)
+			goto done;
+		/* Width and precision arguments are captured ahead of the value. */
+		for(; stars > 0; stars--) {
+			int32_t w = va_arg(args, int);
+			if(ERROR_ARGS_SIZE - rec->len < sizeof(w))
+				goto done;
+			memcpy(&rec->args[rec->len], &w, sizeof(w));
+			rec->len += sizeof(w);
+		}
+		uint8_t *dst = &rec->args[rec->len];
+		uint8_t room = ERROR_ARGS_SIZE - rec->len;
+		switch(*p) {
+		case 'f':
+		case 'e':
+		case 'g': {
+			float f = (float)va_arg(args, double);
+			if(room < sizeof(f))
+				goto done;
+			memcpy(dst, &f, sizeof(f));
+			rec->len += sizeof(f);
+			break;
+		}
+		case 's': {
+			const char *str = va_arg(args, const char*);
+			if(room == 0)
+				goto done;
+			size_t n = (str == NULL) ? 0 : strnlen(str, room - 1);
+			memcpy(dst, str, n);
+			dst[n] = 0;
+			rec->len += n + 1;
+			break;
+		}
+		default: {
+			/* Integer, character and pointer arguments are 32 bit. */
+			uint32_t v = va_arg(args, uint32_t);
+			if(room < sizeof(v))
+				goto done;
+			memcpy(dst, &v, sizeof(v));
+			rec->len += sizeof(v);
+			break;
+		}
+		}
+	}
+done:
+	va_end(args);
+	chMtxUnlock(&error_mtx);
+}
+
+/**
+ * Format one record by replaying its format with the captured arguments.
+ * Output stops at the first argument which was not captured.
+ */
+static void debug_print_error(BaseSequentialStream *chp, error_record_t *rec)
+{
+	const char *file = strrchr(rec->file, '/') ? strrchr(rec->file, '/') + 1 : rec->file;
+	chprintf(chp, "[%8d.%03d][%12s %04d] ", rec->time/CH_CFG_ST_FREQUENCY,
+	         (rec->time*1000/CH_CFG_ST_FREQUENCY)%1000, file, rec->line);
+
+	uint8_t pos = 0;
+	for(const char *p = rec->format; *p; p++) {
+		if(*p != '%') {
+			streamPut(chp, *p);
+			continue;
+		}
+		if(p[1] == '%') {
+			streamPut(chp, *++p);
+			continue;
+		}
+		/*
+		 * Copy the specification so it can be handed to chprintf.
+		 * Captured '*' arguments are written into the copy as numbers.
+		 */
+		uint8_t stars;
+		const char *end = debug_skip_spec(p + 1, &stars);
+		if(*end == 0)
+			break;
+		char spec[24];
+		size_t n = 0;
+		for(; p <= end && n < sizeof(spec) - 12; p++) {
+			if(*p != '*') {
+				spec[n++] = *p;
+				continue;
+			}
+			int32_t w;
+			if(rec->len - pos < sizeof(w))
+				return;
+			memcpy(&w, &rec->args[pos], sizeof(w));
+			pos += sizeof(w);
+			n += chsnprintf(&spec[n], sizeof(spec) - n, "%d", w);
+		}
+		if(p <= end)
+			return;
+		spec[n] = 0;
+		p = end;
+		switch(*end) {
+		case 'f':
+		case 'e':
+		case 'g': {
+			float f;
+			if(rec->len - pos < sizeof(f))
+				return;
+			memcpy(&f, &rec->args[pos], sizeof(f));
+			pos += sizeof(f);
+			chprintf(chp, spec, f);
+			break;
+		}
+		case 's': {
+			if(pos >= rec->len)
+				return;
+			const char *str = (const char *)&rec->args[pos];
+			pos += strlen(str) + 1;
+			chprintf(chp, spec, str);
+			break;
+		}
+		default: {
+			uint32_t v;
+			if(rec->len - pos < sizeof(v))
+				return;
+			memcpy(&v, &rec->args[pos], sizeof(v));
+			pos += sizeof(v);
+			chprintf(chp, spec, v);
+			break;
+		}
+		}
+	}
+}
+
+/**
+ * Print the error list oldest first.
+ * Returns the number of errors printed.
+ */
+uint8_t debug_print_errors(BaseSequentialStream *chp)
+{
+	uint8_t cntr = 0;
+	chMtxLock(&error_mtx);
+	for(uint8_t i=0; i<ERROR_LIST_SIZE; i++)
+	{
+		error_record_t *rec = &error_list[(error_counter+i)%ERROR_LIST_SIZE];
+		if(rec->format == NULL)
+			continue;
+		debug_print_error(chp, rec);
+		chprintf(chp, "\r\n");
+		cntr++;
+	}
+	chMtxUnlock(&error_mtx);
+	return cntr;
+}
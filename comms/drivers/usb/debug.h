@@ -10,27 +10,45 @@
 #include "usbcfg.h"
 #include "usb.h"
 
-#define ERROR_LIST_LENGTH	64
 #define ERROR_LIST_SIZE		32
+#define ERROR_ARGS_SIZE		24		/* Bytes of captured arguments per record */
 
 #define __FILENAME__ (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILE__)
 
-extern char error_list[ERROR_LIST_SIZE][ERROR_LIST_LENGTH];
-extern uint8_t error_counter;
+/*
+ * Binary error record.
+ * The location and format identify the error. Arguments are captured raw
+ * and only formatted when the error list is printed.
+ */
+typedef struct {
+	systime_t		time;
+	const char		*file;
+	const char		*format;
+	uint16_t		line;
+	uint8_t			len;
+	uint8_t			args[ERROR_ARGS_SIZE];
+} error_record_t;
+
 extern uint8_t usb_trace_level;
+extern uint8_t serial_trace_level;
+
+/*
+ * Tracing at a level is active only if a consumer wants that level: the
+ * serial port at its own level or a connected USB console at the USB level.
+ * Arguments are not evaluated and nothing is formatted otherwise.
+ */
+#define TRACE_ACTIVE(level)	debug_output_active(level)
+#define TRACE_MON_ACTIVE()	TRACE_ACTIVE(2)
 
-#define TRACE_DEBUG(format, args...) if(usb_trace_level > 4) { debug_print("DEBUG", __FILENAME__, __LINE__, format, ##args); }
-#define TRACE_INFO(format, args...)  if(usb_trace_level > 3) { debug_print("     ", __FILENAME__, __LINE__, format, ##args); }
-#define TRACE_MON(format, args...)  if(usb_trace_level > 2) { debug_print("     ", __FILENAME__, __LINE__, format, ##args); }
-#define TRACE_WARN(format, args...)  if(usb_trace_level > 1) { debug_print("WARN ", __FILENAME__, __LINE__, format, ##args); }
+#define TRACE_DEBUG(format, args...) if(TRACE_ACTIVE(4)) { debug_print(4, "DEBUG", __FILENAME__, __LINE__, format, ##args); }
+#define TRACE_INFO(format, args...)  if(TRACE_ACTIVE(3)) { debug_print(3, "     ", __FILENAME__, __LINE__, format, ##args); }
+#define TRACE_MON(format, args...)  if(TRACE_ACTIVE(2)) { debug_print(2, "     ", __FILENAME__, __LINE__, format, ##args); }
+#define TRACE_WARN(format, args...)  if(TRACE_ACTIVE(1)) { debug_print(1, "WARN ", __FILENAME__, __LINE__, format, ##args); }
 #define TRACE_ERROR(format, args...) { \
-	if(usb_trace_level > 0) { \
-		debug_print("ERROR", __FILENAME__, __LINE__, format, ##args); \
+	if(TRACE_ACTIVE(0)) { \
+		debug_print(0, "ERROR", __FILENAME__, __LINE__, format, ##args); \
 	} \
-	\
-	uint8_t strcnt = chsnprintf(error_list[error_counter], ERROR_LIST_LENGTH, "[%8d.%03d] ", chVTGetSystemTime()/CH_CFG_ST_FREQUENCY, (chVTGetSystemTime()*1000/CH_CFG_ST_FREQUENCY)%1000); \
-	chsnprintf(&error_list[error_counter][strcnt], ERROR_LIST_LENGTH-strcnt, (format), ##args); \
-	error_counter = (error_counter+1)%ERROR_LIST_SIZE; \
+	debug_error_record(__FILE__, __LINE__, format, ##args); \
 }
 
 #if TRACE_TIME && TRACE_FILE
@@ -64,7 +82,10 @@ static inline heap_header_t *pktSystemCheck(void) {
 #endif
 
 void debug_init(void);
-void debug_print(char *type, char* filename, uint32_t line, char* format, ...);
+bool debug_output_active(uint8_t level);
+void debug_print(uint8_t level, char *type, char* filename, uint32_t line, char* format, ...);
+void debug_error_record(const char *file, uint32_t line, const char *format, ...);
+uint8_t debug_print_errors(BaseSequentialStream *chp);
 
 #endif /* __TRACE_H__ */
 
@@ -0,0 +1,304 @@
+#include "ch.h"
+#include "hal.h"
+#include "debug.h"
+#include "ax25_pad.h"
+#include "radio.h"
+#include "kiss.h"
+
+/* Bridge thread events. */
+#define KISS_EVT_DATA               EVENT_MASK(0)
+#define KISS_EVT_INPUT              EVENT_MASK(1)
+#define KISS_WRITE_TIMEOUT          TIME_MS2I(100)
+
+#define KISS_RING_MASK              (KISS_RING_SIZE - 1)
+
+typedef struct {
+  bool              in_frame;
+  bool              escape;
+  bool              overrun;
+  size_t            len;
+  uint8_t           frame[AX25_MAX_PACKET_LEN + 1]; /* Command + frame. */
+} kiss_decoder_t;
+
+/*
+ * Single consumer ring. Producers are serialized by the mutex.
+ * Indexes are free running and masked on access.
+ */
+static uint8_t kiss_ring[KISS_RING_SIZE];
+static volatile uint32_t kiss_head;
+static volatile uint32_t kiss_tail;
+static MUTEX_DECL(kiss_mtx);
+
+static kiss_decoder_t kiss_decoder;
+static kiss_stats_t kiss_stats;
+static thread_t *kiss_thd;
+static volatile bool kiss_active;
+
+/* Broadcast when the bridge thread exits. */
+EVENTSOURCE_DECL(kiss_terminated);
+
+/**
+ * @brief   Put a byte in the ring at a working head index.
+ */
+static inline void kissRingPut(uint32_t *head, uint8_t c) {
+  kiss_ring[(*head)++ & KISS_RING_MASK] = c;
+}
+
+/**
+ * @brief   Stop producers from queuing frames or signaling the bridge.
+ */
+static void kissDetach(void) {
+  chMtxLock(&kiss_mtx);
+  kiss_active = false;
+  kiss_thd = NULL;
+  chMtxUnlock(&kiss_mtx);
+}
+
+/**
+ * @brief   Send a frame received from the host on the radio.
+ * @notes   The frame is AX25 without CRC.
+ */
+static void kissTransmitFrame(uint8_t *frame, size_t len) {
+  if(len < AX25_MIN_PACKET_LEN) {
+    kiss_stats.tx_errors++;
+    return;
+  }
+  packet_t pp = ax25_from_frame(frame, len);
+  if(pp == NULL) {
+    kiss_stats.tx_errors++;
+    return;
+  }
+  /* The packet buffer is released by transmit. */
+  if(transmitOnRadio(pp,
+                     conf_sram.aprs.tx.radio_conf.freq,
+                     0,
+                     0,
+                     conf_sram.aprs.tx.radio_conf.pwr,
+                     conf_sram.aprs.tx.radio_conf.mod,
+                     conf_sram.aprs.tx.radio_conf.cca))
+    kiss_stats.tx_frames++;
+  else
+    kiss_stats.tx_errors++;
+}
+
+/**
+ * @brief   Decode one byte of KISS input from the host.
+ *
+ * @return  status of decode
+ * @retval  true    if the host requested exit from KISS mode.
+ */
+static bool kissDecodeByte(kiss_decoder_t *dec, uint8_t c) {
+  if(c == KISS_FEND) {
+    if(dec->in_frame && dec->len > 0 && !dec->overrun) {
+      uint8_t cmd = dec->frame[0];
+      if(cmd == KISS_CMD_RETURN)
+        return true;
+      /* Only data frames are used. TNC parameters are ignored. */
+      if((cmd & 0x0F) == KISS_CMD_DATA)
+        kissTransmitFrame(&dec->frame[1], dec->len - 1);
+    } else if(dec->overrun) {
+      kiss_stats.tx_errors++;
+    }
+    dec->in_frame = true;
+    dec->escape = false;
+    dec->overrun = false;
+    dec->len = 0;
+    return false;
+  }
+  if(!dec->in_frame)
+    return false;
+  if(dec->escape) {
+    dec->escape = false;
+    if(c == KISS_TFEND)
+      c = KISS_FEND;
+    else if(c == KISS_TFESC)
+      c = KISS_FESC;
+  } else if(c == KISS_FESC) {
+    dec->escape = true;
+    return false;
+  }
+  if(dec->len >= sizeof(dec->frame)) {
+    dec->overrun = true;
+    return false;
+  }
+  dec->frame[dec->len++] = c;
+  return false;
+}
+
+/**
+ * @brief   KISS bridge between USB CDC and the packet system.
+ * @notes   Host bound frames are written from the ring in contiguous runs.
+ *          A run spans as many frames as are queued so the serial USB
+ *          buffers fill and go out as full bulk packets.
+ * @notes   When idle the thread waits for channel input or a queued frame.
+ *
+ * @thread
+ */
+static THD_FUNCTION(kissThread, arg) {
+  BaseAsynchronousChannel *chp = arg;
+  event_listener_t in_el;
+  uint8_t in[64];
+  bool exit = false;
+
+  chEvtRegisterMaskWithFlags(chnGetEventSource(chp), &in_el,
+                             KISS_EVT_INPUT, CHN_INPUT_AVAILABLE);
+  while(!exit && !chThdShouldTerminateX()) {
+    bool idle = true;
+
+    /* Host to radio. */
+    size_t n = chnReadTimeout(chp, in, sizeof(in), TIME_IMMEDIATE);
+    if(n > 0) {
+      idle = false;
+      for(size_t i = 0; i < n && !exit; i++)
+        exit = kissDecodeByte(&kiss_decoder, in[i]);
+    }
+
+    /* Radio to host. */
+    uint32_t head = kiss_head;
+    uint32_t tail = kiss_tail;
+    if(head != tail) {
+      idle = false;
+      uint32_t index = tail & KISS_RING_MASK;
+      size_t run = head - tail;
+      if(run > KISS_RING_SIZE - index)
+        run = KISS_RING_SIZE - index;
+      size_t w = chnWriteTimeout(chp, &kiss_ring[index], run,
+                                 KISS_WRITE_TIMEOUT);
+      kiss_tail = tail + w;
+      kiss_stats.rx_bytes += w;
+    }
+
+    if(idle && !exit)
+      (void)chEvtWaitAny(KISS_EVT_DATA | KISS_EVT_INPUT);
+  }
+  chEvtUnregister(chnGetEventSource(chp), &in_el);
+  kissDetach();
+  chSysLock();
+  chEvtBroadcastI(&kiss_terminated);
+  chThdExitS(MSG_OK);
+}
+
+/**
+ * @brief   Start the KISS bridge on a channel.
+ * @notes   The caller must not use the channel until the bridge exits.
+ *
+ * @notes   @p kiss_terminated is broadcast when the bridge exits.
+ *
+ * @param[in] chp   pointer to the channel (SDU1).
+ *
+ * @return  the bridge thread.
+ * @retval  NULL if the thread could not be created.
+ *
+ * @api
+ */
+thread_t *kissStart(BaseAsynchronousChannel *chp) {
+  kiss_head = 0;
+  kiss_tail = 0;
+  memset(&kiss_decoder, 0, sizeof(kiss_decoder));
+  memset(&kiss_stats, 0, sizeof(kiss_stats));
+
+  thread_t *tp = chThdCreateFromHeap(NULL,
+              THD_WORKING_AREA_SIZE(KISS_THD_WA_SIZE),
+              "KISS",
+              NORMALPRIO - 10,
+              kissThread,
+              chp);
+  chMtxLock(&kiss_mtx);
+  kiss_thd = tp;
+  kiss_active = (tp != NULL);
+  chMtxUnlock(&kiss_mtx);
+  return tp;
+}
+
+/**
+ * @brief   Stop the KISS bridge and wait for it to exit.
+ *
+ * @param[in] kiss  the bridge thread.
+ *
+ * @api
+ */
+void kissStop(thread_t *kiss) {
+  kissDetach();
+  chThdTerminate(kiss);
+  chEvtSignal(kiss, KISS_EVT_DATA);
+  chThdWait(kiss);
+}
+
+/**
+ * @brief   Check if the KISS bridge is running.
+ *
+ * @api
+ */
+bool kissIsActive(void) {
+  return kiss_active;
+}
+
+/**
+ * @brief   Queue a received AX25 frame for the host.
+ * @notes   Never blocks on USB. The frame is KISS encoded into the ring.
+ *          If the ring has no room the frame is dropped and counted.
+ *
+ * @param[in] frame   AX25 frame without CRC.
+ * @param[in] len     frame length.
+ *
+ * @return  status
+ * @retval  true    if the frame was queued.
+ *
+ * @api
+ */
+bool kissSendFrame(const uint8_t *frame, size_t len) {
+  /* Cheap check before encoding. Rechecked under lock. */
+  if(!kiss_active)
+    return false;
+
+  /* FEND, command, data with escapes and FEND. */
+  size_t need = len + 3;
+  for(size_t i = 0; i < len; i++) {
+    if(frame[i] == KISS_FEND || frame[i] == KISS_FESC)
+      need++;
+  }
+
+  chMtxLock(&kiss_mtx);
+  if(!kiss_active) {
+    chMtxUnlock(&kiss_mtx);
+    return false;
+  }
+  if(need > KISS_RING_SIZE - (kiss_head - kiss_tail)) {
+    kiss_stats.rx_dropped++;
+    chMtxUnlock(&kiss_mtx);
+    return false;
+  }
+  uint32_t head = kiss_head;
+  kissRingPut(&head, KISS_FEND);
+  kissRingPut(&head, KISS_CMD_DATA);
+  for(size_t i = 0; i < len; i++) {
+    uint8_t c = frame[i];
+    if(c == KISS_FEND) {
+      kissRingPut(&head, KISS_FESC);
+      kissRingPut(&head, KISS_TFEND);
+    } else if(c == KISS_FESC) {
+      kissRingPut(&head, KISS_FESC);
+      kissRingPut(&head, KISS_TFESC);
+    } else {
+      kissRingPut(&head, c);
+    }
+  }
+  kissRingPut(&head, KISS_FEND);
+  /* Publish the frame to the bridge thread. */
+  kiss_head = head;
+  kiss_stats.rx_frames++;
+  chEvtSignal(kiss_thd, KISS_EVT_DATA);
+  chMtxUnlock(&kiss_mtx);
+  return true;
+}
+
+/**
+ * @brief   Get a copy of the KISS bridge statistics.
+ *
+ * @api
+ */
+void kissGetStats(kiss_stats_t *stats) {
+  chMtxLock(&kiss_mtx);
+  *stats = kiss_stats;
+  chMtxUnlock(&kiss_mtx);
+}
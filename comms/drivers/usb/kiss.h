@@ -0,0 +1,47 @@
+#ifndef __KISS_H__
+#define __KISS_H__
+
+#include "ch.h"
+#include "hal.h"
+
+/* KISS special characters. */
+#define KISS_FEND                   0xC0
+#define KISS_FESC                   0xDB
+#define KISS_TFEND                  0xDC
+#define KISS_TFESC                  0xDD
+
+/* KISS commands (low nibble, port in high nibble). */
+#define KISS_CMD_DATA               0x00
+#define KISS_CMD_RETURN             0xFF
+
+/*
+ * Host bound ring of KISS encoded frames.
+ * Must be a power of 2.
+ */
+#define KISS_RING_SIZE              4096
+
+#define KISS_THD_WA_SIZE            2048
+
+typedef struct {
+  uint32_t          rx_frames;    /**< @brief Frames sent to host.        */
+  uint32_t          rx_dropped;   /**< @brief Frames dropped, ring full.  */
+  uint32_t          rx_bytes;     /**< @brief Encoded bytes sent to host. */
+  uint32_t          tx_frames;    /**< @brief Frames from host sent.      */
+  uint32_t          tx_errors;    /**< @brief Frames from host rejected.  */
+} kiss_stats_t;
+
+extern event_source_t kiss_terminated;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  thread_t  *kissStart(BaseAsynchronousChannel *chp);
+  void      kissStop(thread_t *kiss);
+  bool      kissIsActive(void);
+  bool      kissSendFrame(const uint8_t *frame, size_t len);
+  void      kissGetStats(kiss_stats_t *stats);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KISS_H__ */
@@ -4,6 +4,7 @@
 #include "shell.h"
 #include "commands.h"
 #include "pktconf.h"
+#include "kiss.h"
 
 
 static const ShellConfig shell_cfg = {
@@ -12,6 +13,7 @@ static const ShellConfig shell_cfg = {
 };
 
 static con_chn_state_t console_state;
+static volatile bool kiss_request;
 
 /**
  * @brief   Manage trace output and shell on Serial Over USB.
@@ -19,14 +21,18 @@ static con_chn_state_t console_state;
  * @notes   TRACE output is suspended when any key is pressed on terminal.
  * @notes   A new shell is invoked and remains active until logout.
  * @notes   TRACE output is then resumed.
+ * @notes   Shell and KISS bridge exits are signaled by their terminated
+ *          event sources so the console only wakes on events.
  *
  * @thread
  */
 THD_FUNCTION(pktConsole, arg) {
   BaseAsynchronousChannel *driver = (BaseAsynchronousChannel *)arg;
   event_listener_t con_el;
+  event_listener_t child_el;
 
   thread_t *shelltp;
+  thread_t *kisstp = NULL;
   chEvtRegisterMaskWithFlags(chnGetEventSource(driver),
                       &con_el,
                       CONSOLE_CHANNEL_EVT,
@@ -50,7 +56,7 @@ THD_FUNCTION(pktConsole, arg) {
   chMsgRelease(initiator, MSG_OK);
 
   while(true) {
-    chEvtWaitAny(CONSOLE_CHANNEL_EVT);
+    (void)chEvtWaitAny(CONSOLE_CHANNEL_EVT | CONSOLE_CHILD_EVT);
     BaseSequentialStream *chp = (BaseSequentialStream *)driver;
     eventflags_t evtf = chEvtGetAndClearFlags(&con_el);
 
@@ -88,12 +94,14 @@ THD_FUNCTION(pktConsole, arg) {
         chprintf(chp, "\r\n*** Trace suspended - type ^D or use the "
             "'exit' command to resume trace ***\r\n");
         shellInit();
+        chEvtRegisterMask(&shell_terminated, &child_el, CONSOLE_CHILD_EVT);
         shelltp = chThdCreateFromHeap(NULL,
                                       THD_WORKING_AREA_SIZE(4*1024),
                                       "shell", NORMALPRIO + 1,
                                       shellThread,
                                       (void*)&shell_cfg);
         if(shelltp == NULL) {
+          chEvtUnregister(&shell_terminated, &child_el);
           chprintf(chp, "\r\n*** Failed to open shell ***\r\n");
           break;
         }
@@ -112,15 +120,54 @@ THD_FUNCTION(pktConsole, arg) {
       /* Was shell terminated from CLI? */
       if(chThdTerminatedX(shelltp)) {
           chThdWait(shelltp);
+          chEvtUnregister(&shell_terminated, &child_el);
           shelltp = NULL;
+          if(kiss_request) {
+            /* Hand the channel to the KISS bridge. */
+            kiss_request = false;
+            chEvtRegisterMask(&kiss_terminated, &child_el, CONSOLE_CHILD_EVT);
+            kisstp = kissStart(driver);
+            if(kisstp != NULL) {
+              console_state = CON_CHN_KISS;
+              break;
+            }
+            chEvtUnregister(&kiss_terminated, &child_el);
+            chprintf(chp, "\r\n*** Failed to start KISS ***\r\n");
+          }
           console_state = CON_CHN_OUT;
           chprintf(chp, "\r\n*** Trace resumed by user ***\r\n");
       }
       break;
     } /* End case TERM_SDU_SHELL */
 
+    case CON_CHN_KISS: {
+      /* Input is consumed by the bridge. */
+      if(evtf & CHN_DISCONNECTED) {
+        kissStop(kisstp);
+        chEvtUnregister(&kiss_terminated, &child_el);
+        kisstp = NULL;
+        console_state = CON_CHN_READY;
+        break;
+      }
+      /* Did the host send the KISS return command? */
+      if(chThdTerminatedX(kisstp)) {
+        chThdWait(kisstp);
+        chEvtUnregister(&kiss_terminated, &child_el);
+        kisstp = NULL;
+        kiss_stats_t stats;
+        kissGetStats(&stats);
+        console_state = CON_CHN_OUT;
+        chprintf(chp, "\r\n*** KISS exited, rx %u (dropped %u)"
+                 " tx %u (errors %u) - trace resumed ***\r\n",
+                 stats.rx_frames, stats.rx_dropped,
+                 stats.tx_frames, stats.tx_errors);
+      }
+      break;
+    } /* End case CON_CHN_KISS */
+
     case CON_CHN_EXIT: {
       chThdWait(shelltp);
+      chEvtUnregister(&shell_terminated, &child_el);
       shelltp = NULL;
       console_state = CON_CHN_READY;
       break;
@@ -185,3 +232,10 @@ bool isConsoleOutputAvailable(void) {
   /* Return channel connection status of SDU. */
     return (bool)(console_state == CON_CHN_OUT);
 }
+
+/**
+ * @brief   Request the console switch to KISS mode when the shell exits.
+ */
+void pktRequestKISSMode(void) {
+  kiss_request = true;
+}
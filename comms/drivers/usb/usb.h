@@ -10,7 +10,8 @@ typedef enum consoleStates {
   CON_CHN_IDLE,
   CON_CHN_OUT,
   CON_CHN_SHELL,
-  CON_CHN_EXIT
+  CON_CHN_EXIT,
+  CON_CHN_KISS
 } con_chn_state_t;
 
 #define isUSBactive() (SDU1.config->usbp->state == USB_ACTIVE)
@@ -19,6 +20,7 @@ msg_t   pktStartConsole(void);
 void    startSDU(void);
 void    manageTraceAndShell(void);
 bool    isConsoleOutputAvailable(void);
+void    pktRequestKISSMode(void);
 
 #endif
 
@@ -413,6 +413,12 @@ static void pktResetAFSKDecoder(AFSKDemodDriver *myDriver) {
   /* Set the hdlc bits to all ones. */
   myDriver->hdlc_bits = (int32_t)-1;
 
+  if(myDriver->demod_type == MOD_2FSK) {
+    /* 2FSK does not use the tone decoder. */
+    pktReset2FSKDecoder(myDriver);
+    return;
+  }
+
   switch(AFSK_DECODE_TYPE) {
 
     case AFSK_DSP_QCORR_DECODE: {
@@ -539,6 +545,9 @@ AFSKDemodDriver *pktCreateAFSKDecoder(packet_svc_t *pktHandler) {
   myDriver->icudriver->link = myDriver;
   myDriver->icustate = PKT_PWM_READY;
 
+  /* AFSK unless changed by the 2FSK channel. */
+  myDriver->demod_type = MOD_AFSK;
+
   /* Create the packet buffer name. */
   chsnprintf(myDriver->decoder_name, sizeof(myDriver->decoder_name),
              "%s%02i", PKT_AFSK_THREAD_NAME_PREFIX, rid);
@@ -968,9 +977,12 @@ THD_FUNCTION(pktAFSKDecoder, arg) {
         } /* End if in-band. */
 
         /*
-         * If not in-band process the AFSK into an HDLC bit and AX25 data.
+         * If not in-band process the AFSK or 2FSK into HDLC bits and AX25 data.
          */
-        if(!pktProcessAFSK(myDriver, stream.array)) {
+        bool processed = (myDriver->demod_type == MOD_2FSK)
+            ? pktProcess2FSK(myDriver, stream.array)
+            : pktProcessAFSK(myDriver, stream.array);
+        if(!processed) {
           /* AX25 character decoded but buffer is full.
            * Event sent by HDLC processor (common code for AFSK & 2FSK).
            * Set error state and don't dispatch the AX25 buffer.
@@ -997,6 +1009,15 @@ THD_FUNCTION(pktAFSKDecoder, arg) {
           myDriver->decoder_state = DECODER_RESET;
           continue;
 
+        /*
+         * Receive filter rejected the frame after the address field.
+         * RESET returns the buffer to the FIFO without a callback.
+         */
+        case FRAME_REJECT:
+          myDriver->active_demod_object->status |= STA_PKT_FILTERED;
+          myDriver->decoder_state = DECODER_RESET;
+          continue;
+
         case FRAME_CLOSE: {
           myDriver->decoder_state = DECODER_DISPATCH;
           continue; /* From this case. */
@@ -1044,13 +1065,20 @@ THD_FUNCTION(pktAFSKDecoder, arg) {
           chHeapFree(myHandler->active_packet_object->buffer);
 #endif
           /* Release the AX25 receive packet buffer management object. */
-          objects_fifo_t *pkt_fifo =
-              chFactoryGetObjectsFIFO(myHandler->active_packet_object->pkt_factory);
+          dyn_objects_fifo_t *pkt_factory =
+              myHandler->active_packet_object->pkt_factory;
+          objects_fifo_t *pkt_fifo = chFactoryGetObjectsFIFO(pkt_factory);
 
           chDbgAssert(pkt_fifo != NULL, "no packet FIFO");
 
           chFifoReturnObject(pkt_fifo, myHandler->active_packet_object);
 
+          /*
+           * Decrease FIFO reference counter (increased in SESSION_POLL).
+           * The buffer is not dispatched so no consumer will release it.
+           */
+          chFactoryReleaseObjectsFIFO(pkt_factory);
+
           /* Forget the AX25 buffer management object. */
           myHandler->active_packet_object = NULL;
         }
@@ -271,6 +271,31 @@ typedef struct AFSK_data {
    * @brief Opening HDLC flag sequence found.
    */
   frame_state_t             frame_state;
+
+  /**
+   * @brief Modulation decoded from the PWM stream (AFSK or 2FSK).
+   */
+  mod_t                     demod_type;
+
+  /**
+   * @brief 2FSK bit period in ICU counts.
+   */
+  pwm_accum_t               fsk_bit_size;
+
+  /**
+   * @brief 2FSK bit timing error carried into the next run.
+   */
+  pwm_accum_t               fsk_timing;
+
+  /**
+   * @brief 2FSK prior bit level for NRZI decode.
+   */
+  bit_t                     fsk_level;
+
+  /**
+   * @brief 2FSK descrambler shift register.
+   */
+  uint32_t                  fsk_lfsr;
 } AFSKDemodDriver;
 
 /*===========================================================================*/
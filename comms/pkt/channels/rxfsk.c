@@ -0,0 +1,129 @@
+/*
+    Aerospace Decoder - Copyright (C) 2018 Bob Anderson (VK2GJ)
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/**
+ * @file        rxfsk.c
+ * @brief       2FSK channel.
+ * @details     The radio slices 9600 baud G3RUH 2FSK and outputs the data
+ *              level on RX_DATA. The PWM capture used for AFSK measures the
+ *              length of each high and low run. Here the runs are converted
+ *              to bits, NRZI decoded and descrambled before HDLC deframing.
+ *              The AFSK decoder thread, PWM and packet buffers are shared.
+ *
+ * @addtogroup  channels
+ * @{
+ */
+
+#include "pktconf.h"
+
+/*===========================================================================*/
+/* Decoder local functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Decode one channel bit.
+ *
+ * @param[in]   myDriver   pointer to an @p AFSKDemodDriver structure.
+ * @param[in]   level      the sliced data level of the bit.
+ *
+ * @return  status of operation
+ * @retval  true    bit processed.
+ * @retval  false   frame buffer full.
+ *
+ * @notapi
+ */
+static bool pktDecode2FSKBit(AFSKDemodDriver *myDriver, bit_t level) {
+  /* NRZI. No change of level indicates a 1. */
+  uint8_t bit = (level == myDriver->fsk_level) ? 1 : 0;
+  myDriver->fsk_level = level;
+  bit = pktDescrambleFSKBit(&myDriver->fsk_lfsr, bit);
+  return pktExtractHDLCfrom2FSK(myDriver, bit);
+}
+
+/*===========================================================================*/
+/* Decoder exported functions.                                               */
+/*===========================================================================*/
+
+/**
+ * @brief   Creates a 2FSK channel which decodes PWM data from the radio.
+ * @notes   The AFSK channel is created and then switched to 2FSK decode.
+ *
+ * @param[in]   pktHandler  pointer to a @p packet_svc_t structure.
+ *
+ * @return  pointer to the demod driver object.
+ * @retval  NULL if initialization failed.
+ *
+ * @api
+ */
+AFSKDemodDriver *pktCreate2FSKDecoder(packet_svc_t *pktHandler) {
+  AFSKDemodDriver *myDriver = pktCreateAFSKDecoder(pktHandler);
+  if(myDriver == NULL)
+    return NULL;
+
+  /* Decoding does not run until the decoder is started. */
+  myDriver->demod_type = MOD_2FSK;
+  myDriver->fsk_bit_size = (pwm_accum_t)ICU_COUNT_FREQUENCY
+                            / (pwm_accum_t)FSK_BAUD_RATE;
+  pktReset2FSKDecoder(myDriver);
+  return myDriver;
+}
+
+/**
+ * @brief   Reset the 2FSK bit recovery.
+ * @notes   Called at completion of packet reception.
+ *
+ * @param[in]   myDriver   pointer to an @p AFSKDemodDriver structure.
+ *
+ * @api
+ */
+void pktReset2FSKDecoder(AFSKDemodDriver *myDriver) {
+  myDriver->fsk_timing = 0;
+  myDriver->fsk_level = 0;
+  myDriver->fsk_lfsr = 0;
+}
+
+/**
+ * @brief   Processes PWM runs into bits for 2FSK decoding.
+ * @details Each run of one level is rounded to a whole number of bits.
+ *          Part of the timing error is carried into the next run so the
+ *          bit clock follows the transmitter. A run shorter than half a bit
+ *          is a glitch and its time is added to the next run.
+ *
+ * @param[in]   myDriver      pointer to an @p AFSKDemodDriver structure.
+ * @param[in]   current_run   high and low run lengths in ICU counts.
+ *
+ * @return  status of operations.
+ * @retval  true    no error occurred so decoding can continue at next data.
+ * @retval  false   the frame buffer is full and decoding should be aborted.
+ *
+ * @api
+ */
+bool pktProcess2FSK(AFSKDemodDriver *myDriver, min_pwmcnt_t current_run[]) {
+  const pwm_accum_t size = myDriver->fsk_bit_size;
+  uint8_t i;
+  for(i = 0; i < (sizeof(min_pwm_counts_t) / sizeof(min_pwmcnt_t)); i++) {
+    pwm_accum_t run = (pwm_accum_t)current_run[i] + myDriver->fsk_timing;
+    if(run < size / 2) {
+      myDriver->fsk_timing = run;
+      continue;
+    }
+    uint32_t bits = (uint32_t)(run / size + 0.5f);
+    myDriver->fsk_timing = (run - (pwm_accum_t)bits * size) * FSK_TIMING_GAIN;
+    if(bits > FSK_MAX_RUN_BITS)
+      bits = FSK_MAX_RUN_BITS;
+    /* Impulse is the high level. */
+    bit_t level = !(i & 1);
+    while(bits-- > 0) {
+      if(!pktDecode2FSKBit(myDriver, level))
+        return false;
+    }
+  }
+  return true;
+}
+
+/** @} */
@@ -0,0 +1,93 @@
+/*
+    Aerospace Decoder - Copyright (C) 2018 Bob Anderson (VK2GJ)
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/**
+ * @file        rxfsk.h
+ * @brief       2FSK (G3RUH) decoding definitions.
+ *
+ * @addtogroup decoders
+ * @{
+ */
+
+#ifndef CHANNELS_RXFSK_H_
+#define CHANNELS_RXFSK_H_
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*
+ * 2FSK decoding definitions.
+ */
+#define FSK_BAUD_RATE               9600U
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*
+ * Part of the bit timing error of a run carried into the next run.
+ * Zero times each run on its own. One runs the bit clock free.
+ */
+#if !defined(FSK_TIMING_GAIN)
+#define FSK_TIMING_GAIN             0.5f
+#endif
+
+/* Longest run of one level that is decoded. Longer runs are noise. */
+#if !defined(FSK_MAX_RUN_BITS)
+#define FSK_MAX_RUN_BITS            32U
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Descramble one received bit.
+ * @notes   G3RUH self synchronizing descrambler (1 + x^12 + x^17).
+ * @notes   The inverse of the scrambler in the HDLC stream iterator.
+ *
+ * @param[in,out] lfsr  pointer to the descrambler shift register.
+ * @param[in]     bit   the NRZI decoded channel bit.
+ *
+ * @return  the data bit.
+ */
+static inline uint8_t pktDescrambleFSKBit(uint32_t *lfsr, uint8_t bit) {
+  *lfsr = (*lfsr << 1) | (bit & 1);
+  return (bit ^ (*lfsr >> 17) ^ (*lfsr >> 12)) & 1;
+}
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  AFSKDemodDriver *pktCreate2FSKDecoder(packet_svc_t *pktHandler);
+  void pktReset2FSKDecoder(AFSKDemodDriver *myDriver);
+  bool pktProcess2FSK(AFSKDemodDriver *myDriver, min_pwmcnt_t current_run[]);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CHANNELS_RXFSK_H_ */
+
+/** @} */
@@ -129,6 +129,28 @@ void pktDiagnosticOutput(packet_svc_t *packetHandler,
           magicCRC
       );
       dbgWrite(DBG_INFO, (uint8_t *)serial_buf, serial_out);
+      if(packetHandler->rx_filter.enabled) {
+        serial_out = chsnprintf(serial_buf, sizeof(serial_buf),
+            "Filter... passed: %u, dropped no match: %u"
+            ", not addressee: %u, bad address: %u\r\n",
+            packetHandler->filter_pass_count,
+            packetHandler->filter_drop_count[PKT_DROP_NO_MATCH],
+            packetHandler->filter_drop_count[PKT_DROP_NOT_ADDRESSEE],
+            packetHandler->filter_drop_count[PKT_DROP_BAD_ADDRESS]);
+        dbgWrite(DBG_INFO, (uint8_t *)serial_buf, serial_out);
+      }
+      const char *lane_name[PKT_LANES] = {"command", "digipeat", "monitor"};
+      for(uint8_t i = 0; i < PKT_LANES; i++) {
+        pkt_lane_stats_t *lane = &packetHandler->lanes[i];
+        uint32_t done = lane->dispatched - lane->in_flight;
+        serial_out = chsnprintf(serial_buf, sizeof(serial_buf),
+            "Lane %s... dispatched: %u, dropped: %u, in flight: %u"
+            ", latency avg: %u ms, max: %u ms\r\n",
+            lane_name[i], lane->dispatched, lane->dropped, lane->in_flight,
+            done == 0 ? 0 : chTimeI2MS(lane->latency_total / done),
+            chTimeI2MS(lane->latency_max));
+        dbgWrite(DBG_INFO, (uint8_t *)serial_buf, serial_out);
+      }
       /* Dump the frame contents out. */
       pktDumpAX25Frame(frame_buffer, frame_size, AX25_DUMP_RAW);
   } else { /* End if valid frame. */
@@ -39,6 +39,425 @@ const radio_band_t band_70cm = {
   //.def_aprs = BAND_DEF_70CM_APRS
 };
 
+/* Airtime limit per service in 1/1000 of the duty window. */
+static const uint16_t pkt_tx_duty[PKT_TX_SERVICES] = {
+  PKT_TX_DUTY_OTHER,
+  PKT_TX_DUTY_BEACON,
+  PKT_TX_DUTY_LOG,
+  PKT_TX_DUTY_IMAGE
+};
+
+/* Longest wait for airtime per service. */
+static const uint16_t pkt_tx_deadline_s[PKT_TX_SERVICES] = {
+  PKT_TX_DEADLINE_OTHER_S,
+  PKT_TX_DEADLINE_BEACON_S,
+  PKT_TX_DEADLINE_LOG_S,
+  PKT_TX_DEADLINE_IMAGE_S
+};
+
+/* Time a new send is held for others to join its burst. */
+static const sysinterval_t pkt_tx_gather = TIME_MS2I(PKT_TX_GATHER_MS);
+
+/**
+ * @brief   Return a task object to the radio task free list.
+ * @notes   The task callback is performed first if specified.
+ *
+ * @param[in] handler   pointer to a @p packet service object.
+ * @param[in] rto       pointer to a @p radio task object.
+ *
+ * @notapi
+ */
+static void pktReturnRadioTask(packet_svc_t *handler,
+                               radio_task_object_t *rto) {
+  if(rto->callback != NULL)
+    rto->callback(rto);
+  chFifoReturnObject(chFactoryGetObjectsFIFO(handler->the_radio_fifo), rto);
+}
+
+/**
+ * @brief   Start a transmit task.
+ * @notes   Receive is paused while the transmit thread runs.
+ *
+ * @param[in] handler   pointer to a @p packet service object.
+ * @param[in] rto       pointer to a @p radio task object.
+ *
+ * @return  status of the send.
+ * @retval  true    the task object is held by the transmit thread.
+ * @retval  false   the send failed and the packet chain has been released.
+ *
+ * @notapi
+ */
+static bool pktRadioSendTask(packet_svc_t *handler,
+                             radio_task_object_t *rto) {
+  const radio_unit_t radio = handler->radio;
+
+  /* Give each send a sequence number. */
+  ++handler->radio_tx_config.tx_seq_num;
+  if(pktIsReceiveActive(radio)) {
+    /* Pause the decoder. */
+    pktLockRadioTransmit(radio, TIME_INFINITE);
+    pktLLDradioPauseDecoding(radio);
+    pktUnlockRadioTransmit(radio);
+  }
+  if(pktLLDradioSendPacket(rto)) {
+    /*
+     * Keep count of active sends.
+     * Shutdown or resume receive when all done.
+     */
+    handler->tx_count++;
+
+    /* Send Successfully enqueued.
+     * Unlike receive the task object is held by the TX until complete.
+     * This is non blocking as each radio transmit runs in a thread.
+     * The radio task object is released through a TX thread release task.
+     */
+    return true;
+  }
+  /* Send failed so release send packet object(s). */
+  pktReleaseBufferChain(rto->packet_out);
+  if(pktIsReceivePaused(radio)) {
+    pktLockRadioTransmit(radio, TIME_INFINITE);
+    if(!pktLLDradioResumeReceive(radio)) {
+      TRACE_ERROR("RAD  > Receive on radio %d failed to "
+          "resume after transmit", radio);
+      pktUnlockRadioTransmit(radio);
+      return false;
+    }
+    pktLLDradioResumeDecoding(radio);
+    pktUnlockRadioTransmit(radio);
+  }
+  return false;
+}
+
+/**
+ * @brief   Initialize the transmit scheduler.
+ * @notes   Each service starts with a full airtime budget.
+ *
+ * @param[in] handler   pointer to a @p packet service object.
+ *
+ * @notapi
+ */
+static void pktTransmitSchedulerInit(packet_svc_t *handler) {
+  pkt_tx_sched_t *sched = &handler->tx_sched;
+  memset(sched, 0, sizeof(pkt_tx_sched_t));
+  sched->credit_time = chVTGetSystemTime();
+  for(uint8_t i = 0; i < PKT_TX_SERVICES; i++)
+    sched->credit[i] = (int32_t)pkt_tx_duty[i] * PKT_TX_DUTY_WINDOW_S * 1000;
+}
+
+/**
+ * @brief   Count packets, frame bytes and airtime of a send.
+ *
+ * @param[in] rto       pointer to a @p radio task object.
+ *
+ * @notapi
+ */
+static void pktMeasureTransmit(radio_task_object_t *rto) {
+  uint16_t packets = 0;
+  uint32_t bytes = 0;
+  uint32_t bits = 0;
+  for(packet_t pp = rto->packet_out; pp != NULL; pp = pp->nextp) {
+    packets++;
+    bytes += pp->frame_len;
+    /* Frame and CRC with an allowance for bit stuffing. */
+    uint32_t frame = (pp->frame_len + 2) * 8;
+    bits += frame + frame / 32 + PKT_TX_FRAME_OVERHEAD_BITS;
+  }
+  uint32_t speed = (rto->tx_speed != 0) ? rto->tx_speed : 1200;
+  rto->tx_packets = packets;
+  rto->tx_bytes = bytes;
+  rto->tx_airtime_ms = bits * 1000 / speed;
+}
+
+/**
+ * @brief   Check if two sends can share a key up.
+ *
+ * @notapi
+ */
+static bool pktIsSameTransmit(const radio_task_object_t *a,
+                              const radio_task_object_t *b) {
+  return a->type == b->type
+      && a->base_frequency == b->base_frequency
+      && a->step_hz == b->step_hz
+      && a->channel == b->channel
+      && a->tx_power == b->tx_power
+      && a->tx_speed == b->tx_speed
+      && a->squelch == b->squelch;
+}
+
+/**
+ * @brief   Append the packet chain of one send to another.
+ *
+ * @notapi
+ */
+static void pktJoinTransmit(radio_task_object_t *rto,
+                            radio_task_object_t *other) {
+  packet_t pp = rto->packet_out;
+  while(pp->nextp != NULL)
+    pp = pp->nextp;
+  pp->nextp = other->packet_out;
+  rto->tx_packets += other->tx_packets;
+  rto->tx_bytes += other->tx_bytes;
+  rto->tx_airtime_ms += other->tx_airtime_ms;
+}
+
+/**
+ * @brief   Add airtime credit earned since the last update.
+ * @notes   Credit is in 1/1000 ms and capped at the window budget.
+ *
+ * @notapi
+ */
+static void pktRefillTransmitCredit(pkt_tx_sched_t *sched) {
+  systime_t now = chVTGetSystemTime();
+  uint32_t elapsed = chTimeI2MS(chTimeDiffX(sched->credit_time, now));
+  if(elapsed == 0)
+    return;
+  sched->credit_time = chTimeAddX(sched->credit_time, TIME_MS2I(elapsed));
+  for(uint8_t i = 0; i < PKT_TX_SERVICES; i++) {
+    if(pkt_tx_duty[i] == 0)
+      continue;
+    int32_t cap = (int32_t)pkt_tx_duty[i] * PKT_TX_DUTY_WINDOW_S * 1000;
+    int32_t credit = sched->credit[i] + (int32_t)(elapsed * pkt_tx_duty[i]);
+    sched->credit[i] = (credit > cap) ? cap : credit;
+  }
+}
+
+/**
+ * @brief   Check if a service has airtime for a send.
+ * @notes   A send larger than the whole budget goes when the budget is full.
+ *
+ * @param[in] sched     pointer to the transmit scheduler.
+ * @param[in] svc       service charged for the send.
+ * @param[in] airtime   airtime of the send in ms.
+ *
+ * @notapi
+ */
+static bool pktHasTransmitCredit(pkt_tx_sched_t *sched,
+                                 pkt_tx_service_t svc,
+                                 uint32_t airtime) {
+  uint16_t duty = pkt_tx_duty[svc];
+  if(duty == 0)
+    return true;
+  int32_t cap = (int32_t)duty * PKT_TX_DUTY_WINDOW_S * 1000;
+  int32_t need = (int32_t)airtime * 1000;
+  return sched->credit[svc] >= ((need < cap) ? need : cap);
+}
+
+/**
+ * @brief   Check if a service has airtime for a send to join a burst.
+ * @notes   Unlike a new burst the whole send must fit the credit.
+ *
+ * @param[in] sched     pointer to the transmit scheduler.
+ * @param[in] svc       service charged for the send.
+ * @param[in] airtime   airtime of the send in ms.
+ *
+ * @notapi
+ */
+static bool pktHasJoinCredit(pkt_tx_sched_t *sched,
+                             pkt_tx_service_t svc,
+                             uint32_t airtime) {
+  if(pkt_tx_duty[svc] == 0)
+    return true;
+  return sched->credit[svc] >= (int32_t)airtime * 1000;
+}
+
+/**
+ * @brief   Charge a send to its service.
+ *
+ * @notapi
+ */
+static void pktAccountTransmit(pkt_tx_sched_t *sched,
+                               radio_task_object_t *rto) {
+  pkt_tx_stats_t *stats = &sched->stats[rto->tx_service];
+  if(pkt_tx_duty[rto->tx_service] != 0)
+    sched->credit[rto->tx_service] -= (int32_t)rto->tx_airtime_ms * 1000;
+  stats->packets += rto->tx_packets;
+  stats->bytes += rto->tx_bytes;
+  stats->airtime_ms += rto->tx_airtime_ms;
+}
+
+/**
+ * @brief   Remove a held send from the scheduler.
+ *
+ * @notapi
+ */
+static radio_task_object_t *pktTakeTransmit(pkt_tx_sched_t *sched,
+                                            uint8_t i) {
+  radio_task_object_t *rto = sched->pending[i];
+  sched->pending[i] = sched->pending[--sched->count];
+  return rto;
+}
+
+/**
+ * @brief   Send held transmit tasks which are due.
+ * @details A send is due once its gather time has passed and its service
+ *          has airtime. Earliest deadline goes first then service priority.
+ *          Other held sends on the same channel join the burst.
+ *          Sends which cannot get airtime by their deadline are dropped.
+ *
+ * @param[in] handler   pointer to a @p packet service object.
+ * @param[in] flush     send everything held regardless of time and budget.
+ *
+ * @notapi
+ */
+static void pktDispatchTransmit(packet_svc_t *handler, bool flush) {
+  pkt_tx_sched_t *sched = &handler->tx_sched;
+  if(sched->count == 0)
+    return;
+  pktRefillTransmitCredit(sched);
+  systime_t now = chVTGetSystemTime();
+
+  while(true) {
+    int8_t best = -1;
+    sysinterval_t best_left = 0;
+    for(uint8_t i = 0; i < sched->count; i++) {
+      radio_task_object_t *rto = sched->pending[i];
+      sysinterval_t age = chTimeDiffX(rto->tx_arrival, now);
+      sysinterval_t deadline = TIME_S2I(pkt_tx_deadline_s[rto->tx_service]);
+      if(!flush && age < pkt_tx_gather)
+        continue;
+      if(!flush && !pktHasTransmitCredit(sched, rto->tx_service,
+                                         rto->tx_airtime_ms)) {
+        if(age >= deadline) {
+          TRACE_WARN("RAD  > Transmit of %d packet(s) dropped on radio %d,"
+                     " no airtime", rto->tx_packets, handler->radio);
+          sched->stats[rto->tx_service].expired++;
+          pktTakeTransmit(sched, i--);
+          pktReleaseBufferChain(rto->packet_out);
+          pktReturnRadioTask(handler, rto);
+          continue;
+        }
+        if(!rto->tx_deferred) {
+          rto->tx_deferred = true;
+          sched->stats[rto->tx_service].deferred++;
+        }
+        continue;
+      }
+      sysinterval_t left = (age < deadline) ? deadline - age : 0;
+      if(best < 0 || left < best_left || (left == best_left
+          && rto->tx_service < sched->pending[best]->tx_service)) {
+        best = i;
+        best_left = left;
+      }
+    }
+    if(best < 0)
+      return;
+
+    radio_task_object_t *rto = pktTakeTransmit(sched, best);
+    pktAccountTransmit(sched, rto);
+    sched->stats[rto->tx_service].bursts++;
+
+    /* Held sends on the same channel join this key up. */
+    for(uint8_t i = 0; i < sched->count; i++) {
+      radio_task_object_t *other = sched->pending[i];
+      if(!pktIsSameTransmit(rto, other)
+          || rto->tx_airtime_ms + other->tx_airtime_ms > PKT_TX_BURST_MAX_MS
+          || (!flush && !pktHasJoinCredit(sched, other->tx_service,
+                                          other->tx_airtime_ms)))
+        continue;
+      pktTakeTransmit(sched, i--);
+      pktAccountTransmit(sched, other);
+      sched->stats[other->tx_service].merged++;
+      pktJoinTransmit(rto, other);
+      pktReturnRadioTask(handler, other);
+    }
+    if(!pktRadioSendTask(handler, rto))
+      pktReturnRadioTask(handler, rto);
+  }
+}
+
+/**
+ * @brief   Hand a transmit task to the scheduler.
+ * @details The send joins a held send of the same service on the same
+ *          channel if the service has airtime for both. Otherwise it is
+ *          held for the gather time. If the scheduler is full the send
+ *          goes immediately when it has airtime and is dropped if not.
+ *
+ * @param[in] handler   pointer to a @p packet service object.
+ * @param[in] rto       pointer to a @p radio task object.
+ *
+ * @return  status of the task object.
+ * @retval  true    the task object is held by the scheduler or transmit.
+ * @retval  false   the task object can be returned to the free list.
+ *
+ * @notapi
+ */
+static bool pktScheduleTransmit(packet_svc_t *handler,
+                                radio_task_object_t *rto) {
+  pkt_tx_sched_t *sched = &handler->tx_sched;
+
+  if(rto->tx_service >= PKT_TX_SERVICES)
+    rto->tx_service = PKT_TX_SVC_OTHER;
+  rto->tx_arrival = chVTGetSystemTime();
+  rto->tx_deferred = false;
+  pktMeasureTransmit(rto);
+  pktRefillTransmitCredit(sched);
+
+  for(uint8_t i = 0; i < sched->count; i++) {
+    radio_task_object_t *held = sched->pending[i];
+    uint32_t airtime = held->tx_airtime_ms + rto->tx_airtime_ms;
+    if(held->tx_service == rto->tx_service
+        && pktIsSameTransmit(held, rto)
+        && airtime <= PKT_TX_BURST_MAX_MS
+        && pktHasJoinCredit(sched, rto->tx_service, airtime)) {
+      pktJoinTransmit(held, rto);
+      sched->stats[rto->tx_service].merged++;
+      return false;
+    }
+  }
+
+  if(sched->count == PKT_TX_SCHED_MAX) {
+    pktDispatchTransmit(handler, false);
+    if(sched->count == PKT_TX_SCHED_MAX) {
+      /* No room to hold the send. */
+      if(!pktHasTransmitCredit(sched, rto->tx_service, rto->tx_airtime_ms)) {
+        TRACE_WARN("RAD  > Transmit of %d packet(s) dropped on radio %d,"
+                   " scheduler full", rto->tx_packets, handler->radio);
+        sched->stats[rto->tx_service].rejected++;
+        pktReleaseBufferChain(rto->packet_out);
+        return false;
+      }
+      pktAccountTransmit(sched, rto);
+      sched->stats[rto->tx_service].bursts++;
+      return pktRadioSendTask(handler, rto);
+    }
+  }
+  sched->pending[sched->count++] = rto;
+
+  /* Without a gather time the send goes now if it has airtime. */
+  if(pkt_tx_gather == 0)
+    pktDispatchTransmit(handler, false);
+  return true;
+}
+
+/**
+ * @brief   Time until the next held send may be due.
+ *
+ * @param[in] handler   pointer to a @p packet service object.
+ *
+ * @return  time to wait for radio tasks.
+ *
+ * @notapi
+ */
+static sysinterval_t pktTransmitScheduleWait(packet_svc_t *handler) {
+  pkt_tx_sched_t *sched = &handler->tx_sched;
+  if(sched->count == 0)
+    return TIME_INFINITE;
+  sysinterval_t wait = TIME_MS2I(PKT_TX_SCHED_POLL_MS);
+  systime_t now = chVTGetSystemTime();
+  for(uint8_t i = 0; i < sched->count; i++) {
+    radio_task_object_t *rto = sched->pending[i];
+    if(rto->tx_deferred)
+      continue;
+    sysinterval_t age = chTimeDiffX(rto->tx_arrival, now);
+    sysinterval_t left = (age < pkt_tx_gather)
+        ? pkt_tx_gather - age : TIME_MS2I(1);
+    if(left < wait)
+      wait = left;
+  }
+  return wait;
+}
+
 /**
  * @brief   Process radio task requests.
  * @notes   Task objects posted to the queue are processed per radio.
@@ -80,10 +499,16 @@ THD_FUNCTION(pktRadioManager, arg) {
   chMsgRelease(initiator, MSG_OK);
   /* Run until close request and no outstanding TX tasks. */
   while(true) {
+    /* Send any held transmits which are due. */
+    pktDispatchTransmit(handler, false);
+
     /* Check for task requests. */
     radio_task_object_t *task_object;
-    (void)chFifoReceiveObjectTimeout(radio_queue,
-                         (void *)&task_object, TIME_INFINITE);
+    msg_t fmsg = chFifoReceiveObjectTimeout(radio_queue,
+                         (void *)&task_object,
+                         pktTransmitScheduleWait(handler));
+    if(fmsg != MSG_OK)
+      continue;
     /* Something to do. */
 
     /* Process command. */
@@ -94,6 +519,8 @@ THD_FUNCTION(pktRadioManager, arg) {
        * When no TX tasks are outstanding release the FIFO and terminate.
        * The task initiator waits with chThdWait(...).
        */
+      /* Held transmits are sent now. */
+      pktDispatchTransmit(handler, true);
       if(handler->tx_count == 0) {
         pktLLDradioShutdown(radio);
         chFactoryReleaseObjectsFIFO(handler->the_radio_fifo);
@@ -149,11 +576,27 @@ THD_FUNCTION(pktRadioManager, arg) {
           break;
         } /* End case PKT_RADIO_OPEN. */
 
-        case MOD_NONE:
         case MOD_2FSK: {
+#if PKT_RX_USE_2FSK != TRUE
+          /* 2FSK receive is experimental and not enabled. */
+          TRACE_ERROR("RAD  > 2FSK receive not enabled on radio %d", radio);
+          handler->link_controller = NULL;
+          pktAddEventFlags(handler, (EVT_AFSK_START_FAIL));
           break;
+#else
+          /* The 2FSK decoder shares the AFSK PWM and decoder thread. */
+          AFSKDemodDriver *driver = pktCreate2FSKDecoder(handler);
+          handler->link_controller = driver;
+          if(driver == NULL) {
+            pktAddEventFlags(handler, (EVT_AFSK_START_FAIL));
+            break;
+          }
+          break;
+#endif
         }
-        break;
+
+        case MOD_NONE:
+          break;
       } /* End switch on modulation type. */
 
       break;
@@ -163,7 +606,8 @@ THD_FUNCTION(pktRadioManager, arg) {
     case PKT_RADIO_RX_START: {
       /* The function switches on mod type so no need for switch here. */
       switch(task_object->type) {
-      case MOD_AFSK: {
+      case MOD_AFSK:
+      case MOD_2FSK: {
         pktLockRadioTransmit(radio, TIME_INFINITE);
         /* Enable receive. */
         if(!pktLLDradioEnableReceive(radio, task_object)) {
@@ -177,8 +621,7 @@ THD_FUNCTION(pktRadioManager, arg) {
         break;
         } /* End case MOD_AFSK. */
 
-      case MOD_NONE:
-      case MOD_2FSK: {
+      case MOD_NONE: {
         break;
         }
       } /* End switch on task_object->type. */
@@ -187,7 +630,8 @@ THD_FUNCTION(pktRadioManager, arg) {
 
     case PKT_RADIO_RX_STOP: {
       switch(task_object->type) {
-            case MOD_AFSK: {
+            case MOD_AFSK:
+            case MOD_2FSK: {
               /* TODO: Abstract acquire and release in LLD. */
               pktLockRadioTransmit(radio, TIME_INFINITE);
               pktLLDradioStopDecoder(radio);
@@ -195,8 +639,7 @@ THD_FUNCTION(pktRadioManager, arg) {
               break;
               } /* End case. */
 
-            case MOD_NONE:
-            case MOD_2FSK: {
+            case MOD_NONE: {
               break;
               }
        } /* End switch. */
@@ -204,42 +647,12 @@ THD_FUNCTION(pktRadioManager, arg) {
     } /* End case PKT_RADIO_RX_STOP. */
 
     case PKT_RADIO_TX_SEND: {
-      /* Give each send a sequence number. */
-      ++handler->radio_tx_config.tx_seq_num;
-      if(pktIsReceiveActive(radio)) {
-        /* Pause the decoder. */
-        pktLockRadioTransmit(radio, TIME_INFINITE);
-        pktLLDradioPauseDecoding(radio);
-        pktUnlockRadioTransmit(radio);
-      }
-      if(pktLLDradioSendPacket(task_object)) {
-        /*
-         * Keep count of active sends.
-         * Shutdown or resume receive when all done.
-         */
-        handler->tx_count++;
-
-        /* Send Successfully enqueued.
-         * Unlike receive the task object is held by the TX until complete.
-         * This is non blocking as each radio transmit runs in a thread.
-         * The radio task object is released through a TX thread release task.
-         */
+      /*
+       * The scheduler holds the send to merge it into a burst.
+       * A send merged into a held burst returns its task object here.
+       */
+      if(pktScheduleTransmit(handler, task_object))
         continue;
-      }
-      /* Send failed so release send packet object(s) and task object. */
-      packet_t pp = task_object->packet_out;
-      pktReleaseBufferChain(pp);
-      if(pktIsReceivePaused(radio)) {
-        pktLockRadioTransmit(radio, TIME_INFINITE);
-        if(!pktLLDradioResumeReceive(radio)) {
-          TRACE_ERROR("RAD  > Receive on radio %d failed to "
-              "resume after transmit", radio);
-          pktUnlockRadioTransmit(radio);
-          break;
-        }
-        pktLLDradioResumeDecoding(radio);
-        pktUnlockRadioTransmit(radio);
-      }
       break;
     } /* End case PKT_RADIO_TX. */
 
@@ -248,7 +661,8 @@ THD_FUNCTION(pktRadioManager, arg) {
       event_source_t *esp;
       thread_t *decoder = NULL;
       switch(task_object->type) {
-      case MOD_AFSK: {
+      case MOD_AFSK:
+      case MOD_2FSK: {
         /* Stop receive. */
         pktLockRadioTransmit(radio, TIME_INFINITE);
         pktLLDradioDisableReceive(radio);
@@ -267,10 +681,9 @@ THD_FUNCTION(pktRadioManager, arg) {
         break;
         }
 
-      case MOD_NONE:
-      case MOD_2FSK: {
+      case MOD_NONE: {
         break;
-        } /* End case DECODE_FSK. */
+        }
       } /* End switch on link_type. */
       if(decoder == NULL)
         /* No decoder processed. */
@@ -377,6 +790,8 @@ thread_t *pktRadioManagerCreate(const radio_unit_t radio) {
 
   handler->the_radio_fifo = the_radio_fifo;
 
+  pktTransmitSchedulerInit(handler);
+
   TRACE_INFO("PKT  > radio manager thread created. FIFO @ 0x%x",
             the_radio_fifo);
 
@@ -411,6 +826,30 @@ thread_t *pktRadioManagerCreate(const radio_unit_t radio) {
   return NULL;
 }
 
+/**
+ * @brief   Get the transmit airtime accounting for a service.
+ *
+ * @param[in]   radio   radio unit ID.
+ * @param[in]   svc     transmit service.
+ * @param[out]  stats   pointer to a @p pkt_tx_stats_t to be filled.
+ *
+ * @return  status of the request.
+ * @retval  false   the radio or service is invalid.
+ *
+ * @api
+ */
+bool pktGetTransmitStats(const radio_unit_t radio,
+                         const pkt_tx_service_t svc,
+                         pkt_tx_stats_t *stats) {
+  packet_svc_t *handler = pktGetServiceObject(radio);
+  if(handler == NULL || svc >= PKT_TX_SERVICES)
+    return false;
+  chSysLock();
+  *stats = handler->tx_sched.stats[svc];
+  chSysUnlock();
+  return true;
+}
+
 /**
  * @brief   Release the radio task manager.
  * @pre     The packet session is stopped so new TX or RX requests are blocked.
@@ -952,7 +1391,7 @@ void pktLLDradioStandby(const radio_unit_t radio) {
  * @notapi
  */
 bool pktLLDradioSendPacket(radio_task_object_t *rto) {
-  bool status;
+  bool status = false;
   /* TODO: Implement VMT to functions per radio type. */
   switch(rto->type) {
   case MOD_2FSK:
@@ -34,6 +34,53 @@
 /* Set TRUE to use mutex instead of bsem. */
 #define PKT_USE_RADIO_MUTEX             TRUE
 
+/*
+ * Transmit scheduler.
+ * Sends for the same channel, modulation and power are merged into bursts.
+ * A new send can be held briefly so others join its burst. 0 sends at once.
+ */
+#define PKT_TX_SCHED_MAX                4
+#if !defined(PKT_TX_GATHER_MS)
+#define PKT_TX_GATHER_MS                0
+#endif
+#define PKT_TX_BURST_MAX_MS             10000
+#define PKT_TX_SCHED_POLL_MS            1000
+
+/* Bits added to each frame by the feeders (30 + 10 flags, 10 tail). */
+#define PKT_TX_FRAME_OVERHEAD_BITS      ((30 + 10 + 10) * 8)
+
+/*
+ * Airtime limit per service in 1/1000 of the duty window. 0 is unlimited.
+ * Sends over the limit wait for airtime until their deadline.
+ */
+#define PKT_TX_DUTY_WINDOW_S            600
+#if !defined(PKT_TX_DUTY_OTHER)
+#define PKT_TX_DUTY_OTHER               0
+#endif
+#if !defined(PKT_TX_DUTY_BEACON)
+#define PKT_TX_DUTY_BEACON              0
+#endif
+#if !defined(PKT_TX_DUTY_LOG)
+#define PKT_TX_DUTY_LOG                 0
+#endif
+#if !defined(PKT_TX_DUTY_IMAGE)
+#define PKT_TX_DUTY_IMAGE               0
+#endif
+
+/* Longest time a send waits for airtime before it is dropped. */
+#if !defined(PKT_TX_DEADLINE_OTHER_S)
+#define PKT_TX_DEADLINE_OTHER_S         10
+#endif
+#if !defined(PKT_TX_DEADLINE_BEACON_S)
+#define PKT_TX_DEADLINE_BEACON_S        60
+#endif
+#if !defined(PKT_TX_DEADLINE_LOG_S)
+#define PKT_TX_DEADLINE_LOG_S           300
+#endif
+#if !defined(PKT_TX_DEADLINE_IMAGE_S)
+#define PKT_TX_DEADLINE_IMAGE_S         600
+#endif
+
 /*===========================================================================*/
 /* Module data structures and types.                                         */
 /*===========================================================================*/
@@ -55,6 +102,31 @@ typedef enum radioCommand {
   PKT_RADIO_RX_RSSI
 } radio_command_t;
 
+/**
+ * @brief   Transmit services in priority order.
+ */
+typedef enum {
+  PKT_TX_SVC_OTHER = 0,   /* Replies, digipeat and host frames. */
+  PKT_TX_SVC_BEACON,
+  PKT_TX_SVC_LOG,
+  PKT_TX_SVC_IMAGE,
+  PKT_TX_SERVICES
+} pkt_tx_service_t;
+
+/**
+ * @brief   Transmit airtime accounting per service.
+ */
+typedef struct {
+  uint32_t                  packets;
+  uint32_t                  bytes;        /* Frame bytes sent.             */
+  uint32_t                  airtime_ms;   /* Estimated time on air.        */
+  uint16_t                  bursts;       /* Key ups led by this service.  */
+  uint16_t                  merged;       /* Sends joined to a burst.      */
+  uint16_t                  deferred;     /* Sends held by the duty limit. */
+  uint16_t                  expired;      /* Sends dropped at deadline.    */
+  uint16_t                  rejected;     /* Sends dropped when full.      */
+} pkt_tx_stats_t;
+
 /**
  * Forward declare structure types.
  */
@@ -117,8 +189,27 @@ struct radioTask {
   radio_pwr_t               tx_power;
   uint32_t                  tx_speed;
   uint8_t                   tx_seq_num;
+  /* Transmit scheduler data for the packet chain. */
+  pkt_tx_service_t          tx_service;
+  systime_t                 tx_arrival;
+  bool                      tx_deferred;
+  uint16_t                  tx_packets;
+  uint32_t                  tx_bytes;
+  uint32_t                  tx_airtime_ms;
 };
 
+/**
+ * @brief       Transmit scheduler state.
+ * @details     Held sends, service airtime credit and accounting.
+ */
+typedef struct {
+  radio_task_object_t       *pending[PKT_TX_SCHED_MAX];
+  uint8_t                   count;
+  int32_t                   credit[PKT_TX_SERVICES];
+  systime_t                 credit_time;
+  pkt_tx_stats_t            stats[PKT_TX_SERVICES];
+} pkt_tx_sched_t;
+
 /*===========================================================================*/
 /* External declarations.                                                    */
 /*===========================================================================*/
@@ -181,6 +272,9 @@ extern "C" {
             	 	                        size_t size);
   const radio_config_t	*pktGetRadioData(radio_unit_t radio);
   uint8_t           pktLLDradioReadCCA(const radio_unit_t radio);
+  bool              pktGetTransmitStats(const radio_unit_t radio,
+                                        const pkt_tx_service_t svc,
+                                        pkt_tx_stats_t *stats);
 #ifdef __cplusplus
 }
 #endif
@@ -8,6 +8,7 @@
 
 #include "pktconf.h"
 #include "portab.h"
+#include <ctype.h>
 
 /*===========================================================================*/
 /* Module local definitions.                                                 */
@@ -40,6 +41,16 @@ packet_svc_t RPKTD2;
 /* Module local variables.                                                   */
 /*===========================================================================*/
 
+/* Dispatch lane callback priority and in flight limit. */
+static const struct {
+  tprio_t   prio;
+  uint16_t  limit;
+} lane_conf[PKT_LANES] = {
+  [PKT_LANE_COMMAND]  = {PKT_LANE_COMMAND_PRIO, PKT_LANE_COMMAND_LIMIT},
+  [PKT_LANE_DIGIPEAT] = {PKT_LANE_DIGIPEAT_PRIO, PKT_LANE_DIGIPEAT_LIMIT},
+  [PKT_LANE_MONITOR]  = {PKT_LANE_MONITOR_PRIO, PKT_LANE_MONITOR_LIMIT}
+};
+
 #if USE_CCM_HEAP_FOR_PKT == TRUE
 static memory_heap_t _ccm_heap;
 /*#elif USE_CCM_FOR_PKT_POOL == TRUE
@@ -308,6 +319,9 @@ msg_t pktOpenRadioReceive(const radio_unit_t radio,
   handler->frame_count = 0;
   handler->valid_count = 0;
   handler->good_count = 0;
+  handler->filter_pass_count = 0;
+  memset(handler->filter_drop_count, 0, sizeof(handler->filter_drop_count));
+  memset(handler->lanes, 0, sizeof(handler->lanes));
 
   radio_task_object_t rt = handler->radio_rx_config;
 
@@ -377,6 +391,39 @@ msg_t pktEnableDataReception(const radio_unit_t radio,
   return MSG_OK;
 }
 
+/**
+ * @brief   Sets the receive address filter.
+ * @notes   Frames not matching the interest set are abandoned by the HDLC
+ *          receiver once the address field is decoded.
+ * @notes   The buffer is returned to the packet FIFO without a callback.
+ * @notes   Should be set before reception is enabled.
+ *
+ * @param[in]   radio   radio unit ID.
+ * @param[in]   filter  pointer to the filter or NULL to accept all frames.
+ *
+ * @return              Status of the operation.
+ * @retval MSG_OK       if the filter was set.
+ * @retval MSG_RESET    if the radio ID is invalid.
+ *
+ * @api
+ */
+msg_t pktSetReceiveFilter(const radio_unit_t radio,
+                          const pkt_rx_filter_t *filter) {
+
+  packet_svc_t *handler = pktGetServiceObject(radio);
+  if(handler == NULL)
+    return MSG_RESET;
+
+  chSysLock();
+  if(filter == NULL)
+    handler->rx_filter.enabled = false;
+  else
+    handler->rx_filter = *filter;
+  handler->filter_state = PKT_FILTER_PENDING;
+  chSysUnlock();
+  return MSG_OK;
+}
+
 /**
  * @brief   Enables a packet decoder.
  * @pre     The packet channel must have been opened.
@@ -400,7 +447,8 @@ void pktStartDecoder(const radio_unit_t radio) {
   event_source_t *esp;
 
   switch(handler->radio_rx_config.type) {
-    case MOD_AFSK: {
+    case MOD_AFSK:
+    case MOD_2FSK: {
 
       esp = pktGetEventSource((AFSKDemodDriver *)handler->link_controller);
 
@@ -412,10 +460,6 @@ void pktStartDecoder(const radio_unit_t radio) {
       break;
     } /* End case. */
 
-    case MOD_2FSK: {
-      return;
-    }
-
     default:
       return;
   } /* End switch. */
@@ -498,7 +542,8 @@ void pktStopDecoder(radio_unit_t radio) {
   event_source_t *esp;
 
   switch(handler->radio_rx_config.type) {
-    case MOD_AFSK: {
+    case MOD_AFSK:
+    case MOD_2FSK: {
       esp = pktGetEventSource((AFSKDemodDriver *)handler->link_controller);
 
       pktRegisterEventListener(esp, &el, USR_COMMAND_ACK, DEC_STOP_EXEC);
@@ -509,10 +554,6 @@ void pktStopDecoder(radio_unit_t radio) {
       break;
     } /* End case. */
 
-    case MOD_2FSK: {
-      return;
-    }
-
     default:
       return;
   } /* End switch. */
@@ -607,6 +648,9 @@ bool pktStoreBufferData(pkt_data_object_t *pkt_buffer, ax25char_t data) {
  * @post    Packet quality statistics are updated.
  * @post    Where no callback is used the buffer is posted to the FIFO mailbox.
  * @post    Where a callback is used a thread is created to execute the callback.
+ * @post    The callback runs at the priority of the frame's dispatch lane.
+ * @post    If the lane already has its limit of callbacks in flight the
+ *          frame is shed and the buffer returned to the free list.
  *
  * @param[in] pkt_buffer    pointer to a @p packet buffer object.
  *
@@ -641,6 +685,14 @@ eventflags_t pktDispatchReceivedBuffer(pkt_data_object_t *pkt_buffer) {
   /* Update status in packet buffer object. */
   pkt_buffer->status |= flags;
 
+  /*
+   * Assign the dispatch lane by destination and frame type.
+   * The CRC outcome is left to the consumer.
+   */
+  pkt_buffer->lane = pktClassifyReceivedBuffer(pkt_buffer);
+  pkt_buffer->dispatch_time = chVTGetSystemTime();
+  pkt_lane_stats_t *lane = &handler->lanes[pkt_buffer->lane];
+
   objects_fifo_t *pkt_fifo = chFactoryGetObjectsFIFO(pkt_buffer->pkt_factory);
 
   chDbgAssert(pkt_fifo != NULL, "no packet FIFO");
@@ -648,25 +700,115 @@ eventflags_t pktDispatchReceivedBuffer(pkt_data_object_t *pkt_buffer) {
   if(pkt_buffer->cb_func == NULL) {
 
     /* Send the packet buffer to the FIFO queue. */
+    lane->dispatched++;
     chFifoSendObject(pkt_fifo, pkt_buffer);
+    return flags;
+  }
+
+  /*
+   * Shed the frame if buffers are running out and its lane is full.
+   * The buffer goes back to the free list so the decoder can continue.
+   * This keeps buffers and CPU for the higher priority lanes.
+   */
+  chSysLock();
+  bool pressure = chSemGetCounterI(&pkt_fifo->free.sem)
+      < PKT_LANE_BUFFER_RESERVE;
+  bool full = pressure
+      && lane->in_flight >= lane_conf[pkt_buffer->lane].limit;
+  if(full)
+    lane->dropped++;
+  else
+    lane->in_flight++;
+  chSysUnlock();
+  if(full) {
+#if USE_CCM_HEAP_RX_BUFFERS == TRUE
+    chHeapFree(pkt_buffer->buffer);
+#endif
+    dyn_objects_fifo_t *pkt_factory = pkt_buffer->pkt_factory;
+    chFifoReturnObject(pkt_fifo, pkt_buffer);
+    chFactoryReleaseObjectsFIFO(pkt_factory);
+    return flags;
+  }
+
+  /* Schedule a callback. */
+  thread_t *cb_thd = pktCreateBufferCallback(pkt_buffer);
+
+  chDbgAssert(cb_thd != NULL, "failed to create callback thread");
+
+  if(cb_thd == NULL) {
+    /* Failed to create CB thread. Release buffer. Broadcast event. */
+    chSysLock();
+    lane->in_flight--;
+    chSysUnlock();
+    chFifoReturnObject(pkt_fifo, pkt_buffer);
+    pktAddEventFlags(handler, EVT_PKT_FAILED_CB_THD);
   } else {
-    /* Schedule a callback. */
-    thread_t *cb_thd = pktCreateBufferCallback(pkt_buffer);
-
-    chDbgAssert(cb_thd != NULL, "failed to create callback thread");
-
-    if(cb_thd == NULL) {
-      /* Failed to create CB thread. Release buffer. Broadcast event. */
-      chFifoReturnObject(pkt_fifo, pkt_buffer);
-      pktAddEventFlags(handler, EVT_PKT_FAILED_CB_THD);
-    } else {
-      /* Increase outstanding callback count. */
-      handler->cb_count++;
-    }
+    /* Increase outstanding callback count. */
+    lane->dispatched++;
+    handler->cb_count++;
   }
   return flags;
 }
 
+/**
+ * @brief   Classify a received frame into a dispatch lane.
+ * @notes   Uses the receive filter interest set whether or not the filter
+ *          is enabled.
+ *
+ * @param[in] pkt_buffer    pointer to a @p packet buffer object.
+ *
+ * @return  The lane for the frame.
+ * @retval  PKT_LANE_COMMAND    APRS message addressed to an interest call.
+ * @retval  PKT_LANE_DIGIPEAT   first unused digipeater is ours or an alias.
+ * @retval  PKT_LANE_MONITOR    all other traffic.
+ *
+ * @api
+ */
+pkt_lane_t pktClassifyReceivedBuffer(pkt_data_object_t *pkt_buffer) {
+  const pkt_rx_filter_t *filter = &pkt_buffer->handler->rx_filter;
+  ax25char_t *buf = pkt_buffer->buffer;
+  size_t size = pkt_buffer->packet_size;
+  pkt_lane_t lane = PKT_LANE_MONITOR;
+  bool digi_checked = false;
+  size_t n = 0;
+  uint8_t index = 0;
+
+  /* Walk the address field. */
+  while(true) {
+    if(n + PKT_DS_ADDRESS_LEN > size || index >= PKT_MAX_ADDRS)
+      return PKT_LANE_MONITOR;
+    ax25char_t *addr = &buf[n];
+    n += PKT_DS_ADDRESS_LEN;
+    bool last = (addr[PKT_DS_ADDRESS_LEN - 1] & 0x01) != 0;
+    if(index >= PKT_REPEATER_1 && !digi_checked
+        && !(addr[PKT_DS_ADDRESS_LEN - 1] & 0x80)) {
+      char call[PKT_MAX_ADDR_LEN];
+      digi_checked = true;
+      if(pktDecodeFilterAddress(addr, call)
+          && ((filter->wide && pktIsFilterAlias(filter, call))
+              || pktIsFilterCall(filter, call)))
+        lane = PKT_LANE_DIGIPEAT;
+    }
+    index++;
+    if(last)
+      break;
+  }
+
+  /* Check for ":ADDRESSEE:" after control and PID. */
+  n += PKT_CONTROL_LEN + PKT_PROTOCOL_LEN;
+  if(n + PKT_MSG_ADDRESSEE_LEN + 2U + PKT_CRC_LEN > size)
+    return lane;
+  ax25char_t *info = &buf[n];
+  if(info[0] != ':' || info[PKT_MSG_ADDRESSEE_LEN + 1] != ':')
+    return lane;
+  char dest[PKT_MSG_ADDRESSEE_LEN + 1];
+  uint8_t i;
+  for(i = 0; i < PKT_MSG_ADDRESSEE_LEN && info[i + 1] != ' '; i++)
+    dest[i] = toupper(info[i + 1]);
+  dest[i] = 0;
+  return pktIsFilterCall(filter, dest) ? PKT_LANE_COMMAND : lane;
+}
+
 /**
  * @brief   Create a callback processing thread.
  * @notes   Packet callbacks are processed by individual threads.
@@ -692,11 +834,11 @@ thread_t *pktCreateBufferCallback(pkt_data_object_t *pkt_buffer) {
   chsnprintf(pkt_buffer->cb_thd_name, sizeof(pkt_buffer->cb_thd_name),
              PKT_CALLBACK_THD_PREFIX"%x", pkt_buffer);
 
-  /* Start a callback dispatcher thread. */
+  /* Start a callback dispatcher thread at the priority of its lane. */
   thread_t *cb_thd = chThdCreateFromHeap(NULL,
               THD_WORKING_AREA_SIZE(PKT_CALLBACK_WA_SIZE),
               pkt_buffer->cb_thd_name,
-              NORMALPRIO - 20,
+              lane_conf[pkt_buffer->lane].prio,
               pktCallback,
               pkt_buffer);
 
@@ -25,6 +25,29 @@
 #define PKT_CALLBACK_WA_SIZE             (1024 * 10)
 #define PKT_TERMINATOR_WA_SIZE           (1024 * 1)
 
+/*
+ * Receive dispatch lanes.
+ * Callback thread priority and maximum callbacks in flight per lane.
+ * Lane limits apply only when free receive buffers drop below the reserve.
+ * Monitor traffic is then shed first when its lane is full.
+ */
+#define PKT_LANE_COMMAND_PRIO            (NORMALPRIO - 10)
+#define PKT_LANE_DIGIPEAT_PRIO           (NORMALPRIO - 20)
+#define PKT_LANE_MONITOR_PRIO            (NORMALPRIO - 25)
+
+#if !defined(PKT_LANE_COMMAND_LIMIT)
+#define PKT_LANE_COMMAND_LIMIT           4
+#endif
+#if !defined(PKT_LANE_DIGIPEAT_LIMIT)
+#define PKT_LANE_DIGIPEAT_LIMIT          2
+#endif
+#if !defined(PKT_LANE_MONITOR_LIMIT)
+#define PKT_LANE_MONITOR_LIMIT           1
+#endif
+#if !defined(PKT_LANE_BUFFER_RESERVE)
+#define PKT_LANE_BUFFER_RESERVE          2
+#endif
+
 /*===========================================================================*/
 /* Module data structures and types.                                         */
 /*===========================================================================*/
@@ -47,7 +70,8 @@ typedef enum HDLCFrameStates {
   FRAME_OPEN,
   FRAME_DATA,
   FRAME_CLOSE,
-  FRAME_RESET
+  FRAME_RESET,
+  FRAME_REJECT
 } frame_state_t;
 
 #include "types.h"
@@ -57,6 +81,23 @@ typedef mod_t encoding_type_t;
 
 #include "pktradio.h"
 
+/* Receive dispatch lanes in priority order. */
+typedef enum {
+  PKT_LANE_COMMAND = 0,
+  PKT_LANE_DIGIPEAT,
+  PKT_LANE_MONITOR,
+  PKT_LANES
+} pkt_lane_t;
+
+/* Receive dispatch lane statistics. */
+typedef struct {
+  uint16_t                  in_flight;
+  uint16_t                  dispatched;
+  uint16_t                  dropped;
+  sysinterval_t             latency_max;
+  uint32_t                  latency_total;  /* Ticks dispatch to release. */
+} pkt_lane_stats_t;
+
 /* Receive packet buffer. */
 typedef struct packetBuffer pkt_data_object_t;
 
@@ -71,6 +112,8 @@ typedef struct packetBuffer {
   char                      cb_thd_name[PKT_THREAD_NAME_MAX];
   pkt_buffer_cb_t           cb_func;
   volatile eventflags_t     status;
+  pkt_lane_t                lane;
+  systime_t                 dispatch_time;
   size_t                    buffer_size;
   size_t                    packet_size;
 #if USE_CCM_HEAP_RX_BUFFERS == TRUE
@@ -144,6 +187,11 @@ typedef struct packetHandlerData {
    */
   uint8_t                   tx_count;
 
+  /**
+   * @brief Transmit scheduler held sends and airtime accounting.
+   */
+  pkt_tx_sched_t            tx_sched;
+
   /**
    * @brief Pointer to link level protocol data.
    */
@@ -215,6 +263,24 @@ typedef struct packetHandlerData {
   uint16_t                  frame_count;
   uint16_t                  good_count;
   uint16_t                  valid_count;
+
+  /**
+   * @brief Receive address filter and per frame decision.
+   */
+  pkt_rx_filter_t           rx_filter;
+  pkt_filter_state_t        filter_state;
+  uint16_t                  filter_info;
+
+  /**
+   * @brief Receive filter counters.
+   */
+  uint16_t                  filter_pass_count;
+  uint16_t                  filter_drop_count[PKT_DROP_REASONS];
+
+  /**
+   * @brief Receive dispatch lane statistics.
+   */
+  pkt_lane_stats_t          lanes[PKT_LANES];
 } packet_svc_t;
 
 /*===========================================================================*/
@@ -244,6 +310,7 @@ extern "C" {
   msg_t pktCloseRadioReceive(const radio_unit_t radio);
   bool  pktStoreBufferData(pkt_data_object_t *buffer, ax25char_t data);
   eventflags_t  pktDispatchReceivedBuffer(pkt_data_object_t *pkt_buffer);
+  pkt_lane_t pktClassifyReceivedBuffer(pkt_data_object_t *pkt_buffer);
   thread_t *pktCreateBufferCallback(pkt_data_object_t *pkt_buffer);
   void pktCallback(void *arg);
   void pktCallbackManagerOpen(const radio_unit_t radio);
@@ -260,6 +327,8 @@ extern "C" {
   dyn_semaphore_t *pktInitBufferControl(void);
   void pktDeinitBufferControl(void);
   packet_svc_t *pktGetServiceObject(radio_unit_t radio);
+  msg_t pktSetReceiveFilter(const radio_unit_t radio,
+                            const pkt_rx_filter_t *filter);
 #ifdef __cplusplus
 }
 #endif
@@ -441,6 +510,15 @@ static inline void pktReleaseDataBuffer(pkt_data_object_t *object) {
 
   /* Is this a callback release? */
   if(object->cb_func != NULL) {
+    /* Close out the dispatch lane entry. */
+    pkt_lane_stats_t *lane = &object->handler->lanes[object->lane];
+    sysinterval_t latency = chVTTimeElapsedSinceX(object->dispatch_time);
+    chSysLock();
+    lane->in_flight--;
+    lane->latency_total += latency;
+    if(latency > lane->latency_max)
+      lane->latency_max = latency;
+    chSysUnlock();
 #if PKT_RX_RLS_USE_NO_FIFO == TRUE
     extern void pktThdTerminateSelf(void);
     /*
@@ -107,6 +107,7 @@
 
 /* Console thread event masks. */
 #define CONSOLE_CHANNEL_EVT     EVENT_MASK(EVT_PRIORITY_BASE + 0)
+#define CONSOLE_CHILD_EVT       EVENT_MASK(EVT_PRIORITY_BASE + 1)
 
 /* Response thread event masks (from decoder to initiator). */
 #define DEC_OPEN_EXEC           EVENT_MASK(EVT_PRIORITY_BASE + 15)
@@ -140,6 +141,7 @@ typedef uint32_t            statusmask_t;    /**< Mask of status identifiers. */
 #define STA_AFSK_INVALID_SWAP       STATUS_MASK(9)
 #define STA_PWM_STREAM_TIMEOUT      STATUS_MASK(10)
 #define STA_PKT_NO_BUFFER           STATUS_MASK(11)
+#define STA_PKT_FILTERED            STATUS_MASK(12)
 
 /**
  * Use this attribute to put variables in CCM.
@@ -175,6 +177,7 @@ typedef uint32_t            statusmask_t;    /**< Mask of status identifiers. */
 #include "rxpwm.h"
 #include "firfilter_q31.h"
 #include "rxafsk.h"
+#include "rxfsk.h"
 #include "corr_q31.h"
 #include "rxhdlc.h"
 #include "txhdlc.h"
@@ -196,6 +199,14 @@ typedef uint32_t            statusmask_t;    /**< Mask of status identifiers. */
 #define PKT_SVC_USE_RADIO2 FALSE
 #endif
 
+/*
+ * 9600 baud 2FSK receive is experimental. The radio receive settings have
+ * not been confirmed on hardware.
+ */
+#if !defined(PKT_RX_USE_2FSK)
+#define PKT_RX_USE_2FSK FALSE
+#endif
+
 /*===========================================================================*/
 /* External declarations.                                                    */
 /*===========================================================================*/
@@ -59,6 +59,11 @@
 #define PKT_FLAG_LEN           1
 #define PKT_MIN_INFO_LEN       0
 
+/* Receive filter interest set size. */
+#define PKT_FILTER_MAX_CALLS   6
+/* APRS message addressee field ":ADDRESSEE:". */
+#define PKT_MSG_ADDRESSEE_LEN  9
+
 
 /* An AX.25 packet can have a control byte and no protocol. */
 #define PKT_MIN_PACKET_LEN     (PKT_MIN_ADDRS * PKT_DS_ADDRESS_LEN        \
@@ -93,6 +98,44 @@
 
 typedef int16_t ax25size_t;
 
+/**
+ * @brief   Receive filter decision for the frame being received.
+ */
+typedef enum {
+  PKT_FILTER_PENDING = 0,
+  PKT_FILTER_ACCEPT,
+  PKT_FILTER_MESSAGE,
+  PKT_FILTER_REJECT
+} pkt_filter_state_t;
+
+/**
+ * @brief   Receive filter drop reasons.
+ */
+typedef enum {
+  PKT_DROP_NO_MATCH = 0,      /**< No interest call or digipeat alias.    */
+  PKT_DROP_NOT_ADDRESSEE,     /**< Message not addressed to an interest.  */
+  PKT_DROP_BAD_ADDRESS,       /**< Address field is not valid AX25.       */
+  PKT_DROP_REASONS
+} pkt_drop_reason_t;
+
+/**
+ * @brief   Receive filter interest set.
+ * @notes   Calls are upper case text with optional SSID (e.g. "DL7AD-15").
+ * @notes   A frame is accepted if any destination, source or digipeater
+ *          address matches a call, the first unused digipeater matches the
+ *          digipeater alias or WIDEn-N patterns (when enabled) or it is an
+ *          APRS message to a call.
+ */
+typedef struct {
+  bool      enabled;
+  bool      wide;           /**< @brief Accept digipeat aliases.          */
+  bool      messages;       /**< @brief Accept messages to listed calls.  */
+  char      *alias_re;      /**< @brief Digipeater alias pattern.         */
+  char      *wide_re;       /**< @brief Digipeater WIDEn-N pattern.       */
+  uint8_t   num_calls;
+  char      call[PKT_FILTER_MAX_CALLS][PKT_MAX_ADDR_LEN];
+} pkt_rx_filter_t;
+
 #endif /* PKT_PROTOCOLS_RXAX25_H_ */
 
 /** @} */
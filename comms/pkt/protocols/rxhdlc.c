@@ -7,36 +7,215 @@
 */
 
 #include "pktconf.h"
+#include "crx.h"
+#include <ctype.h>
 
 /**
- * @brief   Extract HDLC from AFSK.
+ * @brief   Decode an AX25 address into text.
+ *
+ * @param[in]   addr    pointer to the 7 byte shifted address.
+ * @param[out]  call    buffer of at least @p PKT_MAX_ADDR_LEN for text.
+ *
+ * @return  status of decode
+ * @retval  true    address contains only valid characters.
+ * @retval  false   address is malformed.
+ *
+ * @api
+ */
+bool pktDecodeFilterAddress(const ax25char_t *addr, char *call) {
+  uint8_t n = 0;
+  for(uint8_t i = 0; i < PKT_DS_ADDRESS_LEN - 1; i++) {
+    char c = (addr[i] >> 1) & 0x7F;
+    if(c == ' ') {
+      /* Only trailing spaces are allowed. */
+      while(++i < PKT_DS_ADDRESS_LEN - 1) {
+        if(((addr[i] >> 1) & 0x7F) != ' ')
+          return false;
+      }
+      break;
+    }
+    if(!((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')))
+      return false;
+    call[n++] = c;
+  }
+  if(n == 0)
+    return false;
+  uint8_t ssid = (addr[PKT_DS_ADDRESS_LEN - 1] >> 1) & 0x0F;
+  if(ssid != 0) {
+    call[n++] = '-';
+    if(ssid >= 10) {
+      call[n++] = '1';
+      ssid -= 10;
+    }
+    call[n++] = '0' + ssid;
+  }
+  call[n] = 0;
+  return true;
+}
+
+/**
+ * @brief   Check if a call is in the filter interest set.
+ *
+ * @api
+ */
+bool pktIsFilterCall(const pkt_rx_filter_t *filter, const char *call) {
+  for(uint8_t i = 0; i < filter->num_calls; i++) {
+    if(strcmp(filter->call[i], call) == 0)
+      return true;
+  }
+  return false;
+}
+
+/**
+ * @brief   Check if a call is a digipeat alias of the filter.
+ * @notes   Matched as the digipeater does so against its alias
+ *          (e.g. CITYD) and WIDEn-N patterns.
+ *
+ * @api
+ */
+bool pktIsFilterAlias(const pkt_rx_filter_t *filter, char *call) {
+  int found_len = 0;
+  if(filter->alias_re != NULL) {
+    (void)regex(filter->alias_re, call, &found_len);
+    if(found_len != 0)
+      return true;
+  }
+  if(filter->wide_re != NULL)
+    (void)regex(filter->wide_re, call, &found_len);
+  return found_len != 0;
+}
+
+/**
+ * @brief   Record a filter decision.
+ */
+static pkt_filter_state_t pktSetFilterResult(packet_svc_t *handler,
+                                             pkt_filter_state_t state,
+                                             pkt_drop_reason_t reason) {
+  handler->filter_state = state;
+  if(state == PKT_FILTER_ACCEPT)
+    handler->filter_pass_count++;
+  else if(state == PKT_FILTER_REJECT)
+    handler->filter_drop_count[reason]++;
+  return state;
+}
+
+/**
+ * @brief   Apply the receive address filter to the frame being received.
+ * @notes   Called after each byte is stored in the active packet buffer.
+ * @notes   Each address is checked as soon as it has been destuffed.
+ * @notes   A decision is made at the first unused digipeater address or at
+ *          the end of the address field. If messages are accepted and no
+ *          address matched the decision is deferred to the APRS addressee.
+ *
+ * @param[in]   handler   pointer to a @p packet handler object.
+ *
+ * @return  filter state for the frame
+ * @retval  PKT_FILTER_REJECT   the frame should be abandoned.
+ *
+ * @notapi
+ */
+static pkt_filter_state_t pktCheckReceiveFilter(packet_svc_t *handler) {
+  pkt_data_object_t *object = handler->active_packet_object;
+  const pkt_rx_filter_t *filter = &handler->rx_filter;
+  size_t n = object->packet_size;
+  ax25char_t *buf = object->buffer;
+
+  /* First byte of a new frame. */
+  if(n == 1)
+    handler->filter_state = PKT_FILTER_PENDING;
+
+  switch(handler->filter_state) {
+  case PKT_FILTER_PENDING:
+    break;
+
+  case PKT_FILTER_MESSAGE: {
+    /* Wait for ":ADDRESSEE:" to be received. */
+    if(n < handler->filter_info + PKT_MSG_ADDRESSEE_LEN + 2U)
+      return PKT_FILTER_MESSAGE;
+    ax25char_t *info = &buf[handler->filter_info];
+    if(info[0] == ':' && info[PKT_MSG_ADDRESSEE_LEN + 1] == ':') {
+      char dest[PKT_MSG_ADDRESSEE_LEN + 1];
+      uint8_t i;
+      for(i = 0; i < PKT_MSG_ADDRESSEE_LEN && info[i + 1] != ' '; i++)
+        dest[i] = toupper(info[i + 1]);
+      dest[i] = 0;
+      if(pktIsFilterCall(filter, dest))
+        return pktSetFilterResult(handler, PKT_FILTER_ACCEPT,
+                                  PKT_DROP_REASONS);
+    }
+    return pktSetFilterResult(handler, PKT_FILTER_REJECT,
+                              PKT_DROP_NOT_ADDRESSEE);
+  }
+
+  default:
+    return handler->filter_state;
+  }
+
+  /* Check each address once all of its bytes are in. */
+  if((n % PKT_DS_ADDRESS_LEN) != 0)
+    return PKT_FILTER_PENDING;
+
+  uint8_t index = (n / PKT_DS_ADDRESS_LEN) - 1;
+  ax25char_t *addr = &buf[n - PKT_DS_ADDRESS_LEN];
+  bool last = (addr[PKT_DS_ADDRESS_LEN - 1] & 0x01) != 0;
+  char call[PKT_MAX_ADDR_LEN];
+
+  if(!pktDecodeFilterAddress(addr, call)
+      || (index == PKT_DESTINATION && last)
+      || (index >= PKT_MAX_ADDRS)) {
+    return pktSetFilterResult(handler, PKT_FILTER_REJECT,
+                              PKT_DROP_BAD_ADDRESS);
+  }
+
+  if(pktIsFilterCall(filter, call))
+    return pktSetFilterResult(handler, PKT_FILTER_ACCEPT, PKT_DROP_REASONS);
+
+  /* The H bit is clear in an unused digipeater address. */
+  bool unused_digi = (index >= PKT_REPEATER_1)
+      && !(addr[PKT_DS_ADDRESS_LEN - 1] & 0x80);
+  if(unused_digi && filter->wide && pktIsFilterAlias(filter, call))
+    return pktSetFilterResult(handler, PKT_FILTER_ACCEPT, PKT_DROP_REASONS);
+
+  if(!last && !(unused_digi && !filter->messages))
+    return PKT_FILTER_PENDING;
+
+  if(!filter->messages || !last) {
+    /* No interest found by the first unused digipeater. */
+    return pktSetFilterResult(handler, PKT_FILTER_REJECT, PKT_DROP_NO_MATCH);
+  }
+
+  /* Info follows control and PID. */
+  handler->filter_info = n + PKT_CONTROL_LEN + PKT_PROTOCOL_LEN;
+  handler->filter_state = PKT_FILTER_MESSAGE;
+  return PKT_FILTER_MESSAGE;
+}
+
+/**
+ * @brief   Add a decoded bit to the HDLC frame.
  * @post    The HDLC state will be updated.
  * @notes   In the case of an HDLC_RESET HDLC sync can be restarted.
  * @notes   This is done where the AX25 payload is below minimum size.
  * @notes   If the payload is above minimum size state HDLC_RESET is set.
  * @notes   In that case it is left to the decoder to determine an action.
+ * @notes   If the receive filter rejects the frame state FRAME_REJECT is set.
  *
  * @param[in]   myDriver   pointer to an @p AFSKDemodDriver structure.
+ * @param[in]   bit        the NRZI decoded bit.
  *
  * @return  status of operation
  * @retval  true    character processed and HDLC state updated on flags.
  * @retval  false   frame buffer full.
  *
- * @api
+ * @notapi
  */
-bool pktExtractHDLCfromAFSK(AFSKDemodDriver *myDriver) {
+static bool pktExtractHDLCbit(AFSKDemodDriver *myDriver, uint8_t bit) {
 
   packet_svc_t *myHandler = myDriver->packet_handler;
 
   /* Shift prior HDLC bits up before adding new bit. */
   myDriver->hdlc_bits <<= 1;
   myDriver->hdlc_bits &= 0xFE;
-  /* Same tone indicates a 1. */
-  if(myDriver->tone_freq == myDriver->prior_freq) {
-    myDriver->hdlc_bits |= 1;
-  }
-  /* Update the prior frequency. */
-  myDriver->prior_freq = myDriver->tone_freq;
+  myDriver->hdlc_bits |= (bit & 1);
 
   /*
    * Check if we are in AX25 data capture mode.
@@ -112,6 +291,11 @@ bool pktExtractHDLCfromAFSK(AFSKDemodDriver *myDriver) {
          myDriver->bit_index = 0;
          if(pktStoreBufferData(myHandler->active_packet_object,
                          myDriver->current_byte)) {
+           /* Abandon the frame early if it is of no interest. */
+           if(myHandler->rx_filter.enabled
+               && pktCheckReceiveFilter(myHandler) == PKT_FILTER_REJECT) {
+             myDriver->frame_state = FRAME_REJECT;
+           }
            return true;
          }
          pktAddEventFlags(myHandler, EVT_PKT_BUFFER_FULL);
@@ -154,4 +338,40 @@ bool pktExtractHDLCfromAFSK(AFSKDemodDriver *myDriver) {
   } /* End switch on frame state. */
 } /* End function. */
 
+/**
+ * @brief   Extract HDLC from AFSK.
+ * @notes   The tones are NRZI decoded. Same tone indicates a 1.
+ *
+ * @param[in]   myDriver   pointer to an @p AFSKDemodDriver structure.
+ *
+ * @return  status of operation
+ * @retval  true    character processed and HDLC state updated on flags.
+ * @retval  false   frame buffer full.
+ *
+ * @api
+ */
+bool pktExtractHDLCfromAFSK(AFSKDemodDriver *myDriver) {
+  uint8_t bit = (myDriver->tone_freq == myDriver->prior_freq) ? 1 : 0;
+  /* Update the prior frequency. */
+  myDriver->prior_freq = myDriver->tone_freq;
+  return pktExtractHDLCbit(myDriver, bit);
+}
+
+/**
+ * @brief   Extract HDLC from 2FSK.
+ * @notes   The bit has been NRZI decoded and descrambled by the channel.
+ *
+ * @param[in]   myDriver   pointer to an @p AFSKDemodDriver structure.
+ * @param[in]   bit        the data bit.
+ *
+ * @return  status of operation
+ * @retval  true    character processed and HDLC state updated on flags.
+ * @retval  false   frame buffer full.
+ *
+ * @api
+ */
+bool pktExtractHDLCfrom2FSK(AFSKDemodDriver *myDriver, uint8_t bit) {
+  return pktExtractHDLCbit(myDriver, bit);
+}
+
 /** @} */
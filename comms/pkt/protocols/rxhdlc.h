@@ -35,6 +35,10 @@
   extern "C" {
   #endif
     bool pktExtractHDLCfromAFSK(AFSKDemodDriver *myDriver);
+    bool pktExtractHDLCfrom2FSK(AFSKDemodDriver *myDriver, uint8_t bit);
+    bool pktDecodeFilterAddress(const ax25char_t *addr, char *call);
+    bool pktIsFilterCall(const pkt_rx_filter_t *filter, const char *call);
+    bool pktIsFilterAlias(const pkt_rx_filter_t *filter, char *call);
   #ifdef __cplusplus
   }
   #endif
@@ -43,6 +43,42 @@ void pktStreamIteratorInit(tx_iterator_t *iterator,
 }
 
 
+/**
+ * @brief   Stream length of an initialized iterator.
+ * @notes   Only the RLL inserted bits are counted in one pass over the frame
+ *          and CRC. Nothing is encoded so the length is available at once.
+ * @notes   The result equals the count returned for a quantity zero request.
+ *
+ * @param[in]   iterator    pointer to an initialized @p iterator object.
+ *
+ * @return  the number of stream bytes.
+ *
+ * @api
+ */
+uint16_t pktStreamEncodingLength(tx_iterator_t *iterator) {
+  uint32_t data = iterator->data_size + sizeof(iterator->crc);
+  uint32_t rll = 0;
+  uint8_t ones = 0;
+
+  /* The preamble ends on a zero so the frame starts with no run of ones. */
+  for(uint32_t i = 0; i < data; i++) {
+    uint8_t byte = (i < iterator->data_size) ? iterator->data_buff[i]
+                   : iterator->crc[i - iterator->data_size];
+    for(uint8_t n = 0; n < 8; n++, byte >>= 1) {
+      /* A zero is inserted ahead of a bit which follows five ones. */
+      if(ones == 5) {
+        rll++;
+        ones = 0;
+      }
+      ones = (byte & 0x1) ? ones + 1 : 0;
+    }
+  }
+  uint32_t bits = (iterator->hdlc_count + data + iterator->hdlc_post
+                   + iterator->hdlc_tail) * 8 + rll;
+  uint32_t length = (bits + 7) / 8;
+  return (length > ITERATOR_MAX_QTY) ? ITERATOR_MAX_QTY : length;
+}
+
 /**
  * @brief   Write NRZI stream data to buffer.
  * @post    NRZI encoded bits are written to the stream.
@@ -297,8 +333,11 @@ uint16_t pktStreamEncodingIterator(tx_iterator_t *iterator,
           /* True means the requested count has been reached. */
           return iterator->qty;
       } /* End while. */
-      /* Account for RLL inserted bits. */
-      iterator->hdlc_count = ((iterator->rll_count + 7) / 8);
+      /*
+       * RLL inserted bits are already in the output count.
+       * Only a partly filled last byte remains to be counted.
+       */
+      iterator->hdlc_count = ((iterator->out_index % 8) != 0) ? 1 : 0;
       iterator->state = ITERATE_FINAL;
       continue;
     } /* End case ITERATE_TAIL. */
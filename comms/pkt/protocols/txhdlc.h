@@ -72,6 +72,7 @@ extern "C" {
 #endif
   uint16_t pktStreamEncodingIterator(tx_iterator_t *iterator,
                                      uint8_t *stream, uint16_t qty);
+  uint16_t pktStreamEncodingLength(tx_iterator_t *iterator);
   void pktStreamIteratorInit(tx_iterator_t *iterator,
                              packet_t pp,
                              uint8_t pre,
@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <ctype.h>
 #include "debug.h"
 #include "base91.h"
 #include "digipeater.h"
@@ -31,6 +32,14 @@
 
 #define METER_TO_FEET(m) (((m)*26876) / 8192)
 
+/* Size of the monitor text buffers used by the full text encoders. */
+#define APRS_XMIT_LEN    256
+
+/* Template info text is written in the frame after the constant part. */
+#if AX25_MAX_PACKET_LEN + 1 - APRS_TEMPLATE_FRAME_LEN < APRS_XMIT_LEN
+#error "Packet frame too small for template info text"
+#endif
+
 typedef struct {
 	sysinterval_t time;
 	char call[AX25_MAX_ADDR_LEN];
@@ -92,6 +101,8 @@ const conf_command_t command_list[] = {
 	{TYPE_STR,  "img_pri.path",                  sizeof(conf_sram.img_pri.path),                              &conf_sram.img_pri.path                             },
 	{TYPE_INT,  "img_pri.res",                   sizeof(conf_sram.img_pri.res),                               &conf_sram.img_pri.res                              },
 	{TYPE_INT,  "img_pri.quality",               sizeof(conf_sram.img_pri.quality),                           &conf_sram.img_pri.quality                          },
+	{TYPE_INT,  "img_pri.packet_budget",         sizeof(conf_sram.img_pri.packet_budget),                     &conf_sram.img_pri.packet_budget                    },
+	{TYPE_INT,  "img_pri.preview",               sizeof(conf_sram.img_pri.preview),                           &conf_sram.img_pri.preview                          },
 	{TYPE_INT,  "img_pri.buf_size",              sizeof(conf_sram.img_pri.buf_size),                          &conf_sram.img_pri.buf_size                         },
 
 	{TYPE_INT,  "img_sec.active",                sizeof(conf_sram.img_sec.svc_conf.active),                   &conf_sram.img_sec.svc_conf.active                  },
@@ -111,6 +122,8 @@ const conf_command_t command_list[] = {
 	{TYPE_STR,  "img_sec.path",                  sizeof(conf_sram.img_sec.path),                              &conf_sram.img_sec.path                             },
 	{TYPE_INT,  "img_sec.res",                   sizeof(conf_sram.img_sec.res),                               &conf_sram.img_sec.res                              },
 	{TYPE_INT,  "img_sec.quality",               sizeof(conf_sram.img_sec.quality),                           &conf_sram.img_sec.quality                          },
+	{TYPE_INT,  "img_sec.packet_budget",         sizeof(conf_sram.img_sec.packet_budget),                     &conf_sram.img_sec.packet_budget                    },
+	{TYPE_INT,  "img_sec.preview",               sizeof(conf_sram.img_sec.preview),                           &conf_sram.img_sec.preview                          },
 	{TYPE_INT,  "img_sec.buf_size",              sizeof(conf_sram.img_sec.buf_size),                          &conf_sram.img_sec.buf_size                         },
 
 	{TYPE_INT,  "log.active",                    sizeof(conf_sram.log.svc_conf.active),                       &conf_sram.log.svc_conf.active                      },
@@ -138,6 +151,7 @@ const conf_command_t command_list[] = {
     {TYPE_STR,  "aprs.rx.call",                  sizeof(conf_sram.aprs.rx.call),                              &conf_sram.aprs.rx.call                             },
 
     {TYPE_INT,  "aprs.digi",                     sizeof(conf_sram.aprs.digi),                                 &conf_sram.aprs.digi                                },
+    {TYPE_INT,  "aprs.filter",                   sizeof(conf_sram.aprs.filter),                               &conf_sram.aprs.filter                              },
 	{TYPE_INT,  "aprs.tx.freq",                  sizeof(conf_sram.aprs.tx.radio_conf.freq),                   &conf_sram.aprs.tx.radio_conf.freq                  },
     {TYPE_INT,  "aprs.tx.pwr",                   sizeof(conf_sram.aprs.tx.radio_conf.pwr),                    &conf_sram.aprs.tx.radio_conf.pwr                   },
     {TYPE_INT,  "aprs.tx.mod",                   sizeof(conf_sram.aprs.tx.radio_conf.mod),                    &conf_sram.aprs.tx.radio_conf.mod                   },
@@ -285,20 +299,17 @@ void aprs_debug_getPacket(packet_t pp, char* buf, uint32_t len)
 }
 
 /**
- * @brief  Transmit APRS position packet.
+ * @brief   Encode compressed position, symbol and altitude.
+ * @notes   Always writes 13 characters (not terminated).
  *
- * @param[in] callsign  origination call sign
- * @param[in] path      path to use
- * @param[in] symbol    symbol for originator
- * @param[in] dataPoint position data object
+ * @param[out] out       buffer for encoded characters
+ * @param[in]  symbol    symbol for originator
+ * @param[in]  dataPoint position data object
  *
- * @return    encoded packet object pointer
- * @retval    NULL if encoding failed
+ * @return    number of characters written
  */
-packet_t aprs_encode_stamped_position_and_telemetry(const char *callsign,
-                              const char *path, aprs_sym_t symbol,
-                              dataPoint_t *dataPoint) {
-
+static uint32_t aprs_encode_compressed_position(char *out, aprs_sym_t symbol,
+                                                dataPoint_t *dataPoint) {
   // Latitude
   uint32_t y = 380926 * (90 - dataPoint->gps_lat/10000000.0);
   uint32_t y3  = y   / 753571;
@@ -328,46 +339,45 @@ packet_t aprs_encode_stamped_position_and_telemetry(const char *callsign,
   uint8_t src = NMEA_SRC_GGA;
   uint8_t origin = ORIGIN_PICO;
 
-  ptime_t time;
-  getTime(&time);
-  if(time.year == RTC_BASE_YEAR)
-    /* RTC is not set so use dataPoint (it may have a valid date). */
-    unixTimestamp2Date(&time, dataPoint->gps_time);
-  char xmit[256];
-  uint32_t len = chsnprintf(xmit, sizeof(xmit), "%s>%s,%s:@%02d%02d%02dz",
-                            callsign,
-                            APRS_DEVICE_CALLSIGN,
-                            path,
-                            time.day,
-                            time.hour,
-                            time.minute);
-
-  xmit[len+0]  = (symbol >> 8) & 0xFF;
-  xmit[len+1]  = y3+33;
-  xmit[len+2]  = y2+33;
-  xmit[len+3]  = y1+33;
-  xmit[len+4]  = y1r+33;
-  xmit[len+5]  = x3+33;
-  xmit[len+6]  = x2+33;
-  xmit[len+7]  = x1+33;
-  xmit[len+8]  = x1r+33;
-  xmit[len+9]  = symbol & 0xFF;
-  xmit[len+10] = a1+33;
-  xmit[len+11] = a1r+33;
-  xmit[len+12] = ((gpsFix << 5) | (src << 3) | origin) + 33;
+  out[0]  = (symbol >> 8) & 0xFF;
+  out[1]  = y3+33;
+  out[2]  = y2+33;
+  out[3]  = y1+33;
+  out[4]  = y1r+33;
+  out[5]  = x3+33;
+  out[6]  = x2+33;
+  out[7]  = x1+33;
+  out[8]  = x1r+33;
+  out[9]  = symbol & 0xFF;
+  out[10] = a1+33;
+  out[11] = a1r+33;
+  out[12] = ((gpsFix << 5) | (src << 3) | origin) + 33;
+  return 13;
+}
 
+/**
+ * @brief   Encode datapoint comment and base 91 telemetry.
+ * @notes   The output is terminated.
+ *
+ * @param[out] out       buffer for encoded characters
+ * @param[in]  dataPoint position data object
+ *
+ * @return    number of characters written excluding terminator
+ */
+static uint32_t aprs_encode_telemetry_comment(char *out,
+                                              dataPoint_t *dataPoint) {
   // Comments
   uint32_t len2 = base91_encode((uint8_t*)dataPoint,
-                                (uint8_t*)&xmit[len+13],
+                                (uint8_t*)out,
                                 sizeof(dataPoint_t));
 
-  xmit[len+len2+13] = '|';
+  out[len2] = '|';
 
   /* APRS base91 encoded telemetry. */
   // Sequence ID
   uint32_t t = dataPoint->id & 0x1FFF;
-  xmit[len+len2+14] = t/91 + 33;
-  xmit[len+len2+15] = t%91 + 33;
+  out[len2+1] = t/91 + 33;
+  out[len2+2] = t%91 + 33;
 
   // Telemetry analog parameters
   for(uint8_t i=0; i<5; i++) {
@@ -379,17 +389,58 @@ packet_t aprs_encode_stamped_position_and_telemetry(const char *callsign,
     case 4: t = dataPoint->sen_i1_press/125 - 40;   break;
     }
 
-    xmit[len+len2+16+i*2]   = t/91 + 33;
-    xmit[len+len2+16+i*2+1] = t%91 + 33;
+    out[len2+3+i*2]   = t/91 + 33;
+    out[len2+3+i*2+1] = t%91 + 33;
   }
 
   // Telemetry digital parameter
-  xmit[len+len2+26] = dataPoint->gpio + 33;
+  out[len2+13] = dataPoint->gpio + 33;
 
   /* Digital bits second byte - set zero. */
-  xmit[len+len2+27] = 33;
-  xmit[len+len2+28] = '|';
-  xmit[len+len2+29] = 0;
+  out[len2+14] = 33;
+  out[len2+15] = '|';
+  out[len2+16] = 0;
+  return len2 + 16;
+}
+
+/**
+ * @brief   Get the time stamp used in stamped position reports.
+ */
+static void aprs_get_stamp_time(ptime_t *time, dataPoint_t *dataPoint) {
+  getTime(time);
+  if(time->year == RTC_BASE_YEAR)
+    /* RTC is not set so use dataPoint (it may have a valid date). */
+    unixTimestamp2Date(time, dataPoint->gps_time);
+}
+
+/**
+ * @brief  Transmit APRS position packet.
+ *
+ * @param[in] callsign  origination call sign
+ * @param[in] path      path to use
+ * @param[in] symbol    symbol for originator
+ * @param[in] dataPoint position data object
+ *
+ * @return    encoded packet object pointer
+ * @retval    NULL if encoding failed
+ */
+packet_t aprs_encode_stamped_position_and_telemetry(const char *callsign,
+                              const char *path, aprs_sym_t symbol,
+                              dataPoint_t *dataPoint) {
+
+  ptime_t time;
+  aprs_get_stamp_time(&time, dataPoint);
+  char xmit[256];
+  uint32_t len = chsnprintf(xmit, sizeof(xmit), "%s>%s,%s:@%02d%02d%02dz",
+                            callsign,
+                            APRS_DEVICE_CALLSIGN,
+                            path,
+                            time.day,
+                            time.hour,
+                            time.minute);
+
+  len += aprs_encode_compressed_position(&xmit[len], symbol, dataPoint);
+  aprs_encode_telemetry_comment(&xmit[len], dataPoint);
 
   return ax25_from_text(xmit, true);
 }
@@ -421,28 +472,6 @@ packet_t aprs_encode_position_and_telemetry(const char *callsign,
                               dataPoint_t *dataPoint,
                               bool extended) {
   (void)extended;
-	// Latitude
-	uint32_t y = 380926 * (90 - dataPoint->gps_lat/10000000.0);
-	uint32_t y3  = y   / 753571;
-	uint32_t y3r = y   % 753571;
-	uint32_t y2  = y3r / 8281;
-	uint32_t y2r = y3r % 8281;
-	uint32_t y1  = y2r / 91;
-	uint32_t y1r = y2r % 91;
-
-	// Longitude
-	uint32_t x = 190463 * (180 + dataPoint->gps_lon/10000000.0);
-	uint32_t x3  = x   / 753571;
-	uint32_t x3r = x   % 753571;
-	uint32_t x2  = x3r / 8281;
-	uint32_t x2r = x3r % 8281;
-	uint32_t x1  = x2r / 91;
-	uint32_t x1r = x2r % 91;
-
-	// Altitude
-	uint32_t a = logf(METER_TO_FEET(dataPoint->gps_alt)) / logf(1.002f);
-	uint32_t a1  = a / 91;
-	uint32_t a1r = a % 91;
 
 	char xmit[256];
     uint32_t len = chsnprintf(xmit, sizeof(xmit), "%s>%s,%s:=",
@@ -450,61 +479,8 @@ packet_t aprs_encode_position_and_telemetry(const char *callsign,
                               APRS_DEVICE_CALLSIGN,
                               path);
 
-    uint8_t gpsFix = dataPoint->gps_state == GPS_LOCKED1
-        || dataPoint->gps_state == GPS_LOCKED2
-        || dataPoint->gps_state == GPS_FIXED ? GSP_FIX_CURRENT : GSP_FIX_OLD;
-
-    uint8_t src = NMEA_SRC_GGA;
-    uint8_t origin = ORIGIN_PICO;
-
-	xmit[len+0]  = (symbol >> 8) & 0xFF;
-	xmit[len+1]  = y3+33;
-	xmit[len+2]  = y2+33;
-	xmit[len+3]  = y1+33;
-	xmit[len+4]  = y1r+33;
-	xmit[len+5]  = x3+33;
-	xmit[len+6]  = x2+33;
-	xmit[len+7]  = x1+33;
-	xmit[len+8]  = x1r+33;
-	xmit[len+9]  = symbol & 0xFF;
-	xmit[len+10] = a1+33;
-	xmit[len+11] = a1r+33;
-	xmit[len+12] = ((gpsFix << 5) | (src << 3) | origin) + 33;
-
-	// Comments
-	uint32_t len2 = base91_encode((uint8_t*)dataPoint,
-	                              (uint8_t*)&xmit[len+13],
-	                              sizeof(dataPoint_t));
-
-	xmit[len+len2+13] = '|';
-
-	/* APRS base91 encoded telemetry. */
-	// Sequence ID
-	uint32_t t = dataPoint->id & 0x1FFF;
-	xmit[len+len2+14] = t/91 + 33;
-	xmit[len+len2+15] = t%91 + 33;
-
-	// Telemetry analog parameters
-	for(uint8_t i=0; i<5; i++) {
-		switch(i) {
-			case 0: t = dataPoint->adc_vbat;				break;
-			case 1: t = dataPoint->adc_vsol;				break;
-			case 2: t = dataPoint->pac_pbat+4096;			break;
-			case 3: t = dataPoint->sen_i1_temp/10 + 1000;	break;
-			case 4: t = dataPoint->sen_i1_press/125 - 40;	break;
-		}
-
-		xmit[len+len2+16+i*2]   = t/91 + 33;
-		xmit[len+len2+16+i*2+1] = t%91 + 33;
-	}
-
-    // Telemetry digital parameter
-    xmit[len+len2+26] = dataPoint->gpio + 33;
-
-    /* Digital bits second byte - set zero. */
-    xmit[len+len2+27] = 33;
-    xmit[len+len2+28] = '|';
-	xmit[len+len2+29] = 0;
+    len += aprs_encode_compressed_position(&xmit[len], symbol, dataPoint);
+    aprs_encode_telemetry_comment(&xmit[len], dataPoint);
 
 	return ax25_from_text(xmit, true);
 }
@@ -1305,6 +1281,280 @@ packet_t aprs_encode_telemetry_configuration(const char *originator,
 	}
 }
 
+/**
+ * @brief   Capture an encoded frame as a template.
+ * @notes   The packet buffer is released.
+ *
+ * @param[out] t         frame template
+ * @param[in]  pp        packet produced by @p ax25_from_text()
+ * @param[in]  text_len  length of the monitor text which produced the frame
+ *
+ * @return    status of capture
+ * @retval    true if the frame was captured
+ */
+static bool aprs_template_capture(aprs_frame_template_t *t, packet_t pp,
+                                  uint16_t text_len) {
+  if(pp == NULL)
+    return false;
+  if(pp->frame_len > sizeof(t->frame)) {
+    pktReleasePacketBuffer(pp);
+    return false;
+  }
+  memcpy(t->frame, pp->frame_data, pp->frame_len);
+  t->len = pp->frame_len;
+  t->info = ax25_get_info_offset(pp);
+  t->text_len = text_len;
+  pktReleasePacketBuffer(pp);
+  return true;
+}
+
+/**
+ * @brief   Build a frame template from a monitor format prefix.
+ *
+ * @param[out] t         frame template
+ * @param[in]  prefix    header and constant info in monitor format
+ *
+ * @return    status of build
+ * @retval    true if the template was built
+ */
+static bool aprs_template_build(aprs_frame_template_t *t, char *prefix) {
+  uint16_t text_len = strlen(prefix);
+  return aprs_template_capture(t, ax25_from_text(prefix, true), text_len);
+}
+
+/**
+ * @brief   Start a packet from a frame template.
+ * @notes   The encoded header and constant info are copied. The caller
+ *          then writes the variable info text directly into the frame.
+ *
+ * @param[in]  t         frame template
+ * @param[out] info      where to write the terminated info text
+ *                       (room for @p APRS_XMIT_LEN characters)
+ *
+ * @return    packet object pointer
+ * @retval    NULL if no packet buffer available
+ */
+static packet_t aprs_template_open(const aprs_frame_template_t *t,
+                                   char **info) {
+  packet_t pp;
+  msg_t msg = pktGetPacketBuffer(&pp, TIME_INFINITE);
+  if(msg == MSG_RESET || pp == NULL) {
+    TRACE_ERROR("PKT  > No packet buffer available");
+    return NULL;
+  }
+  memcpy(pp->frame_data, t->frame, t->len);
+  *info = (char *)&pp->frame_data[t->len];
+  return pp;
+}
+
+/**
+ * @brief   Complete a packet started from a frame template.
+ * @notes   The info text in the frame is translated in place exactly as
+ *          @p ax25_from_text() would do so for the same monitor text.
+ *          This includes <0xnn> escapes, truncation to the text buffer
+ *          used by the full encoders and the info and packet length limits.
+ * @notes   The packet buffer is released on failure.
+ *
+ * @param[in] t         frame template
+ * @param[in] pp        packet from @p aprs_template_open()
+ *
+ * @return    encoded packet object pointer
+ * @retval    NULL if the frame would exceed the maximum packet length
+ */
+static packet_t aprs_template_close(const aprs_frame_template_t *t,
+                                    packet_t pp) {
+  const char *info = (char *)&pp->frame_data[t->len];
+  uint16_t flen = t->len;
+  uint16_t info_len = t->len - t->info;
+  size_t remain = 0;
+  if(t->text_len < APRS_XMIT_LEN - 1)
+    remain = strnlen(info, APRS_XMIT_LEN - 1 - t->text_len);
+  /* Translated bytes are never longer than the text so write trails read. */
+  while(remain != 0 && info_len < AX25_MAX_INFO_LEN) {
+    uint8_t c;
+    if(remain >= 6 && info[0] == '<' && info[1] == '0' && info[2] == 'x'
+        && isxdigit((unsigned char)info[3])
+        && isxdigit((unsigned char)info[4]) && info[5] == '>') {
+      c = strtol(&info[3], NULL, 16);
+      info += 6;
+      remain -= 6;
+    } else {
+      c = *info++;
+      remain--;
+    }
+    if(flen >= AX25_MAX_PACKET_LEN) {
+      TRACE_ERROR("PKT  > frame buffer overrun");
+      pktReleasePacketBuffer(pp);
+      return NULL;
+    }
+    pp->frame_data[flen++] = c;
+    info_len++;
+  }
+  pp->frame_len = flen;
+  pp->num_addr = (-1);
+  (void)ax25_get_num_addr(pp);
+  return pp;
+}
+
+/**
+ * @brief   Initialize an APRS frame template set.
+ * @notes   Frames are built on the first @p aprs_template_update().
+ *
+ * @param[out] tpl      template set
+ */
+void aprs_template_init(aprs_template_t *tpl) {
+  memset(tpl, 0, sizeof(aprs_template_t));
+}
+
+/**
+ * @brief   Build or validate the frame templates for an identity.
+ * @notes   Frames are rebuilt only when call sign or path have changed.
+ * @notes   Packet buffers are used briefly during a rebuild.
+ *
+ * @param[in] tpl       template set
+ * @param[in] callsign  origination call sign
+ * @param[in] path      path to use
+ * @param[in] symbol    symbol for originator
+ *
+ * @return    status of templates
+ * @retval    true if the templates can be used
+ * @retval    false if building failed or the identity does not fit
+ *                  (use full encoders instead)
+ */
+bool aprs_template_update(aprs_template_t *tpl, const char *callsign,
+                          const char *path, aprs_sym_t symbol) {
+  tpl->symbol = symbol;
+  if(tpl->valid && strcmp(tpl->call, callsign) == 0
+      && strcmp(tpl->path, path) == 0)
+    return true;
+
+  tpl->valid = false;
+  /* An identity which does not fit would be truncated in the frames. */
+  if(strlcpy(tpl->call, callsign, sizeof(tpl->call)) >= sizeof(tpl->call)
+      || strlcpy(tpl->path, path, sizeof(tpl->path)) >= sizeof(tpl->path))
+    return false;
+
+  char xmit[APRS_XMIT_LEN];
+  chsnprintf(xmit, sizeof(xmit), "%s>%s,%s:=",
+             tpl->call, APRS_DEVICE_CALLSIGN, tpl->path);
+  if(!aprs_template_build(&tpl->position, xmit))
+    return false;
+  chsnprintf(xmit, sizeof(xmit), "%s>%s,%s:@",
+             tpl->call, APRS_DEVICE_CALLSIGN, tpl->path);
+  if(!aprs_template_build(&tpl->stamped, xmit))
+    return false;
+  chsnprintf(xmit, sizeof(xmit), "%s>%s,%s:{{",
+             tpl->call, APRS_DEVICE_CALLSIGN, tpl->path);
+  if(!aprs_template_build(&tpl->data, xmit))
+    return false;
+  /* Telemetry configuration messages have no variable content. */
+  for(uint8_t i = 0; i < APRS_NUM_TELEM_GROUPS; i++) {
+    packet_t pp = aprs_encode_telemetry_configuration(tpl->call, tpl->path,
+                                                      tpl->call, i);
+    if(!aprs_template_capture(&tpl->telem_conf[i], pp, 0))
+      return false;
+  }
+  tpl->valid = true;
+  return true;
+}
+
+/**
+ * @brief   Encode position and telemetry packet from a template.
+ * @notes   Output is identical to @p aprs_encode_position_and_telemetry().
+ *
+ * @param[in] tpl       template set
+ * @param[in] dataPoint position data object
+ *
+ * @return    encoded packet object pointer
+ * @retval    NULL if encoding failed
+ */
+packet_t aprs_template_position_and_telemetry(aprs_template_t *tpl,
+                                              dataPoint_t *dataPoint) {
+  if(!tpl->valid)
+    return NULL;
+  char *info;
+  packet_t pp = aprs_template_open(&tpl->position, &info);
+  if(pp == NULL)
+    return NULL;
+  uint32_t len = aprs_encode_compressed_position(info, tpl->symbol,
+                                                 dataPoint);
+  aprs_encode_telemetry_comment(&info[len], dataPoint);
+  return aprs_template_close(&tpl->position, pp);
+}
+
+/**
+ * @brief   Encode time stamped position and telemetry from a template.
+ * @notes   Output is identical to
+ *          @p aprs_encode_stamped_position_and_telemetry().
+ *
+ * @param[in] tpl       template set
+ * @param[in] dataPoint position data object
+ *
+ * @return    encoded packet object pointer
+ * @retval    NULL if encoding failed
+ */
+packet_t aprs_template_stamped_position_and_telemetry(aprs_template_t *tpl,
+                                                      dataPoint_t *dataPoint) {
+  if(!tpl->valid)
+    return NULL;
+  ptime_t time;
+  aprs_get_stamp_time(&time, dataPoint);
+  char *info;
+  packet_t pp = aprs_template_open(&tpl->stamped, &info);
+  if(pp == NULL)
+    return NULL;
+  uint32_t len = chsnprintf(info, APRS_XMIT_LEN, "%02d%02d%02dz",
+                            time.day, time.hour, time.minute);
+  len += aprs_encode_compressed_position(&info[len], tpl->symbol, dataPoint);
+  aprs_encode_telemetry_comment(&info[len], dataPoint);
+  return aprs_template_close(&tpl->stamped, pp);
+}
+
+/**
+ * @brief   Get a telemetry configuration packet from a template.
+ * @notes   The destination is the template call sign.
+ *
+ * @param[in] tpl       template set
+ * @param[in] type      telemetry group
+ *
+ * @return    encoded packet object pointer
+ * @retval    NULL if encoding failed
+ */
+packet_t aprs_template_telemetry_configuration(aprs_template_t *tpl,
+                                               uint8_t type) {
+  if(!tpl->valid || type >= APRS_NUM_TELEM_GROUPS)
+    return NULL;
+  char *info;
+  packet_t pp = aprs_template_open(&tpl->telem_conf[type], &info);
+  if(pp == NULL)
+    return NULL;
+  info[0] = '\0';
+  return aprs_template_close(&tpl->telem_conf[type], pp);
+}
+
+/**
+ * @brief   Encode data packet from a template.
+ * @notes   Output is identical to @p aprs_encode_data_packet().
+ *
+ * @param[in] tpl           template set
+ * @param[in] packetType    data packet type character
+ * @param[in] data          terminated data string
+ *
+ * @return    encoded packet object pointer
+ * @retval    NULL if encoding failed
+ */
+packet_t aprs_template_data_packet(aprs_template_t *tpl, char packetType,
+                                   uint8_t *data) {
+  if(!tpl->valid)
+    return NULL;
+  char *info;
+  packet_t pp = aprs_template_open(&tpl->data, &info);
+  if(pp == NULL)
+    return NULL;
+  chsnprintf(info, APRS_XMIT_LEN, "%c%s", packetType, data);
+  return aprs_template_close(&tpl->data, pp);
+}
+
 /*
  * 
  */
@@ -58,6 +58,10 @@
 
 #define APRS_MAX_MSG_ARGUMENTS          10
 
+/* Space for addresses, control/PID and the largest static info part. */
+#define APRS_TEMPLATE_FRAME_LEN         (AX25_MAX_ADDRS * AX25_ADDR_LEN     \
+                                         + 2 + 11 + AX25_MAX_APRS_MSG_LEN)
+
 typedef struct APRSIdentity {
   /* APRS parameters. */
   char              num[8];                  /**< @brief Message number.    */
@@ -86,6 +90,38 @@ typedef struct {
   aprscmd_t         ac_function;           /**< @brief Command function.   */
 } APRSCommand;
 
+/**
+ * @brief   Pre-encoded AX.25 frame prefix.
+ * @details Holds the addresses, control, PID and any constant leading
+ *          info bytes of a frame as produced by @p ax25_from_text().
+ */
+typedef struct {
+  uint8_t           frame[APRS_TEMPLATE_FRAME_LEN];
+  uint16_t          len;                   /**< @brief Encoded bytes.      */
+  uint16_t          info;                  /**< @brief Info field offset.  */
+  uint16_t          text_len;              /**< @brief Monitor text used.  */
+} aprs_frame_template_t;
+
+/**
+ * @brief   Pre-encoded frames for one originator identity.
+ * @details Built once per call sign and path. Sends copy the frame and
+ *          write the variable info field content in place behind it.
+ */
+typedef struct {
+  char              call[AX25_MAX_ADDR_LEN];
+  char              path[APRS_PATH_LENGTH];
+  aprs_sym_t        symbol;
+  bool              valid;
+  aprs_frame_template_t position;          /**< @brief "=" position.       */
+  aprs_frame_template_t stamped;           /**< @brief "@" position.       */
+  aprs_frame_template_t data;              /**< @brief "{{" data packet.   */
+  aprs_frame_template_t telem_conf[APRS_NUM_TELEM_GROUPS];
+} aprs_template_t;
+
+
+/* Digipeater patterns (also used by the receive filter). */
+extern char alias_re[];
+extern char wide_re[];
 
 #ifdef __cplusplus
 extern "C" {
@@ -110,6 +146,17 @@ extern "C" {
   packet_t  aprs_compose_aprsd_message(const char *callsign, const char *path,
                                    const char *receiver);
   void      aprs_decode_packet(packet_t pp);
+  void      aprs_template_init(aprs_template_t *tpl);
+  bool      aprs_template_update(aprs_template_t *tpl, const char *callsign,
+                                 const char *path, aprs_sym_t symbol);
+  packet_t  aprs_template_position_and_telemetry(aprs_template_t *tpl,
+                                                 dataPoint_t *dataPoint);
+  packet_t  aprs_template_stamped_position_and_telemetry(aprs_template_t *tpl,
+                                                 dataPoint_t *dataPoint);
+  packet_t  aprs_template_telemetry_configuration(aprs_template_t *tpl,
+                                                  uint8_t type);
+  packet_t  aprs_template_data_packet(aprs_template_t *tpl, char packetType,
+                                      uint8_t *data);
   msg_t     aprs_transmit_telemetry_response(aprs_identity_t *id,
                                   int argc, char *argv[]);
   msg_t     aprs_send_aprsd_message(aprs_identity_t *id,
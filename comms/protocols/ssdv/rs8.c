@@ -8,7 +8,9 @@
 #include <string.h>
 #include "rs8.h"
 
-static const uint8_t ALPHA_TO[] = {
+/* Antilog table, repeated so the sum of two logs can index it directly.
+ * The last two entries are never used. */
+static const uint8_t ALPHA_TO[512] = {
 0x01,0x02,0x04,0x08,0x10,0x20,0x40,0x80,0x87,0x89,0x95,0xAD,0xDD,0x3D,0x7A,0xF4,
 0x6F,0xDE,0x3B,0x76,0xEC,0x5F,0xBE,0xFB,0x71,0xE2,0x43,0x86,0x8B,0x91,0xA5,0xCD,
 0x1D,0x3A,0x74,0xE8,0x57,0xAE,0xDB,0x31,0x62,0xC4,0x0F,0x1E,0x3C,0x78,0xF0,0x67,
@@ -24,7 +26,23 @@ static const uint8_t ALPHA_TO[] = {
 0xB0,0xE7,0x49,0x92,0xA3,0xC1,0x05,0x0A,0x14,0x28,0x50,0xA0,0xC7,0x09,0x12,0x24,
 0x48,0x90,0xA7,0xC9,0x15,0x2A,0x54,0xA8,0xD7,0x29,0x52,0xA4,0xCF,0x19,0x32,0x64,
 0xC8,0x17,0x2E,0x5C,0xB8,0xF7,0x69,0xD2,0x23,0x46,0x8C,0x9F,0xB9,0xF5,0x6D,0xDA,
-0x33,0x66,0xCC,0x1F,0x3E,0x7C,0xF8,0x77,0xEE,0x5B,0xB6,0xEB,0x51,0xA2,0xC3,0x00,
+0x33,0x66,0xCC,0x1F,0x3E,0x7C,0xF8,0x77,0xEE,0x5B,0xB6,0xEB,0x51,0xA2,0xC3,0x01,
+0x02,0x04,0x08,0x10,0x20,0x40,0x80,0x87,0x89,0x95,0xAD,0xDD,0x3D,0x7A,0xF4,0x6F,
+0xDE,0x3B,0x76,0xEC,0x5F,0xBE,0xFB,0x71,0xE2,0x43,0x86,0x8B,0x91,0xA5,0xCD,0x1D,
+0x3A,0x74,0xE8,0x57,0xAE,0xDB,0x31,0x62,0xC4,0x0F,0x1E,0x3C,0x78,0xF0,0x67,0xCE,
+0x1B,0x36,0x6C,0xD8,0x37,0x6E,0xDC,0x3F,0x7E,0xFC,0x7F,0xFE,0x7B,0xF6,0x6B,0xD6,
+0x2B,0x56,0xAC,0xDF,0x39,0x72,0xE4,0x4F,0x9E,0xBB,0xF1,0x65,0xCA,0x13,0x26,0x4C,
+0x98,0xB7,0xE9,0x55,0xAA,0xD3,0x21,0x42,0x84,0x8F,0x99,0xB5,0xED,0x5D,0xBA,0xF3,
+0x61,0xC2,0x03,0x06,0x0C,0x18,0x30,0x60,0xC0,0x07,0x0E,0x1C,0x38,0x70,0xE0,0x47,
+0x8E,0x9B,0xB1,0xE5,0x4D,0x9A,0xB3,0xE1,0x45,0x8A,0x93,0xA1,0xC5,0x0D,0x1A,0x34,
+0x68,0xD0,0x27,0x4E,0x9C,0xBF,0xF9,0x75,0xEA,0x53,0xA6,0xCB,0x11,0x22,0x44,0x88,
+0x97,0xA9,0xD5,0x2D,0x5A,0xB4,0xEF,0x59,0xB2,0xE3,0x41,0x82,0x83,0x81,0x85,0x8D,
+0x9D,0xBD,0xFD,0x7D,0xFA,0x73,0xE6,0x4B,0x96,0xAB,0xD1,0x25,0x4A,0x94,0xAF,0xD9,
+0x35,0x6A,0xD4,0x2F,0x5E,0xBC,0xFF,0x79,0xF2,0x63,0xC6,0x0B,0x16,0x2C,0x58,0xB0,
+0xE7,0x49,0x92,0xA3,0xC1,0x05,0x0A,0x14,0x28,0x50,0xA0,0xC7,0x09,0x12,0x24,0x48,
+0x90,0xA7,0xC9,0x15,0x2A,0x54,0xA8,0xD7,0x29,0x52,0xA4,0xCF,0x19,0x32,0x64,0xC8,
+0x17,0x2E,0x5C,0xB8,0xF7,0x69,0xD2,0x23,0x46,0x8C,0x9F,0xB9,0xF5,0x6D,0xDA,0x33,
+0x66,0xCC,0x1F,0x3E,0x7C,0xF8,0x77,0xEE,0x5B,0xB6,0xEB,0x51,0xA2,0xC3,0x00,0x00,
 };
 
 static const uint8_t INDEX_OF[] = {
@@ -52,6 +70,12 @@ static const uint8_t GENPOLY[] = {
 0x00,
 };
 
+/* Log of each root of the generator, (FCR + i) * PRIM mod NN */
+static const uint8_t ROOTS[] = {
+0xD4,0xDF,0xEA,0xF5,0x01,0x0C,0x17,0x22,0x2D,0x38,0x43,0x4E,0x59,0x64,0x6F,0x7A,
+0x85,0x90,0x9B,0xA6,0xB1,0xBC,0xC7,0xD2,0xDD,0xE8,0xF3,0xFE,0x0A,0x15,0x20,0x2B,
+};
+
 static inline int mod255(int x)
 {
 	while(x >= 255)
@@ -73,30 +97,47 @@ static inline int mod255(int x)
 #define MIN(a,b) ((a) < (b) ? (a) : (b))
 #define A0       (NN) /* Special reserved value encoding zero in index form */
 
-/* Portable C version */
+/* Portable C version. The parity register is kept as a ring in
+ * reg[] rotating with each data byte, instead of being shifted. It is
+ * only written to parity[] at the end, so parity may be the tail of
+ * the packet holding data. */
 void encode_rs_8(uint8_t *data, uint8_t *parity, int pad)
 {
-	int i, j;
+	int i, j, h;
 	uint8_t feedback;
+	const uint8_t *a;
+	uint8_t reg[NROOTS];
 	
-	memset(parity, 0, NROOTS * sizeof(uint8_t));
+	memset(reg, 0, sizeof(reg));
 	
-	for(i = 0; i < NN - NROOTS - pad; i++)
+	/* reg[h] is the oldest parity byte, parity[0] in the original */
+	for(i = 0, h = 0; i < NN - NROOTS - pad; i++)
 	{
-		feedback = INDEX_OF[data[i] ^ parity[0]];
+		feedback = INDEX_OF[data[i] ^ reg[h]];
 		if(feedback != A0) /* feedback term is non-zero */
 		{
-			for(j = 1; j < NROOTS; j++)
-				parity[j] ^= ALPHA_TO[mod255(feedback + GENPOLY[NROOTS - j])];
+			a = &ALPHA_TO[feedback];
+			for(j = h + 1; j < NROOTS; j++)
+				reg[j] ^= a[GENPOLY[NROOTS + h - j]];
+			for(j = 0; j < h; j++)
+				reg[j] ^= a[GENPOLY[h - j]];
+			reg[h] = a[GENPOLY[0]];
 		}
+		else reg[h] = 0;
 		
-		/* Shift */
-		memmove(&parity[0], &parity[1], sizeof(uint8_t) * (NROOTS - 1));
-		if(feedback != A0)
-			parity[NROOTS - 1] = ALPHA_TO[mod255(feedback + GENPOLY[0])];
-		else
-			parity[NROOTS - 1] = 0;
+		/* Rotate, the slot just filled is the newest */
+		h = (h + 1) & (NROOTS - 1);
 	}
+	
+	for(j = 0; j < NROOTS; j++)
+		parity[j] = reg[(h + j) & (NROOTS - 1)];
+}
+
+/* Encode a codeword in place. The parity is written after the
+ * NN - NROOTS - pad data bytes at the start of block. */
+void encode_rs_8_block(uint8_t *block, int pad)
+{
+	encode_rs_8(block, &block[NN - NROOTS - pad], pad);
 }
 
 int decode_rs_8(uint8_t *data, int *eras_pos, int no_eras, int pad)
@@ -108,19 +149,40 @@ int decode_rs_8(uint8_t *data, int *eras_pos, int no_eras, int pad)
 	                                        * and syndrome poly */
 	uint8_t b[NROOTS + 1], t[NROOTS + 1], omega[NROOTS + 1];
 	uint8_t root[NROOTS], reg[NROOTS + 1], loc[NROOTS];
-	int syn_error, count;
+	uint8_t rem[NROOTS];
+	int syn_error, count, n;
 	
 	if(pad < 0 || pad > 222) return(-1);
 	
-	/* form the syndromes; i.e., evaluate data(x) at roots of g(x) */
-	for(i = 0; i < NROOTS; i++) s[i] = data[0];
+	/* Recompute the parity. If it matches there are no errors, otherwise
+	 * the difference is the remainder of data(x) by g(x), and has the
+	 * same syndromes as data(x) while being only NROOTS long */
+	encode_rs_8(data, rem, pad);
+	
+	syn_error = 0;
+	for(i = 0; i < NROOTS; i++)
+	{
+		rem[i] ^= data[NN - NROOTS - pad + i];
+		syn_error |= rem[i];
+	}
+	
+	if(!syn_error)
+	{
+		count = 0;
+		goto finish;
+	}
+	
+	/* form the syndromes; i.e., evaluate rem(x) at roots of g(x) by
+	 * Horner's rule. All roots step together, keeping the chains apart */
+	for(i = 0; i < NROOTS; i++) s[i] = rem[0];
 	
-	for(j = 1; j < NN - pad; j++)
+	for(j = 1; j < NROOTS; j++)
 	{
+		u = rem[j];
 		for(i = 0; i < NROOTS; i++)
 		{
-			if(s[i] == 0) s[i] = data[j];
-			else s[i] = data[j] ^ ALPHA_TO[MODNN(INDEX_OF[s[i]] + (FCR + i) * PRIM)];
+			if(s[i] == 0) s[i] = u;
+			else s[i] = u ^ ALPHA_TO[INDEX_OF[s[i]] + ROOTS[i]];
 		}
 	}
 	
@@ -154,7 +216,7 @@ int decode_rs_8(uint8_t *data, int *eras_pos, int no_eras, int pad)
 			for(j = i + 1; j > 0; j--)
 			{
 				tmp = INDEX_OF[lambda[j - 1]];
-				if(tmp != A0) lambda[j] ^= ALPHA_TO[MODNN(u + tmp)];
+				if(tmp != A0) lambda[j] ^= ALPHA_TO[u + tmp];
 			}
 		}
 		
@@ -177,7 +239,7 @@ int decode_rs_8(uint8_t *data, int *eras_pos, int no_eras, int pad)
 		{
 			if((lambda[i] != 0) && (s[r - i - 1] != A0))
 			{
-				discr_r ^= ALPHA_TO[MODNN(INDEX_OF[lambda[i]] + s[r - i - 1])];
+				discr_r ^= ALPHA_TO[INDEX_OF[lambda[i]] + s[r - i - 1]];
 			}
 		}
 		discr_r = INDEX_OF[discr_r]; /* Index form */
@@ -194,7 +256,7 @@ int decode_rs_8(uint8_t *data, int *eras_pos, int no_eras, int pad)
 			for(i = 0; i < NROOTS; i++)
 			{
 				if(b[i] != A0)
-					t[i + 1] = lambda[i + 1] ^ ALPHA_TO[MODNN(discr_r + b[i])];
+					t[i + 1] = lambda[i + 1] ^ ALPHA_TO[discr_r + b[i]];
 				else
 					t[i + 1] = lambda[i + 1];
 			}
@@ -238,7 +300,9 @@ int decode_rs_8(uint8_t *data, int *eras_pos, int no_eras, int pad)
 		{
 			if(reg[j] != A0)
 			{
-				reg[j] = MODNN(reg[j] + j);
+				/* reg[j] + j < 2 * NN */
+				n = reg[j] + j;
+				reg[j] = n >= NN ? n - NN : n;
 				q ^= ALPHA_TO[reg[j]];
 			}
 		}
@@ -275,7 +339,7 @@ int decode_rs_8(uint8_t *data, int *eras_pos, int no_eras, int pad)
 		for(j = i; j >= 0; j--)
 		{
 			if((s[i - j] != A0) && (lambda[j] != A0))
-				tmp ^= ALPHA_TO[MODNN(s[i - j] + lambda[j])];
+				tmp ^= ALPHA_TO[s[i - j] + lambda[j]];
 		}
 		omega[i] = INDEX_OF[tmp];
 	}
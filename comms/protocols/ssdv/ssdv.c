@@ -21,6 +21,7 @@
 #include <string.h>
 #include "ssdv.h"
 #include "rs8.h"
+#include "crc32.h"
 #include "debug.h"
 
 /* Recognised JPEG markers */
@@ -109,9 +110,129 @@ static const uint8_t std_dht11[179] = {
 0xF8,0xF9,0xFA,
 };
 
+/* Huffman encoding lookup for one output DHT table */
+typedef struct
+{
+	uint16_t code[256]; /* Code for each symbol                         */
+	uint8_t width[256]; /* Width of each code, 0 = symbol not in table  */
+} ssdv_dht_codes_t;
+
+/* The output tables are always the standard tables. Their codes are
+ * listed here rather than built into every encoder state */
+static const ssdv_dht_codes_t std_dht_codes[2][2] = {
+{
+{ /* std_dht00 */
+	.code = {
+		0x0000,0x0002,0x0003,0x0004,0x0005,0x0006,0x000E,0x001E,0x003E,0x007E,0x00FE,0x01FE,
+	},
+	.width = {
+		 2, 3, 3, 3, 3, 3, 4, 5, 6, 7, 8, 9,
+	},
+},
+{ /* std_dht01 */
+	.code = {
+		0x0000,0x0001,0x0002,0x0006,0x000E,0x001E,0x003E,0x007E,0x00FE,0x01FE,0x03FE,0x07FE,
+	},
+	.width = {
+		 2, 2, 2, 3, 4, 5, 6, 7, 8, 9,10,11,
+	},
+},
+},
+{
+{ /* std_dht10 */
+	.code = {
+		0x000A,0x0000,0x0001,0x0004,0x000B,0x001A,0x0078,0x00F8,0x03F6,0xFF82,0xFF83,0x0000,
+		0x0000,0x0000,0x0000,0x0000,0x0000,0x000C,0x001B,0x0079,0x01F6,0x07F6,0xFF84,0xFF85,
+		0xFF86,0xFF87,0xFF88,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x001C,0x00F9,0x03F7,
+		0x0FF4,0xFF89,0xFF8A,0xFF8B,0xFF8C,0xFF8D,0xFF8E,0x0000,0x0000,0x0000,0x0000,0x0000,
+		0x0000,0x003A,0x01F7,0x0FF5,0xFF8F,0xFF90,0xFF91,0xFF92,0xFF93,0xFF94,0xFF95,0x0000,
+		0x0000,0x0000,0x0000,0x0000,0x0000,0x003B,0x03F8,0xFF96,0xFF97,0xFF98,0xFF99,0xFF9A,
+		0xFF9B,0xFF9C,0xFF9D,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x007A,0x07F7,0xFF9E,
+		0xFF9F,0xFFA0,0xFFA1,0xFFA2,0xFFA3,0xFFA4,0xFFA5,0x0000,0x0000,0x0000,0x0000,0x0000,
+		0x0000,0x007B,0x0FF6,0xFFA6,0xFFA7,0xFFA8,0xFFA9,0xFFAA,0xFFAB,0xFFAC,0xFFAD,0x0000,
+		0x0000,0x0000,0x0000,0x0000,0x0000,0x00FA,0x0FF7,0xFFAE,0xFFAF,0xFFB0,0xFFB1,0xFFB2,
+		0xFFB3,0xFFB4,0xFFB5,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x01F8,0x7FC0,0xFFB6,
+		0xFFB7,0xFFB8,0xFFB9,0xFFBA,0xFFBB,0xFFBC,0xFFBD,0x0000,0x0000,0x0000,0x0000,0x0000,
+		0x0000,0x01F9,0xFFBE,0xFFBF,0xFFC0,0xFFC1,0xFFC2,0xFFC3,0xFFC4,0xFFC5,0xFFC6,0x0000,
+		0x0000,0x0000,0x0000,0x0000,0x0000,0x01FA,0xFFC7,0xFFC8,0xFFC9,0xFFCA,0xFFCB,0xFFCC,
+		0xFFCD,0xFFCE,0xFFCF,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x03F9,0xFFD0,0xFFD1,
+		0xFFD2,0xFFD3,0xFFD4,0xFFD5,0xFFD6,0xFFD7,0xFFD8,0x0000,0x0000,0x0000,0x0000,0x0000,
+		0x0000,0x03FA,0xFFD9,0xFFDA,0xFFDB,0xFFDC,0xFFDD,0xFFDE,0xFFDF,0xFFE0,0xFFE1,0x0000,
+		0x0000,0x0000,0x0000,0x0000,0x0000,0x07F8,0xFFE2,0xFFE3,0xFFE4,0xFFE5,0xFFE6,0xFFE7,
+		0xFFE8,0xFFE9,0xFFEA,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0xFFEB,0xFFEC,0xFFED,
+		0xFFEE,0xFFEF,0xFFF0,0xFFF1,0xFFF2,0xFFF3,0xFFF4,0x0000,0x0000,0x0000,0x0000,0x0000,
+		0x07F9,0xFFF5,0xFFF6,0xFFF7,0xFFF8,0xFFF9,0xFFFA,0xFFFB,0xFFFC,0xFFFD,0xFFFE,
+	},
+	.width = {
+		 4, 2, 2, 3, 4, 5, 7, 8,10,16,16, 0, 0, 0, 0, 0,
+		 0, 4, 5, 7, 9,11,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0, 5, 8,10,12,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0, 6, 9,12,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0, 6,10,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0, 7,11,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0, 7,12,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0, 8,12,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0, 9,15,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0, 9,16,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0, 9,16,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0,10,16,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0,10,16,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0,11,16,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0,16,16,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		11,16,16,16,16,16,16,16,16,16,16,
+	},
+},
+{ /* std_dht11 */
+	.code = {
+		0x0000,0x0001,0x0004,0x000A,0x0018,0x0019,0x0038,0x0078,0x01F4,0x03F6,0x0FF4,0x0000,
+		0x0000,0x0000,0x0000,0x0000,0x0000,0x000B,0x0039,0x00F6,0x01F5,0x07F6,0x0FF5,0xFF88,
+		0xFF89,0xFF8A,0xFF8B,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x001A,0x00F7,0x03F7,
+		0x0FF6,0x7FC2,0xFF8C,0xFF8D,0xFF8E,0xFF8F,0xFF90,0x0000,0x0000,0x0000,0x0000,0x0000,
+		0x0000,0x001B,0x00F8,0x03F8,0x0FF7,0xFF91,0xFF92,0xFF93,0xFF94,0xFF95,0xFF96,0x0000,
+		0x0000,0x0000,0x0000,0x0000,0x0000,0x003A,0x01F6,0xFF97,0xFF98,0xFF99,0xFF9A,0xFF9B,
+		0xFF9C,0xFF9D,0xFF9E,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x003B,0x03F9,0xFF9F,
+		0xFFA0,0xFFA1,0xFFA2,0xFFA3,0xFFA4,0xFFA5,0xFFA6,0x0000,0x0000,0x0000,0x0000,0x0000,
+		0x0000,0x0079,0x07F7,0xFFA7,0xFFA8,0xFFA9,0xFFAA,0xFFAB,0xFFAC,0xFFAD,0xFFAE,0x0000,
+		0x0000,0x0000,0x0000,0x0000,0x0000,0x007A,0x07F8,0xFFAF,0xFFB0,0xFFB1,0xFFB2,0xFFB3,
+		0xFFB4,0xFFB5,0xFFB6,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x00F9,0xFFB7,0xFFB8,
+		0xFFB9,0xFFBA,0xFFBB,0xFFBC,0xFFBD,0xFFBE,0xFFBF,0x0000,0x0000,0x0000,0x0000,0x0000,
+		0x0000,0x01F7,0xFFC0,0xFFC1,0xFFC2,0xFFC3,0xFFC4,0xFFC5,0xFFC6,0xFFC7,0xFFC8,0x0000,
+		0x0000,0x0000,0x0000,0x0000,0x0000,0x01F8,0xFFC9,0xFFCA,0xFFCB,0xFFCC,0xFFCD,0xFFCE,
+		0xFFCF,0xFFD0,0xFFD1,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x01F9,0xFFD2,0xFFD3,
+		0xFFD4,0xFFD5,0xFFD6,0xFFD7,0xFFD8,0xFFD9,0xFFDA,0x0000,0x0000,0x0000,0x0000,0x0000,
+		0x0000,0x01FA,0xFFDB,0xFFDC,0xFFDD,0xFFDE,0xFFDF,0xFFE0,0xFFE1,0xFFE2,0xFFE3,0x0000,
+		0x0000,0x0000,0x0000,0x0000,0x0000,0x07F9,0xFFE4,0xFFE5,0xFFE6,0xFFE7,0xFFE8,0xFFE9,
+		0xFFEA,0xFFEB,0xFFEC,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x3FE0,0xFFED,0xFFEE,
+		0xFFEF,0xFFF0,0xFFF1,0xFFF2,0xFFF3,0xFFF4,0xFFF5,0x0000,0x0000,0x0000,0x0000,0x0000,
+		0x03FA,0x7FC3,0xFFF6,0xFFF7,0xFFF8,0xFFF9,0xFFFA,0xFFFB,0xFFFC,0xFFFD,0xFFFE,
+	},
+	.width = {
+		 2, 2, 3, 4, 5, 5, 6, 7, 9,10,12, 0, 0, 0, 0, 0,
+		 0, 4, 6, 8, 9,11,12,16,16,16,16, 0, 0, 0, 0, 0,
+		 0, 5, 8,10,12,15,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0, 5, 8,10,12,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0, 6, 9,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0, 6,10,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0, 7,11,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0, 7,11,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0, 8,16,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0, 9,16,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0, 9,16,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0, 9,16,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0, 9,16,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0,11,16,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		 0,14,16,16,16,16,16,16,16,16,16, 0, 0, 0, 0, 0,
+		10,15,16,16,16,16,16,16,16,16,16,
+	},
+},
+},
+};
+
 /* Helper for returning the current DHT table */
 #define SDHT (s->sdht[s->acpart ? 1 : 0][s->component ? 1 : 0])
 #define DDHT (s->ddht[s->acpart ? 1 : 0][s->component ? 1 : 0])
+#define SDHT_LUT (&s->sdht_lut[s->acpart ? 1 : 0][s->component ? 1 : 0])
+#define DDHT_CODES (&std_dht_codes[s->acpart ? 1 : 0][s->component ? 1 : 0])
 
 /* Helpers for looking up the current DQT value */
 #define SDQT (s->sdqt[s->component ? 1 : 0][1 + s->acpart])
@@ -214,25 +335,6 @@ static void *dtblcpy(ssdv_t *s, const void *src, size_t n)
 	return(r);
 }
 
-static uint32_t crc32(void *data, size_t length)
-{
-	uint32_t crc, x;
-	uint8_t i, *d;
-	
-	for(d = data, crc = 0xFFFFFFFF; length; length--)
-	{
-		x = (crc ^ *(d++)) & 0xFF;
-		for(i = 8; i > 0; i--)
-		{
-			if(x & 1) x = (x >> 1) ^ 0xEDB88320;
-			else x >>= 1;
-		}
-		crc = (crc >> 8) ^ x;
-	}
-	
-	return(crc ^ 0xFFFFFFFF);
-}
-
 static uint32_t encode_callsign(char *callsign)
 {
 	uint32_t x;
@@ -277,71 +379,98 @@ static char *decode_callsign(char *callsign, uint32_t code)
 	return(callsign);
 }
 
-static inline char jpeg_dht_lookup(ssdv_t *s, uint8_t *symbol, uint8_t *width)
+static void jpeg_dht_build(ssdv_dht_lut_t *lut, const uint8_t *dht)
 {
-	uint16_t code = 0;
+	uint16_t code = 0, index = 0;
+	uint16_t c, f, e;
 	uint8_t cw, n;
-	uint8_t *dht, *ss;
 	
-	/* Select the appropriate huffman table */
-	dht = SDHT;
-	ss = &dht[17];
+	memset(lut->fast, 0, sizeof(lut->fast));
 	
 	for(cw = 1; cw <= 16; cw++)
 	{
-		/* Got enough bits? */
-		if(cw > s->worklen) return(SSDV_FEED_ME);
-		
-		/* Compare against each code 'cw' bits wide */
-		for(n = dht[cw]; n > 0; n--)
+		/* The first code 'cw' bits wide and where its symbol is */
+		lut->code[cw] = code;
+		lut->index[cw] = index;
+		
+		/* Fill the lookup entries that begin with each short code. Shorter
+		 * codes are entered first and never replaced, so a lookup finds the
+		 * same code as a walk of the code lists */
+		for(n = 0; cw <= SSDV_DHT_FAST_BITS && n < dht[cw]; n++)
 		{
-			if(s->workbits >> (s->worklen - cw) == code)
-			{
-				/* Found a match */
-				*symbol = *ss;
-				*width = cw;
-				return(SSDV_OK);
-			}
-			ss++; code++;
+			c = code + n;
+			if(c >> cw) break;
+			
+			e = (cw << 8) | dht[17 + index + n];
+			for(f = c << (SSDV_DHT_FAST_BITS - cw); f < (c + 1) << (SSDV_DHT_FAST_BITS - cw); f++)
+				if(!lut->fast[f]) lut->fast[f] = e;
 		}
 		
+		code += dht[cw];
+		index += dht[cw];
 		code <<= 1;
 	}
-	
-	/* No match found - error */
-	return(SSDV_ERROR);
 }
 
-static inline char jpeg_dht_lookup_symbol(ssdv_t *s, uint8_t symbol, uint16_t *bits, uint8_t *width)
+static inline char jpeg_dht_lookup(ssdv_t *s, uint8_t *symbol, uint8_t *width)
 {
-	uint16_t code = 0;
-	uint8_t cw, n;
-	uint8_t *dht, *ss;
+	uint16_t bits, e;
+	uint8_t cw;
+	uint8_t *dht;
+	ssdv_dht_lut_t *lut;
 	
-	dht = DDHT;
-	ss = &dht[17];
+	/* Select the appropriate huffman table */
+	dht = SDHT;
+	lut = SDHT_LUT;
 	
-	for(cw = 1; cw <= 16; cw++)
+	/* Look up the short codes, padding with zeros if bits are missing */
+	if(s->worklen >= SSDV_DHT_FAST_BITS)
+		bits = s->workbits >> (s->worklen - SSDV_DHT_FAST_BITS);
+	else
+		bits = s->workbits << (SSDV_DHT_FAST_BITS - s->worklen);
+	
+	if((e = lut->fast[bits]) != 0)
+	{
+		/* Got enough bits? */
+		if((e >> 8) > s->worklen) return(SSDV_FEED_ME);
+		
+		*symbol = e & 0xFF;
+		*width = e >> 8;
+		return(SSDV_OK);
+	}
+	
+	/* Not a short code, compare against the longer ones */
+	for(cw = SSDV_DHT_FAST_BITS + 1; cw <= 16; cw++)
 	{
-		for(n = dht[cw]; n > 0; n--)
+		/* Got enough bits? */
+		if(cw > s->worklen) return(SSDV_FEED_ME);
+		
+		bits = (s->workbits >> (s->worklen - cw)) - lut->code[cw];
+		if(bits < dht[cw])
 		{
-			if(*ss == symbol)
-			{
-				/* Found a match */
-				*bits = code;
-				*width = cw;
-				return(SSDV_OK);
-			}
-			ss++; code++;
+			/* Found a match */
+			*symbol = dht[17 + lut->index[cw] + bits];
+			*width = cw;
+			return(SSDV_OK);
 		}
-		
-		code <<= 1;
 	}
 	
 	/* No match found - error */
 	return(SSDV_ERROR);
 }
 
+static inline char jpeg_dht_lookup_symbol(ssdv_t *s, uint8_t symbol, uint16_t *bits, uint8_t *width)
+{
+	const ssdv_dht_codes_t *codes = DDHT_CODES;
+	
+	/* Symbol not in the table - error */
+	if(codes->width[symbol] == 0) return(SSDV_ERROR);
+	
+	*bits = codes->code[symbol];
+	*width = codes->width[symbol];
+	return(SSDV_OK);
+}
+
 static inline int jpeg_int(int bits, int width)
 {
 	int b = (1 << width) - 1;
@@ -363,35 +492,45 @@ static inline void jpeg_encode_int(int value, int *bits, uint8_t *width)
 
 /*****************************************************************************/
 
-static char ssdv_outbits(ssdv_t *s, uint16_t bits, uint8_t length)
+static char ssdv_outbits(ssdv_t *s, uint32_t bits, uint8_t length)
 {
+	uint32_t outbits = s->outbits;
+	uint8_t outlen = s->outlen;
+	uint8_t *outp = s->outp;
+	size_t out_len = s->out_len;
 	uint8_t b;
 	
 	if(length)
 	{
-		s->outbits <<= length;
-		s->outbits |= bits & ((1 << length) - 1);
-		s->outlen += length;
+		outbits <<= length;
+		outbits |= bits & ((1UL << length) - 1);
+		outlen += length;
 	}
 	
-	while(s->outlen >= 8 && s->out_len > 0)
+	/* Write out all the whole bytes there is room for */
+	while(outlen >= 8 && out_len > 0)
 	{
-		b = s->outbits >> (s->outlen - 8);
+		b = outbits >> (outlen - 8);
 		
 		/* Put the byte into the output buffer */
-		*(s->outp++) = b;
-		s->outlen -= 8;
-		s->out_len--;
+		*(outp++) = b;
+		outlen -= 8;
+		out_len--;
 		
 		/* Insert stuffing byte if needed */
 		if(s->out_stuff && b == 0xFF)
 		{
-			s->outbits &= (1 << s->outlen) - 1;
-			s->outlen += 8;
+			outbits &= (1UL << outlen) - 1;
+			outlen += 8;
 		}
 	}
 	
-	return(s->out_len ? SSDV_OK : SSDV_BUFFER_FULL);
+	s->outbits = outbits;
+	s->outlen = outlen;
+	s->outp = outp;
+	s->out_len = out_len;
+	
+	return(out_len ? SSDV_OK : SSDV_BUFFER_FULL);
 }
 
 static char ssdv_outbits_sync(ssdv_t *s)
@@ -413,12 +552,25 @@ static char ssdv_out_jpeg_int(ssdv_t *s, uint8_t rle, int value)
 	
 	if(r != SSDV_OK) TRACE_ERROR("SSDV > jpeg_dht_lookup_symbol: %i (%i:%i)", r, value, rle);
 	
-	ssdv_outbits(s, huffbits, hufflen);
-	if(intlen) ssdv_outbits(s, intbits, intlen);
+	/* Write the code and value together while they fit the output bits */
+	if(hufflen + intlen <= 24)
+		ssdv_outbits(s, ((uint32_t) huffbits << intlen) | (intbits & ((1 << intlen) - 1)), hufflen + intlen);
+	else
+	{
+		ssdv_outbits(s, huffbits, hufflen);
+		if(intlen) ssdv_outbits(s, intbits, intlen);
+	}
 	
 	return(SSDV_OK);
 }
 
+static inline char ssdv_out_jpeg_ac(ssdv_t *s, uint8_t rle, int value)
+{
+	/* A DC only image has an EOB written after each DC value instead */
+	if(s->dc_only) return(SSDV_OK);
+	return(ssdv_out_jpeg_int(s, rle, value));
+}
+
 static char ssdv_process(ssdv_t *s)
 {
 	if(s->state == S_HUFF)
@@ -448,6 +600,8 @@ static char ssdv_process(ssdv_t *s)
 				
 				/* skip to the next AC part immediately */
 				s->acpart++;
+				
+				if(s->dc_only) ssdv_out_jpeg_int(s, 0, 0); /* EOB */
 			}
 			else
 			{
@@ -462,13 +616,13 @@ static char ssdv_process(ssdv_t *s)
 			if(symbol == 0x00)
 			{
 				/* EOB -- all remaining AC parts are zero */
-				ssdv_out_jpeg_int(s, 0, 0);
+				ssdv_out_jpeg_ac(s, 0, 0);
 				s->acpart = 64;
 			}
 			else if(symbol == 0xF0)
 			{
 				/* The next 16 AC parts are zero */
-				ssdv_out_jpeg_int(s, 15, 0);
+				ssdv_out_jpeg_ac(s, 15, 0);
 				s->acpart += 16;
 			}
 			else
@@ -539,10 +693,10 @@ static char ssdv_process(ssdv_t *s)
 				s->accrle += s->acrle;
 				while(s->accrle >= 16)
 				{
-					ssdv_out_jpeg_int(s, 15, 0);
+					ssdv_out_jpeg_ac(s, 15, 0);
 					s->accrle -= 16;
 				}
-				ssdv_out_jpeg_int(s, s->accrle, i);
+				ssdv_out_jpeg_ac(s, s->accrle, i);
 				s->accrle = 0;
 			}
 			else
@@ -550,7 +704,7 @@ static char ssdv_process(ssdv_t *s)
 				/* AC value got reduced to 0 in the DQT conversion */
 				if(s->acpart >= 63)
 				{
-					ssdv_out_jpeg_int(s, 0, 0);
+					ssdv_out_jpeg_ac(s, 0, 0);
 					s->accrle = 0;
 				}
 				else s->accrle += s->acrle + 1;
@@ -560,6 +714,8 @@ static char ssdv_process(ssdv_t *s)
 		/* Next AC part to expect */
 		s->acpart++;
 		
+		if(s->dc_only && s->acpart == 1) ssdv_out_jpeg_int(s, 0, 0); /* EOB */
+		
 		/* Next bits are a huffman code */
 		s->state = S_HUFF;
 		
@@ -598,11 +754,12 @@ static char ssdv_process(ssdv_t *s)
 			if(s->mode == S_DECODING && s->mcu_id == s->reset_mcu)
 				s->workbits = s->worklen = 0;
 			
-			/* Test for a reset marker */
+			/* Test for a reset marker. A full buffer must be reported
+			 * now, or it is lost if the caller runs out of input */
 			if(s->dri > 0 && s->mcu_id > 0 && s->mcu_id % s->dri == 0)
 			{
 				s->state = S_MARKER;
-				return(SSDV_FEED_ME);
+				return(s->out_len == 0 ? SSDV_BUFFER_FULL : SSDV_FEED_ME);
 			}
 		}
 		
@@ -856,10 +1013,10 @@ static char ssdv_have_marker_data(ssdv_t *s)
 			
 			switch(d[0])
 			{
-			case 0x00: s->sdht[0][0] = d; break;
-			case 0x01: s->sdht[0][1] = d; break;
-			case 0x10: s->sdht[1][0] = d; break;
-			case 0x11: s->sdht[1][1] = d; break;
+			case 0x00: s->sdht[0][0] = d; jpeg_dht_build(&s->sdht_lut[0][0], d); break;
+			case 0x01: s->sdht[0][1] = d; jpeg_dht_build(&s->sdht_lut[0][1], d); break;
+			case 0x10: s->sdht[1][0] = d; jpeg_dht_build(&s->sdht_lut[1][0], d); break;
+			case 0x11: s->sdht[1][1] = d; jpeg_dht_build(&s->sdht_lut[1][1], d); break;
 			}
 			
 			/* Skip to the next DHT table */
@@ -922,6 +1079,14 @@ char ssdv_enc_init(ssdv_t *s, uint8_t type, char *callsign, uint8_t image_id, in
 	return(SSDV_OK);
 }
 
+char ssdv_enc_set_dc_only(ssdv_t *s, char dc_only)
+{
+	/* Drop all AC coefficients, for a low resolution preview of the
+	 * image. It is still a normal SSDV image to the decoder */
+	s->dc_only = dc_only;
+	return(SSDV_OK);
+}
+
 char ssdv_enc_set_buffer(ssdv_t *s, uint8_t *buffer)
 {
 	s->out     = buffer;
@@ -937,6 +1102,110 @@ char ssdv_enc_set_buffer(ssdv_t *s, uint8_t *buffer)
 	return(SSDV_OK);
 }
 
+static char ssdv_enc_packet(ssdv_t *s)
+{
+	int r;
+	
+	/* Process the bits until more needed, or an error occurs */
+	while((r = ssdv_process(s)) == SSDV_OK);
+	
+	if(r == SSDV_BUFFER_FULL || r == SSDV_EOI)
+	{
+		uint16_t mcu_id     = s->packet_mcu_id;
+		uint8_t i, mcu_offset = s->packet_mcu_offset;
+		uint32_t x;
+		
+		if(mcu_offset != 0xFF && mcu_offset >= s->pkt_size_payload)
+		{
+			/* The first MCU begins in the next packet, not this one */
+			mcu_id = 0xFFFF;
+			mcu_offset = 0xFF;
+			s->packet_mcu_offset -= s->pkt_size_payload;
+		}
+		else
+		{
+			/* Clear the MCU data for the next packet */
+			s->packet_mcu_id = 0xFFFF;
+			s->packet_mcu_offset = 0xFF;
+		}
+		
+		/* A packet is ready, create the headers */
+		s->out[0]   = 0x55;                /* Sync */
+		s->out[1]   = 0x66 + s->type;      /* Type */
+		s->out[2]   = s->callsign >> 24;
+		s->out[3]   = s->callsign >> 16;
+		s->out[4]   = s->callsign >> 8;
+		s->out[5]   = s->callsign;
+		s->out[6]   = s->image_id;         /* Image ID */
+		s->out[7]   = s->packet_id >> 8;   /* Packet ID MSB */
+		s->out[8]   = s->packet_id & 0xFF; /* Packet ID LSB */
+		s->out[9]   = s->width >> 4;       /* Width / 16 */
+		s->out[10]  = s->height >> 4;      /* Height / 16 */
+		s->out[11]  = 0x00;
+		s->out[11] |= ((s->quality - 4) & 7) << 3;  /* Quality level */
+		s->out[11] |= (r == SSDV_EOI ? 1 : 0) << 2; /* EOI flag (1 bit) */
+		s->out[11] |= s->mcu_mode & 0x03;  /* MCU mode (2 bits) */
+		s->out[12]  = mcu_offset;          /* Next MCU offset */
+		s->out[13]  = mcu_id >> 8;         /* MCU ID MSB */
+		s->out[14]  = mcu_id & 0xFF;       /* MCU ID LSB */
+		
+		/* Fill any remaining bytes with noise */
+		if(s->out_len > 0) ssdv_memset_prng(s->outp, s->out_len);
+		
+		/* Calculate the CRC codes */
+		x = crc32_calc(&s->out[1], s->pkt_size_crcdata);
+		
+		i = 1 + s->pkt_size_crcdata;
+		s->out[i++] = (x >> 24) & 0xFF;
+		s->out[i++] = (x >> 16) & 0xFF;
+		s->out[i++] = (x >> 8) & 0xFF;
+		s->out[i++] = x & 0xFF;
+		
+		/* Generate the RS codes */
+		if(s->type == SSDV_TYPE_NORMAL)
+			encode_rs_8_block(&s->out[1], 0);
+		
+		s->packet_id++;
+		
+		/* Have we reached the end of the image data? */
+		if(r == SSDV_EOI) s->state = S_EOI;
+		
+		return(SSDV_OK);
+	}
+	else if(r != SSDV_FEED_ME)
+	{
+		/* An error occured */
+		TRACE_ERROR("SSDV > ssdv_process() failed: %i", r);
+		return(SSDV_ERROR);
+	}
+	
+	return(SSDV_FEED_ME);
+}
+
+static void ssdv_enc_load_bits(ssdv_t *s)
+{
+	/* Take more bytes of image data directly from the input, so each
+	 * pass through ssdv_process has more than one byte to decode. This
+	 * stops before any marker and leaves an unmatched 0xFF to in_skip */
+	while(s->worklen <= 16 && s->in_len > s->in_skip)
+	{
+		if(s->in_skip)
+		{
+			s->inp++;
+			s->in_len--;
+			s->in_skip = 0;
+			continue;
+		}
+		
+		if(s->inp[0] == 0xFF && (s->in_len < 2 || s->inp[1] != 0x00)) break;
+		
+		s->workbits = (s->workbits << 8) | s->inp[0];
+		s->worklen += 8;
+		if(*(s->inp++) == 0xFF) s->in_skip++;
+		s->in_len--;
+	}
+}
+
 char ssdv_enc_get_packet(ssdv_t *s)
 {
 	int r;
@@ -948,6 +1217,14 @@ char ssdv_enc_get_packet(ssdv_t *s)
 	/* If the output buffer is empty, re-initialise */
 	if(s->out_len == 0) ssdv_enc_set_buffer(s, s->out);
 	
+	/* Codes left over from the last packet are processed first, the next
+	 * input byte may be the marker following them */
+	if((s->state == S_HUFF || s->state == S_INT) && s->worklen > 0)
+	{
+		r = ssdv_enc_packet(s);
+		if(r != SSDV_FEED_ME) return(r);
+	}
+	
 	while(s->in_len)
 	{
 		b = *(s->inp++);
@@ -1006,79 +1283,10 @@ char ssdv_enc_get_packet(ssdv_t *s)
 			/* Add the new byte to the work area */
 			s->workbits = (s->workbits << 8) | b;
 			s->worklen += 8;
+			ssdv_enc_load_bits(s);
 			
-			/* Process the new data until more needed, or an error occurs */
-			while((r = ssdv_process(s)) == SSDV_OK);
-			
-			if(r == SSDV_BUFFER_FULL || r == SSDV_EOI)
-			{
-				uint16_t mcu_id     = s->packet_mcu_id;
-				uint8_t i, mcu_offset = s->packet_mcu_offset;
-				uint32_t x;
-				
-				if(mcu_offset != 0xFF && mcu_offset >= s->pkt_size_payload)
-				{
-					/* The first MCU begins in the next packet, not this one */
-					mcu_id = 0xFFFF;
-					mcu_offset = 0xFF;
-					s->packet_mcu_offset -= s->pkt_size_payload;
-				}
-				else
-				{
-					/* Clear the MCU data for the next packet */
-					s->packet_mcu_id = 0xFFFF;
-					s->packet_mcu_offset = 0xFF;
-				}
-				
-				/* A packet is ready, create the headers */
-				s->out[0]   = 0x55;                /* Sync */
-				s->out[1]   = 0x66 + s->type;      /* Type */
-				s->out[2]   = s->callsign >> 24;
-				s->out[3]   = s->callsign >> 16;
-				s->out[4]   = s->callsign >> 8;
-				s->out[5]   = s->callsign;
-				s->out[6]   = s->image_id;         /* Image ID */
-				s->out[7]   = s->packet_id >> 8;   /* Packet ID MSB */
-				s->out[8]   = s->packet_id & 0xFF; /* Packet ID LSB */
-				s->out[9]   = s->width >> 4;       /* Width / 16 */
-				s->out[10]  = s->height >> 4;      /* Height / 16 */
-				s->out[11]  = 0x00;
-				s->out[11] |= ((s->quality - 4) & 7) << 3;  /* Quality level */
-				s->out[11] |= (r == SSDV_EOI ? 1 : 0) << 2; /* EOI flag (1 bit) */
-				s->out[11] |= s->mcu_mode & 0x03;  /* MCU mode (2 bits) */
-				s->out[12]  = mcu_offset;          /* Next MCU offset */
-				s->out[13]  = mcu_id >> 8;         /* MCU ID MSB */
-				s->out[14]  = mcu_id & 0xFF;       /* MCU ID LSB */
-				
-				/* Fill any remaining bytes with noise */
-				if(s->out_len > 0) ssdv_memset_prng(s->outp, s->out_len);
-				
-				/* Calculate the CRC codes */
-				x = crc32(&s->out[1], s->pkt_size_crcdata);
-				
-				i = 1 + s->pkt_size_crcdata;
-				s->out[i++] = (x >> 24) & 0xFF;
-				s->out[i++] = (x >> 16) & 0xFF;
-				s->out[i++] = (x >> 8) & 0xFF;
-				s->out[i++] = x & 0xFF;
-				
-				/* Generate the RS codes */
-				if(s->type == SSDV_TYPE_NORMAL)
-					encode_rs_8(&s->out[1], &s->out[i], 0);
-				
-				s->packet_id++;
-				
-				/* Have we reached the end of the image data? */
-				if(r == SSDV_EOI) s->state = S_EOI;
-				
-				return(SSDV_OK);
-			}
-			else if(r != SSDV_FEED_ME)
-			{
-				/* An error occured */
-				TRACE_ERROR("SSDV > ssdv_process() failed: %i", r);
-				return(SSDV_ERROR);
-			}
+			r = ssdv_enc_packet(s);
+			if(r != SSDV_FEED_ME) return(r);
 			break;
 		
 		case S_EOI:
@@ -1098,6 +1306,14 @@ char ssdv_enc_feed(ssdv_t *s, const uint8_t *buffer, size_t length)
 	return(SSDV_OK);
 }
 
+char ssdv_enc_set_input(ssdv_t *s, const uint8_t *buffer, size_t length)
+{
+	/* The whole image is read in place, no more feeding is needed */
+	s->inp    = buffer;
+	s->in_len = length;
+	return(SSDV_OK);
+}
+
 /*****************************************************************************/
 
 static void ssdv_write_marker(ssdv_t *s, uint16_t id, uint16_t length, const uint8_t *data)
@@ -1200,6 +1416,10 @@ char ssdv_dec_init(ssdv_t *s)
 	s->sdht[0][1] = stblcpy(s, std_dht01, sizeof(std_dht01));
 	s->sdht[1][0] = stblcpy(s, std_dht10, sizeof(std_dht10));
 	s->sdht[1][1] = stblcpy(s, std_dht11, sizeof(std_dht11));
+	jpeg_dht_build(&s->sdht_lut[0][0], s->sdht[0][0]);
+	jpeg_dht_build(&s->sdht_lut[0][1], s->sdht[0][1]);
+	jpeg_dht_build(&s->sdht_lut[1][0], s->sdht[1][0]);
+	jpeg_dht_build(&s->sdht_lut[1][1], s->sdht[1][1]);
 	
 	/* Prepare the output JPEG tables */
 	s->ddht[0][0] = dtblcpy(s, std_dht00, sizeof(std_dht00));
@@ -1388,7 +1608,7 @@ char ssdv_dec_is_packet(uint8_t *packet, int *errors)
 		if(errors) *errors = 0;
 		
 		/* Test the checksum */
-		x = crc32(&pkt[1], pkt_size_crcdata);
+		x = crc32_calc(&pkt[1], pkt_size_crcdata);
 		
 		i = 1 + pkt_size_crcdata;
 		if(x == (uint32_t)(pkt[i + 3] | (pkt[i + 2] << 8) | (pkt[i + 1] << 16) | (pkt[i] << 24)))
@@ -1407,7 +1627,7 @@ char ssdv_dec_is_packet(uint8_t *packet, int *errors)
 		if(errors) *errors = 0;
 		
 		/* Test the checksum */
-		x = crc32(&pkt[1], pkt_size_crcdata);
+		x = crc32_calc(&pkt[1], pkt_size_crcdata);
 		
 		i = 1 + pkt_size_crcdata;
 		if(x == (uint32_t)(pkt[i + 3] | (pkt[i + 2] << 8) | (pkt[i + 1] << 16) | (pkt[i] << 24)))
@@ -1426,7 +1646,7 @@ char ssdv_dec_is_packet(uint8_t *packet, int *errors)
 		if(errors) *errors = 0;
 		
 		/* Test the checksum */
-		x = crc32(&pkt[1], pkt_size_crcdata);
+		x = crc32_calc(&pkt[1], pkt_size_crcdata);
 		
 		i = 1 + pkt_size_crcdata;
 		if(x == (uint32_t)(pkt[i + 3] | (pkt[i + 2] << 8) | (pkt[i + 1] << 16) | (pkt[i] << 24)))
@@ -1450,7 +1670,7 @@ char ssdv_dec_is_packet(uint8_t *packet, int *errors)
 		if(errors) *errors = i;
 		
 		/* Test the checksum */
-		x = crc32(&pkt[1], pkt_size_crcdata);
+		x = crc32_calc(&pkt[1], pkt_size_crcdata);
 		
 		i = 1 + pkt_size_crcdata;
 		if(x == (uint32_t)(pkt[i + 3] | (pkt[i + 2] << 8) | (pkt[i + 1] << 16) | (pkt[i] << 24)))
@@ -1504,3 +1724,409 @@ void ssdv_dec_header(ssdv_packet_info_t *info, uint8_t *packet)
 
 /*****************************************************************************/
 
+/* Not a marker, used by the validator for the end of the input */
+#define J_END (0xFF00)
+
+static char ssdv_check_error(size_t *offset, size_t at, const char *msg)
+{
+	TRACE_ERROR("SSDV > Error: %s at offset %i", msg, (int) at);
+	*offset = at;
+	return(SSDV_ERROR);
+}
+
+static void ssdv_check_fill(ssdv_t *s)
+{
+	uint8_t b;
+	
+	/* Load whole bytes until the bits are full or a marker is reached */
+	while(s->worklen <= 24 && !s->marker)
+	{
+		if(s->in_len == 0)
+		{
+			s->marker = J_END;
+			break;
+		}
+		
+		b = s->inp[0];
+		if(b == 0xFF)
+		{
+			if(s->in_len == 1)
+			{
+				s->marker = J_END;
+				break;
+			}
+			
+			/* Skip fill bytes in front of a marker */
+			if(s->inp[1] == 0xFF)
+			{
+				s->inp++;
+				s->in_len--;
+				continue;
+			}
+			
+			/* Stop at a marker, the bits belong to the segment before it */
+			if(s->inp[1] != 0x00)
+			{
+				s->marker = 0xFF00 | s->inp[1];
+				break;
+			}
+			
+			/* Skip the stuffing byte */
+			s->inp++;
+			s->in_len--;
+		}
+		
+		s->workbits = (s->workbits << 8) | b;
+		s->worklen += 8;
+		s->inp++;
+		s->in_len--;
+	}
+}
+
+static inline char ssdv_check_bits(ssdv_t *s, uint8_t width)
+{
+	if(width == 0) return(SSDV_OK);
+	if(s->worklen < width) ssdv_check_fill(s);
+	if(s->worklen < width) return(SSDV_ERROR);
+	
+	s->worklen -= width;
+	s->workbits &= (1UL << s->worklen) - 1;
+	
+	return(SSDV_OK);
+}
+
+static inline char ssdv_check_symbol(ssdv_t *s, uint8_t *symbol)
+{
+	uint8_t width;
+	
+	/* A code is at most 16 bits wide */
+	if(s->worklen < 16) ssdv_check_fill(s);
+	if(jpeg_dht_lookup(s, symbol, &width) != SSDV_OK) return(SSDV_ERROR);
+	
+	return(ssdv_check_bits(s, width));
+}
+
+static char ssdv_check_scan(ssdv_t *s, const uint8_t *jpeg, size_t *offset)
+{
+	uint16_t mcu;
+	uint8_t symbol, rst = 0;
+	
+	s->workbits = s->worklen = 0;
+	s->marker = 0;
+	
+	for(mcu = 0; mcu < s->mcu_count; mcu++)
+	{
+		/* Each reset interval ends with the next RSTn marker */
+		if(s->dri && mcu > 0 && mcu % s->dri == 0)
+		{
+			ssdv_check_fill(s);
+			if(s->worklen >= 8 || s->marker != J_RST0 + rst)
+				return(ssdv_check_error(offset, s->inp - jpeg, "Expected restart marker"));
+			
+			s->inp += 2;
+			s->in_len -= 2;
+			s->marker = 0;
+			s->workbits = s->worklen = 0;
+			rst = (rst + 1) & 7;
+		}
+		
+		for(s->mcupart = 0; s->mcupart < s->ycparts + 2; s->mcupart++)
+		{
+			s->component = s->mcupart < s->ycparts ? 0 : s->mcupart - s->ycparts + 1;
+			
+			/* DC coefficient */
+			s->acpart = 0;
+			if(ssdv_check_symbol(s, &symbol) != SSDV_OK ||
+			   symbol > 11 ||
+			   ssdv_check_bits(s, symbol) != SSDV_OK)
+				return(ssdv_check_error(offset, s->inp - jpeg, "Bad DC coefficient"));
+			
+			/* AC coefficients, up to the end of block */
+			for(s->acpart = 1; s->acpart < 64; s->acpart++)
+			{
+				if(ssdv_check_symbol(s, &symbol) != SSDV_OK)
+					return(ssdv_check_error(offset, s->inp - jpeg, "Bad AC coefficient"));
+				
+				if(symbol == 0x00) break;
+				
+				/* Zero run and the size of the value */
+				s->acpart += symbol >> 4;
+				if((symbol & 0x0F) == 0 && symbol != 0xF0) s->acpart = 64;
+				if(s->acpart > 63 || (symbol & 0x0F) > 10 ||
+				   ssdv_check_bits(s, symbol & 0x0F) != SSDV_OK)
+					return(ssdv_check_error(offset, s->inp - jpeg, "Bad AC coefficient"));
+			}
+		}
+	}
+	
+	/* All that should be left is padding before the end of image */
+	ssdv_check_fill(s);
+	if(s->worklen >= 8 || s->marker != J_EOI)
+		return(ssdv_check_error(offset, s->inp - jpeg, "Expected end of image"));
+	
+	*offset = s->inp - jpeg + 2;
+	return(SSDV_OK);
+}
+
+static char ssdv_check_markers(ssdv_t *s, const uint8_t *jpeg, size_t length, size_t p, size_t *offset)
+{
+	const uint8_t *f;
+	uint8_t rst = 0;
+	
+	/* Search the entropy coded data for markers, without decoding it */
+	while(p + 1 < length)
+	{
+		f = memchr(&jpeg[p], 0xFF, length - p - 1);
+		if(!f) break;
+		
+		p = f - jpeg;
+		switch(0xFF00 | jpeg[p + 1])
+		{
+		case 0xFF00: /* Stuffing */
+		case 0xFFFF: /* Fill */
+			p++;
+			break;
+		
+		case J_EOI:
+			*offset = p + 2;
+			return(SSDV_OK);
+		
+		case J_RST0: case J_RST1: case J_RST2: case J_RST3:
+		case J_RST4: case J_RST5: case J_RST6: case J_RST7:
+			if(!s->dri || jpeg[p + 1] != (J_RST0 & 0xFF) + rst)
+				return(ssdv_check_error(offset, p, "Unexpected restart marker"));
+			rst = (rst + 1) & 7;
+			p += 2;
+			break;
+		
+		default:
+			return(ssdv_check_error(offset, p, "Unexpected marker in the image data"));
+		}
+	}
+	
+	return(ssdv_check_error(offset, length, "Premature end of file"));
+}
+
+char ssdv_jpeg_check(ssdv_t *s, const uint8_t *jpeg, size_t length, uint16_t width, uint16_t height, char scan, size_t *offset)
+{
+	const uint8_t *d;
+	size_t p = 2, l, next;
+	uint32_t code;
+	uint16_t marker;
+	int i, j;
+	
+	memset(s, 0, sizeof(ssdv_t));
+	*offset = 0;
+	
+	if(length < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8)
+		return(ssdv_check_error(offset, 0, "Missing SOI marker"));
+	
+	/* Walk the segments up to the start of the image data */
+	while(1)
+	{
+		if(p + 4 > length)
+			return(ssdv_check_error(offset, p, "Premature end of file"));
+		
+		if(jpeg[p] != 0xFF)
+			return(ssdv_check_error(offset, p, "Expected a marker"));
+		
+		/* Skip any fill bytes */
+		if(jpeg[p + 1] == 0xFF)
+		{
+			p++;
+			continue;
+		}
+		
+		marker = 0xFF00 | jpeg[p + 1];
+		
+		/* Markers without a length don't belong here */
+		if(marker == J_TEM || marker == J_SOI || marker == J_EOI ||
+		   (marker >= J_RST0 && marker <= J_RST7))
+			return(ssdv_check_error(offset, p, "Unexpected marker"));
+		
+		l = (jpeg[p + 2] << 8) | jpeg[p + 3];
+		if(l < 2 || p + 2 + l > length)
+			return(ssdv_check_error(offset, p + 2, "Bad segment length"));
+		
+		next = p + 2 + l;
+		d = &jpeg[p + 4];
+		l -= 2;
+		
+		switch(marker)
+		{
+		case J_SOF0:
+			if(l != 15 || d[0] != 8 || d[5] != 3)
+				return(ssdv_check_error(offset, p, "Image must be 8-bit Y'Cb'Cr"));
+			
+			s->width  = (d[3] << 8) | d[4];
+			s->height = (d[1] << 8) | d[2];
+			
+			if(s->width == 0 || s->height == 0 ||
+			   s->width > 4080 || s->height > 4080 ||
+			   (s->width & 0x0F) || (s->height & 0x0F))
+				return(ssdv_check_error(offset, p, "Bad image dimensions"));
+			
+			if((width && s->width != width) || (height && s->height != height))
+			{
+				TRACE_ERROR("SSDV > Error: Image is %ix%i, expected %ix%i",
+				            s->width, s->height, width, height);
+				return(ssdv_check_error(offset, p, "Wrong image dimensions"));
+			}
+			
+			for(i = 0; i < 3; i++)
+			{
+				const uint8_t *dq = &d[i * 3 + 6];
+				
+				if(dq[0] != i + 1 || (i > 0 && dq[1] != 0x11))
+					return(ssdv_check_error(offset, p, "Bad component in the SOF0 header"));
+			}
+			
+			switch(d[7])
+			{
+			case 0x22: s->ycparts = 4; s->mcu_count = (s->width >> 4) * (s->height >> 4); break;
+			case 0x12: s->ycparts = 2; s->mcu_count = (s->width >> 4) * (s->height >> 3); break;
+			case 0x21: s->ycparts = 2; s->mcu_count = (s->width >> 3) * (s->height >> 4); break;
+			case 0x11: s->ycparts = 1; s->mcu_count = (s->width >> 3) * (s->height >> 3); break;
+			default:
+				return(ssdv_check_error(offset, p, "Component 1 sampling factor is not supported"));
+			}
+			break;
+		
+		case J_SOF1: case J_SOF2:  case J_SOF3:  case J_SOF5:
+		case J_SOF6: case J_SOF7:  case J_SOF9:  case J_SOF10:
+		case J_SOF11: case J_SOF13: case J_SOF14: case J_SOF15:
+			return(ssdv_check_error(offset, p, "Only baseline images are supported"));
+		
+		case J_DHT:
+			while(l > 0)
+			{
+				/* Count the codes, they must fit the code space */
+				if(l < 17)
+					return(ssdv_check_error(offset, d - jpeg, "Bad DHT table"));
+				
+				for(j = 17, code = 0, i = 1; i <= 16; i++)
+				{
+					code = (code << 1) + d[i];
+					if(code > (1u << i))
+						return(ssdv_check_error(offset, d - jpeg, "Bad DHT table"));
+					j += d[i];
+				}
+				
+				if((size_t) j > l)
+					return(ssdv_check_error(offset, d - jpeg, "Bad DHT table"));
+				
+				switch(d[0])
+				{
+				case 0x00: s->sdht[0][0] = (uint8_t *) d; jpeg_dht_build(&s->sdht_lut[0][0], d); break;
+				case 0x01: s->sdht[0][1] = (uint8_t *) d; jpeg_dht_build(&s->sdht_lut[0][1], d); break;
+				case 0x10: s->sdht[1][0] = (uint8_t *) d; jpeg_dht_build(&s->sdht_lut[1][0], d); break;
+				case 0x11: s->sdht[1][1] = (uint8_t *) d; jpeg_dht_build(&s->sdht_lut[1][1], d); break;
+				}
+				
+				l -= j;
+				d += j;
+			}
+			break;
+		
+		case J_DQT:
+			while(l > 0)
+			{
+				/* Only 8-bit tables */
+				if(l < 65 || (d[0] >> 4))
+					return(ssdv_check_error(offset, d - jpeg, "Bad DQT table"));
+				
+				switch(d[0])
+				{
+				case 0x00: s->sdqt[0] = (uint8_t *) d; break;
+				case 0x01: s->sdqt[1] = (uint8_t *) d; break;
+				}
+				
+				l -= 65;
+				d += 65;
+			}
+			break;
+		
+		case J_DRI:
+			if(l != 2)
+				return(ssdv_check_error(offset, p, "Bad DRI segment"));
+			s->dri = (d[0] << 8) | d[1];
+			break;
+		
+		case J_SOS:
+			if(l != 10 || d[0] != 3 || d[1] != 1 || d[3] != 2 || d[5] != 3 ||
+			   d[7] != 0x00 || d[8] != 0x3F || d[9] != 0x00)
+				return(ssdv_check_error(offset, p, "Bad SOS header"));
+			
+			if(!s->mcu_count)
+				return(ssdv_check_error(offset, p, "Image data before the SOF0 header"));
+			
+			if(!s->sdqt[0] || !s->sdqt[1])
+				return(ssdv_check_error(offset, p, "Missing one or more DQT tables"));
+			
+			if(!s->sdht[0][0] || !s->sdht[0][1] ||
+			   !s->sdht[1][0] || !s->sdht[1][1])
+				return(ssdv_check_error(offset, p, "Missing one or more DHT tables"));
+			
+			if(!scan) return(ssdv_check_markers(s, jpeg, length, next, offset));
+			
+			s->inp    = &jpeg[next];
+			s->in_len = length - next;
+			return(ssdv_check_scan(s, jpeg, offset));
+		}
+		
+		/* Other segments are skipped */
+		p = next;
+	}
+}
+
+/* Quantisation tables, for estimating the size of the encoded image */
+
+char ssdv_jpeg_dqt(const uint8_t *jpeg, size_t length, uint8_t id, uint8_t *table)
+{
+	const uint8_t *d, *end;
+	size_t p = 2, l;
+	
+	if(length < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8) return(SSDV_ERROR);
+	
+	/* Walk the segments up to the start of the image data */
+	while(p + 4 <= length && jpeg[p] == 0xFF)
+	{
+		/* Skip any fill bytes */
+		if(jpeg[p + 1] == 0xFF)
+		{
+			p++;
+			continue;
+		}
+		
+		if((0xFF00 | jpeg[p + 1]) == J_SOS) break;
+		
+		l = (jpeg[p + 2] << 8) | jpeg[p + 3];
+		if(l < 2 || p + 2 + l > length) break;
+		
+		if((0xFF00 | jpeg[p + 1]) == J_DQT)
+		{
+			/* A segment may hold several tables */
+			end = &jpeg[p + 2 + l];
+			for(d = &jpeg[p + 4]; d + 65 <= end && (*d >> 4) == 0; d += 65)
+			{
+				if((*d & 0x0F) != id) continue;
+				memcpy(table, &d[1], 64);
+				return(SSDV_OK);
+			}
+		}
+		
+		p += 2 + l;
+	}
+	
+	return(SSDV_ERROR);
+}
+
+void ssdv_enc_dqt(uint8_t id, uint8_t quality, uint8_t *table)
+{
+	uint8_t dqt[65];
+	
+	load_standard_dqt(dqt, id ? std_dqt1 : std_dqt0, quality);
+	memcpy(table, &dqt[1], 64);
+}
+
+/*****************************************************************************/
@@ -48,6 +48,16 @@ extern "C" {
 #define SSDV_TYPE_NOFEC   (0x01)
 #define SSDV_TYPE_PADDING (0x02)
 
+#define SSDV_DHT_FAST_BITS (9) /* Width of the huffman code lookup table index */
+
+/* Huffman decoding lookup for one source DHT table */
+typedef struct
+{
+	uint16_t fast[1 << SSDV_DHT_FAST_BITS]; /* (width << 8) | symbol, 0 = no short code */
+	uint16_t code[17];  /* First code of each length                    */
+	uint16_t index[17]; /* Position of its symbol in the DHT table      */
+} ssdv_dht_lut_t;
+
 typedef struct
 {
 	/* Packet type configuration */
@@ -66,6 +76,7 @@ typedef struct
 	uint16_t mcu_id;
 	uint16_t mcu_count;
 	uint8_t  quality;   /* JPEG quality level for encoding, 0-7         */
+	char     dc_only;   /* Encode the DC coefficients only              */
 	uint16_t packet_mcu_id;
 	uint8_t  packet_mcu_offset;
 	
@@ -121,6 +132,7 @@ typedef struct
 	uint8_t stbls[TBL_LEN + HBUFF_LEN];
 	uint8_t *sdht[2][2], *sdqt[2];
 	uint16_t stbl_len;
+	ssdv_dht_lut_t sdht_lut[2][2];
 	
 	/* The same for output */
 	uint8_t dtbls[TBL_LEN];
@@ -147,9 +159,11 @@ typedef struct {
 
 /* Encoding */
 extern char ssdv_enc_init(ssdv_t *s, uint8_t type, char *callsign, uint8_t image_id, int8_t quality);
+extern char ssdv_enc_set_dc_only(ssdv_t *s, char dc_only);
 extern char ssdv_enc_set_buffer(ssdv_t *s, uint8_t *buffer);
 extern char ssdv_enc_get_packet(ssdv_t *s);
 extern char ssdv_enc_feed(ssdv_t *s, const uint8_t *buffer, size_t length);
+extern char ssdv_enc_set_input(ssdv_t *s, const uint8_t *buffer, size_t length);
 
 /* Decoding */
 extern char ssdv_dec_init(ssdv_t *s);
@@ -160,6 +174,13 @@ extern char ssdv_dec_get_jpeg(ssdv_t *s, uint8_t **jpeg, size_t *length);
 extern char ssdv_dec_is_packet(uint8_t *packet, int *errors);
 extern void ssdv_dec_header(ssdv_packet_info_t *info, uint8_t *packet);
 
+/* Validation */
+extern char ssdv_jpeg_check(ssdv_t *s, const uint8_t *jpeg, size_t length, uint16_t width, uint16_t height, char scan, size_t *offset);
+
+/* Quantisation tables, 64 entries in zigzag order */
+extern char ssdv_jpeg_dqt(const uint8_t *jpeg, size_t length, uint8_t id, uint8_t *table);
+extern void ssdv_enc_dqt(uint8_t id, uint8_t quality, uint8_t *table);
+
 #ifdef __cplusplus
 }
 #endif
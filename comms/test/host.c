@@ -0,0 +1,250 @@
+/*
+ * Host implementations of the stubbed kernel calls and newlib extras.
+ * Time is simulated and advances only when a thread sleeps or idles.
+ */
+#include "ch.h"
+#include "host.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <setjmp.h>
+
+static systime_t host_time;
+
+systime_t chVTGetSystemTime(void) {
+  return host_time;
+}
+
+systime_t chVTGetSystemTimeX(void) {
+  return host_time;
+}
+
+sysinterval_t chVTTimeElapsedSinceX(systime_t start) {
+  return host_time - start;
+}
+
+bool chVTIsSystemTimeWithinX(systime_t start, systime_t end) {
+  return (systime_t)(host_time - start) < (systime_t)(end - start);
+}
+
+void host_advance(sysinterval_t time) {
+  host_time += time;
+}
+
+/* Default sleep hook. Time passes with nothing else happening. */
+__attribute__((weak)) void host_sleep(sysinterval_t time) {
+  host_advance(time);
+}
+
+void chThdSleep(sysinterval_t time) {
+  host_sleep(time);
+}
+
+/* Default idle hook. A wait with nothing to wake it fails. */
+__attribute__((weak)) bool host_idle(sysinterval_t timeout) {
+  if(timeout == TIME_INFINITE)
+    return false;
+  host_time += timeout;
+  return false;
+}
+
+void chThdSleepMilliseconds(uint32_t msec) {
+  host_sleep(TIME_MS2I(msec));
+}
+
+void *chHeapAlloc(memory_heap_t *heapp, size_t size) {
+  (void)heapp;
+  return malloc(size);
+}
+
+void chHeapFree(void *p) {
+  free(p);
+}
+
+size_t strlcpy(char *dst, const char *src, size_t size) {
+  size_t len = strlen(src);
+  if(size != 0) {
+    size_t n = len < size - 1 ? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return len;
+}
+
+size_t strlcat(char *dst, const char *src, size_t size) {
+  size_t len = strnlen(dst, size);
+  if(len == size)
+    return len + strlen(src);
+  return len + strlcpy(dst + len, src, size - len);
+}
+
+char *strupr(char *s) {
+  for(char *p = s; *p != '\0'; p++)
+    *p = toupper((unsigned char)*p);
+  return s;
+}
+
+char *strlwr(char *s) {
+  for(char *p = s; *p != '\0'; p++)
+    *p = tolower((unsigned char)*p);
+  return s;
+}
+
+/*
+ * Threads.
+ * A created thread is run to completion by the test in host_run_thread().
+ * Exit returns to the runner with a long jump.
+ */
+static thread_t host_main_thread;
+static thread_t *host_current = &host_main_thread;
+static jmp_buf host_exit;
+
+thread_t *chThdGetSelfX(void) {
+  return host_current;
+}
+
+thread_t *chThdCreateFromHeap(memory_heap_t *heapp, size_t size,
+                              const char *name, tprio_t prio,
+                              tfunc_t pf, void *arg) {
+  (void)heapp;
+  (void)size;
+  (void)name;
+  (void)prio;
+  thread_t *tp = calloc(1, sizeof(thread_t));
+  if(tp != NULL) {
+    tp->func = pf;
+    tp->arg = arg;
+  }
+  return tp;
+}
+
+/* The working area is not used. The thread is freed by chThdWait(). */
+thread_t *chThdCreateStatic(void *wsp, size_t size,
+                            tprio_t prio, tfunc_t pf, void *arg) {
+  return chThdCreateFromHeap(NULL, size, NULL, prio, pf, arg);
+}
+
+void host_run_thread(thread_t *tp) {
+  thread_t *prev = host_current;
+  host_current = tp;
+  if(setjmp(host_exit) == 0)
+    tp->func(tp->arg);
+  tp->terminated = true;
+  host_current = prev;
+}
+
+bool chThdShouldTerminateX(void) {
+  return host_current->terminate;
+}
+
+void chThdTerminate(thread_t *tp) {
+  tp->terminate = true;
+}
+
+bool chThdTerminatedX(thread_t *tp) {
+  return tp->terminated;
+}
+
+msg_t chThdWait(thread_t *tp) {
+  if(!tp->terminated)
+    host_run_thread(tp);
+  free(tp);
+  return MSG_OK;
+}
+
+void chThdExit(msg_t msg) {
+  (void)msg;
+  longjmp(host_exit, 1);
+}
+
+void chThdExitS(msg_t msg) {
+  chThdExit(msg);
+}
+
+/*
+ * Thread references.
+ * A suspended thread calls the idle hook until it is resumed.
+ */
+msg_t chThdSuspendTimeoutS(thread_reference_t *trp, sysinterval_t timeout) {
+  thread_t *tp = host_current;
+  if(timeout == TIME_IMMEDIATE)
+    return MSG_TIMEOUT;
+  *trp = tp;
+  while(*trp == tp) {
+    if(!host_idle(timeout)) {
+      *trp = NULL;
+      return MSG_TIMEOUT;
+    }
+  }
+  return tp->msg;
+}
+
+void chThdResumeI(thread_reference_t *trp, msg_t msg) {
+  if(*trp != NULL) {
+    (*trp)->msg = msg;
+    *trp = NULL;
+  }
+}
+
+/*
+ * Events.
+ * A wait returns pending events or calls the test's idle hook which must
+ * make an event pending or request termination.
+ */
+void chEvtRegisterMaskWithFlags(event_source_t *esp, event_listener_t *elp,
+                                eventmask_t events, eventflags_t wflags) {
+  elp->next = esp->next;
+  esp->next = elp;
+  elp->listener = host_current;
+  elp->events = events;
+  elp->flags = 0;
+  elp->wflags = wflags;
+}
+
+void chEvtRegisterMask(event_source_t *esp, event_listener_t *elp,
+                       eventmask_t events) {
+  chEvtRegisterMaskWithFlags(esp, elp, events, (eventflags_t)-1);
+}
+
+void chEvtUnregister(event_source_t *esp, event_listener_t *elp) {
+  for(event_listener_t **p = &esp->next; *p != NULL; p = &(*p)->next) {
+    if(*p == elp) {
+      *p = elp->next;
+      return;
+    }
+  }
+}
+
+void chEvtBroadcastFlagsI(event_source_t *esp, eventflags_t flags) {
+  for(event_listener_t *elp = esp->next; elp != NULL; elp = elp->next) {
+    elp->flags |= flags;
+    if(flags == 0 || (flags & elp->wflags) != 0)
+      elp->listener->events |= elp->events;
+  }
+}
+
+eventflags_t chEvtGetAndClearFlags(event_listener_t *elp) {
+  eventflags_t flags = elp->flags;
+  elp->flags = 0;
+  return flags;
+}
+
+void chEvtSignal(thread_t *tp, eventmask_t events) {
+  tp->events |= events;
+}
+
+eventmask_t chEvtWaitAnyTimeout(eventmask_t events, sysinterval_t timeout) {
+  thread_t *tp = host_current;
+  while((tp->events & events) == 0) {
+    if(!host_idle(timeout) || tp->terminate)
+      return 0;
+  }
+  eventmask_t m = tp->events & events;
+  m &= -m;
+  tp->events &= ~m;
+  return m;
+}
+
+eventmask_t chEvtWaitAny(eventmask_t events) {
+  return chEvtWaitAnyTimeout(events, TIME_INFINITE);
+}
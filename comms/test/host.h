@@ -0,0 +1,27 @@
+/*
+ * Host test support.
+ */
+#ifndef TEST_HOST_H
+#define TEST_HOST_H
+
+#include "ch.h"
+
+/*
+ * Called when a thread waits with no event pending.
+ * Return false to end the wait with a timeout.
+ */
+bool host_idle(sysinterval_t timeout);
+
+/*
+ * Called when a thread sleeps. The default advances time.
+ * A simulator replaces it to deliver line events during the sleep.
+ */
+void host_sleep(sysinterval_t time);
+
+/* Advance simulated time. */
+void host_advance(sysinterval_t time);
+
+/* Run a thread created with chThdCreateFromHeap() until it exits. */
+void host_run_thread(thread_t *tp);
+
+#endif /* TEST_HOST_H */
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+"""
+Fit the SSDV packet model of imgctl.c to the test images in fit.txt.
+
+    packets = len / payload * exp(bias[q] + slope * steps)
+
+steps is the mean over the 64 luma coefficients of log2(SSDV step / camera
+step), counting zero where the SSDV step is finer. The camera tables are the
+libjpeg tables for the quality of each image. One slope is shared by all
+qualities and each quality 1 to 7 has its own bias. Quality 0 is not fitted,
+imgctl.c uses the quality 1 bias for it.
+
+Prints the constants for imgctl.c and the prediction error per quality.
+Run from this directory: python3 fit.py
+"""
+import math
+
+# SSDV packet payload of the image threads (SSDV_TYPE_PADDING).
+PAYLOAD = 256 - 15 - 4 - 72
+
+# Luma quantisation table of ssdv.c (std_dqt0) and of libjpeg, both in the
+# zigzag order of a DQT segment.
+SSDV_DQT = [
+    0x10, 0x0C, 0x0C, 0x0E, 0x0C, 0x0A, 0x10, 0x0E, 0x0E, 0x0E, 0x12, 0x12,
+    0x10, 0x14, 0x18, 0x28, 0x1A, 0x18, 0x16, 0x16, 0x18, 0x32, 0x24, 0x26,
+    0x1E, 0x28, 0x3A, 0x34, 0x3E, 0x3C, 0x3A, 0x34, 0x38, 0x38, 0x40, 0x48,
+    0x5C, 0x4E, 0x40, 0x44, 0x58, 0x46, 0x38, 0x38, 0x50, 0x6E, 0x52, 0x58,
+    0x60, 0x62, 0x68, 0x68, 0x68, 0x3E, 0x4E, 0x72, 0x7A, 0x70, 0x64, 0x78,
+    0x5C, 0x66, 0x68, 0x64,
+]
+SSDV_SCALES = [5000, 357, 172, 116, 100, 58, 28, 0]
+
+JPEG_DQT = [
+    16, 11, 12, 14, 12, 10, 16, 14, 13, 14, 18, 17, 16, 19, 24, 40, 26, 24,
+    22, 22, 24, 49, 35, 37, 29, 40, 58, 51, 61, 60, 57, 51, 56, 55, 64, 72,
+    92, 78, 64, 68, 87, 69, 55, 56, 80, 109, 81, 87, 95, 98, 103, 104, 103,
+    62, 77, 113, 121, 112, 100, 120, 92, 101, 103, 99,
+]
+
+
+def scale(table, factor):
+    return [min(255, max(1, (v * factor + 50) // 100)) for v in table]
+
+
+def ssdv_dqt(quality):
+    return scale(SSDV_DQT, SSDV_SCALES[quality])
+
+
+def jpeg_dqt(quality):
+    return scale(JPEG_DQT, 5000 // quality if quality < 50 else 200 - 2 * quality)
+
+
+def steps(cam, ssdv):
+    return sum(max(0.0, math.log2(s / c)) for s, c in zip(ssdv, cam)) / 64
+
+
+def main():
+    rows = []
+    for line in open("fit.txt"):
+        if line.startswith("#"):
+            continue
+        _, jq, size, *packets = line.split()
+        rows.append((jpeg_dqt(int(jq)), int(size), [int(p) for p in packets]))
+
+    qualities = range(1, 8)
+    data = {q: [(steps(cam, ssdv_dqt(q)), math.log(p[q] * PAYLOAD / size))
+                for cam, size, p in rows] for q in qualities}
+
+    # Common slope over the points centred on their quality's mean.
+    mean = {q: (sum(x for x, _ in d) / len(d), sum(y for _, y in d) / len(d))
+            for q, d in data.items()}
+    num = sum((x - mean[q][0]) * (y - mean[q][1])
+              for q, d in data.items() for x, y in d)
+    den = sum((x - mean[q][0]) ** 2 for q, d in data.items() for x, _ in d)
+    slope = num / den
+    bias = {q: mean[q][1] - slope * mean[q][0] for q in qualities}
+
+    print("#define IMG_CTL_SLOPE       %.3ff" % slope)
+    print("bias: " + ", ".join("%.2ff" % bias[q] for q in [1, *qualities]))
+    for q in qualities:
+        err = sorted(abs(math.exp(bias[q] + slope * x - y) - 1)
+                     for x, y in data[q])
+        print("quality %d: median error %.3f, 90%% %.3f"
+              % (q, err[len(err) // 2], err[int(len(err) * 0.9)]))
+
+
+if __name__ == "__main__":
+    main()
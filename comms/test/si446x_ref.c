@@ -0,0 +1,271 @@
+/*
+ * Reference property writes for test_si446x.c: the modem and band setup
+ * of si446x.c as it was before the property shadow, one SET_PROPERTY per
+ * property or setProperty call. 2FSK RX is the AFSK RX setup followed by
+ * its clock recovery run and slicer eye, written in the same way.
+ *
+ * Commands are applied to a property space of 256 groups of 256 instead
+ * of being sent to the radio.
+ */
+#include "pktconf.h"
+
+static uint8_t *ref_props;
+static uint32_t ref_cmds;
+
+static void ref_write(const uint8_t *msg, size_t len) {
+  if(msg[0] != Si446x_SET_PROPERTY)
+    return;
+  for(uint8_t i = 0; i < msg[2] && 4U + i < len; i++)
+    ref_props[(msg[1] << 8) | ((msg[3] + i) & 0xFF)] = msg[4 + i];
+  ref_cmds++;
+}
+
+static void Si446x_setProperty8(uint16_t reg, uint8_t val) {
+    uint8_t msg[] = {Si446x_SET_PROPERTY,
+                     (reg >> 8) & 0xFF, 0x01, reg & 0xFF, val};
+    ref_write(msg, sizeof(msg));
+}
+
+static void Si446x_setProperty16(uint16_t reg, uint8_t val1, uint8_t val2) {
+    uint8_t msg[] = {Si446x_SET_PROPERTY,
+                     (reg >> 8) & 0xFF, 0x02, reg & 0xFF, val1, val2};
+    ref_write(msg, sizeof(msg));
+}
+
+static void Si446x_setProperty24(uint16_t reg, uint8_t val1,
+                                 uint8_t val2, uint8_t val3) {
+    uint8_t msg[] = {Si446x_SET_PROPERTY,
+                     (reg >> 8) & 0xFF, 0x03, reg & 0xFF, val1, val2, val3};
+    ref_write(msg, sizeof(msg));
+}
+
+static void Si446x_setProperty32(uint16_t reg, uint8_t val1,
+                                 uint8_t val2, uint8_t val3, uint8_t val4) {
+    uint8_t msg[] = {Si446x_SET_PROPERTY,
+                     (reg >> 8) & 0xFF, 0x04, reg & 0xFF,
+                     val1, val2, val3, val4};
+    ref_write(msg, sizeof(msg));
+}
+
+uint32_t ref_setBandParameters(uint8_t *props, radio_freq_t freq,
+                               channel_hz_t step) {
+  ref_props = props;
+  ref_cmds = 0;
+
+  uint32_t outdiv = 0;
+  uint32_t band = 0;
+  if(freq < 705000000UL) {outdiv = 6;  band = 1;}
+  if(freq < 525000000UL) {outdiv = 8;  band = 2;}
+  if(freq < 353000000UL) {outdiv = 12; band = 3;}
+  if(freq < 239000000UL) {outdiv = 16; band = 4;}
+  if(freq < 177000000UL) {outdiv = 24; band = 5;}
+
+  uint32_t sy_sel = 8;
+  uint8_t set_band_property_command[] = {Si446x_SET_PROPERTY,
+                                         0x20, 0x01, 0x51, (band + sy_sel)};
+  ref_write(set_band_property_command, sizeof(set_band_property_command));
+
+  uint32_t f_pfd = 2 * Si446x_CCLK / outdiv;
+  uint32_t n = ((uint32_t)(freq / f_pfd)) - 1;
+  float ratio = (float)freq / (float)f_pfd;
+  float rest  = ratio - (float)n;
+
+  uint32_t m = (uint32_t)(rest * 524288UL);
+  uint32_t m2 = m >> 16;
+  uint32_t m1 = (m - m2 * 0x10000) >> 8;
+  uint32_t m0 = (m - m2 * 0x10000 - (m1 << 8));
+
+  uint32_t channel_increment = 524288 * outdiv * step / (2 * Si446x_CCLK);
+  uint8_t c1 = channel_increment / 0x100;
+  uint8_t c0 = channel_increment - (0x100 * c1);
+
+  uint8_t set_frequency_property_command[] = {Si446x_SET_PROPERTY,
+                                              0x40, 0x04, 0x00, n,
+                                              m2, m1, m0, c1, c0};
+  ref_write(set_frequency_property_command,
+            sizeof(set_frequency_property_command));
+
+  uint32_t x = ((((uint32_t)1 << 19) * outdiv * 1300.0)/(2*Si446x_CCLK))*2;
+  uint8_t x2 = (x >> 16) & 0xFF;
+  uint8_t x1 = (x >>  8) & 0xFF;
+  uint8_t x0 = (x >>  0) & 0xFF;
+  uint8_t set_deviation[] = {Si446x_SET_PROPERTY, 0x20, 0x03, 0x0a, x2, x1, x0};
+  ref_write(set_deviation, sizeof(set_deviation));
+  return ref_cmds;
+}
+
+uint32_t ref_setModemAFSK_TX(uint8_t *props) {
+    ref_props = props;
+    ref_cmds = 0;
+
+    uint32_t s = Si446x_CCLK / 10;
+    uint8_t f3 = (s >> 24) & 0xFF;
+    uint8_t f2 = (s >> 16) & 0xFF;
+    uint8_t f1 = (s >>  8) & 0xFF;
+    uint8_t f0 = (s >>  0) & 0xFF;
+    Si446x_setProperty32(Si446x_MODEM_TX_NCO_MODE, f3, f2, f1, f0);
+
+    Si446x_setProperty24(Si446x_MODEM_DATA_RATE, 0x00, 0x33, 0x90);
+
+    Si446x_setProperty8(Si446x_MODEM_MOD_TYPE, 0x02);
+
+    Si446x_setProperty8(Si446x_PKT_CONFIG1, 0x01);
+
+    const uint8_t coeff[] = {0x81, 0x9f, 0xc4, 0xee, 0x18, 0x3e, 0x5c, 0x70, 0x76};
+    uint8_t i;
+    for(i = 0; i < sizeof(coeff); i++) {
+        uint8_t msg[] = {0x11, 0x20, 0x01, 0x17-i, coeff[i]};
+        ref_write(msg, 5);
+    }
+    return ref_cmds;
+}
+
+static void ref_afsk_rx(radio_part_t part) {
+  Si446x_setProperty8(Si446x_MODEM_MOD_TYPE, 0x0A);
+
+  Si446x_setProperty8(Si446x_PKT_CONFIG1, 0x41);
+
+  if(is_part_Si4463(part)) {
+    Si446x_setProperty8(Si446x_MODEM_RAW_SEARCH2, 0x00);
+  }
+  Si446x_setProperty8(Si446x_MODEM_RAW_CONTROL, 0x8F);
+  Si446x_setProperty8(Si446x_MODEM_RAW_SEARCH, 0xD6);
+  Si446x_setProperty16(Si446x_MODEM_RAW_EYE, 0x00, 0x3B);
+
+  Si446x_setProperty8(Si446x_MODEM_OOK_PDTC, 0x2A);
+  Si446x_setProperty8(Si446x_MODEM_OOK_CNT1, 0x85);
+  Si446x_setProperty8(Si446x_MODEM_OOK_MISC, 0x23);
+
+  Si446x_setProperty8(Si446x_MODEM_AFC_GEAR, 0x54);
+  Si446x_setProperty8(Si446x_MODEM_AFC_WAIT, 0x36);
+  Si446x_setProperty16(Si446x_MODEM_AFC_GAIN, 0x80, 0xAB);
+  Si446x_setProperty16(Si446x_MODEM_AFC_LIMITER, 0x02, 0x50);
+  Si446x_setProperty8(Si446x_MODEM_AFC_MISC, 0xC0);
+
+  Si446x_setProperty8(Si446x_MODEM_AGC_CONTROL, 0xE0);
+  Si446x_setProperty8(Si446x_MODEM_AGC_WINDOW_SIZE, 0x11);
+  Si446x_setProperty8(Si446x_MODEM_AGC_RFPD_DECAY, 0x63);
+  Si446x_setProperty8(Si446x_MODEM_AGC_IFPD_DECAY, 0x63);
+
+  Si446x_setProperty8(Si446x_MODEM_MDM_CTRL, 0x80);
+  Si446x_setProperty16(Si446x_MODEM_BCR_OSR, 0x01, 0xC3);
+  Si446x_setProperty24(Si446x_MODEM_BCR_NCO_OFFSET, 0x01, 0x22, 0x60);
+  Si446x_setProperty16(Si446x_MODEM_BCR_GAIN, 0x00, 0x91);
+  Si446x_setProperty8(Si446x_MODEM_BCR_GEAR, 0x00);
+  Si446x_setProperty8(Si446x_MODEM_BCR_MISC1, 0xC2);
+
+  Si446x_setProperty8(Si446x_MODEM_IF_CONTROL, 0x08);
+  Si446x_setProperty24(Si446x_MODEM_IF_FREQ, 0x02, 0x80, 0x00);
+
+  Si446x_setProperty8(Si446x_MODEM_DECIMATION_CFG1, 0x70);
+  Si446x_setProperty8(Si446x_MODEM_DECIMATION_CFG0, 0x10);
+  if(is_part_Si4463(part)) {
+    Si446x_setProperty8(Si446x_MODEM_DECIMATION_CFG2, 0x0C);
+  }
+
+  Si446x_setProperty8(Si446x_MODEM_RSSI_CONTROL, 0x00);
+
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX1_CHFLT_COE13_7_0, 0xFF);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX1_CHFLT_COE12_7_0, 0xC4);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX1_CHFLT_COE11_7_0, 0x30);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX1_CHFLT_COE10_7_0, 0x7F);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX1_CHFLT_COE9_7_0, 0x5F);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX1_CHFLT_COE8_7_0, 0xB5);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX1_CHFLT_COE7_7_0, 0xB8);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX1_CHFLT_COE6_7_0, 0xDE);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX1_CHFLT_COE5_7_0, 0x05);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX1_CHFLT_COE4_7_0, 0x17);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX1_CHFLT_COE3_7_0, 0x16);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX1_CHFLT_COE2_7_0, 0x0C);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX1_CHFLT_COE1_7_0, 0x03);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX1_CHFLT_COE0_7_0, 0x00);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX1_CHFLT_COEM0, 0x15);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX1_CHFLT_COEM1, 0xFF);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX1_CHFLT_COEM2, 0x00);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX1_CHFLT_COEM3, 0x00);
+
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX2_CHFLT_COE13_7_0, 0xFF);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX2_CHFLT_COE12_7_0, 0xC4);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX2_CHFLT_COE11_7_0, 0x30);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX2_CHFLT_COE10_7_0, 0x7F);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX2_CHFLT_COE9_7_0, 0x5F);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX2_CHFLT_COE8_7_0, 0xB5);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX2_CHFLT_COE7_7_0, 0xB8);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX2_CHFLT_COE6_7_0, 0xDE);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX2_CHFLT_COE5_7_0, 0x05);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX2_CHFLT_COE4_7_0, 0x17);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX2_CHFLT_COE3_7_0, 0x16);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX2_CHFLT_COE2_7_0, 0x0C);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX2_CHFLT_COE1_7_0, 0x03);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX2_CHFLT_COE0_7_0, 0x00);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX2_CHFLT_COEM0, 0x15);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX2_CHFLT_COEM1, 0xFF);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX2_CHFLT_COEM2, 0x00);
+  Si446x_setProperty8(Si446x_MODEM_CHFLT_RX2_CHFLT_COEM3, 0x00);
+
+  Si446x_setProperty8(Si446x_PREAMBLE_CONFIG, 0x21);
+
+  if(is_part_Si4463(part)) {
+   Si446x_setProperty8(Si446x_MODEM_DSA_CTRL1, 0x00);
+   Si446x_setProperty8(Si446x_MODEM_DSA_CTRL2, 0x00);
+   Si446x_setProperty8(Si446x_MODEM_SPIKE_DET, 0x00);
+   Si446x_setProperty8(Si446x_MODEM_ONE_SHOT_AFC, 0x00);
+   Si446x_setProperty8(Si446x_MODEM_DSA_QUAL, 0x00);
+   Si446x_setProperty8(Si446x_MODEM_DSA_RSSI, 0x00);
+   Si446x_setProperty8(Si446x_MODEM_RSSI_MUTE, 0x00);
+   Si446x_setProperty8(Si446x_MODEM_DSA_MISC, 0x00);
+  }
+}
+
+uint32_t ref_setModemAFSK_RX(uint8_t *props, radio_part_t part) {
+  ref_props = props;
+  ref_cmds = 0;
+  ref_afsk_rx(part);
+  return ref_cmds;
+}
+
+uint32_t ref_setModem2FSK_RX(uint8_t *props, radio_part_t part,
+                             uint32_t speed) {
+  ref_props = props;
+  ref_cmds = 0;
+  ref_afsk_rx(part);
+
+  uint32_t fs = Si446x_CCLK / Si446x_RX_SAMPLE_DIV;
+  uint16_t osr = (8 * fs + speed / 2) / speed;
+  uint32_t nco = (uint32_t)(((uint64_t)speed << 22) / fs);
+  uint16_t gain = nco >> 9;
+  Si446x_setProperty16(Si446x_MODEM_BCR_OSR, osr >> 8, osr);
+  Si446x_setProperty24(Si446x_MODEM_BCR_NCO_OFFSET,
+                       nco >> 16, nco >> 8, nco);
+  Si446x_setProperty16(Si446x_MODEM_BCR_GAIN, gain >> 8, gain);
+  Si446x_setProperty16(Si446x_MODEM_RAW_EYE, 0x01, 0x62);
+  return ref_cmds;
+}
+
+uint32_t ref_setModem2FSK_TX(uint8_t *props, uint32_t speed) {
+    ref_props = props;
+    ref_cmds = 0;
+
+    uint32_t s = Si446x_CCLK / 10;
+    uint8_t f3 = (s >> 24) & 0xFF;
+    uint8_t f2 = (s >> 16) & 0xFF;
+    uint8_t f1 = (s >>  8) & 0xFF;
+    uint8_t f0 = (s >>  0) & 0xFF;
+    Si446x_setProperty32(Si446x_MODEM_TX_NCO_MODE, f3, f2, f1, f0);
+
+    Si446x_setProperty24(Si446x_MODEM_DATA_RATE,
+                         (uint8_t)(speed >> 16),
+                         (uint8_t)(speed >> 8), (uint8_t)speed);
+
+    Si446x_setProperty8(Si446x_MODEM_MOD_TYPE, 0x03);
+
+    Si446x_setProperty8(Si446x_PKT_CONFIG1, 0x01);
+
+    const uint8_t coeff[] = {0x01, 0x03, 0x08, 0x11, 0x21, 0x36, 0x4d, 0x60, 0x67};
+    uint8_t i;
+    for(i = 0; i < sizeof(coeff); i++) {
+        uint8_t msg[] = {0x11, 0x20, 0x01, 0x17-i, coeff[i]};
+        ref_write(msg, sizeof(msg));
+    }
+    return ref_cmds;
+}
@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+"""
+Make the reference JPEGs of test_ssdv.c, a synthetic view of the horizon
+from altitude: sky gradient, curved earth, clouds and some fine detail.
+
+    scene.jpg      320x240, 4:2:2 as from the camera, quality 85
+    scene_dri.jpg  320x240, 4:2:0 with a restart interval of 5 MCUs
+
+Needs Pillow. Run from this directory: python3 scene.py
+"""
+import math
+import random
+
+from PIL import Image, ImageDraw, ImageFilter
+
+W, H = 320, 240
+
+
+def scene():
+    random.seed(1)
+    im = Image.new("RGB", (W, H))
+    px = im.load()
+    for y in range(H):
+        for x in range(W):
+            # Earth below a horizon that bows up towards the middle.
+            horizon = 100 + 0.0012 * (x - W / 2) ** 2
+            if y < horizon:
+                t = y / horizon
+                px[x, y] = (int(10 + 90 * t), int(30 + 120 * t), int(90 + 150 * t))
+            else:
+                t = (y - horizon) / (H - horizon + 1)
+                g = 0.5 + 0.5 * math.sin(x * 0.11 + y * 0.05)
+                px[x, y] = (int(60 + 40 * g + 30 * t), int(80 + 50 * g), int(40 + 20 * t))
+
+    draw = ImageDraw.Draw(im)
+    for _ in range(40):
+        x, y = random.randrange(W), random.randrange(110, H)
+        r = random.randrange(4, 24)
+        v = random.randrange(200, 255)
+        draw.ellipse((x - 2 * r, y - r, x + 2 * r, y + r), fill=(v, v, v))
+    im = im.filter(ImageFilter.GaussianBlur(2))
+
+    # Sharp edges and noise, as the camera sees the payload and the sensor.
+    draw = ImageDraw.Draw(im)
+    draw.rectangle((8, 8, 72, 40), outline=(255, 255, 255))
+    for i in range(12):
+        draw.line((240 + i * 6, 10, 250 + i * 6, 60), fill=(255, 200, 0))
+    px = im.load()
+    for y in range(H):
+        for x in range(W):
+            n = random.randrange(-6, 7)
+            px[x, y] = tuple(min(255, max(0, c + n)) for c in px[x, y])
+    return im
+
+
+def main():
+    im = scene()
+    im.save("scene.jpg", quality=85, subsampling="4:2:2")
+    im.save("scene_dri.jpg", quality=85, subsampling="4:2:0",
+            restart_marker_blocks=5)
+
+
+if __name__ == "__main__":
+    main()
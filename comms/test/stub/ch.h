@@ -0,0 +1,184 @@
+/*
+ * Minimal ChibiOS kernel API for host tests.
+ * Only types and calls used by the modules under test are provided. Calls
+ * are implemented by the test programs or in host.c.
+ */
+#ifndef TEST_STUB_CH_H
+#define TEST_STUB_CH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define TRUE                1
+#define FALSE               0
+
+typedef int32_t             msg_t;
+typedef uint32_t            systime_t;
+typedef uint32_t            sysinterval_t;
+typedef uint32_t            time_msecs_t;
+typedef uint32_t            time_secs_t;
+typedef uint32_t            eventmask_t;
+typedef uint32_t            eventflags_t;
+typedef uint32_t            tprio_t;
+typedef uint32_t            cnt_t;
+typedef uint32_t            rtcnt_t;
+
+typedef void (*tfunc_t)(void *p);
+
+/* Threads are run by the test programs. */
+typedef struct {
+  tfunc_t           func;
+  void              *arg;
+  bool              terminate;
+  bool              terminated;
+  eventmask_t       events;
+  msg_t             msg;
+} thread_t;
+typedef thread_t           *thread_reference_t;
+typedef struct { int dummy; } memory_heap_t;
+typedef struct { int dummy; } heap_header_t;
+typedef struct { int dummy; } mutex_t;
+typedef struct { cnt_t cnt; } semaphore_t;
+typedef semaphore_t         binary_semaphore_t;
+typedef struct event_listener event_listener_t;
+typedef struct { event_listener_t *next; } event_source_t;
+struct event_listener {
+  event_listener_t  *next;
+  thread_t          *listener;
+  eventmask_t       events;
+  eventflags_t      flags;
+  eventflags_t      wflags;
+};
+typedef struct { int dummy; } BaseSequentialStream;
+struct pool_header {
+  struct pool_header *next;
+};
+
+typedef void (*vtfunc_t)(void *p);
+typedef struct {
+  vtfunc_t          func;
+  void              *par;
+  systime_t         when;
+  bool              armed;
+} virtual_timer_t;
+
+#define THD_FUNCTION(tname, arg)    void tname(void *arg)
+#define THD_WORKING_AREA_SIZE(n)    (n)
+#define THD_WORKING_AREA(s, n)      uint8_t s[n]
+#define NORMALPRIO          128
+#define LOWPRIO             2
+#define HIGHPRIO            255
+
+#define EVENT_MASK(eid)     ((eventmask_t)1 << (eventmask_t)(eid))
+#define ALL_EVENTS          ((eventmask_t)-1)
+#define EVENTSOURCE_DECL(name)      event_source_t name = {NULL}
+#define MUTEX_DECL(name)            mutex_t name = {0}
+
+#define MSG_OK              0
+#define MSG_TIMEOUT         -1
+#define MSG_RESET           -2
+#define MSG_ERROR           -3
+
+#define TIME_IMMEDIATE      ((sysinterval_t)0)
+#define TIME_INFINITE       ((sysinterval_t)-1)
+
+/* Host ticks are milliseconds. */
+#define CH_CFG_ST_FREQUENCY 1000
+#define TIME_MS2I(x)        ((sysinterval_t)(x))
+#define TIME_US2I(x)        ((sysinterval_t)(((x) + 999) / 1000))
+#define TIME_S2I(x)         ((sysinterval_t)((x) * 1000))
+#define TIME_I2MS(x)        ((time_msecs_t)(x))
+#define TIME_I2S(x)         ((time_secs_t)((x) / 1000))
+#define chTimeI2S(x)        TIME_I2S(x)
+#define chTimeI2MS(x)       TIME_I2MS(x)
+#define chTimeMS2I(x)       TIME_MS2I(x)
+#define chTimeUS2I(x)       TIME_US2I(x)
+#define chTimeDiffX(s, e)   ((sysinterval_t)((e) - (s)))
+#define chTimeAddX(s, i)    ((systime_t)((s) + (i)))
+
+#define chDbgAssert(c, r)   ((void)(c))
+#define chDbgCheck(c)       ((void)(c))
+#define osalDbgAssert(c, r) ((void)(c))
+#define osalDbgCheck(c)     ((void)(c))
+
+#define chSysLock()
+#define chSysUnlock()
+#define chSysLockFromISR()
+#define chSysUnlockFromISR()
+#define chMtxLock(m)        ((void)(m))
+#define chMtxUnlock(m)      ((void)(m))
+
+systime_t chVTGetSystemTime(void);
+systime_t chVTGetSystemTimeX(void);
+sysinterval_t chVTTimeElapsedSinceX(systime_t start);
+bool chVTIsSystemTimeWithinX(systime_t start, systime_t end);
+void chVTObjectInit(virtual_timer_t *vtp);
+void chVTSet(virtual_timer_t *vtp, sysinterval_t delay, vtfunc_t vtfunc,
+             void *par);
+void chVTReset(virtual_timer_t *vtp);
+#define chVTSetI(vtp, d, f, p)      chVTSet(vtp, d, f, p)
+#define chVTResetI(vtp)             chVTReset(vtp)
+rtcnt_t chSysGetRealtimeCounterX(void);
+void chSysHalt(const char *reason);
+void chThdSleep(sysinterval_t time);
+void chThdSleepMilliseconds(uint32_t msec);
+void *chHeapAlloc(memory_heap_t *heapp, size_t size);
+void chHeapFree(void *p);
+
+thread_t *chThdGetSelfX(void);
+thread_t *chThdCreateFromHeap(memory_heap_t *heapp, size_t size,
+                              const char *name, tprio_t prio,
+                              tfunc_t pf, void *arg);
+thread_t *chThdCreateStatic(void *wsp, size_t size,
+                            tprio_t prio, tfunc_t pf, void *arg);
+bool chThdShouldTerminateX(void);
+void chThdTerminate(thread_t *tp);
+bool chThdTerminatedX(thread_t *tp);
+msg_t chThdWait(thread_t *tp);
+void chThdExit(msg_t msg);
+void chThdExitS(msg_t msg);
+msg_t chThdSuspendTimeoutS(thread_reference_t *trp, sysinterval_t timeout);
+void chThdResumeI(thread_reference_t *trp, msg_t msg);
+
+void chEvtRegisterMaskWithFlags(event_source_t *esp, event_listener_t *elp,
+                                eventmask_t events, eventflags_t wflags);
+void chEvtRegisterMask(event_source_t *esp, event_listener_t *elp,
+                       eventmask_t events);
+void chEvtUnregister(event_source_t *esp, event_listener_t *elp);
+void chEvtBroadcastFlagsI(event_source_t *esp, eventflags_t flags);
+eventflags_t chEvtGetAndClearFlags(event_listener_t *elp);
+void chEvtSignal(thread_t *tp, eventmask_t events);
+eventmask_t chEvtWaitAny(eventmask_t events);
+eventmask_t chEvtWaitAnyTimeout(eventmask_t events, sysinterval_t timeout);
+#define chEvtBroadcastI(esp)        chEvtBroadcastFlagsI(esp, 0)
+#define chEvtBroadcast(esp)         chEvtBroadcastFlagsI(esp, 0)
+#define chEvtSignalI(tp, events)    chEvtSignal(tp, events)
+
+/* Objects FIFOs and messages are implemented by the tests using them. */
+#define CH_CFG_FACTORY_MAX_NAMES_LENGTH 8
+typedef struct { int dummy; } objects_fifo_t;
+typedef struct { objects_fifo_t fifo; } dyn_objects_fifo_t;
+
+dyn_objects_fifo_t *chFactoryCreateObjectsFIFO(const char *name,
+                                               size_t objsize,
+                                               size_t objn,
+                                               unsigned objalign);
+dyn_objects_fifo_t *chFactoryFindObjectsFIFO(const char *name);
+void chFactoryReleaseObjectsFIFO(dyn_objects_fifo_t *dofp);
+objects_fifo_t *chFactoryGetObjectsFIFO(dyn_objects_fifo_t *dofp);
+void *chFifoTakeObjectI(objects_fifo_t *ofp);
+void *chFifoTakeObjectTimeout(objects_fifo_t *ofp, sysinterval_t timeout);
+void chFifoReturnObject(objects_fifo_t *ofp, void *objp);
+void chFifoSendObjectI(objects_fifo_t *ofp, void *objp);
+void chFifoSendObject(objects_fifo_t *ofp, void *objp);
+msg_t chFifoReceiveObjectTimeout(objects_fifo_t *ofp, void **objpp,
+                                 sysinterval_t timeout);
+msg_t chMsgSend(thread_t *tp, msg_t msg);
+thread_t *chMsgWait(void);
+msg_t chMsgGet(thread_t *tp);
+void chMsgRelease(thread_t *tp, msg_t msg);
+void chBSemSignal(binary_semaphore_t *bsp);
+msg_t chBSemWaitTimeout(binary_semaphore_t *bsp, sysinterval_t timeout);
+
+#endif /* TEST_STUB_CH_H */
@@ -0,0 +1,11 @@
+/*
+ * Formatted output for host tests (mapped to the C library).
+ */
+#ifndef TEST_STUB_CHPRINTF_H
+#define TEST_STUB_CHPRINTF_H
+
+#include <stdio.h>
+
+#define chsnprintf          snprintf
+
+#endif /* TEST_STUB_CHPRINTF_H */
@@ -0,0 +1,39 @@
+/*
+ * STM32F4 CRC peripheral for host tests of the CRC32 hardware backend.
+ *
+ * The peripheral runs the CRC32 polynomial MSB first over 32 bit words
+ * written to DR and reads back the CRC register from DR. The CR reset
+ * bit loads 0xFFFFFFFF.
+ *
+ * A plain register cannot see its writes, so DR expands to a slot handed
+ * out by crc_emu_slot(). Each call first runs the word left in the last
+ * slot through the register, then fills the new slot with the register so
+ * a read returns it. A read leaves one word to be run, which only happens
+ * before the reset that starts every CRC.
+ */
+#ifndef TEST_STUB_CRC_HAL_H
+#define TEST_STUB_CRC_HAL_H
+
+#include "ch.h"
+
+typedef struct {
+  volatile uint32_t DR;
+  volatile uint32_t IDR;
+  volatile uint32_t CR;
+} CRC_TypeDef;
+
+#define CRC_CR_RESET        1U
+
+extern CRC_TypeDef crc_emu_regs;
+extern unsigned crc_emu_words;      /* Words run since the last reset. */
+volatile uint32_t *crc_emu_slot(void);
+
+#define CRC                 (&crc_emu_regs)
+#define DR                  DR, *crc_emu_slot()
+#define __RBIT(...)         crc_emu_rbit((__VA_ARGS__))
+
+uint32_t crc_emu_rbit(uint32_t value);
+
+#define rccEnableCRC(lp)    ((void)(lp))
+
+#endif /* TEST_STUB_CRC_HAL_H */
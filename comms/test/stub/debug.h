@@ -0,0 +1,24 @@
+/*
+ * Tracing is compiled out in host tests.
+ * The guard matches the real header so a module that includes debug.h
+ * from its own directory gets this one when it is included first.
+ */
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include "ch.h"
+#include "hal.h"
+#include "chprintf.h"
+#include "config.h"
+#include <string.h>
+
+#define TRACE_ACTIVE(level)     false
+#define TRACE_MON_ACTIVE()      false
+#define TRACE_DEBUG(format, args...)
+#define TRACE_INFO(format, args...)
+#define TRACE_MON(format, args...)
+#define TRACE_WARN(format, args...)
+#define TRACE_ERROR(format, args...) {}
+#define TRACE_TAB               ""
+
+#endif /* __TRACE_H__ */
@@ -0,0 +1,46 @@
+/*
+ * Packet system headers for host tests of the 2FSK channel.
+ * The demod driver holds only the 2FSK fields. The PWM capture and
+ * decoder thread are not used.
+ */
+#ifndef TEST_STUB_FSK_PKTCONF_H
+#define TEST_STUB_FSK_PKTCONF_H
+
+#include "ch.h"
+#include "hal.h"
+#include <string.h>
+
+/* ICU timer rate of the PWM capture. */
+#define ICU_COUNT_FREQUENCY     1000000U
+
+#include "types.h"
+#include "pkttypes.h"
+#include "txhdlc.h"
+#include "crc_calc.h"
+
+typedef float               pwm_accum_t;
+typedef int8_t              bit_t;
+typedef uint16_t            min_pwmcnt_t;
+
+typedef struct {
+  min_pwmcnt_t              impulse;
+  min_pwmcnt_t              valley;
+} min_pwm_counts_t;
+
+typedef struct packetHandlerData packet_svc_t;
+
+typedef struct AFSK_data {
+  mod_t                     demod_type;
+  pwm_accum_t               fsk_bit_size;
+  pwm_accum_t               fsk_timing;
+  bit_t                     fsk_level;
+  uint32_t                  fsk_lfsr;
+} AFSKDemodDriver;
+
+AFSKDemodDriver *pktCreateAFSKDecoder(packet_svc_t *pktHandler);
+
+#include "rxax25.h"
+#include "rxhdlc.h"
+#include "rxfsk.h"
+
+#endif /* TEST_STUB_FSK_PKTCONF_H */
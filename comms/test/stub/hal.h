@@ -0,0 +1,110 @@
+/*
+ * Minimal ChibiOS HAL API for host tests.
+ */
+#ifndef TEST_STUB_HAL_H
+#define TEST_STUB_HAL_H
+
+#include "ch.h"
+
+typedef uint32_t            ioline_t;
+typedef uint32_t            iomode_t;
+
+/* Channels are implemented by the test programs. */
+typedef struct host_channel BaseChannel;
+typedef struct host_channel BaseAsynchronousChannel;
+
+#define CHN_CONNECTED       1
+#define CHN_DISCONNECTED    2
+#define CHN_INPUT_AVAILABLE 4
+#define CHN_OUTPUT_EMPTY    8
+
+size_t chnReadTimeout(void *ip, uint8_t *bp, size_t n, sysinterval_t time);
+size_t chnWriteTimeout(void *ip, const uint8_t *bp, size_t n,
+                       sysinterval_t time);
+event_source_t *chnGetEventSource(void *ip);
+
+#define PAL_LOW             0
+#define PAL_HIGH            1
+#define PAL_MODE_INPUT      0
+#define PAL_MODE_OUTPUT_PUSHPULL 1
+#define PAL_MODE_INPUT_PULLUP    2
+#define PAL_MODE_INPUT_PULLDOWN  3
+#define PAL_MODE_ALTERNATE(n)    (16 + (n))
+
+#define PAL_EVENT_MODE_DISABLED     0
+#define PAL_EVENT_MODE_RISING_EDGE  1
+#define PAL_EVENT_MODE_FALLING_EDGE 2
+#define PAL_EVENT_MODE_BOTH_EDGES   3
+
+/* A line is its own port and pad. */
+#define PAL_PORT(line)      (line)
+#define PAL_PAD(line)       0
+#define PAL_LINE(port, pad) ((ioline_t)(port) * 16 + (pad))
+
+typedef void (*palcallback_t)(void *arg);
+typedef struct {
+  palcallback_t     cb;
+  void              *arg;
+} palevent_t;
+
+palevent_t *pal_lld_get_line_event(ioline_t line);
+
+uint8_t palReadLine(ioline_t line);
+void palWriteLine(ioline_t line, uint8_t state);
+void palSetLineMode(ioline_t line, iomode_t mode);
+void palEnableLineEvent(ioline_t line, uint32_t mode);
+void palDisableLineEvent(ioline_t line);
+void palSetLineCallback(ioline_t line, palcallback_t cb, void *arg);
+#define palSetLine(line)            palWriteLine(line, PAL_HIGH)
+#define palClearLine(line)          palWriteLine(line, PAL_LOW)
+#define palEnableLineEventI(l, m)   palEnableLineEvent(l, m)
+#define palDisableLineEventI(l)     palDisableLineEvent(l)
+
+/* Pads are not simulated. */
+#define GPIOA               0
+#define GPIOG               6
+#define PAL_STM32_OSPEED_HIGHEST    0
+#define palSetPadMode(port, pad, mode)  ((void)0)
+
+/* SPI transfers are implemented by the test programs. */
+typedef struct host_spi SPIDriver;
+typedef struct {
+  bool              circular;
+  void              *end_cb;
+  ioline_t          ssport;
+  uint32_t          sspad;
+  uint16_t          cr1;
+  uint16_t          cr2;
+} SPIConfig;
+
+#define SPI_READY           2
+#define SPI_CR1_BR_2        32
+#define SPI_CR1_MSTR        4
+
+extern SPIDriver SPID6;
+
+void spiStart(SPIDriver *spip, const SPIConfig *config);
+void spiStop(SPIDriver *spip);
+void spiAcquireBus(SPIDriver *spip);
+void spiReleaseBus(SPIDriver *spip);
+void spiSelect(SPIDriver *spip);
+void spiUnselect(SPIDriver *spip);
+void spiSend(SPIDriver *spip, size_t n, const void *txbuf);
+void spiReceive(SPIDriver *spip, size_t n, void *rxbuf);
+void spiExchange(SPIDriver *spip, size_t n, const void *txbuf, void *rxbuf);
+
+/* Input capture is not simulated. */
+typedef struct { int dummy; } ICUDriver;
+typedef struct { int dummy; } ICUConfig;
+
+#define LINE_IO1            1
+#define LINE_IO2            2
+#define LINE_IO3            3
+#define LINE_IO4            4
+
+#define RTC_BASE_YEAR       1980U
+
+void NVIC_SystemReset(void);
+#define __DMB()             __sync_synchronize()
+
+#endif /* TEST_STUB_HAL_H */
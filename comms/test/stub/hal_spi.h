@@ -0,0 +1,9 @@
+/*
+ * The SPI API is in the HAL stub.
+ */
+#ifndef TEST_STUB_HAL_SPI_H
+#define TEST_STUB_HAL_SPI_H
+
+#include "hal.h"
+
+#endif /* TEST_STUB_HAL_SPI_H */
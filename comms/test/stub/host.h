@@ -0,0 +1,15 @@
+/*
+ * Declarations newlib provides on target but glibc may not.
+ * Included ahead of every source file built for host tests.
+ */
+#ifndef TEST_STUB_HOST_H
+#define TEST_STUB_HOST_H
+
+#include <stddef.h>
+
+size_t strlcpy(char *dst, const char *src, size_t size);
+size_t strlcat(char *dst, const char *src, size_t size);
+char *strupr(char *s);
+char *strlwr(char *s);
+
+#endif /* TEST_STUB_HOST_H */
@@ -0,0 +1,20 @@
+/*
+ * Tracing for host tests of the image controller.
+ * Messages are printed when the test sets img_trace.
+ */
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdbool.h>
+#include <stdio.h>
+
+extern bool img_trace;
+
+#define TRACE_PRINT(format, args...)                                        \
+  do { if(img_trace) printf(format "\n", ##args); } while(0)
+#define TRACE_DEBUG(format, args...)
+#define TRACE_INFO(format, args...)     TRACE_PRINT(format, ##args)
+#define TRACE_WARN(format, args...)     TRACE_PRINT(format, ##args)
+#define TRACE_ERROR(format, args...)    TRACE_PRINT(format, ##args)
+
+#endif /* __TRACE_H__ */
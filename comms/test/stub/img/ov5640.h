@@ -0,0 +1,12 @@
+/*
+ * Camera driver calls used by the image controller.
+ */
+#ifndef __OV5640_H__
+#define __OV5640_H__
+
+#include "types.h"
+
+void OV5640_getResolutionSize(resolution_t res, uint16_t *width,
+                              uint16_t *height);
+
+#endif /* __OV5640_H__ */
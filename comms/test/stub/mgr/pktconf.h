@@ -0,0 +1,121 @@
+/*
+ * Packet system headers for host tests of the radio manager.
+ * The real module headers are used. Board and DSP headers are not.
+ */
+#ifndef TEST_STUB_MGR_PKTCONF_H
+#define TEST_STUB_MGR_PKTCONF_H
+
+#include "ch.h"
+#include "hal.h"
+#include "chprintf.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define EVT_NONE                0
+#define EVT_PRIORITY_BASE       0
+
+#define EVT_AFSK_START_FAIL     EVENT_MASK(EVT_PRIORITY_BASE +  5)
+#define EVT_PKT_BUFFER_MGR_FAIL EVENT_MASK(EVT_PRIORITY_BASE + 21)
+#define EVT_PKT_CBK_MGR_FAIL    EVENT_MASK(EVT_PRIORITY_BASE + 23)
+#define DEC_COMMAND_CLOSE       EVENT_MASK(EVT_PRIORITY_BASE + 2)
+#define DEC_CLOSE_EXEC          EVENT_MASK(EVT_PRIORITY_BASE + 18)
+#define USR_COMMAND_ACK         EVENT_MASK(EVT_PRIORITY_BASE + 19)
+
+/* Experimental 2FSK receive is off as in the firmware. */
+#define PKT_RX_USE_2FSK         FALSE
+
+#define PAL_TOGGLE              2U
+#define PAL_INVALID             -1
+
+/* Board band plan. */
+#define BAND_MIN_2M_FREQ        144000000
+#define BAND_MAX_2M_FREQ        148000000
+#define BAND_STEP_2M_HZ         12500
+#define BAND_MIN_70CM_FREQ      420000000
+#define BAND_MAX_70CM_FREQ      450000000
+#define BAND_STEP_70CM_HZ       25000
+#define DEFAULT_OPERATING_FREQ  144800000
+
+#include "pkttypes.h"
+#include "portab.h"
+#include "pktradio.h"
+#include "txhdlc.h"
+#include "crc_calc.h"
+#include "rxax25.h"
+#include "rxhdlc.h"
+
+extern const radio_config_t radio_list[];
+
+/* Packet service state used by the manager. */
+typedef enum {
+  PACKET_IDLE = 0,
+  PACKET_READY,
+  PACKET_OPEN,
+  PACKET_DECODE,
+  PACKET_PAUSE,
+  PACKET_STOP,
+  PACKET_CLOSE,
+  PACKET_INVALID
+} packet_state_t;
+
+struct packetHandlerData {
+  packet_state_t        state;
+  radio_unit_t          radio;
+  radio_part_t          radio_part;
+  radio_rev_t           radio_rom_rev;
+  radio_patch_t         radio_patch;
+  bool                  radio_init;
+  mutex_t               radio_mtx;
+  radio_task_object_t   radio_rx_config;
+  radio_signal_t        rx_strength;
+  radio_task_object_t   radio_tx_config;
+  uint8_t               tx_count;
+  pkt_tx_sched_t        tx_sched;
+  void                  *link_controller;
+  char                  rtask_name[CH_CFG_FACTORY_MAX_NAMES_LENGTH];
+  dyn_objects_fifo_t    *the_packet_fifo;
+  dyn_objects_fifo_t    *the_radio_fifo;
+  thread_t              *radio_manager;
+  binary_semaphore_t    close_sem;
+};
+
+packet_svc_t *pktGetServiceObject(radio_unit_t radio);
+
+static inline bool pktIsReceiveActive(radio_unit_t radio) {
+  return pktGetServiceObject(radio)->state == PACKET_DECODE;
+}
+
+static inline bool pktIsReceivePaused(radio_unit_t radio) {
+  return pktGetServiceObject(radio)->state == PACKET_PAUSE;
+}
+
+void pktReleaseBufferObject(packet_t pp);
+void pktReleaseBufferChain(packet_t pp);
+#include "si446x.h"
+
+/* Decoders started by the manager. */
+typedef struct AFSK_data {
+  event_source_t        event;
+  thread_t              *decoder_thd;
+} AFSKDemodDriver;
+
+AFSKDemodDriver *pktCreateAFSKDecoder(packet_svc_t *handler);
+AFSKDemodDriver *pktCreate2FSKDecoder(packet_svc_t *handler);
+
+void pktSetGPIOlineMode(ioline_t line, iomode_t mode);
+void pktWriteGPIOline(ioline_t line, uint8_t state);
+int8_t pktReadGPIOline(ioline_t line);
+
+/* Service calls made by the manager. */
+dyn_objects_fifo_t *pktIncomingBufferPoolCreate(radio_unit_t radio);
+void pktIncomingBufferPoolRelease(packet_svc_t *handler);
+thread_t *pktCallbackManagerCreate(radio_unit_t radio);
+void pktCallbackManagerRelease(packet_svc_t *handler);
+#define pktGetEventSource(ip) (&((ip)->event))
+#define pktRegisterEventListener(esp, el, events, flags)                    \
+  chEvtRegisterMaskWithFlags(esp, el, events, flags)
+#define pktUnregisterEventListener(esp, el) chEvtUnregister(esp, el)
+#define pktAddEventFlags(ip, flags) ((void)(flags))
+
+#endif /* TEST_STUB_MGR_PKTCONF_H */
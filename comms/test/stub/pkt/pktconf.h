@@ -0,0 +1,17 @@
+/*
+ * The packet system is not used by the host tests.
+ */
+#ifndef TEST_STUB_PKTCONF_H
+#define TEST_STUB_PKTCONF_H
+
+#include "ch.h"
+#include "hal.h"
+#include "pkttypes.h"
+
+typedef int pkt_tx_service_t;
+
+void pktSetGPIOlineMode(ioline_t line, iomode_t mode);
+void pktWriteGPIOline(ioline_t line, uint8_t state);
+int8_t pktReadGPIOline(ioline_t line);
+
+#endif /* TEST_STUB_PKTCONF_H */
@@ -0,0 +1,9 @@
+/*
+ * The radio driver is not used by the host tests.
+ */
+#ifndef TEST_STUB_SI446X_H
+#define TEST_STUB_SI446X_H
+
+#include "pkttypes.h"
+
+#endif /* TEST_STUB_SI446X_H */
@@ -0,0 +1,71 @@
+/*
+ * Packet system headers for host tests of the radio driver.
+ * The real module headers are used. Board and DSP headers are not.
+ */
+#ifndef TEST_STUB_RADIO_PKTCONF_H
+#define TEST_STUB_RADIO_PKTCONF_H
+
+#include "ch.h"
+#include "hal.h"
+#include "chprintf.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define EVT_NONE                0
+#define EVT_PRIORITY_BASE       0
+
+/* Experimental 2FSK receive is off as in the firmware. */
+#define PKT_RX_USE_2FSK         FALSE
+
+#define PAL_TOGGLE              2U
+#define PAL_INVALID             -1
+
+#include "pkttypes.h"
+#include "portab.h"
+#include "pktradio.h"
+#include "txhdlc.h"
+#include "crc_calc.h"
+#include "rxax25.h"
+#include "rxhdlc.h"
+
+/* Packet service state used by the driver. */
+typedef enum {
+  PACKET_IDLE = 0,
+  PACKET_READY,
+  PACKET_OPEN,
+  PACKET_DECODE,
+  PACKET_PAUSE,
+  PACKET_STOP,
+  PACKET_CLOSE,
+  PACKET_INVALID
+} packet_state_t;
+
+struct packetHandlerData {
+  radio_unit_t      radio;
+  packet_state_t    state;
+  bool              radio_init;
+  radio_part_t      radio_part;
+  radio_rev_t       radio_rom_rev;
+  radio_patch_t     radio_patch;
+};
+
+packet_svc_t *pktGetServiceObject(radio_unit_t radio);
+
+static inline bool pktIsReceiveActive(radio_unit_t radio) {
+  return pktGetServiceObject(radio)->state == PACKET_DECODE;
+}
+
+static inline bool pktIsReceivePaused(radio_unit_t radio) {
+  return pktGetServiceObject(radio)->state == PACKET_PAUSE;
+}
+
+void pktReleaseBufferObject(packet_t pp);
+void pktReleaseBufferChain(packet_t pp);
+#include "si446x.h"
+
+void pktSetGPIOlineMode(ioline_t line, iomode_t mode);
+void pktWriteGPIOline(ioline_t line, uint8_t state);
+int8_t pktReadGPIOline(ioline_t line);
+
+#endif /* TEST_STUB_RADIO_PKTCONF_H */
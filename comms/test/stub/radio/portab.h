@@ -0,0 +1,11 @@
+/*
+ * Board definitions for host tests of the radio driver.
+ */
+#ifndef TEST_STUB_RADIO_PORTAB_H
+#define TEST_STUB_RADIO_PORTAB_H
+
+#define Si446x_CLK              26000000U
+#define Si446x_CLK_OFFSET       0
+#define Si446x_CLK_TCXO_EN      TRUE
+
+#endif /* TEST_STUB_RADIO_PORTAB_H */
@@ -0,0 +1,15 @@
+/*
+ * Logging for host tests of the main firmware radio driver.
+ * Messages are dropped.
+ */
+#ifndef LOG_H
+#define LOG_H
+
+#define log_trace(...)      ((void)0)
+#define log_debug(...)      ((void)0)
+#define log_info(...)       ((void)0)
+#define log_warn(...)       ((void)0)
+#define log_error(...)      ((void)0)
+#define log_fatal(...)      ((void)0)
+
+#endif /* LOG_H */
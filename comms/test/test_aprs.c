@@ -0,0 +1,158 @@
+/*
+ * APRS frame templates against the full text encoders.
+ *
+ * Every frame built from a template must match the frame built by
+ * ax25_from_text() for the same monitor text byte for byte.
+ */
+#include "aprs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+conf_t conf_sram;
+
+static int failures;
+static uint32_t checked;
+static ptime_t now;
+
+msg_t pktGetPacketBuffer(packet_t *pp, sysinterval_t timeout) {
+  (void)timeout;
+  *pp = calloc(1, sizeof(struct TXpacket));
+  if(*pp == NULL)
+    return MSG_TIMEOUT;
+  (*pp)->magic1 = MAGIC;
+  (*pp)->magic2 = MAGIC;
+  return MSG_OK;
+}
+
+void pktReleasePacketBuffer(packet_t pp) {
+  free(pp);
+}
+
+void getTime(ptime_t *date) {
+  *date = now;
+}
+
+void unixTimestamp2Date(ptime_t *date, uint32_t time) {
+  memset(date, 0, sizeof(*date));
+  date->day = 1 + time % 28;
+  date->hour = time % 24;
+  date->minute = time % 60;
+}
+
+static void compare(const char *what, packet_t ref, packet_t tpl) {
+  checked++;
+  if(ref == NULL && tpl == NULL)
+    return;
+  if(ref == NULL || tpl == NULL) {
+    printf("%s: %s packet is NULL\n", what, ref == NULL ? "full" : "template");
+    failures++;
+  } else if(ref->frame_len != tpl->frame_len
+      || memcmp(ref->frame_data, tpl->frame_data, ref->frame_len) != 0) {
+    printf("%s: frames differ (%u/%u bytes)\n", what,
+           ref->frame_len, tpl->frame_len);
+    failures++;
+  }
+  pktReleasePacketBuffer(ref);
+  pktReleasePacketBuffer(tpl);
+}
+
+static void random_point(dataPoint_t *dp) {
+  uint8_t *p = (uint8_t *)dp;
+  for(size_t i = 0; i < sizeof(*dp); i++)
+    p[i] = rand();
+  dp->gps_lat = (rand() % 1800000000) - 900000000;
+  dp->gps_lon = (rand() % 1800000000) - 900000000;
+  dp->gps_alt = 1 + rand() % 40000;
+}
+
+/* Data strings include <0xnn> escapes and lengths past the text limit. */
+static void random_data(uint8_t *data, size_t size) {
+  static const char *escapes[] = {"<0x41>", "<0xff>", "<0x4g>", "<0x1", "<"};
+  size_t len = rand() % (size - 1);
+  size_t i = 0;
+  while(i < len) {
+    if(rand() % 8 == 0) {
+      const char *e = escapes[rand() % 5];
+      size_t n = strlen(e);
+      if(i + n > len)
+        break;
+      memcpy(&data[i], e, n);
+      i += n;
+    } else {
+      data[i++] = 33 + rand() % 91;
+    }
+  }
+  data[i] = '\0';
+}
+
+static void check_identity(const char *call, const char *path) {
+  aprs_template_t *tpl = malloc(sizeof(aprs_template_t));
+  aprs_template_init(tpl);
+  aprs_sym_t symbol = SYM_BALLOON;
+  if(!aprs_template_update(tpl, call, path, symbol)) {
+    printf("%s %s: template build failed\n", call, path);
+    failures++;
+    free(tpl);
+    return;
+  }
+  char what[64];
+  snprintf(what, sizeof(what), "%s %s", call, path);
+  for(int i = 0; i < 500; i++) {
+    dataPoint_t dp;
+    random_point(&dp);
+    now.day = 1 + i % 28;
+    now.hour = i % 24;
+    now.minute = i % 60;
+    now.year = i & 1 ? RTC_BASE_YEAR : 2020;
+    compare(what,
+            aprs_encode_position_and_telemetry(call, path, symbol, &dp, true),
+            aprs_template_position_and_telemetry(tpl, &dp));
+    compare(what,
+            aprs_encode_stamped_position_and_telemetry(call, path, symbol, &dp),
+            aprs_template_stamped_position_and_telemetry(tpl, &dp));
+    uint8_t data[300];
+    random_data(data, sizeof(data));
+    compare(what, aprs_encode_data_packet(call, path, 'I', data),
+            aprs_template_data_packet(tpl, 'I', data));
+  }
+  for(uint8_t type = 0; type < APRS_NUM_TELEM_GROUPS; type++)
+    compare(what,
+            aprs_encode_telemetry_configuration(call, path, call, type),
+            aprs_template_telemetry_configuration(tpl, type));
+  if(aprs_template_telemetry_configuration(tpl, APRS_NUM_TELEM_GROUPS)
+      != NULL) {
+    printf("%s: telemetry group out of range accepted\n", what);
+    failures++;
+  }
+  free(tpl);
+}
+
+int main(void) {
+  srand(26);
+  check_identity("DL7AD-12", "WIDE1-1");
+  check_identity("VK2GJ-15", "WIDE1-1,WIDE2-1");
+  check_identity("N0CALL", "RELAY,WIDE2-2");
+
+  /* A rebuild is needed only when call or path change. */
+  aprs_template_t *tpl = malloc(sizeof(aprs_template_t));
+  aprs_template_init(tpl);
+  if(!aprs_template_update(tpl, "DL7AD-12", "WIDE1-1", SYM_BALLOON)
+      || !aprs_template_update(tpl, "DL7AD-13", "WIDE1-1", SYM_BALLOON)
+      || strcmp(tpl->call, "DL7AD-13") != 0) {
+    printf("template rebuild failed\n");
+    failures++;
+  }
+  /* A path longer than the template holds must not be truncated. */
+  if(aprs_template_update(tpl, "DL7AD-12", "WIDE1-1,WIDE2-1,WIDE3-1",
+                          SYM_BALLOON)
+      || aprs_template_position_and_telemetry(tpl, &(dataPoint_t){0})
+         != NULL) {
+    printf("oversize path accepted\n");
+    failures++;
+  }
+  free(tpl);
+
+  printf("aprs: %u frames compared, %d failures\n", checked, failures);
+  return failures != 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * CRC32 against a bitwise reference.
+ *
+ * Every software kernel and the hardware backend must give the check value
+ * and the reference CRC for all lengths and alignments, and a CRC run in
+ * two parts must equal one run over the whole buffer. The hardware build
+ * uses the emulated peripheral in stub/crc and checks that long buffers
+ * were sent to it.
+ *
+ * The software build also times the kernel against the bitwise loop it
+ * replaced, over SSDV packet sized blocks.
+ */
+#include "crc32.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if CRC32_USE_HW
+#include "hal.h"
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TEST_CRC_CYCLES
+#endif
+
+static int failures;
+
+/* The loop ssdv.c used before the CRC32 module. */
+static uint32_t crc32_bitwise(const void *data, size_t length) {
+  uint32_t crc = 0xFFFFFFFF, x;
+  const uint8_t *d = data;
+  for(; length; length--) {
+    x = (crc ^ *d++) & 0xFF;
+    for(int i = 8; i > 0; i--)
+      x = (x & 1) ? (x >> 1) ^ 0xEDB88320 : x >> 1;
+    crc = (crc >> 8) ^ x;
+  }
+  return crc ^ 0xFFFFFFFF;
+}
+
+#if CRC32_USE_HW
+CRC_TypeDef crc_emu_regs;
+unsigned crc_emu_words;
+static volatile uint32_t crc_emu_data;
+static uint32_t crc_emu_crc;
+static bool crc_emu_pending;
+
+volatile uint32_t *crc_emu_slot(void) {
+  if(crc_emu_pending) {
+    crc_emu_crc ^= crc_emu_data;
+    for(int i = 0; i < 32; i++)
+      crc_emu_crc = (crc_emu_crc & 0x80000000)
+                    ? (crc_emu_crc << 1) ^ 0x04C11DB7 : crc_emu_crc << 1;
+    crc_emu_words++;
+  }
+  if(crc_emu_regs.CR & CRC_CR_RESET) {
+    crc_emu_regs.CR &= ~CRC_CR_RESET;
+    crc_emu_crc = 0xFFFFFFFF;
+    crc_emu_words = 0;
+  }
+  crc_emu_data = crc_emu_crc;
+  crc_emu_pending = true;
+  return &crc_emu_data;
+}
+
+uint32_t crc_emu_rbit(uint32_t value) {
+  uint32_t r = 0;
+  for(int i = 0; i < 32; i++)
+    if(value & (1U << i))
+      r |= 1U << (31 - i);
+  return r;
+}
+#endif
+
+static void check(bool ok, const char *what, size_t off, size_t len) {
+  if(!ok) {
+    printf("FAIL %s: offset %zu length %zu\n", what, off, len);
+    failures++;
+  }
+}
+
+static void test_vectors(void) {
+  check(crc32_calc("123456789", 9) == 0xCBF43926, "check value", 0, 9);
+  check(crc32_calc("", 0) == 0, "empty", 0, 0);
+}
+
+static void test_reference(const uint8_t *buf) {
+  for(size_t off = 0; off < 8; off++) {
+    for(size_t len = 0; len < 600; len++) {
+      const uint8_t *d = buf + off;
+      uint32_t ref = crc32_bitwise(d, len);
+#if CRC32_USE_HW
+      crc_emu_words = 0;
+#endif
+      check(crc32_calc(d, len) == ref, "crc", off, len);
+#if CRC32_USE_HW
+      check(crc_emu_words == (len >= CRC32_HW_MIN ? len / 4 : 0),
+            "peripheral not used", off, len);
+#endif
+      size_t h = len / 3;
+      check(crc32_update(crc32_update(0, d, h), d + h, len - h) == ref,
+            "running crc", off, len);
+    }
+  }
+}
+
+#if defined(TEST_CRC_CYCLES)
+static void benchmark(const uint8_t *buf) {
+  static const size_t sizes[] = {219, 251, 4096};
+  for(size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+    size_t n = sizes[k];
+    int it = 200000 * 251 / n;
+    volatile uint32_t sink = 0;
+    unsigned long long a = __rdtsc();
+    for(int i = 0; i < it / 10; i++)
+      sink += crc32_bitwise(buf + 1, n);
+    unsigned long long b = __rdtsc();
+    for(int i = 0; i < it; i++)
+      sink += crc32_calc(buf + 1, n);
+    unsigned long long c = __rdtsc();
+    printf("crc32: %4zu bytes: bitwise %.3f, %d slice %.3f bytes/cycle\n",
+           n, (double)n * (it / 10) / (b - a), CRC32_SLICES,
+           (double)n * it / (c - b));
+  }
+}
+#endif
+
+int main(void) {
+  static uint8_t buf[4096 + 8];
+  srand(3);
+  for(size_t i = 0; i < sizeof(buf); i++)
+    buf[i] = rand();
+  test_vectors();
+  test_reference(buf);
+#if defined(TEST_CRC_CYCLES)
+  benchmark(buf);
+#endif
+  printf("crc32: %d failures\n", failures);
+  return failures != 0;
+}
@@ -0,0 +1,194 @@
+/*
+ * Image packet budget controller over recorded images.
+ *
+ * imgctl/seq.txt records a sequence of 60 frames of a panning scene, with
+ * stretches of clear, hazy and noisy frames, captured at every resolution.
+ * Each record holds the JPEG size and the SSDV packet count at each
+ * quality. The controller is run over the sequence and each capture is
+ * given a JPEG of the recorded size with the camera quantisation table.
+ *
+ * With no budget the configured quality and resolution must be used. With
+ * a budget few images may go over it, most of it must be used and the
+ * model must predict the packet count closely once it has learned. Packets
+ * reserved ahead of each image, as for a preview, count against the budget.
+ *
+ * Set IMG_TRACE in the environment to print the controller decisions.
+ * The packet model is fitted by imgctl/fit.py.
+ */
+#include "imgctl.h"
+#include "ov5640.h"
+#include "ssdv.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define FRAMES          60
+#define WARM_UP         3
+
+/* Quality of the recorded JPEGs. */
+#define JPEG_QUALITY    85
+
+bool img_trace;
+
+typedef struct {
+  uint32_t          size;
+  uint16_t          packets[8];
+} img_record_t;
+
+static img_record_t seq[FRAMES][RES_MAX];
+static uint8_t jpeg[512 * 1024];
+static int failures;
+
+void OV5640_getResolutionSize(resolution_t res, uint16_t *width,
+                              uint16_t *height) {
+  switch(res) {
+  case RES_QQVGA:   *width = 160;   *height = 112;  break;
+  case RES_VGA:     *width = 640;   *height = 480;  break;
+  case RES_XGA:     *width = 1024;  *height = 768;  break;
+  case RES_UXGA:
+  case RES_MAX:     *width = 1600;  *height = 1200; break;
+  case RES_NONE:    *width = 0;     *height = 0;    break;
+  default:          *width = 320;   *height = 240;  break;
+  }
+}
+
+static resolution_t resolution(const char *name) {
+  static const char *names[] = {
+    [RES_QQVGA] = "QQVGA", [RES_QVGA] = "QVGA", [RES_VGA] = "VGA",
+    [RES_XGA] = "XGA", [RES_UXGA] = "UXGA"
+  };
+  for(int r = 0; r < RES_MAX; r++) {
+    if(names[r] != NULL && strcmp(names[r], name) == 0)
+      return r;
+  }
+  return RES_NONE;
+}
+
+static bool load(const char *path) {
+  FILE *fp = fopen(path, "r");
+  if(fp == NULL)
+    return false;
+  char line[128], name[8];
+  int frame;
+  img_record_t rec;
+  while(fgets(line, sizeof(line), fp) != NULL) {
+    if(line[0] == '#')
+      continue;
+    if(sscanf(line, "%d %7s %u %hu %hu %hu %hu %hu %hu %hu %hu", &frame,
+              name, &rec.size, &rec.packets[0], &rec.packets[1],
+              &rec.packets[2], &rec.packets[3], &rec.packets[4],
+              &rec.packets[5], &rec.packets[6], &rec.packets[7]) != 11
+        || frame < 0 || frame >= FRAMES || rec.size > sizeof(jpeg)
+        || resolution(name) == RES_NONE) {
+      fclose(fp);
+      return false;
+    }
+    seq[frame][resolution(name)] = rec;
+  }
+  fclose(fp);
+  return true;
+}
+
+/* A JPEG header holding the libjpeg luma table, zigzag order. */
+static void jpeg_header(void) {
+  static const uint8_t luma[64] = {
+    16, 11, 12, 14, 12, 10, 16, 14, 13, 14, 18, 17, 16, 19, 24, 40,
+    26, 24, 22, 22, 24, 49, 35, 37, 29, 40, 58, 51, 61, 60, 57, 51,
+    56, 55, 64, 72, 92, 78, 64, 68, 87, 69, 55, 56, 80, 109, 81, 87,
+    95, 98, 103, 104, 103, 62, 77, 113, 121, 112, 100, 120, 92, 101,
+    103, 99
+  };
+  const int scale = 200 - 2 * JPEG_QUALITY;
+  uint8_t *d = jpeg;
+  *d++ = 0xFF; *d++ = 0xD8;
+  *d++ = 0xFF; *d++ = 0xDB; *d++ = 0; *d++ = 67; *d++ = 0;
+  for(int i = 0; i < 64; i++) {
+    int v = (luma[i] * scale + 50) / 100;
+    *d++ = v < 1 ? 1 : v;
+  }
+  *d++ = 0xFF; *d++ = 0xDA; *d++ = 0; *d++ = 2;
+}
+
+typedef struct {
+  int               over;       /* Images over budget.              */
+  int               fixed_over; /* The same at fixed settings.      */
+  double            use;        /* Mean part of the budget used.    */
+  double            error;      /* Mean prediction error.           */
+  int               res_kept;   /* Captures at the configured res.  */
+  int               quality_kept; /* Images at the configured quality. */
+} img_run_t;
+
+static img_run_t run(uint16_t budget, uint8_t quality, resolution_t res,
+                     uint16_t reserve) {
+  img_ctl_t ctl;
+  img_run_t result = {0};
+  imgCtlInit(&ctl);
+  for(int k = 0; k < FRAMES; k++) {
+    resolution_t r = imgCtlStart(&ctl, budget, quality, res);
+    imgCtlReserve(&ctl, reserve);
+    img_record_t *rec = &seq[k][r];
+    uint8_t q = imgCtlSelect(&ctl, jpeg, rec->size);
+    uint16_t packets = rec->packets[q];
+    float predicted = ctl.predicted;
+    imgCtlUpdate(&ctl, packets);
+
+    result.res_kept += r == res;
+    result.quality_kept += q == quality;
+    if(budget == 0)
+      continue;
+    result.over += reserve + packets > budget;
+    result.fixed_over += reserve + seq[k][res].packets[quality] > budget;
+    result.use += (double)(reserve + packets) / budget / FRAMES;
+    if(k >= WARM_UP)
+      result.error += fabs(packets / predicted - 1) / (FRAMES - WARM_UP);
+  }
+  if(budget == 0)
+    return result;
+  printf("imgctl: budget %3u reserve %2u quality %u res %u: over %2d/%d,"
+         " use %.2f, error %.3f | fixed over %2d/%d\n", budget, reserve,
+         quality, res, result.over, FRAMES, result.use, result.error,
+         result.fixed_over, FRAMES);
+  return result;
+}
+
+static void check(bool ok, const char *name, const char *what) {
+  if(!ok) {
+    printf("FAIL %s: %s\n", name, what);
+    failures++;
+  }
+}
+
+static void test_off(void) {
+  const char *name = "no budget";
+  img_run_t r = run(0, 5, RES_UXGA, 0);
+  check(r.res_kept == FRAMES && r.quality_kept == FRAMES, name,
+        "settings changed");
+}
+
+static void test_budget(uint16_t budget, uint8_t quality, resolution_t res,
+                        uint16_t reserve) {
+  const char *name = "budget";
+  img_run_t r = run(budget, quality, res, reserve);
+  check(r.over <= FRAMES / 10, name, "too many images over budget");
+  check(r.use >= 0.6, name, "budget not used");
+  check(r.error <= 0.1, name, "prediction error");
+}
+
+int main(void) {
+  img_trace = getenv("IMG_TRACE") != NULL;
+  if(!load("imgctl/seq.txt")) {
+    printf("imgctl: cannot read imgctl/seq.txt\n");
+    return 1;
+  }
+  jpeg_header();
+  test_off();
+  test_budget(200, 5, RES_UXGA, 0);
+  test_budget(100, 7, RES_UXGA, 0);
+  test_budget(400, 4, RES_XGA, 0);
+  test_budget(60, 5, RES_VGA, 0);
+  test_budget(200, 5, RES_UXGA, 50);
+  printf("imgctl: %d failures\n", failures);
+  return failures != 0;
+}
@@ -0,0 +1,328 @@
+/*
+ * KISS bridge loopback.
+ *
+ * Frames queued from the radio side are read back from the channel and
+ * KISS decoded. Frames written to the channel by the host are checked at
+ * the radio. The bridge must only wake on channel input or queued frames.
+ */
+#include "usb/kiss.h"
+#include "radio.h"
+#include "host.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_FRAMES      400
+#define FRAME_MAX       (AX25_MAX_PACKET_LEN)
+
+conf_t conf_sram;
+
+typedef struct {
+  size_t            len;
+  uint8_t           data[FRAME_MAX];
+} frame_t;
+
+typedef struct {
+  frame_t           frame[MAX_FRAMES];
+  int               count;
+} frame_list_t;
+
+struct host_channel {
+  event_source_t    event;
+  uint8_t           *in;
+  size_t            in_len;
+  size_t            in_arrived;     /* Bytes the host has sent so far. */
+  size_t            in_pos;
+  size_t            chunk;          /* Bytes sent per arrival. */
+  uint8_t           *out;
+  size_t            out_len;
+  size_t            out_size;
+  size_t            write_max;      /* Bytes accepted per write call. */
+};
+
+static struct host_channel chan;
+static thread_t *bridge;
+static uint32_t wakeups;
+static int failures;
+
+static frame_list_t radio_rx;       /* Radio to host. */
+static frame_list_t host_tx;        /* Host to radio. */
+static frame_list_t radio_tx;       /* Seen at the radio. */
+
+packet_t ax25_from_frame(unsigned char *data, uint16_t len) {
+  packet_t pp = calloc(1, sizeof(struct TXpacket));
+  memcpy(pp->frame_data, data, len);
+  pp->frame_len = len;
+  return pp;
+}
+
+bool transmitOnRadio(packet_t pp, radio_freq_t freq, channel_hz_t step,
+                     radio_ch_t chan, radio_pwr_t pwr, mod_t mod,
+                     radio_squelch_t rssi) {
+  frame_t *f = &radio_tx.frame[radio_tx.count++];
+  f->len = pp->frame_len;
+  memcpy(f->data, pp->frame_data, pp->frame_len);
+  free(pp);
+  return true;
+}
+
+size_t chnReadTimeout(void *ip, uint8_t *bp, size_t n, sysinterval_t time) {
+  struct host_channel *c = ip;
+  size_t avail = c->in_arrived - c->in_pos;
+  if(n > avail)
+    n = avail;
+  memcpy(bp, &c->in[c->in_pos], n);
+  c->in_pos += n;
+  return n;
+}
+
+size_t chnWriteTimeout(void *ip, const uint8_t *bp, size_t n,
+                       sysinterval_t time) {
+  struct host_channel *c = ip;
+  if(n > c->write_max)
+    n = c->write_max;
+  if(c->out_len + n > c->out_size) {
+    c->out_size = (c->out_len + n) * 2;
+    c->out = realloc(c->out, c->out_size);
+  }
+  memcpy(&c->out[c->out_len], bp, n);
+  c->out_len += n;
+  return n;
+}
+
+event_source_t *chnGetEventSource(void *ip) {
+  return &((struct host_channel *)ip)->event;
+}
+
+/*
+ * The bridge waits. Deliver the next chunk of host input as a real USB
+ * endpoint would, or end the run once everything has been exchanged.
+ */
+bool host_idle(sysinterval_t timeout) {
+  wakeups++;
+  if(chan.in_arrived < chan.in_len) {
+    chan.in_arrived += chan.chunk;
+    if(chan.in_arrived > chan.in_len)
+      chan.in_arrived = chan.in_len;
+    chEvtBroadcastFlagsI(&chan.event, CHN_INPUT_AVAILABLE);
+    return true;
+  }
+  chThdTerminate(bridge);
+  return false;
+}
+
+static void random_frame(frame_t *f, size_t min, size_t max) {
+  f->len = min + rand() % (max - min + 1);
+  for(size_t i = 0; i < f->len; i++) {
+    /* Plenty of bytes which need escaping. */
+    switch(rand() % 8) {
+    case 0: f->data[i] = KISS_FEND; break;
+    case 1: f->data[i] = KISS_FESC; break;
+    default: f->data[i] = rand(); break;
+    }
+  }
+}
+
+static void kiss_encode(uint8_t cmd, const uint8_t *data, size_t len) {
+  size_t need = chan.in_len + 2 * len + 3;
+  chan.in = realloc(chan.in, need);
+  chan.in[chan.in_len++] = KISS_FEND;
+  chan.in[chan.in_len++] = cmd;
+  for(size_t i = 0; i < len; i++) {
+    if(data[i] == KISS_FEND) {
+      chan.in[chan.in_len++] = KISS_FESC;
+      chan.in[chan.in_len++] = KISS_TFEND;
+    } else if(data[i] == KISS_FESC) {
+      chan.in[chan.in_len++] = KISS_FESC;
+      chan.in[chan.in_len++] = KISS_TFESC;
+    } else {
+      chan.in[chan.in_len++] = data[i];
+    }
+  }
+  chan.in[chan.in_len++] = KISS_FEND;
+}
+
+/* Decode the host side output into frames. */
+static void kiss_decode(frame_list_t *list) {
+  frame_t *f = NULL;
+  bool escape = false;
+  list->count = 0;
+  for(size_t i = 0; i < chan.out_len; i++) {
+    uint8_t c = chan.out[i];
+    if(c == KISS_FEND) {
+      if(f != NULL && f->len > 0)
+        list->count++;
+      f = &list->frame[list->count];
+      f->len = 0;
+      escape = false;
+      continue;
+    }
+    if(f == NULL)
+      continue;
+    if(escape) {
+      c = c == KISS_TFEND ? KISS_FEND : c == KISS_TFESC ? KISS_FESC : c;
+      escape = false;
+    } else if(c == KISS_FESC) {
+      escape = true;
+      continue;
+    }
+    if(f->len == 0 && c != KISS_CMD_DATA) {
+      printf("kiss: bad command byte %02x\n", c);
+      failures++;
+    }
+    /* Command byte is not stored. */
+    if(f->len++ > 0)
+      f->data[f->len - 2] = c;
+  }
+  for(int i = 0; i < list->count; i++)
+    list->frame[i].len--;
+}
+
+static void compare(const char *what, const frame_list_t *a,
+                    const frame_list_t *b) {
+  if(a->count != b->count) {
+    printf("%s: %d frames sent, %d received\n", what, a->count, b->count);
+    failures++;
+    return;
+  }
+  for(int i = 0; i < a->count; i++) {
+    if(a->frame[i].len != b->frame[i].len
+        || memcmp(a->frame[i].data, b->frame[i].data, a->frame[i].len)) {
+      printf("%s: frame %d differs\n", what, i);
+      failures++;
+    }
+  }
+}
+
+static void reset_channel(size_t chunk, size_t write_max) {
+  free(chan.in);
+  free(chan.out);
+  memset(&chan, 0, sizeof(chan));
+  chan.chunk = chunk;
+  chan.write_max = write_max;
+  radio_rx.count = 0;
+  host_tx.count = 0;
+  radio_tx.count = 0;
+  wakeups = 0;
+}
+
+/* Frames in both directions with partial input reads and writes. */
+static void test_loopback(size_t chunk, size_t write_max) {
+  reset_channel(chunk, write_max);
+  bridge = kissStart(&chan);
+  if(bridge == NULL || !kissIsActive()) {
+    printf("loopback: bridge did not start\n");
+    failures++;
+    return;
+  }
+  for(int i = 0; i < 20; i++) {
+    frame_t *f = &radio_rx.frame[radio_rx.count++];
+    random_frame(f, AX25_MIN_PACKET_LEN, 120);
+    if(!kissSendFrame(f->data, f->len)) {
+      printf("loopback: frame %d not queued\n", i);
+      failures++;
+    }
+  }
+  for(int i = 0; i < 50; i++) {
+    frame_t *f = &host_tx.frame[host_tx.count++];
+    random_frame(f, AX25_MIN_PACKET_LEN, FRAME_MAX);
+    kiss_encode(KISS_CMD_DATA, f->data, f->len);
+  }
+  /* Rejected: parameter command, short frame and oversize frame. */
+  frame_t bad;
+  random_frame(&bad, 1, 1);
+  kiss_encode(0x01, bad.data, bad.len);
+  random_frame(&bad, 1, AX25_MIN_PACKET_LEN - 1);
+  kiss_encode(KISS_CMD_DATA, bad.data, bad.len);
+  uint8_t big[FRAME_MAX + 10];
+  memset(big, 'A', sizeof(big));
+  kiss_encode(KISS_CMD_DATA, big, sizeof(big));
+
+  host_run_thread(bridge);
+  kissStop(bridge);
+
+  frame_list_t got;
+  kiss_decode(&got);
+  compare("radio to host", &radio_rx, &got);
+  compare("host to radio", &host_tx, &radio_tx);
+
+  kiss_stats_t stats;
+  kissGetStats(&stats);
+  if(stats.rx_frames != (uint32_t)radio_rx.count || stats.rx_dropped != 0
+      || stats.rx_bytes != chan.out_len
+      || stats.tx_frames != (uint32_t)host_tx.count || stats.tx_errors != 2) {
+    printf("loopback: stats rx %u/%u/%u tx %u/%u\n", stats.rx_frames,
+           stats.rx_dropped, stats.rx_bytes, stats.tx_frames,
+           stats.tx_errors);
+    failures++;
+  }
+  /* One wait per input arrival plus the final one. No polling. */
+  size_t arrivals = (chan.in_len + chunk - 1) / chunk;
+  if(wakeups > arrivals + 1) {
+    printf("loopback: %u waits for %zu input arrivals\n", wakeups, arrivals);
+    failures++;
+  }
+  if(kissIsActive() || kissSendFrame(radio_rx.frame[0].data,
+                                     radio_rx.frame[0].len)) {
+    printf("loopback: frames accepted after stop\n");
+    failures++;
+  }
+}
+
+/* A full ring drops frames without blocking and drains completely. */
+static void test_ring_full(void) {
+  reset_channel(64, 64);
+  bridge = kissStart(&chan);
+  int dropped = 0;
+  for(int i = 0; i < MAX_FRAMES; i++) {
+    frame_t *f = &radio_rx.frame[radio_rx.count];
+    random_frame(f, 100, 300);
+    if(kissSendFrame(f->data, f->len))
+      radio_rx.count++;
+    else
+      dropped++;
+  }
+  host_run_thread(bridge);
+  kissStop(bridge);
+  frame_list_t got;
+  kiss_decode(&got);
+  compare("ring full", &radio_rx, &got);
+  kiss_stats_t stats;
+  kissGetStats(&stats);
+  if(dropped == 0 || stats.rx_dropped != (uint32_t)dropped) {
+    printf("ring full: %d dropped, %u counted\n", dropped, stats.rx_dropped);
+    failures++;
+  }
+}
+
+/* The host return command ends the bridge and signals the console. */
+static void test_return(void) {
+  reset_channel(3, 64);
+  event_listener_t el;
+  chEvtRegisterMask(&kiss_terminated, &el, EVENT_MASK(5));
+  bridge = kissStart(&chan);
+  uint8_t none = 0;
+  kiss_encode(KISS_CMD_RETURN, &none, 0);
+  host_run_thread(bridge);
+  if(bridge->terminate || !chThdTerminatedX(bridge) || kissIsActive()) {
+    printf("return: bridge did not exit on command\n");
+    failures++;
+  }
+  if(chEvtWaitAnyTimeout(EVENT_MASK(5), TIME_IMMEDIATE) != EVENT_MASK(5)) {
+    printf("return: termination not broadcast\n");
+    failures++;
+  }
+  chEvtUnregister(&kiss_terminated, &el);
+  chThdWait(bridge);
+}
+
+int main(void) {
+  srand(29);
+  test_loopback(64, 64);
+  test_loopback(1, 7);
+  test_loopback(512, 4096);
+  test_ring_full();
+  test_return();
+  printf("kiss: %d failures\n", failures);
+  return failures != 0;
+}
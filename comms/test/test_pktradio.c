@@ -0,0 +1,230 @@
+/*
+ * Radio manager transmit scheduler.
+ *
+ * The manager is built into the test so the scheduler can be called
+ * directly. Sends are recorded at the radio driver entry.
+ *
+ * Defaults: with no gather time and no duty limits every send goes when
+ * it is scheduled as it did before the scheduler. Built with
+ * TEST_PKT_DEFAULTS.
+ *
+ * Limits: with a gather time and an image duty limit configured here
+ * sends which differ only in squelch are not merged, a held burst only
+ * grows while its service has airtime for it and a send which finds the
+ * scheduler full goes only if it has airtime.
+ */
+#if !defined(TEST_PKT_DEFAULTS)
+#define PKT_TX_GATHER_MS        200
+#define PKT_TX_DUTY_IMAGE       10
+#endif
+#include "pktradio.c"
+#include "host.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const radio_config_t radio_list[] = {
+  {.unit = PKT_RADIO_NONE}
+};
+
+static packet_svc_t svc;
+static int failures;
+
+/* Radio driver side. */
+static int sent;                    /* Sends started.                   */
+static int sent_packets;            /* Packets in those sends.          */
+static int released;                /* Packets released unsent.         */
+static int returned;                /* Task objects returned.           */
+
+packet_svc_t *pktGetServiceObject(radio_unit_t radio) {
+  return &svc;
+}
+
+bool Si446x_blocSendAFSK(radio_task_object_t *rto) {
+  sent++;
+  for(packet_t pp = rto->packet_out; pp != NULL; ) {
+    packet_t np = pp->nextp;
+    sent_packets++;
+    free(pp);
+    pp = np;
+  }
+  free(rto);
+  return true;
+}
+
+/* Receive is not active in these tests. */
+bool Si446x_blocSend2FSK(radio_task_object_t *rto) {
+  return false;
+}
+
+bool Si4464_enableReceive(const radio_unit_t radio,
+                          const radio_freq_t rx_frequency,
+                          const channel_hz_t rx_step,
+                          const radio_ch_t rx_chan,
+                          const radio_squelch_t rx_rssi,
+                          const mod_t rx_mod) {
+  return false;
+}
+
+void pktStartDecoder(const radio_unit_t radio) {}
+void pktStopDecoder(const radio_unit_t radio) {}
+
+void pktReleaseBufferChain(packet_t pp) {
+  while(pp != NULL) {
+    packet_t np = pp->nextp;
+    released++;
+    free(pp);
+    pp = np;
+  }
+}
+
+objects_fifo_t *chFactoryGetObjectsFIFO(dyn_objects_fifo_t *dofp) {
+  return &dofp->fifo;
+}
+
+void chFifoReturnObject(objects_fifo_t *ofp, void *objp) {
+  returned++;
+  free(objp);
+}
+
+static void check(bool ok, const char *name, const char *what) {
+  if(!ok) {
+    printf("FAIL %s: %s\n", name, what);
+    failures++;
+  }
+}
+
+static void reset(void) {
+  static dyn_objects_fifo_t fifo;
+  memset(&svc, 0, sizeof(svc));
+  svc.state = PACKET_READY;
+  svc.the_radio_fifo = &fifo;
+  pktTransmitSchedulerInit(&svc);
+  sent = sent_packets = released = returned = 0;
+}
+
+/*
+ * Schedule a send of frames of len bytes at 1200 baud.
+ * A 256 byte frame is 2106 ms on air.
+ */
+static void schedule(pkt_tx_service_t service, int frames, uint16_t len,
+                     radio_squelch_t squelch) {
+  radio_task_object_t *rto = calloc(1, sizeof(radio_task_object_t));
+  rto->command = PKT_RADIO_TX_SEND;
+  rto->type = MOD_AFSK;
+  rto->base_frequency = 144800000;
+  rto->step_hz = 12500;
+  rto->tx_speed = 1200;
+  rto->squelch = squelch;
+  rto->tx_service = service;
+  packet_t *link = &rto->packet_out;
+  for(int i = 0; i < frames; i++) {
+    *link = calloc(1, sizeof(struct TXpacket));
+    (*link)->frame_len = len;
+    link = &(*link)->nextp;
+  }
+  /* The manager returns the task object if the scheduler does not. */
+  if(!pktScheduleTransmit(&svc, rto))
+    pktReturnRadioTask(&svc, rto);
+}
+
+#if defined(TEST_PKT_DEFAULTS)
+
+static void test_defaults(void) {
+  const char *name = "defaults";
+  reset();
+  for(int i = 0; i < 100; i++)
+    schedule(PKT_TX_SVC_IMAGE, 1, 256, 0x20);
+  schedule(PKT_TX_SVC_BEACON, 1, 60, 0x20);
+  pkt_tx_stats_t *image = &svc.tx_sched.stats[PKT_TX_SVC_IMAGE];
+  check(sent == 101 && sent_packets == 101, name, "sends held");
+  check(svc.tx_sched.count == 0, name, "scheduler not empty");
+  check(image->deferred == 0 && image->expired == 0
+        && image->rejected == 0, name, "image airtime limited");
+  check(released == 0 && returned == 0, name, "sends dropped");
+}
+
+#else
+
+static void test_squelch(void) {
+  const char *name = "squelch";
+  reset();
+  schedule(PKT_TX_SVC_OTHER, 1, 60, 0x20);
+  schedule(PKT_TX_SVC_OTHER, 1, 60, 0x40);
+  schedule(PKT_TX_SVC_OTHER, 1, 60, 0x20);
+  check(sent == 0 && svc.tx_sched.count == 2, name, "not held");
+  host_advance(TIME_MS2I(PKT_TX_GATHER_MS));
+  pktDispatchTransmit(&svc, false);
+  check(sent == 2 && sent_packets == 3, name, "wrong bursts");
+  check(svc.tx_sched.stats[PKT_TX_SVC_OTHER].merged == 1, name,
+        "wrong merge count");
+}
+
+static void test_merge_budget(void) {
+  const char *name = "merge budget";
+  reset();
+  /* The image budget is 6000 ms. Two sends fit and a third does not. */
+  for(int i = 0; i < 3; i++)
+    schedule(PKT_TX_SVC_IMAGE, 1, 256, 0);
+  check(svc.tx_sched.count == 2, name, "burst grew past the budget");
+  host_advance(TIME_MS2I(PKT_TX_GATHER_MS));
+  pktDispatchTransmit(&svc, false);
+  pkt_tx_stats_t *image = &svc.tx_sched.stats[PKT_TX_SVC_IMAGE];
+  check(sent == 1 && sent_packets == 2, name, "wrong burst");
+  check(image->airtime_ms == 2 * 2106, name, "wrong airtime");
+  check(image->deferred == 1 && svc.tx_sched.count == 1, name,
+        "third send not deferred");
+  check(svc.tx_sched.credit[PKT_TX_SVC_IMAGE] >= 0, name, "budget overrun");
+
+  /* The third send goes when its airtime is earned. */
+  host_advance(TIME_S2I(60));
+  pktDispatchTransmit(&svc, false);
+  check(sent == 2 && svc.tx_sched.count == 0, name, "third send not sent");
+}
+
+static void test_full(void) {
+  const char *name = "full";
+  reset();
+  /* Use the image budget then hold sends which cannot merge. */
+  schedule(PKT_TX_SVC_IMAGE, 2, 256, 0);
+  host_advance(TIME_MS2I(PKT_TX_GATHER_MS));
+  pktDispatchTransmit(&svc, false);
+  for(int i = 0; i < PKT_TX_SCHED_MAX; i++)
+    schedule(PKT_TX_SVC_IMAGE, 1, 256, 0);
+  host_advance(TIME_MS2I(PKT_TX_GATHER_MS));
+  pktDispatchTransmit(&svc, false);
+  check(sent == 1 && svc.tx_sched.count == PKT_TX_SCHED_MAX, name,
+        "sends not held");
+
+  /* No room and no airtime. */
+  schedule(PKT_TX_SVC_IMAGE, 1, 256, 0);
+  pkt_tx_stats_t *image = &svc.tx_sched.stats[PKT_TX_SVC_IMAGE];
+  check(sent == 1, name, "sent without airtime");
+  check(image->rejected == 1 && released == 1 && returned == 1, name,
+        "send not dropped");
+
+  /* No room but a service without a limit. */
+  schedule(PKT_TX_SVC_BEACON, 1, 60, 0);
+  check(sent == 2, name, "unlimited send held");
+  check(svc.tx_sched.stats[PKT_TX_SVC_BEACON].bursts == 1, name,
+        "unlimited send not counted");
+
+  /* Held sends are sent on close regardless of airtime. */
+  pktDispatchTransmit(&svc, true);
+  check(svc.tx_sched.count == 0 && sent_packets == 2 + 1 + 4, name,
+        "held sends not flushed");
+}
+
+#endif
+
+int main(void) {
+#if defined(TEST_PKT_DEFAULTS)
+  test_defaults();
+#else
+  test_squelch();
+  test_merge_budget();
+  test_full();
+#endif
+  printf("pktradio: %d failures\n", failures);
+  return failures != 0;
+}
@@ -0,0 +1,220 @@
+/*
+ * DC only preview of the image threads, through the packet store.
+ *
+ * Each reference JPEG in ssdv/ is encoded into the store as a preview at
+ * every quality, as image.c does ahead of each image. The stored packets
+ * must pass the packet check, carry the image size and ID, number from 0
+ * and end with the EOI flag. Decoded they must cover every MCU and give a
+ * JPEG whose scan is valid. Encoding that JPEG again as a preview must
+ * give the same packets, so the preview holds the DC coefficients and
+ * nothing else. A preview must be smaller than the full image.
+ *
+ * The image thread sequence is then run over 20 captures with a packet
+ * budget: preview, imgCtlReserve with its stored packet count, quality
+ * selection and the full image. The reservation must be the preview's
+ * packet count and the image quality must be predicted to fit in what the
+ * preview left of the budget. Captures where the preview and the image
+ * went over the budget are counted, with and without the reservation.
+ * The reservation must cut them to a quarter at most.
+ */
+#include "imgctl.h"
+#include "imgstore.h"
+#include "ov5640.h"
+#include "ssdv.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PREVIEW_ID      1
+#define IMAGE_ID        2
+#define MAX_PACKETS     512
+#define CAPTURES        20
+
+bool img_trace;
+
+typedef struct {
+  const char        *name;
+  uint8_t           *data;
+  size_t            size;
+} jpeg_t;
+
+static jpeg_t images[] = {
+  {.name = "ssdv/scene.jpg"},
+  {.name = "ssdv/scene_dri.jpg"},
+};
+
+static uint8_t packets[MAX_PACKETS][SSDV_PKT_SIZE];
+static uint8_t decoded[512 * 1024];
+static int failures;
+
+/* The reference JPEGs are all QVGA. */
+void OV5640_getResolutionSize(resolution_t res, uint16_t *width,
+                              uint16_t *height) {
+  *width = 320;
+  *height = 240;
+}
+
+static bool load(jpeg_t *img) {
+  FILE *fp = fopen(img->name, "rb");
+  if(fp == NULL)
+    return false;
+  fseek(fp, 0, SEEK_END);
+  img->size = ftell(fp);
+  rewind(fp);
+  img->data = malloc(img->size);
+  bool ok = fread(img->data, 1, img->size, fp) == img->size;
+  fclose(fp);
+  return ok;
+}
+
+static void check(bool ok, const char *name, uint8_t quality,
+                  const char *what) {
+  if(!ok) {
+    printf("FAIL %s quality %u: %s\n", name, quality, what);
+    failures++;
+  }
+}
+
+/* Copies the stored packets of an image, returns the count. */
+static uint16_t stored(uint8_t image_id) {
+  uint16_t count = imgStoreCount(image_id);
+  if(count > MAX_PACKETS)
+    return 0;
+  for(uint16_t i = 0; i < count; i++) {
+    if(!imgStoreGetPacket(image_id, i, packets[i]))
+      return 0;
+  }
+  return count;
+}
+
+/* Decodes the stored packets, returns the JPEG length or 0. */
+static size_t decode(const jpeg_t *img, uint8_t quality, uint16_t count) {
+  static ssdv_t s;
+  ssdv_packet_info_t info;
+  uint8_t *jpeg;
+  size_t length;
+  int errors;
+  ssdv_dec_init(&s);
+  ssdv_dec_set_buffer(&s, decoded, sizeof(decoded));
+  for(uint16_t i = 0; i < count; i++) {
+    if(ssdv_dec_is_packet(packets[i], &errors) != SSDV_OK) {
+      check(false, img->name, quality, "bad packet");
+      return 0;
+    }
+    ssdv_dec_header(&info, packets[i]);
+    check(info.image_id == PREVIEW_ID && info.packet_id == i
+          && info.width == 320 && info.height == 240
+          && info.quality == quality && info.eoi == (i == count - 1),
+          img->name, quality, "packet header");
+    if(ssdv_dec_feed(&s, packets[i]) == SSDV_ERROR) {
+      check(false, img->name, quality, "decode failed");
+      return 0;
+    }
+  }
+  check(s.mcu_id == s.mcu_count, img->name, quality, "MCUs missing");
+  ssdv_dec_get_jpeg(&s, &jpeg, &length);
+  return length;
+}
+
+static void test_preview(const jpeg_t *img, uint8_t quality) {
+  uint16_t full = imgStoreEncode(img->data, img->size, IMAGE_ID,
+                                 SSDV_TYPE_PADDING, quality, false);
+  uint16_t n = imgStoreEncode(img->data, img->size, PREVIEW_ID,
+                              SSDV_TYPE_PADDING, quality, true);
+  check(n > 0 && stored(PREVIEW_ID) == n, img->name, quality,
+        "preview not stored");
+  check(n < full, img->name, quality, "preview not smaller than image");
+  if(n == 0)
+    return;
+
+  static ssdv_t s;
+  size_t length = decode(img, quality, n), offset;
+  check(length > 0 && ssdv_jpeg_check(&s, decoded, length, 320, 240, 1,
+                                      &offset) == SSDV_OK,
+        img->name, quality, "decoded JPEG not valid");
+
+  /* Encode the decoded preview again and compare with the first. */
+  static uint8_t first[MAX_PACKETS][SSDV_PKT_SIZE];
+  memcpy(first, packets, n * SSDV_PKT_SIZE);
+  uint16_t again = imgStoreEncode(decoded, length, PREVIEW_ID,
+                                  SSDV_TYPE_PADDING, quality, true);
+  check(again == n && stored(PREVIEW_ID) == n
+        && memcmp(first, packets, n * SSDV_PKT_SIZE) == 0,
+        img->name, quality, "preview holds more than the DC coefficients");
+}
+
+typedef struct {
+  int               over;       /* Captures over budget.            */
+  uint16_t          preview;    /* Packets of the last preview.     */
+  uint16_t          full;       /* Packets of the last image.       */
+  uint8_t           quality;    /* Quality of the last image.       */
+} img_run_t;
+
+/* The image thread sequence with a packet budget, capture after capture. */
+static img_run_t run(const jpeg_t *img, uint16_t budget, uint8_t quality,
+                     bool reserve) {
+  img_ctl_t ctl;
+  img_run_t r = {0};
+  imgCtlInit(&ctl);
+  for(int k = 0; k < CAPTURES; k++) {
+    imgCtlStart(&ctl, budget, quality, RES_QVGA);
+    r.preview = imgStoreEncode(img->data, img->size, PREVIEW_ID,
+                               SSDV_TYPE_PADDING, quality, true);
+    if(reserve) {
+      imgCtlReserve(&ctl, imgStoreCount(PREVIEW_ID));
+      check(r.preview > 0 && ctl.reserved == r.preview, img->name, quality,
+            "preview not reserved");
+    }
+    r.quality = imgCtlSelect(&ctl, img->data, img->size);
+    if(reserve) {
+      check(r.quality == IMG_CTL_QUALITY_MIN
+            || ctl.predicted <= (budget - r.preview) * IMG_CTL_MARGIN,
+            img->name, quality, "quality chosen for the whole budget");
+    }
+    r.full = imgStoreEncode(img->data, img->size, IMAGE_ID,
+                            SSDV_TYPE_PADDING, r.quality, false);
+    imgCtlUpdate(&ctl, r.full);
+    r.over += r.preview + r.full > budget;
+  }
+  return r;
+}
+
+static int over, unreserved, runs;
+
+static void test_budget(const jpeg_t *img, uint16_t budget, uint8_t quality) {
+  img_run_t r = run(img, budget, quality, true);
+  img_run_t u = run(img, budget, quality, false);
+  printf("preview: %-18s budget %3u: preview %2u, image %3u at quality %u,"
+         " over %2d/%d | not reserved %2d/%d\n", img->name, budget,
+         r.preview, r.full, r.quality, r.over, CAPTURES, u.over, CAPTURES);
+  over += r.over;
+  unreserved += u.over;
+  runs++;
+}
+
+int main(void) {
+  img_trace = getenv("IMG_TRACE") != NULL;
+  for(size_t i = 0; i < sizeof(images) / sizeof(images[0]); i++) {
+    if(!load(&images[i])) {
+      printf("preview: cannot read %s\n", images[i].name);
+      return 1;
+    }
+  }
+  for(size_t i = 0; i < sizeof(images) / sizeof(images[0]); i++) {
+    for(uint8_t q = 0; q < 8; q++)
+      test_preview(&images[i], q);
+    test_budget(&images[i], 40, 5);
+    test_budget(&images[i], 60, 5);
+    test_budget(&images[i], 100, 7);
+    test_budget(&images[i], 200, 7);
+  }
+  printf("preview: over budget %d/%d, not reserved %d/%d\n", over,
+         runs * CAPTURES, unreserved, runs * CAPTURES);
+  if(over * 4 > unreserved) {
+    printf("FAIL budget: too many captures over budget\n");
+    failures++;
+  }
+  printf("preview: %d failures\n", failures);
+  return failures != 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * RS(255,223) codec against the reference codec in rs8_ref.c.
+ *
+ * Random codewords, with and without padding, are encoded by both codecs
+ * and by the in place encoder, then damaged with up to 39 symbol errors
+ * and up to 7 erasures. Parity, decoder results, corrected data and error
+ * positions must match the reference.
+ *
+ * Encode and decode speed of both codecs is printed in MB/s of data.
+ */
+#include "rs8.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NN              255
+#define NROOTS          32
+#define CODEWORDS       20000
+
+void ref_encode_rs_8(uint8_t *data, uint8_t *parity, int pad);
+int ref_decode_rs_8(uint8_t *data, int *eras_pos, int no_eras, int pad);
+
+static int failures;
+
+static void check(int ok, const char *what, int n) {
+  if(!ok) {
+    if(failures < 10)
+      printf("FAIL %s: codeword %d\n", what, n);
+    failures++;
+  }
+}
+
+static void test_fuzz(void) {
+  uint8_t ref[NN], a[NN], b[NN];
+  for(int n = 0; n < CODEWORDS; n++) {
+    int pad = (rand() % 3 == 0) ? rand() % (NN - NROOTS) : 0;
+    int len = NN - pad;
+    for(int i = 0; i < len - NROOTS; i++)
+      ref[i] = rand();
+    memcpy(a, ref, len);
+    memcpy(b, ref, len);
+    ref_encode_rs_8(ref, &ref[len - NROOTS], pad);
+    encode_rs_8(a, &a[len - NROOTS], pad);
+    encode_rs_8_block(b, pad);
+    check(memcmp(ref, a, len) == 0, "parity", n);
+    check(memcmp(ref, b, len) == 0, "in place parity", n);
+
+    /* Mostly correctable, sometimes past the 16 error limit. */
+    int errors = rand() % 21;
+    if(rand() % 4 == 0)
+      errors = rand() % 40;
+    for(int e = 0; e < errors; e++)
+      ref[rand() % len] ^= rand();
+    memcpy(a, ref, len);
+
+    /* Erasure positions may repeat. */
+    int ref_eras[NROOTS], eras[NROOTS], no_eras = 0;
+    if(rand() % 3 == 0) {
+      no_eras = rand() % 8;
+      for(int e = 0; e < no_eras; e++)
+        ref_eras[e] = eras[e] = pad + rand() % len;
+    }
+    int r1 = ref_decode_rs_8(ref, ref_eras, no_eras, pad);
+    int r2 = decode_rs_8(a, eras, no_eras, pad);
+    check(r1 == r2, "decode result", n);
+    check(memcmp(ref, a, len) == 0, "corrected data", n);
+    check(r1 <= 0 || memcmp(ref_eras, eras, r1 * sizeof(int)) == 0,
+          "error positions", n);
+  }
+}
+
+static double now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/* MB/s of data through the encoder and decoder. */
+static void benchmark(const char *name,
+                      void (*enc)(uint8_t *, uint8_t *, int),
+                      int (*dec)(uint8_t *, int *, int, int)) {
+  const int count = 20000, damaged = 2000;
+  const double data = NN - NROOTS;
+  uint8_t blk[NN], err[NN];
+  volatile int sink = 0;
+  for(int i = 0; i < NN - NROOTS; i++)
+    blk[i] = rand();
+
+  double t = now();
+  for(int i = 0; i < count; i++) {
+    blk[0] = i;
+    enc(blk, &blk[NN - NROOTS], 0);
+  }
+  double encode = count * data / (now() - t) / 1e6;
+
+  t = now();
+  for(int i = 0; i < count; i++)
+    sink += dec(blk, NULL, 0, 0);
+  double clean = count * data / (now() - t) / 1e6;
+
+  t = now();
+  for(int i = 0; i < damaged; i++) {
+    memcpy(err, blk, NN);
+    for(int k = 0; k < 16; k++)
+      err[(k * 37 + i) % NN] ^= 1 + k;
+    sink += dec(err, NULL, 0, 0);
+  }
+  double errors = damaged * data / (now() - t) / 1e6;
+  (void)sink;
+
+  printf("rs8: %-9s encode %5.1f, decode %5.1f, 16 errors %5.1f MB/s\n",
+         name, encode, clean, errors);
+}
+
+int main(void) {
+  srand(1);
+  test_fuzz();
+  benchmark("reference", ref_encode_rs_8, ref_decode_rs_8);
+  benchmark("rs8", encode_rs_8, decode_rs_8);
+  printf("rs8: %d failures\n", failures);
+  return failures != 0;
+}
@@ -0,0 +1,141 @@
+/*
+ * 2FSK channel bit recovery.
+ *
+ * Frames are encoded by the transmit HDLC iterator with G3RUH scrambling.
+ * The NRZI levels are timed into high and low runs as the PWM capture
+ * measures them, with a transmitter clock error and random edge jitter.
+ * Once the descrambler has filled the channel must deliver the unscrambled
+ * HDLC bit stream with no errors and no lost or added bits.
+ * Jitter up to a quarter bit on each edge keeps every run within half a
+ * bit of its length so it must decode.
+ */
+#include "pktconf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define FRAMES          40
+#define MAX_BITS        (ITERATOR_MAX_QTY * 8)
+
+/* The descrambler output is valid after it has seen this many bits. */
+#define SYNC_BITS       17
+
+static int failures;
+
+static AFSKDemodDriver driver;
+static uint8_t out[MAX_BITS];
+static size_t out_count;
+
+AFSKDemodDriver *pktCreateAFSKDecoder(packet_svc_t *pktHandler) {
+  return &driver;
+}
+
+bool pktExtractHDLCfrom2FSK(AFSKDemodDriver *myDriver, uint8_t bit) {
+  if(out_count == MAX_BITS)
+    return false;
+  out[out_count++] = bit;
+  return true;
+}
+
+/* Encode a frame into NRZI levels, one per bit. */
+static size_t encode(packet_t pp, bool scramble, uint8_t *level) {
+  static uint8_t stream[ITERATOR_MAX_QTY];
+  tx_iterator_t iterator;
+  pktStreamIteratorInit(&iterator, pp, 30, 10, 10, scramble);
+  uint16_t size = pktStreamEncodingIterator(&iterator, NULL, 0);
+  (void)pktStreamEncodingIterator(&iterator, stream, size);
+  for(size_t i = 0; i < size * 8u; i++)
+    level[i] = (stream[i >> 3] >> (i % 8)) & 1;
+  return size * 8u;
+}
+
+/*
+ * Decode one frame sent with a clock error (fraction of the bit period)
+ * and edge jitter (in bits). Returns the number of bit errors.
+ */
+static size_t decode(packet_t pp, double error, double jitter,
+                     size_t *lost) {
+  static uint8_t sent[MAX_BITS], plain[MAX_BITS];
+  size_t bits = encode(pp, true, sent);
+  (void)encode(pp, false, plain);
+
+  /* The capture starts with a high run. */
+  size_t start = 0;
+  while(start < bits && sent[start] == 0)
+    start++;
+
+  pktReset2FSKDecoder(&driver);
+  out_count = 0;
+  const double period = ICU_COUNT_FREQUENCY / (double)FSK_BAUD_RATE
+                        * (1.0 + error);
+  double last = start * period;
+  min_pwmcnt_t run[2];
+  int k = 0;
+  for(size_t i = start; i < bits;) {
+    size_t j = i;
+    while(j < bits && sent[j] == sent[i])
+      j++;
+    double edge = j * period;
+    if(j < bits)
+      edge += ((double)rand() / RAND_MAX * 2 - 1) * jitter * period;
+    run[k++] = (min_pwmcnt_t)lround(edge - last);
+    last = edge;
+    i = j;
+    if(k == 2) {
+      (void)pktProcess2FSK(&driver, run);
+      k = 0;
+    }
+  }
+
+  /* Only the last high run is not measured. */
+  size_t expect = bits - start;
+  size_t tail = 0;
+  while(tail < expect && sent[bits - 1 - tail] == 1)
+    tail++;
+  if(k == 0)
+    tail = 0;
+  expect -= tail;
+  *lost = (out_count > expect) ? out_count - expect : expect - out_count;
+
+  /*
+   * Unscrambled NRZI decode: no change of level is a 1.
+   * The last stream byte is padded after the tail so is not compared.
+   */
+  size_t errors = 0;
+  for(size_t n = SYNC_BITS; n < out_count && start + n < bits - 8; n++) {
+    size_t m = start + n;
+    uint8_t bit = (plain[m] == plain[m - 1]) ? 1 : 0;
+    errors += out[n] != bit;
+  }
+  return errors;
+}
+
+static void test_channel(double error, double jitter) {
+  static struct TXpacket packet;
+  size_t errors = 0, lost = 0, bits = 0;
+  for(int f = 0; f < FRAMES; f++) {
+    packet.frame_len = 16 + rand() % 240;
+    for(int i = 0; i < packet.frame_len; i++)
+      packet.frame_data[i] = rand();
+    size_t miss;
+    errors += decode(&packet, error, jitter, &miss);
+    lost += miss;
+    bits += out_count;
+  }
+  printf("fsk: clock %+.1f%% jitter %.2f bit: %zu bits, %zu errors,"
+         " %zu lost\n", error * 100, jitter, bits, errors, lost);
+  if(errors != 0 || lost != 0)
+    failures++;
+}
+
+int main(void) {
+  srand(1);
+  pktCreate2FSKDecoder(NULL);
+  test_channel(0, 0);
+  test_channel(0.005, 0.25);
+  test_channel(-0.005, 0.25);
+  test_channel(0.02, 0.1);
+  printf("rxfsk: %d failures\n", failures);
+  return failures != 0;
+}
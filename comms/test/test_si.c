@@ -0,0 +1,526 @@
+/*
+ * Si4464 driver in src/si.c.
+ *
+ * The driver is built into the test so the RX service thread can be run.
+ *
+ * The radio is simulated at the SPI command level. Its FIFOs move a few
+ * bytes each tick at the air data rate. The packet handler sends the length
+ * field and payload from the TX FIFO and puts received packets in the RX
+ * FIFO a byte at a time. As on the chip the FIFO threshold interrupts are
+ * latched as pending when the level crosses the threshold and stay pending
+ * until cleared, while the status shows the current level.
+ *
+ * Packets sent with si_tx() are looped back into si_rx() for lengths from
+ * empty to SI_MAX_PACKET_LEN. Neither FIFO may overflow or underflow. The
+ * RX service receives a run of packets into its ring. Packets beyond the
+ * ring are dropped and long payloads are truncated. Each packet keeps the
+ * RSSI latched at its own sync word even when the next packet follows at
+ * once. Short packets back to back must not make the service poll without
+ * sleeping. Threshold interrupts left pending from before a FIFO reset
+ * must not be taken for the new FIFO contents.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The driver uses the SPI driver state. */
+struct host_spi {
+  int               state;
+  uint8_t           cmd[32];
+  size_t            len;
+};
+
+#include "si.c"
+#include "host.h"
+
+static int failures;
+
+/*===========================================================================*/
+/* Radio simulator.                                                          */
+/*===========================================================================*/
+
+/* Air bytes per tick. 40 kbps with millisecond ticks. */
+#define SIM_RATE            5
+
+/* Largest packet on air: length field and payload. */
+#define SIM_PACKET_MAX      (SI_LEN_FIELD_SIZE + SI_MAX_PACKET_LEN)
+
+/* A packet arriving at the receiver after a gap of idle air bytes. */
+typedef struct {
+  const uint8_t     *data;
+  size_t            len;
+  size_t            gap;
+  uint8_t           rssi;
+} sim_packet_t;
+
+SPIDriver SPID6;
+
+static struct {
+  uint8_t           prop[0x10000];
+  uint8_t           tx[SI_FIFO_SIZE];
+  size_t            txn;
+  uint8_t           rx[SI_FIFO_SIZE];
+  size_t            rxn;
+  bool              txing;
+  bool              rxing;
+  bool              rearm;          /* RX again after a packet.        */
+  size_t            tx_need;        /* Bytes in the packet being sent. */
+  uint8_t           ph_pend;
+  uint8_t           ph_status;      /* FIFO levels at the last change. */
+  uint8_t           chip_pend;
+  uint8_t           latch_rssi;
+  uint8_t           resp[16];
+  uint8_t           air[SIM_PACKET_MAX];
+  size_t            airn;
+  const sim_packet_t *in;           /* Packets to receive.             */
+  size_t            in_count;
+  size_t            in_next;
+  size_t            in_pos;
+  size_t            in_gap;
+  bool              overflow;       /* Driver wrote a full TX FIFO.    */
+  bool              underflow;      /* Driver read an empty RX FIFO.   */
+  bool              rx_overflow;    /* Air filled the RX FIFO.         */
+  uint32_t          idle;           /* Ticks after the last packet.    */
+  uint32_t          stop_after;     /* Terminate the RX service then.  */
+  uint32_t          rate;           /* Air bytes per tick.             */
+  uint32_t          polls;          /* Status reads since the last tick. */
+  bool              spin;           /* Status polled without sleeping. */
+} sim;
+
+/* Status reads in one tick beyond which the driver is spinning. */
+#define SIM_SPIN_POLLS      1000
+
+static uint16_t sim_prop16(si_prop_t prop) {
+  return (sim.prop[prop] << 8) | sim.prop[prop + 1];
+}
+
+/* FIFO threshold status. A rising level is latched as pending. */
+static void sim_fifo_level(void) {
+  uint8_t status = 0;
+  if(SI_FIFO_SIZE - sim.txn >= sim.prop[SI_PKT_TX_THRESHOLD])
+    status |= SI_PH_TX_FIFO_ALMOST_EMPTY;
+  if(sim.rxn >= sim.prop[SI_PKT_RX_THRESHOLD])
+    status |= SI_PH_RX_FIFO_ALMOST_FULL;
+  sim.ph_pend |= status & ~sim.ph_status;
+  sim.ph_status = status;
+}
+
+/* One air byte in each direction. */
+static void sim_air_byte(void) {
+  if(sim.txing) {
+    if(sim.txn == 0) {
+      sim.chip_pend |= SI_CHIP_FIFO_ERROR;
+      sim.txing = false;
+      return;
+    }
+    sim.air[sim.airn++] = sim.tx[0];
+    memmove(sim.tx, &sim.tx[1], --sim.txn);
+    sim_fifo_level();
+    if(sim.airn == sim.tx_need) {
+      sim.txing = false;
+      sim.ph_pend |= SI_PH_PACKET_SENT;
+    }
+    return;
+  }
+  if(!sim.rxing || sim.in_next >= sim.in_count)
+    return;
+  const sim_packet_t *pkt = &sim.in[sim.in_next];
+  if(sim.in_gap > 0) {
+    sim.in_gap--;
+    return;
+  }
+  /* RSSI is latched at the sync word ahead of the length field. */
+  if(sim.in_pos == 0)
+    sim.latch_rssi = pkt->rssi;
+  if(sim.rxn == SI_FIFO_SIZE) {
+    sim.chip_pend |= SI_CHIP_FIFO_ERROR;
+    sim.rx_overflow = true;
+    sim.rxing = false;
+    return;
+  }
+  sim.rx[sim.rxn++] = pkt->data[sim.in_pos++];
+  sim_fifo_level();
+  if(sim.in_pos == pkt->len) {
+    sim.ph_pend |= SI_PH_PACKET_RX;
+    sim.rxing = sim.rearm;
+    sim.in_pos = 0;
+    if(++sim.in_next < sim.in_count)
+      sim.in_gap = sim.in[sim.in_next].gap;
+  }
+}
+
+void host_sleep(sysinterval_t time) {
+  for(sysinterval_t t = 0; t < time; t++) {
+    for(uint32_t i = 0; i < sim.rate; i++)
+      sim_air_byte();
+    host_advance(1);
+    sim.polls = 0;
+    if(sim.in_next == sim.in_count)
+      sim.idle++;
+  }
+  if(sim.stop_after != 0 && sim.idle >= sim.stop_after)
+    chThdTerminate(chThdGetSelfX());
+}
+
+/* Run a command when select is released. */
+static void sim_command(const uint8_t *cmd) {
+  memset(sim.resp, 0, sizeof(sim.resp));
+  switch(cmd[0]) {
+  case SI_CMD_SET_PROPERTY:
+    for(uint8_t i = 0; i < cmd[2] && i < 12; i++)
+      sim.prop[(cmd[1] << 8) + cmd[3] + i] = cmd[4 + i];
+    break;
+
+  case SI_CMD_GET_PROPERTY:
+    for(uint8_t i = 0; i < cmd[2] && i < 12; i++)
+      sim.resp[i] = sim.prop[(cmd[1] << 8) + cmd[3] + i];
+    break;
+
+  case SI_CMD_PART_INFO:
+    sim.resp[1] = 0x44;
+    sim.resp[2] = 0x64;
+    break;
+
+  case SI_CMD_FIFO_INFO:
+    if(cmd[1] & 0x01)
+      sim.txn = 0;
+    if(cmd[1] & 0x02)
+      sim.rxn = 0;
+    sim_fifo_level();
+    sim.resp[0] = sim.rxn;
+    sim.resp[1] = SI_FIFO_SIZE - sim.txn;
+    break;
+
+  case SI_CMD_START_TX:
+    sim.txing = true;
+    sim.airn = 0;
+    sim.tx_need = SI_LEN_FIELD_SIZE
+        + (sim_prop16(SI_PKT_FIELD_2_LENGTH) & SI_MAX_PACKET_LEN);
+    break;
+
+  case SI_CMD_START_RX:
+    sim.rxing = true;
+    sim.rearm = cmd[6] == 0x08;
+    break;
+
+  case SI_CMD_CHANGE_STATE:
+    sim.txing = false;
+    sim.rxing = false;
+    break;
+
+  /*
+   * Pending flags are reported then those with a zero in the clear
+   * argument are cleared. Status shows the FIFO levels.
+   */
+  case SI_CMD_GET_INT_STATUS: {
+    /* A spinning service is stopped as time would never pass. */
+    if(++sim.polls > SIM_SPIN_POLLS) {
+      sim.spin = true;
+      chThdTerminate(chThdGetSelfX());
+    }
+    sim_fifo_level();
+    sim.resp[2] = sim.ph_pend;
+    sim.resp[3] = sim.ph_status;
+    sim.resp[6] = sim.chip_pend;
+    sim.ph_pend &= cmd[1];
+    sim.chip_pend &= cmd[3];
+    break;
+  }
+
+  case SI_CMD_GET_MODEM_STATUS:
+    sim.resp[3] = sim.latch_rssi;
+    break;
+
+  default:
+    break;
+  }
+}
+
+void spiStart(SPIDriver *spip, const SPIConfig *config) {
+  spip->state = SPI_READY;
+}
+
+void spiStop(SPIDriver *spip) {
+}
+
+void spiAcquireBus(SPIDriver *spip) {
+}
+
+void spiReleaseBus(SPIDriver *spip) {
+}
+
+void spiSelect(SPIDriver *spip) {
+  spip->len = 0;
+}
+
+void spiUnselect(SPIDriver *spip) {
+  if(spip->len == 0)
+    return;
+  switch(spip->cmd[0]) {
+  case SI_CMD_READ_CMD_BUFF:
+  case SI_CMD_WRITE_TX_FIFO:
+  case SI_CMD_READ_RX_FIFO:
+    return;
+  }
+  sim_command(spip->cmd);
+}
+
+void spiSend(SPIDriver *spip, size_t n, const void *txbuf) {
+  const uint8_t *tx = txbuf;
+  for(size_t i = 0; i < n; i++) {
+    if(spip->len > 0 && spip->cmd[0] == SI_CMD_WRITE_TX_FIFO) {
+      if(sim.txn == SI_FIFO_SIZE)
+        sim.overflow = true;
+      else
+        sim.tx[sim.txn++] = tx[i];
+      sim_fifo_level();
+      continue;
+    }
+    if(spip->len < sizeof(spip->cmd))
+      spip->cmd[spip->len++] = tx[i];
+  }
+}
+
+void spiReceive(SPIDriver *spip, size_t n, void *rxbuf) {
+  uint8_t *rx = rxbuf;
+  for(size_t i = 0; i < n; i++) {
+    if(sim.rxn == 0) {
+      sim.underflow = true;
+      rx[i] = 0;
+      continue;
+    }
+    rx[i] = sim.rx[0];
+    memmove(sim.rx, &sim.rx[1], --sim.rxn);
+    sim_fifo_level();
+  }
+}
+
+/*
+ * READ_CMD_BUFF. Commands complete at once so CTS is always ready.
+ * src/si.c polls CTS in the byte clocked out with the command byte so the
+ * simulated radio returns CTS there as well as in the next byte.
+ */
+void spiExchange(SPIDriver *spip, size_t n, const void *txbuf, void *rxbuf) {
+  uint8_t *rx = rxbuf;
+  if(spip->len == 0)
+    spip->cmd[spip->len++] = *(const uint8_t *)txbuf;
+  for(size_t i = 0; i < n; i++)
+    rx[i] = (i < 2) ? 0xFF : sim.resp[(i - 2) % sizeof(sim.resp)];
+}
+
+static void sim_reset(void) {
+  memset(&sim, 0, sizeof(sim));
+  sim.rate = SIM_RATE;
+  SPID6.state = 0;
+}
+
+/*===========================================================================*/
+/* Loopback.                                                                 */
+/*===========================================================================*/
+
+static void test_loopback(void) {
+  static const size_t lens[] = {0, 1, 10, 46, 62, 63, 64, 100, 255, 1000,
+                                4096, SI_MAX_PACKET_LEN};
+  static uint8_t buf[SI_MAX_PACKET_LEN], out[SI_MAX_PACKET_LEN];
+  static uint8_t air[SIM_PACKET_MAX];
+
+  sim_reset();
+  if(si_init() != SI_ERR_SUCCESS) {
+    printf("si: init failed\n");
+    failures++;
+  }
+
+  for(size_t k = 0; k < sizeof(lens) / sizeof(lens[0]); k++) {
+    size_t len = lens[k];
+    for(size_t i = 0; i < len; i++)
+      buf[i] = rand();
+
+    si_err_t err = si_tx(buf, len);
+    if(err != SI_ERR_SUCCESS || sim.overflow
+       || sim.airn != SI_LEN_FIELD_SIZE + len
+       || sim.air[0] != (len >> 8) || sim.air[1] != (len & 0xFF)
+       || memcmp(&sim.air[SI_LEN_FIELD_SIZE], buf, len) != 0) {
+      printf("si: tx length %zu error %x\n", len, err);
+      failures++;
+      sim.overflow = false;
+      continue;
+    }
+
+    /* Loop the packet on air back into RX. */
+    memcpy(air, sim.air, sim.airn);
+    sim_packet_t pkt = {air, sim.airn, 0, 0};
+    sim.in = &pkt;
+    sim.in_count = 1;
+    sim.in_next = 0;
+    uint16_t got = 0;
+    err = si_rx(out, SI_MAX_PACKET_LEN, &got);
+    if(err != SI_ERR_SUCCESS || sim.underflow || got != len
+       || memcmp(out, buf, len) != 0) {
+      printf("si: rx length %zu error %x got %u\n", len, err, got);
+      failures++;
+      sim.underflow = false;
+    }
+  }
+
+  /* A payload longer than the buffer is truncated and flagged. */
+  sim_packet_t pkt = {air, SI_LEN_FIELD_SIZE + SI_MAX_PACKET_LEN, 0, 0};
+  sim.in = &pkt;
+  sim.in_count = 1;
+  sim.in_next = 0;
+  uint16_t got = 0;
+  si_err_t err = si_rx(out, 100, &got);
+  if(err == SI_ERR_SUCCESS || sim.underflow || got != 100
+     || memcmp(out, &air[SI_LEN_FIELD_SIZE], 100) != 0) {
+    printf("si: truncated rx error %x got %u\n", err, got);
+    failures++;
+  }
+}
+
+/*
+ * A previous packet leaves both FIFO threshold interrupts pending.
+ * TX must not take the pend as room after its preload and RX must not take
+ * it as data after the FIFO reset.
+ */
+static void test_stale_pend(void) {
+  static const size_t lens[] = {10, 100, 1000};
+  static uint8_t buf[1000], out[1000];
+  static uint8_t air[SIM_PACKET_MAX];
+  const uint8_t stale = SI_PH_TX_FIFO_ALMOST_EMPTY | SI_PH_RX_FIFO_ALMOST_FULL;
+
+  sim_reset();
+  (void)si_init();
+  for(size_t k = 0; k < sizeof(lens) / sizeof(lens[0]); k++) {
+    size_t len = lens[k];
+    for(size_t i = 0; i < len; i++)
+      buf[i] = rand();
+
+    sim.ph_pend |= stale;
+    si_err_t err = si_tx(buf, len);
+    if(err != SI_ERR_SUCCESS || sim.overflow
+       || sim.airn != SI_LEN_FIELD_SIZE + len
+       || memcmp(&sim.air[SI_LEN_FIELD_SIZE], buf, len) != 0) {
+      printf("si: stale pend tx length %zu error %x%s\n", len, err,
+             sim.overflow ? " overflow" : "");
+      failures++;
+      sim.overflow = false;
+      continue;
+    }
+
+    memcpy(air, sim.air, sim.airn);
+    sim_packet_t pkt = {air, sim.airn, SI_FIFO_SIZE, 0};
+    sim.in = &pkt;
+    sim.in_count = 1;
+    sim.in_next = 0;
+    sim.in_gap = pkt.gap;
+    sim.ph_pend |= stale;
+    uint16_t got = 0;
+    err = si_rx(out, sizeof(out), &got);
+    if(err != SI_ERR_SUCCESS || sim.underflow || got != len
+       || memcmp(out, buf, len) != 0) {
+      printf("si: stale pend rx length %zu error %x got %u%s\n", len, err,
+             got, sim.underflow ? " underflow" : "");
+      failures++;
+      sim.underflow = false;
+    }
+  }
+}
+
+/*===========================================================================*/
+/* RX service.                                                               */
+/*===========================================================================*/
+
+#define RUN_PACKETS         12
+
+/*
+ * Receive a run of packets with the service and check the ring.
+ * The ring is not read until the run ends so packets after it fills are
+ * dropped. Packets must arrive in order. Those left in the FIFO with no
+ * PACKET_RX to follow may stay there.
+ *
+ * @return  number of packets received.
+ */
+static size_t check_service(size_t base, size_t spread, size_t gap,
+                            uint32_t rate, bool rssi, const char *name) {
+  static uint8_t data[RUN_PACKETS][SI_LEN_FIELD_SIZE + 400];
+  static sim_packet_t run[RUN_PACKETS];
+
+  for(size_t k = 0; k < RUN_PACKETS; k++) {
+    size_t len = base + (k * 97) % spread;
+    data[k][0] = len >> 8;
+    data[k][1] = len & 0xFF;
+    for(size_t i = 0; i < len; i++)
+      data[k][SI_LEN_FIELD_SIZE + i] = rand();
+    run[k] = (sim_packet_t){data[k], SI_LEN_FIELD_SIZE + len, gap, 0x40 + k};
+  }
+
+  sim_reset();
+  (void)si_init();
+  sim.in = run;
+  sim.in_count = RUN_PACKETS;
+  sim.in_gap = gap;
+  sim.rate = rate;
+  sim.stop_after = 20;
+  if(si_rx_start() != SI_ERR_SUCCESS) {
+    printf("si: %s service did not start\n", name);
+    failures++;
+    return 0;
+  }
+  host_run_thread(si_rx_thd);
+  si_rx_stop();
+
+  size_t n = 0;
+  si_rx_packet_t pkt;
+  while(si_rx_get(&pkt)) {
+    size_t len = run[n].len - SI_LEN_FIELD_SIZE;
+    size_t keep = len > SI_RX_PACKET_SIZE ? SI_RX_PACKET_SIZE : len;
+    if(pkt.len != keep || pkt.truncated != (len > SI_RX_PACKET_SIZE)
+       || memcmp(pkt.data, &run[n].data[SI_LEN_FIELD_SIZE], keep) != 0) {
+      printf("si: %s packet %zu length %u of %zu\n", name, n, pkt.len, len);
+      failures++;
+    }
+    if(rssi && pkt.rssi != run[n].rssi) {
+      printf("si: %s packet %zu RSSI %02x of %02x\n",
+             name, n, pkt.rssi, run[n].rssi);
+      failures++;
+    }
+    n++;
+  }
+  if(sim.spin || sim.underflow || sim.rx_overflow || n > SI_RX_RING_SIZE) {
+    printf("si: %s received %zu%s\n", name, n, sim.spin ? " spinning" : "");
+    failures++;
+  }
+  return n;
+}
+
+static void test_service(void) {
+  /* Packets well apart. All arrive until the ring is full. */
+  size_t n = check_service(0, 350, SI_FIFO_SIZE, SIM_RATE, true, "spaced");
+  if(n != SI_RX_RING_SIZE || si_rx_dropped() != RUN_PACKETS - n) {
+    printf("si: spaced received %zu dropped %u\n", n, si_rx_dropped());
+    failures++;
+  }
+
+  /* Long packets back to back. The next sync follows the packet end. */
+  n = check_service(100, 250, 0, SIM_RATE, true,
+                    "back to back");
+  if(n != SI_RX_RING_SIZE) {
+    printf("si: back to back received %zu\n", n);
+    failures++;
+  }
+
+  /*
+   * Short packets back to back faster than the service polls share one
+   * PACKET_RX and leave the FIFO almost full after a packet is drained.
+   */
+  (void)check_service(2, 6, 0, 4 * SIM_RATE, false, "short");
+}
+
+int main(void) {
+  srand(1);
+  test_loopback();
+  test_stale_pend();
+  test_service();
+  printf("si: %d failures\n", failures);
+  return failures != 0;
+}
@@ -0,0 +1,947 @@
+/*
+ * Si446x driver.
+ *
+ * The driver is built into the test so its local functions can be called.
+ *
+ * AFSK up-sampler: the table driven up-sampler is compared with a per
+ * sample tone generator for every symbol and start phase and for all 16 bit
+ * NRZI sequences. It is also compared with the previous per sample phase
+ * accumulator. That accumulator used truncated phase steps so its tones ran
+ * slightly low and its phase slipped behind the exact tone over a frame.
+ * Its output must differ only where that slip moves a sample across a tone
+ * edge.
+ *
+ * AFSK transmit length: the length is counted from the frame before
+ * encoding. It must equal the length of the encoding so no idle padding is
+ * sent, and the feeder must send exactly the encoding.
+ *
+ * NIRQ: the radio is simulated at the SPI command level with the MCU lines
+ * it drives. Borrowing NIRQ for CCA measurement or the TX FIFO interrupt
+ * must leave the line callback and its edge events as receive had them.
+ *
+ * TX FIFO refill: the simulated FIFO drains at the line rate of AFSK at
+ * 1200 baud and 2FSK at 9600 baud. The feeder loop is run on the almost
+ * empty interrupt at the configured threshold with each refill delayed by
+ * a random scheduling latency. The FIFO must never run empty.
+ *
+ * Properties: the modem and band setup is run through the simulated radio
+ * which applies SET_PROPERTY commands to its property space. After each
+ * step the properties must equal those left by the per property writes in
+ * si446x_ref.c. Commands must hold 1 to 12 values within one group and a
+ * repeated step must send none.
+ *
+ * CTS: with GPIO0 outputting CTS commands wait for its edge and do not
+ * sleep, including commands which outlast the first wait.
+ *
+ * 2FSK RX clock recovery: the values computed for a data rate must be the
+ * calculator's AFSK values at 1200 baud.
+ */
+#include "si446x.c"
+#include "host.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int failures;
+
+/*===========================================================================*/
+/* AFSK up-sampler.                                                          */
+/*===========================================================================*/
+
+/*
+ * Exact tone reference. Phase is in 1/PLAYBACK_RATE of a cycle so both
+ * tones advance a whole number of units per sample.
+ * High for phase in (PI, 2PI] as the driver.
+ */
+typedef struct {
+  uint32_t          phase;
+} exact_tone_t;
+
+static uint8_t exact_sample(exact_tone_t *tone, uint8_t bit) {
+  tone->phase = (tone->phase + (bit ? 1200 : 2200)) % PLAYBACK_RATE;
+  return tone->phase == 0 || tone->phase > PLAYBACK_RATE / 2;
+}
+
+/*
+ * The previous up-sampler. Phase steps were truncated to 11915 and 21845
+ * of a 2^17 cycle. The exact phase is tracked alongside in units 66 times
+ * finer so the slip is known exactly.
+ */
+#define OLD_CYCLE           (1UL << 17)
+#define OLD_DELTA_1200      (((2 * 1200) << 16) / PLAYBACK_RATE)
+#define OLD_DELTA_2200      (((2 * 2200) << 16) / PLAYBACK_RATE)
+#define FINE                66
+
+typedef struct {
+  uint64_t          old;            /* Previous accumulator, unwrapped. */
+  uint64_t          exact;          /* Exact phase in FINE units.        */
+} old_tone_t;
+
+static uint8_t old_sample(old_tone_t *tone, uint8_t bit) {
+  tone->old += bit ? OLD_DELTA_1200 : OLD_DELTA_2200;
+  tone->exact += (uint64_t)OLD_CYCLE * FINE * (bit ? 1200 : 2200)
+                  / PLAYBACK_RATE;
+  return (tone->old >> 16) & 1;
+}
+
+/*
+ * True if a tone edge (a multiple of half a cycle) lies between the
+ * previous accumulator phase and the exact phase.
+ */
+static bool old_near_edge(const old_tone_t *tone) {
+  uint64_t half = (OLD_CYCLE / 2) * FINE;
+  uint64_t lo = tone->old * FINE;
+  return tone->exact / half >= (lo + half - 1) / half;
+}
+
+/*
+ * Run the up-sampler over NRZI data starting at a phase.
+ * The ring is topped up just ahead of the bits being consumed.
+ */
+static void upsample(const uint8_t *nrzi, size_t len, uint8_t phase,
+                     uint8_t *out, size_t out_len) {
+  up_sampler_t upsampler = {0};
+  upsampler.phase = phase;
+  Si446x_initUpsampler();
+  size_t loaded = 0;
+  for(size_t i = 0; i < out_len; i++) {
+    while(loaded < len && loaded <= (upsampler.packet_pos >> 3) + 2) {
+      upsampler.ring[loaded & AFSK_NRZI_RING_MASK] = nrzi[loaded];
+      loaded++;
+    }
+    out[i] = Si446x_getUpsampledNRZIbits(&upsampler);
+  }
+}
+
+static uint8_t nrzi_bit(const uint8_t *nrzi, size_t n) {
+  return (nrzi[n >> 3] >> (n & 7)) & 1;
+}
+
+static uint8_t out_bit(const uint8_t *out, size_t n) {
+  return (out[n >> 3] >> (n & 7)) & 1;
+}
+
+/*
+ * Compare a frame with the exact tone from a start phase.
+ */
+static bool check_exact(const uint8_t *nrzi, size_t len, uint8_t phase) {
+  size_t samples = len * 8 * SAMPLES_PER_BAUD;
+  uint8_t *out = malloc(samples / 8);
+  upsample(nrzi, len, phase, out, samples / 8);
+  exact_tone_t tone = {phase * (PLAYBACK_RATE / PHASE_STEPS)};
+  bool ok = true;
+  for(size_t n = 0; n < samples && ok; n++) {
+    if(out_bit(out, n) != exact_sample(&tone, nrzi_bit(nrzi, n / SAMPLES_PER_BAUD)))
+      ok = false;
+  }
+  free(out);
+  return ok;
+}
+
+static void test_upsampler_exact(void) {
+  uint8_t nrzi[256];
+
+  /* Every symbol from every phase. */
+  for(uint8_t phase = 0; phase < PHASE_STEPS; phase++) {
+    for(uint8_t bit = 0; bit < 2; bit++) {
+      memset(nrzi, bit ? 0xFF : 0x00, 2);
+      if(!check_exact(nrzi, 2, phase)) {
+        printf("upsampler: symbol %d from phase %d differs\n", bit, phase);
+        failures++;
+      }
+    }
+  }
+
+  /* Every 16 bit NRZI sequence. */
+  for(uint32_t seq = 0; seq < 0x10000; seq++) {
+    nrzi[0] = seq;
+    nrzi[1] = seq >> 8;
+    if(!check_exact(nrzi, 2, 0)) {
+      printf("upsampler: sequence %04x differs\n", seq);
+      failures++;
+    }
+  }
+
+  /* Long frames run through the ring many times. */
+  for(int frame = 0; frame < 200; frame++) {
+    for(size_t i = 0; i < sizeof(nrzi); i++)
+      nrzi[i] = rand();
+    if(!check_exact(nrzi, sizeof(nrzi), 0)) {
+      printf("upsampler: frame %d differs\n", frame);
+      failures++;
+    }
+  }
+}
+
+static void test_upsampler_old(void) {
+  /* Longest AFSK transmission: a full frame with stuffing and flags. */
+  static uint8_t nrzi[AX25_MAX_PACKET_LEN * 6 / 5 + 64];
+  size_t samples = sizeof(nrzi) * 8 * SAMPLES_PER_BAUD;
+  uint8_t *out = malloc(samples / 8);
+  uint64_t differ = 0;
+  uint64_t slip_max = 0;
+  size_t first = samples;
+
+  for(int frame = 0; frame < 50; frame++) {
+    for(size_t i = 0; i < sizeof(nrzi); i++)
+      nrzi[i] = rand();
+    upsample(nrzi, sizeof(nrzi), 0, out, samples / 8);
+    old_tone_t tone = {0, 0};
+    for(size_t n = 0; n < samples; n++) {
+      uint8_t bit = nrzi_bit(nrzi, n / SAMPLES_PER_BAUD);
+      if(out_bit(out, n) != old_sample(&tone, bit)) {
+        differ++;
+        if(n < first)
+          first = n;
+        if(!old_near_edge(&tone)) {
+          printf("upsampler: frame %d sample %zu differs away from an edge\n",
+                 frame, n);
+          failures++;
+          break;
+        }
+      }
+      uint64_t slip = tone.exact - tone.old * FINE;
+      if(slip > slip_max)
+        slip_max = slip;
+    }
+  }
+  free(out);
+  printf("upsampler: old accumulator slip %.4f cycle over %zu samples,"
+         " %llu samples differ, first at %zu\n",
+         (double)slip_max / (OLD_CYCLE * FINE), samples,
+         (unsigned long long)differ, first);
+}
+
+/*
+ * Check one frame against the counted length and the feeder output.
+ */
+static bool check_length(packet_t pp, uint16_t *pad) {
+  static uint8_t linear[ITERATOR_MAX_QTY];
+  static uint8_t fed[ITERATOR_MAX_QTY], ref[ITERATOR_MAX_QTY];
+  tx_iterator_t iterator;
+
+  pktStreamIteratorInit(&iterator, pp, 30, 10, 10, false);
+  uint16_t length = pktStreamEncodingLength(&iterator);
+  uint16_t exact = pktStreamEncodingIterator(&iterator, NULL, 0);
+  if(exact > length)
+    return false;
+  *pad = length - exact;
+
+  /* Reference: the whole encoding. */
+  memset(linear, 0, length);
+  tx_iterator_t whole = iterator;
+  (void)pktStreamEncodingIterator(&whole, linear, exact);
+  size_t all = length * SAMPLES_PER_BAUD;
+  upsample(linear, length, 0, ref, all);
+
+  /* Feeder: ring topped up from the iterator between FIFO loads. */
+  up_sampler_t upsampler = {0};
+  Si446x_initUpsampler();
+  for(size_t c = 0; c < all;) {
+    size_t more = 1 + rand() % Si446x_FIFO_COMBINED_SIZE;
+    if(more > all - c)
+      more = all - c;
+    Si446x_fillUpsampler(&upsampler, &iterator);
+    for(size_t i = 0; i < more; i++)
+      fed[c++] = Si446x_getUpsampledNRZIbits(&upsampler);
+  }
+  return memcmp(fed, ref, all) == 0;
+}
+
+static void test_transmit_length(void) {
+  static struct TXpacket packet;
+  uint32_t frames = 0, pad_total = 0;
+  uint16_t pad = 0;
+
+  for(uint16_t len = 1; len <= AX25_MAX_PACKET_LEN; len++) {
+    for(int pattern = 0; pattern < 4; pattern++) {
+      for(uint16_t i = 0; i < len; i++)
+        packet.frame_data[i] = (pattern == 0) ? rand()
+                               : (pattern == 1) ? 0xFF
+                               : (pattern == 2) ? 0x00 : 0x3E;
+      packet.frame_len = len;
+      if(!check_length(&packet, &pad)) {
+        printf("length: length %d pattern %d fails\n", len, pattern);
+        failures++;
+      }
+      if(pad != 0) {
+        printf("length: length %d pattern %d padded %u bytes\n",
+               len, pattern, pad);
+        failures++;
+      }
+      frames++;
+      pad_total += pad;
+    }
+  }
+  printf("length: %u frames, %u bytes of idle padding\n", frames, pad_total);
+}
+
+/*===========================================================================*/
+/* Radio simulator.                                                          */
+/*===========================================================================*/
+
+/*
+ * Commands complete a set time after they are sent. Until then CTS is low
+ * in READ_CMD_BUFF and on GPIO0 when it is configured for CTS.
+ * Line events are delivered to the callbacks the driver has enabled.
+ */
+#define SIM_GPIO0           1
+#define SIM_GPIO1           2
+#define SIM_NIRQ            3
+#define SIM_SDN             4
+#define SIM_CS              5
+#define SIM_LINES           8
+
+typedef struct {
+  uint8_t           level;
+  uint32_t          mode;
+  palevent_t        event;
+} sim_line_t;
+
+struct host_spi {
+  uint8_t           cmd[32];
+  size_t            len;
+};
+
+static struct {
+  sim_line_t        lines[SIM_LINES];
+  systime_t         ready;          /* Time the last command completes. */
+  sysinterval_t     busy;           /* Time each command takes.         */
+  uint8_t           gpio0;          /* GPIO0 mode from GPIO_PIN_CFG.    */
+  uint8_t           response[16];
+  uint8_t           last[32];       /* Last command other than polls.   */
+  uint32_t          commands;
+  uint32_t          polls;
+  uint32_t          sleeps;
+  rtcnt_t           rt;             /* Cycle counter in microseconds.   */
+  uint32_t          cca_period;     /* CCA square wave on NIRQ in us.   */
+  uint32_t          cca_high;
+  uint8_t           nirq;           /* NIRQ mode from GPIO_PIN_CFG.     */
+  uint32_t          byte_us;        /* TX FIFO byte time, 0 for none.   */
+  bool              tx;             /* START_TX sent.                   */
+  rtcnt_t           tx_start;
+  uint32_t          tx_all;         /* Bytes to be sent.                */
+  uint32_t          tx_written;     /* Bytes written to the TX FIFO.    */
+  uint8_t           tx_free;        /* Free count at the last update.   */
+  bool              tx_pend;        /* TX_FIFO_ALMOST_EMPTY pending.    */
+  bool              underrun;
+  uint8_t           props[0x10000]; /* Property space by group, index.  */
+  uint32_t          set_props;      /* SET_PROPERTY commands.           */
+  bool              bad_props;      /* A SET_PROPERTY out of limits.    */
+} sim;
+
+static SPIDriver sim_spi;
+static ICUDriver sim_icu;
+static si446x_mcucfg_t sim_cfg = {
+  .gpio0 = SIM_GPIO0,
+  .gpio1 = SIM_GPIO1,
+  .nirq = SIM_NIRQ,
+  .sdn = SIM_SDN,
+  .cs = SIM_CS,
+  .spi = &sim_spi,
+  .icu = &sim_icu
+};
+static si446x_data_t sim_dat;
+static radio_config_t sim_radio = {
+  .unit = 1,
+  .cfg = &sim_cfg,
+  .dat = &sim_dat
+};
+static packet_svc_t sim_svc;
+
+const radio_config_t *pktGetRadioData(radio_unit_t radio) {
+  return &sim_radio;
+}
+
+packet_svc_t *pktGetServiceObject(radio_unit_t radio) {
+  return &sim_svc;
+}
+
+static bool sim_cts(void) {
+  return (int32_t)(chVTGetSystemTimeX() - sim.ready) >= 0;
+}
+
+/* Drive a line from the radio side and deliver an enabled edge event. */
+static void sim_drive(ioline_t line, uint8_t level) {
+  sim_line_t *lp = &sim.lines[line];
+  if(lp->level == level)
+    return;
+  lp->level = level;
+  uint32_t edge = level ? PAL_EVENT_MODE_RISING_EDGE
+                        : PAL_EVENT_MODE_FALLING_EDGE;
+  if((lp->mode & edge) != 0 && lp->event.cb != NULL)
+    lp->event.cb(lp->event.arg);
+}
+
+/* Bytes the transmitter has taken from the TX FIFO. */
+static uint32_t sim_tx_sent(void) {
+  if(!sim.tx)
+    return 0;
+  uint32_t sent = (sim.rt - sim.tx_start) / sim.byte_us;
+  return (sent < sim.tx_written) ? sent : sim.tx_written;
+}
+
+/*
+ * The FIFO runs empty if the next byte is due before it is written.
+ * The almost empty interrupt is latched as the free count reaches the
+ * threshold and holds NIRQ low until it is cleared.
+ */
+static void sim_tx_update(void) {
+  if(sim.tx && sim.tx_written < sim.tx_all
+     && sim.rt - sim.tx_start >= sim.tx_written * sim.byte_us)
+    sim.underrun = true;
+  uint8_t free = Si446x_FIFO_COMBINED_SIZE - (sim.tx_written - sim_tx_sent());
+  if(free >= Si446x_TX_FIFO_THRESHOLD && sim.tx_free < Si446x_TX_FIFO_THRESHOLD)
+    sim.tx_pend = true;
+  sim.tx_free = free;
+  if(sim.nirq == 0x27)
+    sim_drive(SIM_NIRQ, !sim.tx_pend);
+}
+
+/* Bring radio outputs up to date with the time. */
+static void sim_update(void) {
+  sim.rt = chVTGetSystemTimeX() * 1000;
+  if(sim.gpio0 == 0x08)
+    sim_drive(SIM_GPIO0, sim_cts());
+  if(sim.byte_us != 0)
+    sim_tx_update();
+}
+
+static void sim_reset(void) {
+  memset(&sim, 0, sizeof(sim));
+  memset(&sim_dat, 0, sizeof(sim_dat));
+  memset(&sim_svc, 0, sizeof(sim_svc));
+  sim.ready = chVTGetSystemTimeX();
+  sim.rt = chVTGetSystemTimeX() * 1000;
+}
+
+/* CCA edges are delivered at each microsecond of a sleep. */
+void host_sleep(sysinterval_t time) {
+  sim.sleeps++;
+  rtcnt_t end = (chVTGetSystemTimeX() + time) * 1000;
+  while(sim.cca_period != 0 && sim.rt < end) {
+    sim.rt++;
+    sim_drive(SIM_NIRQ, sim.rt % sim.cca_period
+                        >= sim.cca_period - sim.cca_high);
+  }
+  host_advance(time);
+  sim_update();
+}
+
+/*
+ * A wait ends when the running command completes.
+ * With the TX FIFO running it ends when an interrupt signals the thread.
+ */
+bool host_idle(sysinterval_t timeout) {
+  if(sim.byte_us != 0) {
+    for(sysinterval_t t = 0; t < timeout; t++) {
+      host_advance(1);
+      sim_update();
+      if(chThdGetSelfX()->events != 0)
+        return true;
+    }
+    return false;
+  }
+  sysinterval_t left = sim.ready - chVTGetSystemTimeX();
+  if(sim_cts() || left > timeout) {
+    host_advance(timeout);
+    sim_update();
+    return false;
+  }
+  host_advance(left);
+  sim_update();
+  return true;
+}
+
+rtcnt_t chSysGetRealtimeCounterX(void) {
+  return sim.rt;
+}
+
+palevent_t *pal_lld_get_line_event(ioline_t line) {
+  return &sim.lines[line].event;
+}
+
+uint8_t palReadLine(ioline_t line) {
+  return sim.lines[line].level;
+}
+
+void palWriteLine(ioline_t line, uint8_t state) {
+  sim.lines[line].level = state;
+}
+
+void palSetLineMode(ioline_t line, iomode_t mode) {
+}
+
+void palEnableLineEvent(ioline_t line, uint32_t mode) {
+  sim.lines[line].mode = mode;
+}
+
+void palDisableLineEvent(ioline_t line) {
+  sim.lines[line].mode = PAL_EVENT_MODE_DISABLED;
+}
+
+void palSetLineCallback(ioline_t line, palcallback_t cb, void *arg) {
+  sim.lines[line].event.cb = cb;
+  sim.lines[line].event.arg = arg;
+}
+
+void pktSetGPIOlineMode(ioline_t line, iomode_t mode) {
+}
+
+void spiStart(SPIDriver *spip, const SPIConfig *config) {
+}
+
+void spiStop(SPIDriver *spip) {
+}
+
+void spiAcquireBus(SPIDriver *spip) {
+}
+
+void spiReleaseBus(SPIDriver *spip) {
+}
+
+void spiSelect(SPIDriver *spip) {
+  spip->len = 0;
+}
+
+/* Run a command when select is released. READ_CMD_BUFF has no effect. */
+void spiUnselect(SPIDriver *spip) {
+  if(spip->len == 0)
+    return;
+  if(spip->cmd[0] == Si446x_READ_CMD_BUFF) {
+    sim.polls++;
+    return;
+  }
+  sim.commands++;
+  memcpy(sim.last, spip->cmd, sizeof(sim.last));
+  if(spip->cmd[0] == Si446x_GPIO_PIN_CFG && spip->cmd[1] != 0)
+    sim.gpio0 = spip->cmd[1];
+  if(spip->cmd[0] == Si446x_GPIO_PIN_CFG && spip->cmd[5] != 0)
+    sim.nirq = spip->cmd[5];
+  if(spip->cmd[0] == Si446x_SET_PROPERTY) {
+    uint8_t n = spip->cmd[2], index = spip->cmd[3];
+    sim.set_props++;
+    if(n == 0 || n > Si446x_PROP_MAX_WRITE || spip->len != 4U + n
+       || index + n > 0x100)
+      sim.bad_props = true;
+    for(uint8_t i = 0; i < n && 4U + i < spip->len; i++)
+      sim.props[(spip->cmd[1] << 8) | ((index + i) & 0xFF)] = spip->cmd[4 + i];
+  }
+  sim.ready = chVTGetSystemTimeX() + sim.busy;
+  sim_update();
+  if(sim.byte_us == 0)
+    return;
+  switch(spip->cmd[0]) {
+  case Si446x_FIFO_INFO:
+    if(spip->cmd[1] & 0x01)
+      sim.tx_written = 0;
+    sim_tx_update();
+    sim.response[0] = 0;
+    sim.response[1] = sim.tx_free;
+    break;
+  case Si446x_WRITE_TX_FIFO:
+    sim.tx_written += spip->len - 1;
+    sim_tx_update();
+    break;
+  case Si446x_GET_INT_STATUS:
+    if((spip->cmd[1] & 0x02) == 0)
+      sim.tx_pend = false;
+    sim_tx_update();
+    break;
+  case Si446x_START_TX:
+    sim.tx = true;
+    sim.tx_start = sim.rt;
+    break;
+  }
+}
+
+/*
+ * READ_CMD_BUFF returns CTS after the command byte then the response.
+ * The byte clocked out with the command byte is undefined.
+ */
+void spiExchange(SPIDriver *spip, size_t n, const void *txbuf, void *rxbuf) {
+  const uint8_t *tx = txbuf;
+  uint8_t *rx = rxbuf;
+  for(size_t i = 0; i < n; i++, spip->len++) {
+    if(spip->len < sizeof(spip->cmd))
+      spip->cmd[spip->len] = tx[i];
+    if(rx == NULL)
+      continue;
+    if(spip->cmd[0] != Si446x_READ_CMD_BUFF || spip->len == 0)
+      rx[i] = 0x00;
+    else if(spip->len == 1)
+      rx[i] = sim_cts() ? Si446x_COMMAND_CTS : 0x00;
+    else
+      rx[i] = sim_cts() ? sim.response[(spip->len - 2) % 16] : 0x00;
+  }
+}
+
+void spiSend(SPIDriver *spip, size_t n, const void *txbuf) {
+  spiExchange(spip, n, txbuf, NULL);
+}
+
+void spiReceive(SPIDriver *spip, size_t n, void *rxbuf) {
+  uint8_t tx[n];
+  memset(tx, 0, n);
+  spiExchange(spip, n, tx, rxbuf);
+}
+
+/*===========================================================================*/
+/* NIRQ line sharing.                                                        */
+/*===========================================================================*/
+
+static uint32_t rx_edges;
+
+static void rx_edge(void *arg) {
+  rx_edges++;
+}
+
+/*
+ * Receive state before borrowing NIRQ.
+ * Edge events may be on or off and receive active or paused.
+ */
+static void nirq_setup(bool events, packet_state_t state) {
+  sim_reset();
+  sim_svc.state = state;
+  (void)Si446x_enablePWMevents(1, rx_edge);
+  if(!events)
+    Si446x_disablePWMevents(1);
+  rx_edges = 0;
+}
+
+/* Check NIRQ is back as receive had it and edges reach receive if on. */
+static bool nirq_restored(bool events) {
+  sim_line_t *lp = &sim.lines[SIM_NIRQ];
+  lp->level = PAL_LOW;
+  if(lp->event.cb != rx_edge || lp->event.arg != &sim_icu)
+    return false;
+  if(lp->mode != (events ? PAL_EVENT_MODE_BOTH_EDGES
+                         : PAL_EVENT_MODE_DISABLED))
+    return false;
+  sim_drive(SIM_NIRQ, PAL_HIGH);
+  sim_drive(SIM_NIRQ, PAL_LOW);
+  return rx_edges == (events ? 2 : 0);
+}
+
+static void test_nirq_tx_fifo(void) {
+  for(int c = 0; c < 4; c++) {
+    bool events = c & 1;
+    packet_state_t state = (c & 2) ? PACKET_PAUSE : PACKET_DECODE;
+    nirq_setup(events, state);
+    si446x_nirq_save_t save;
+    Si446x_enableTXFIFOInterrupt(1, &save);
+
+    /* The almost empty interrupt wakes the feeder and not receive. */
+    thread_t *self = chThdGetSelfX();
+    self->events = 0;
+    sim_drive(SIM_NIRQ, PAL_HIGH);
+    sim_drive(SIM_NIRQ, PAL_LOW);
+    if(self->events != SI446X_EVT_TX_FIFO || rx_edges != 0) {
+      printf("nirq: TX FIFO interrupt not delivered, events %d state %d\n",
+             events, state);
+      failures++;
+    }
+    self->events = 0;
+
+    Si446x_disableTXFIFOInterrupt(1, &save);
+    if(!nirq_restored(events)) {
+      printf("nirq: not restored after TX FIFO, events %d state %d\n",
+             events, state);
+      failures++;
+    }
+  }
+}
+
+/*
+ * Run the feeder loop on the almost empty interrupt for a stream of all
+ * bytes, each taking byte_us to send. The feeder wakes up to late ticks
+ * after the interrupt or poll timeout.
+ * Return true if the FIFO never ran empty.
+ */
+static bool fifo_feed(uint32_t byte_us, uint32_t all, sysinterval_t late,
+                      uint32_t *refills, uint8_t *lower) {
+  uint8_t buf[Si446x_FIFO_COMBINED_SIZE] = {0};
+  nirq_setup(true, PACKET_PAUSE);
+  sim.byte_us = byte_us;
+  sim.tx_all = all;
+
+  const uint8_t reset_fifo[] = {Si446x_FIFO_INFO, 0x01};
+  Si446x_write(1, reset_fifo, sizeof(reset_fifo));
+  uint8_t free = Si446x_getTXfreeFIFO(1);
+  uint32_t c = (all > free) ? free : all;
+  Si446x_writeFIFO(1, buf, c);
+  const uint8_t start_tx[] = {Si446x_START_TX, 0x00};
+  Si446x_write(1, start_tx, sizeof(start_tx));
+
+  si446x_nirq_save_t save;
+  Si446x_enableTXFIFOInterrupt(1, &save);
+  thread_t *self = chThdGetSelfX();
+  self->events = 0;
+  *refills = 0;
+  *lower = 0;
+  while((all - c) > 0) {
+    uint8_t more = Si446x_getTXfreeFIFO(1);
+    *lower = (more > *lower) ? more : *lower;
+    more = (more > (all - c)) ? (all - c) : more;
+    Si446x_writeFIFO(1, buf, more);
+    c += more;
+    (*refills)++;
+    Si446x_clearTXFIFOInterrupt(1);
+    (void)chEvtWaitAnyTimeout(SI446X_EVT_TX_FIFO, Si446x_TX_FIFO_POLL(byte_us));
+    chThdSleep(rand() % (late + 1));
+  }
+  Si446x_disableTXFIFOInterrupt(1, &save);
+  sim.byte_us = 0;
+  return !sim.underrun;
+}
+
+static void test_fifo_refill(void) {
+  static const struct {
+    const char      *name;
+    uint32_t        byte_us;
+  } rates[] = {
+    {"AFSK 1200", 833 * 8 / SAMPLES_PER_BAUD},
+    {"2FSK 9600", 104 * 8}
+  };
+  for(size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+    /* Time to send what is left in the FIFO when the interrupt fires. */
+    sysinterval_t hold = TIME_US2I(rates[i].byte_us
+                         * (Si446x_FIFO_COMBINED_SIZE
+                            - Si446x_TX_FIFO_THRESHOLD)) - 1;
+    uint32_t refills;
+    uint8_t lower;
+    for(int run = 0; run < 20; run++) {
+      if(!fifo_feed(rates[i].byte_us, 4000, hold * 3 / 4, &refills, &lower)) {
+        printf("fifo: %s underrun with latency up to %u ms\n",
+               rates[i].name, hold * 3 / 4);
+        failures++;
+        break;
+      }
+    }
+    printf("fifo: %s latency up to %u ms: %u refills, most free %u of %u\n",
+           rates[i].name, hold * 3 / 4, refills, lower,
+           Si446x_FIFO_COMBINED_SIZE);
+
+    /* The model must see an underrun when refills are too late. */
+    if(fifo_feed(rates[i].byte_us, 4000, hold * 2, &refills, &lower)) {
+      printf("fifo: %s no underrun with latency up to %u ms\n",
+             rates[i].name, hold * 2);
+      failures++;
+    }
+  }
+}
+
+/*===========================================================================*/
+/* CTS.                                                                      */
+/*===========================================================================*/
+
+/*
+ * Read a response from a command taking busy ticks.
+ * Return the time taken or -1 if the response is wrong.
+ */
+static int32_t cts_read(bool gpio, sysinterval_t busy, uint32_t *sleeps) {
+  sim_reset();
+  if(gpio)
+    Si446x_enableCTSGPIO(1);
+  for(uint8_t i = 0; i < sizeof(sim.response); i++)
+    sim.response[i] = 0xA0 + i;
+  sim.busy = busy;
+  sim.sleeps = 0;
+
+  const uint8_t cmd[] = {Si446x_GET_INT_STATUS, 0xFF, 0xFF, 0xFF};
+  uint8_t rx[2 + 8];
+  systime_t start = chVTGetSystemTimeX();
+  if(!Si446x_read(1, cmd, sizeof(cmd), rx, sizeof(rx)))
+    return -1;
+  if(sim.last[0] != Si446x_GET_INT_STATUS
+     || memcmp(&rx[2], sim.response, sizeof(rx) - 2) != 0)
+    return -1;
+  *sleeps = sim.sleeps;
+  return chVTTimeElapsedSinceX(start);
+}
+
+static void test_cts_wait(void) {
+  static const sysinterval_t busy[] = {0, 3, 99, 150};
+  uint32_t sleeps;
+
+  for(size_t i = 0; i < sizeof(busy) / sizeof(busy[0]); i++) {
+    /* GPIO0 CTS: the response is read as soon as the command completes. */
+    int32_t t = cts_read(true, busy[i], &sleeps);
+    if(t != (int32_t)busy[i] || sleeps != 0) {
+      printf("cts: GPIO0 busy %u took %d with %u sleeps\n",
+             busy[i], t, sleeps);
+      failures++;
+    }
+
+    /* Polling alone: the response is read within a sleep of completion. */
+    t = cts_read(false, busy[i], &sleeps);
+    if(busy[i] < 100 && (t < (int32_t)busy[i] || t > (int32_t)busy[i] + 1)) {
+      printf("cts: polled busy %u took %d\n", busy[i], t);
+      failures++;
+    }
+  }
+
+  /* A write waits for the previous command before sending. */
+  sim_reset();
+  Si446x_enableCTSGPIO(1);
+  sim.busy = 5;
+  sim.sleeps = 0;
+  const uint8_t nop[] = {Si446x_NOP};
+  systime_t start = chVTGetSystemTimeX();
+  if(!Si446x_write(1, nop, sizeof(nop)) || !Si446x_write(1, nop, sizeof(nop))
+     || chVTTimeElapsedSinceX(start) != 5 || sim.sleeps != 0) {
+    printf("cts: write did not wait for the GPIO0 edge\n");
+    failures++;
+  }
+}
+
+static void test_nirq_cca(void) {
+  for(int c = 0; c < 4; c++) {
+    bool events = c & 1;
+    packet_state_t state = (c & 2) ? PACKET_PAUSE : PACKET_DECODE;
+    nirq_setup(events, state);
+
+    /* CCA high a quarter of the time. Receive sees none of the edges. */
+    sim.cca_period = 400;
+    sim.cca_high = 100;
+    uint16_t busy = Si446x_measureCCA(1, 10);
+    sim.cca_period = 0;
+    if(busy != 250 || rx_edges != 0) {
+      printf("nirq: CCA measured %u with %u receive edges\n",
+             busy, rx_edges);
+      failures++;
+    }
+    if(!nirq_restored(events)) {
+      printf("nirq: not restored after CCA, events %d state %d\n",
+             events, state);
+      failures++;
+    }
+  }
+}
+
+/*===========================================================================*/
+/* Properties.                                                               */
+/*===========================================================================*/
+
+uint32_t ref_setBandParameters(uint8_t *props, radio_freq_t freq,
+                               channel_hz_t step);
+uint32_t ref_setModemAFSK_TX(uint8_t *props);
+uint32_t ref_setModemAFSK_RX(uint8_t *props, radio_part_t part);
+uint32_t ref_setModem2FSK_RX(uint8_t *props, radio_part_t part,
+                             uint32_t speed);
+uint32_t ref_setModem2FSK_TX(uint8_t *props, uint32_t speed);
+
+/* Run a setup step in the driver, or in the reference if ref is set. */
+static uint32_t prop_step(int step, uint8_t *ref, radio_part_t part) {
+  switch(step) {
+  case 0:
+  case 6: {
+    radio_freq_t freq = (step == 0) ? 144800000 : 435000000;
+    channel_hz_t hz = (step == 0) ? 12500 : 25000;
+    if(ref != NULL)
+      return ref_setBandParameters(ref, freq, hz);
+    (void)Si446x_setBandParameters(1, freq, hz);
+    return 0;
+  }
+  case 1:
+  case 5:
+    if(ref != NULL)
+      return ref_setModemAFSK_RX(ref, part);
+    Si446x_setModemAFSK_RX(1);
+    return 0;
+  case 2:
+  case 7:
+    if(ref != NULL)
+      return ref_setModemAFSK_TX(ref);
+    Si446x_setModemAFSK_TX(1);
+    return 0;
+  case 3:
+    if(ref != NULL)
+      return ref_setModem2FSK_TX(ref, 9600);
+    Si446x_setModem2FSK_TX(1, 9600);
+    return 0;
+  case 4:
+    if(ref != NULL)
+      return ref_setModem2FSK_RX(ref, part, 9600);
+    Si446x_setModem2FSK_RX(1, 9600);
+    return 0;
+  }
+  return 0;
+}
+
+static void test_properties(void) {
+  static const char *steps[] = {
+    "band 144.8 MHz", "AFSK RX", "AFSK TX", "2FSK TX", "2FSK RX",
+    "AFSK RX", "band 435 MHz", "AFSK TX"
+  };
+  static const radio_part_t parts[] = {0x4464, 0x4463};
+  static uint8_t ref[0x10000];
+
+  for(size_t p = 0; p < sizeof(parts) / sizeof(parts[0]); p++) {
+    sim_reset();
+    sim_svc.radio_part = parts[p];
+    memset(ref, 0, sizeof(ref));
+    uint32_t sent = 0, baseline = 0;
+    for(int k = 0; k < (int)(sizeof(steps) / sizeof(steps[0])); k++) {
+      uint32_t before = sim.set_props;
+      prop_step(k, NULL, parts[p]);
+      sent += sim.set_props - before;
+      baseline += prop_step(k, ref, parts[p]);
+      if(memcmp(sim.props, ref, sizeof(ref)) != 0) {
+        printf("props: Si%x %s properties differ from the reference\n",
+               parts[p], steps[k]);
+        failures++;
+      }
+
+      /* Everything is in the shadow so a repeat sends nothing. */
+      before = sim.set_props;
+      prop_step(k, NULL, parts[p]);
+      if(sim.set_props != before) {
+        printf("props: Si%x %s repeated sent %u SET_PROPERTY\n",
+               parts[p], steps[k], sim.set_props - before);
+        failures++;
+      }
+    }
+    if(sim.bad_props) {
+      printf("props: Si%x SET_PROPERTY out of limits\n", parts[p]);
+      failures++;
+    }
+    printf("props: Si%x: %u SET_PROPERTY commands, per property %u\n",
+           parts[p], sent, baseline);
+  }
+}
+
+/*===========================================================================*/
+/* 2FSK RX clock recovery.                                                   */
+/*===========================================================================*/
+
+static void test_bcr(void) {
+  uint8_t bcr[Si446x_BCR_RUN_SIZE];
+  Si446x_getModemBCR(1200, bcr);
+  const size_t n = sizeof(Si446x_afsk_rx_props) / sizeof(si446x_prop_t);
+  for(uint8_t i = 0; i < Si446x_BCR_RUN_SIZE; i++) {
+    size_t p = 0;
+    while(p < n && Si446x_afsk_rx_props[p].prop != Si446x_MODEM_BCR_OSR + i)
+      p++;
+    if(p == n || Si446x_afsk_rx_props[p].value != bcr[i]) {
+      printf("bcr: byte %u at 1200 baud is 0x%02x not the AFSK value\n",
+             i, bcr[i]);
+      failures++;
+    }
+  }
+}
+
+int main(void) {
+  srand(1);
+  test_upsampler_exact();
+  test_upsampler_old();
+  test_transmit_length();
+  test_nirq_tx_fifo();
+  test_fifo_refill();
+  test_nirq_cca();
+  test_cts_wait();
+  test_properties();
+  test_bcr();
+  printf("si446x: %d failures\n", failures);
+  return failures != 0;
+}
@@ -0,0 +1,217 @@
+/*
+ * SSDV encoder against the reference encoder in ssdv_ref.c.
+ *
+ * The reference JPEGs in ssdv/ are encoded at every quality, 0 to 7, in
+ * every packet type. Each quality has its own output tables, so every
+ * output huffman code lookup is covered. Packet count and every packet
+ * byte must match the reference, fed whole. The same packets must come
+ * out when the whole input is set in place and when it is fed in chunks.
+ *
+ * The reference takes the RSTn marker after a reset interval as image
+ * data when the interval ends in bits left over from a full packet. It
+ * fails on one encode of the restart interval image, which is not
+ * compared. All others must match.
+ *
+ * Encode speed of both encoders is printed in MB/s of JPEG data. Most of
+ * the time goes into decoding the source huffman codes, which ssdv.c does
+ * through lookup tables and the reference one bit at a time. Higher
+ * qualities write more codes, which ssdv.c looks up by symbol and the
+ * reference by scanning the output table.
+ *
+ * Packets/s of the encoder in the padding type of the image threads is
+ * printed with the input fed in chunks, as the image thread once fed it,
+ * and set in place, as the packet store does now. The packets must be the
+ * same.
+ */
+#include "ssdv.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_PACKETS     512
+
+/* Chunk size meaning the whole input is set in place. */
+#define IN_PLACE        0
+
+int ref_ssdv_encode(uint8_t type, uint8_t image_id, int8_t quality,
+                    const uint8_t *jpeg, size_t length, size_t chunk,
+                    uint8_t *packets, int max);
+
+typedef struct {
+  const char        *name;
+  bool              restart;    /* Has a restart interval.          */
+  uint8_t           *data;
+  size_t            size;
+} jpeg_t;
+
+static jpeg_t images[] = {
+  {.name = "ssdv/scene.jpg"},
+  {.name = "ssdv/scene_dri.jpg", .restart = true},
+};
+
+static uint8_t ref[MAX_PACKETS][SSDV_PKT_SIZE];
+static uint8_t placed[MAX_PACKETS][SSDV_PKT_SIZE];
+static uint8_t out[MAX_PACKETS][SSDV_PKT_SIZE];
+static int compared, encodes;
+static int failures;
+
+static bool load(jpeg_t *img) {
+  FILE *fp = fopen(img->name, "rb");
+  if(fp == NULL)
+    return false;
+  fseek(fp, 0, SEEK_END);
+  img->size = ftell(fp);
+  rewind(fp);
+  img->data = malloc(img->size);
+  bool ok = fread(img->data, 1, img->size, fp) == img->size;
+  fclose(fp);
+  return ok;
+}
+
+/* Encodes a whole JPEG fed in chunks or set in place, returns the packet
+ * count or -1. */
+static int encode(uint8_t type, uint8_t quality, const jpeg_t *img,
+                  size_t chunk, uint8_t (*packets)[SSDV_PKT_SIZE], int max) {
+  static ssdv_t s;
+  size_t pos = 0;
+  int n = 0;
+  char c;
+  ssdv_enc_init(&s, type, "TEST", 7, quality);
+  ssdv_enc_set_buffer(&s, packets[0]);
+  if(chunk == IN_PLACE) {
+    ssdv_enc_set_input(&s, img->data, img->size);
+    pos = img->size;
+  }
+  while(true) {
+    while((c = ssdv_enc_get_packet(&s)) == SSDV_FEED_ME) {
+      size_t k = img->size - pos < chunk ? img->size - pos : chunk;
+      if(k == 0)
+        return -1;
+      ssdv_enc_feed(&s, &img->data[pos], k);
+      pos += k;
+    }
+    if(c == SSDV_EOI)
+      return n;
+    if(c != SSDV_OK || ++n == max)
+      return -1;
+    ssdv_enc_set_buffer(&s, packets[n]);
+  }
+}
+
+static void check(bool ok, const char *name, const char *what,
+                  uint8_t type, uint8_t quality, size_t chunk) {
+  if(!ok) {
+    char fed[40] = "whole";
+    if(chunk == IN_PLACE)
+      strcpy(fed, "in place");
+    else if(chunk != SIZE_MAX)
+      snprintf(fed, sizeof(fed), "in %zu byte chunks", chunk);
+    printf("FAIL %s type %u quality %u fed %s: %s\n", name, type, quality,
+           fed, what);
+    failures++;
+  }
+}
+
+static void compare(const jpeg_t *img, uint8_t type, uint8_t quality) {
+  const size_t chunks[] = {1, 64, SIZE_MAX};
+  int n = encode(type, quality, img, IN_PLACE, placed, MAX_PACKETS);
+  check(n > 0, img->name, "encode failed", type, quality, IN_PLACE);
+  for(size_t k = 0; k < sizeof(chunks) / sizeof(chunks[0]); k++) {
+    int c = encode(type, quality, img, chunks[k], out, MAX_PACKETS);
+    check(c == n, img->name, "packet count", type, quality, chunks[k]);
+    check(c <= 0 || memcmp(placed, out, c * SSDV_PKT_SIZE) == 0, img->name,
+          "packet data", type, quality, chunks[k]);
+  }
+
+  encodes++;
+  int r = ref_ssdv_encode(type, 7, quality, img->data, img->size, SIZE_MAX,
+                          ref[0], MAX_PACKETS);
+  if(r < 0 && img->restart)
+    return;
+  compared++;
+  check(r > 0, img->name, "reference failed", type, quality, SIZE_MAX);
+  check(n == r, img->name, "reference packet count", type, quality,
+        SIZE_MAX);
+  check(n <= 0 || memcmp(ref, placed, n * SSDV_PKT_SIZE) == 0, img->name,
+        "reference packet data", type, quality, SIZE_MAX);
+}
+
+static void test_packets(void) {
+  const uint8_t types[] = {
+    SSDV_TYPE_NORMAL, SSDV_TYPE_NOFEC, SSDV_TYPE_PADDING
+  };
+  for(size_t i = 0; i < sizeof(images) / sizeof(images[0]); i++) {
+    for(size_t t = 0; t < sizeof(types); t++) {
+      for(uint8_t q = 0; q < 8; q++)
+        compare(&images[i], types[t], q);
+    }
+  }
+  printf("ssdv: %d of %d encodes compared with the reference\n", compared,
+         encodes);
+  if(compared < encodes - 1) {
+    printf("FAIL reference: too few encodes compared\n");
+    failures++;
+  }
+}
+
+static double now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/* MB/s of JPEG data through both encoders, fed whole. */
+static void benchmark(const jpeg_t *img, uint8_t quality) {
+  const int count = 200;
+  double t = now();
+  for(int i = 0; i < count; i++)
+    ref_ssdv_encode(SSDV_TYPE_NORMAL, 7, quality, img->data, img->size,
+                    SIZE_MAX, ref[0], MAX_PACKETS);
+  double reference = count * img->size / (now() - t) / 1e6;
+
+  t = now();
+  for(int i = 0; i < count; i++)
+    encode(SSDV_TYPE_NORMAL, quality, img, SIZE_MAX, out, MAX_PACKETS);
+  double ssdv = count * img->size / (now() - t) / 1e6;
+
+  printf("ssdv: %-18s quality %u: reference %5.1f, ssdv %5.1f MB/s\n",
+         img->name, quality, reference, ssdv);
+}
+
+/* Packets/s of the encoder fed in chunks and set in place. */
+static void benchmark_input(const jpeg_t *img) {
+  const int count = 200;
+  const size_t chunks[] = {1, 128, IN_PLACE};
+  const uint8_t type = SSDV_TYPE_PADDING, quality = 4;
+  double rate[sizeof(chunks) / sizeof(chunks[0])];
+  int n = encode(type, quality, img, IN_PLACE, placed, MAX_PACKETS);
+  for(size_t k = 0; k < sizeof(chunks) / sizeof(chunks[0]); k++) {
+    double t = now();
+    for(int i = 0; i < count; i++)
+      encode(type, quality, img, chunks[k], out, MAX_PACKETS);
+    rate[k] = count * n / (now() - t) / 1e3;
+    check(memcmp(placed, out, n * SSDV_PKT_SIZE) == 0, img->name,
+          "benchmark packet data", type, quality, chunks[k]);
+  }
+  printf("ssdv: %-18s packets/s: 1 B feed %5.1fk, 128 B feed %5.1fk,"
+         " in place %5.1fk\n", img->name, rate[0], rate[1], rate[2]);
+}
+
+int main(void) {
+  for(size_t i = 0; i < sizeof(images) / sizeof(images[0]); i++) {
+    if(!load(&images[i])) {
+      printf("ssdv: cannot read %s\n", images[i].name);
+      return 1;
+    }
+  }
+  test_packets();
+  benchmark(&images[0], 0);
+  benchmark(&images[0], 4);
+  benchmark(&images[0], 7);
+  benchmark_input(&images[0]);
+  benchmark_input(&images[1]);
+  printf("ssdv: %d failures\n", failures);
+  return failures != 0;
+}
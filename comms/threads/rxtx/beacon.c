@@ -31,6 +31,15 @@ THD_FUNCTION(bcnThread, arg) {
       chVTGetSystemTime() - conf_sram.tel_enc_cycle;
   sysinterval_t time = chVTGetSystemTime();
 
+  /*
+   * Pre-encoded frames for this beacon identity.
+   * If no memory is available the full text encoders are used.
+   */
+  extern memory_heap_t *ccm_heap;
+  aprs_template_t *tpl = chHeapAlloc(ccm_heap, sizeof(aprs_template_t));
+  if(tpl != NULL)
+    aprs_template_init(tpl);
+
   /* Now wait for our delay before starting. */
 
   chThdSleepUntil(chVTGetSystemTime() + conf->beacon.init_delay);
@@ -62,6 +71,10 @@ THD_FUNCTION(bcnThread, arg) {
 
     /* Continue here when collector responds. */
     if(!p_sleep(&conf->beacon.sleep_conf)) {
+      /* Rebuild templates if the identity has been reconfigured. */
+      bool use_tpl = (tpl != NULL)
+          && aprs_template_update(tpl, conf->call, conf->path, conf->symbol);
+
       // Telemetry encoding parameter transmissions
       if(conf_sram.tel_enc_cycle != 0
     		  && chVTTimeElapsedSinceX(last_conf_transmission)
@@ -71,22 +84,24 @@ THD_FUNCTION(bcnThread, arg) {
         // Encode and transmit telemetry config packet
         uint8_t type = 0;
         do {
-          packet_t packet = aprs_encode_telemetry_configuration(
-              conf->call,
-              conf->path,
-              conf->call,
-              type);
+          packet_t packet = use_tpl
+              ? aprs_template_telemetry_configuration(tpl, type)
+              : aprs_encode_telemetry_configuration(conf->call,
+                                                    conf->path,
+                                                    conf->call,
+                                                    type);
           if(packet == NULL) {
             TRACE_WARN("BCN  > No free packet objects for"
                 " telemetry config transmission %d", type);
           } else {
-            if(!transmitOnRadio(packet,
-                                conf->radio_conf.freq,
-                                0,
-                                0,
-                                conf->radio_conf.pwr,
-                                conf->radio_conf.mod,
-                                conf->radio_conf.cca)) {
+            if(!transmitServiceOnRadio(packet,
+                                       conf->radio_conf.freq,
+                                       0,
+                                       0,
+                                       conf->radio_conf.pwr,
+                                       conf->radio_conf.mod,
+                                       conf->radio_conf.cca,
+                                       PKT_TX_SVC_BEACON)) {
               /* Packet is released in transmitOnRadio. */
               TRACE_ERROR("BCN  > Failed to transmit telemetry config");
             }
@@ -99,21 +114,24 @@ THD_FUNCTION(bcnThread, arg) {
       TRACE_INFO("BCN  > Transmit position and telemetry");
 
       // Encode/Transmit position packet
-      packet_t packet = aprs_encode_position_and_telemetry(conf->call,
-                                                           conf->path,
-                                                           conf->symbol,
-                                                           dataPoint, true);
+      packet_t packet = use_tpl
+          ? aprs_template_position_and_telemetry(tpl, dataPoint)
+          : aprs_encode_position_and_telemetry(conf->call,
+                                               conf->path,
+                                               conf->symbol,
+                                               dataPoint, true);
       if(packet == NULL) {
         TRACE_ERROR("BCN  > No free packet objects"
             " for position transmission");
       } else {
-        if(!transmitOnRadio(packet,
-                            conf->radio_conf.freq,
-                            0,
-                            0,
-                            conf->radio_conf.pwr,
-                            conf->radio_conf.mod,
-                            conf->radio_conf.cca)) {
+        if(!transmitServiceOnRadio(packet,
+                                   conf->radio_conf.freq,
+                                   0,
+                                   0,
+                                   conf->radio_conf.pwr,
+                                   conf->radio_conf.mod,
+                                   conf->radio_conf.cca,
+                                   PKT_TX_SVC_BEACON)) {
           TRACE_ERROR("BCN  > failed to transmit beacon data");
         }
         chThdSleep(TIME_S2I(5));
@@ -140,13 +158,14 @@ THD_FUNCTION(bcnThread, arg) {
         TRACE_ERROR("BCN  > No free packet objects "
             "or badly formed APRSD message");
       } else {
-        if(!transmitOnRadio(packet,
-                            conf->radio_conf.freq,
-                            0,
-                            0,
-                            conf->radio_conf.pwr,
-                            conf->radio_conf.mod,
-                            conf->radio_conf.cca
+        if(!transmitServiceOnRadio(packet,
+                                   conf->radio_conf.freq,
+                                   0,
+                                   0,
+                                   conf->radio_conf.pwr,
+                                   conf->radio_conf.mod,
+                                   conf->radio_conf.cca,
+                                   PKT_TX_SVC_BEACON
         )) {
           TRACE_ERROR("BCN  > Failed to transmit APRSD data");
         }
@@ -154,6 +173,8 @@ THD_FUNCTION(bcnThread, arg) {
       }
     } /* psleep */
     if(conf->run_once) {
+      if(tpl != NULL)
+        chHeapFree(tpl);
       chHeapFree(conf);
       pktThdTerminateSelf();
     }
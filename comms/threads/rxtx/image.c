@@ -18,6 +18,8 @@
 #include "sd.h"
 #include "collector.h"
 #include "image.h"
+#include "imgstore.h"
+#include "imgctl.h"
 
 const uint8_t noCameraFound[] = {
      0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 0x4A, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x01, 0x00, 0x48,
@@ -819,81 +821,73 @@ ssdv_packet_t packetRepeats[16];
 bool reject_pri;
 bool reject_sec;
 
-static bool transmit_image_packet(const uint8_t *image,
-                                  uint32_t image_len,
-                                  img_app_conf_t* conf,
-                                  uint8_t image_id,
-                                  uint16_t packet_id) {
-	ssdv_t ssdv;
-	uint8_t pkt[SSDV_PKT_SIZE];
-	uint8_t pkt_base91[256] = {0};
-	const uint8_t *b;
-	uint32_t bi = 0;
-	uint8_t c = SSDV_OK;
-	uint16_t i = 0;
-
-	// Init SSDV (FEC at 2FSK, non FEC at APRS)
-	bi = 0;
-	ssdv_enc_init(&ssdv, SSDV_TYPE_PADDING, "N0CALL", image_id, conf->quality);
-	ssdv_enc_set_buffer(&ssdv, pkt);
-
-	while(true)
-	{
-		while((c = ssdv_enc_get_packet(&ssdv)) == SSDV_FEED_ME)
-		{
-			b = &image[bi];
-			uint8_t r = bi < image_len-128 ? 128 : image_len - bi;
-			bi += r;
-
-			if(r <= 0)
-			{
-				TRACE_ERROR("SSDV > Premature end of file");
-				return false;
-			}
-			ssdv_enc_feed(&ssdv, b, r);
-		}
-
-		if(c == SSDV_EOI) {
-			return true;
-		} else if(c != SSDV_OK) {
-			return false;
-		}
+/* Pre-encoded APRS frames of the primary and secondary image threads. */
+static aprs_template_t img_templates[2];
 
-		if(i == packet_id) {
-			// Sync byte, CRC and FEC of SSDV not transmitted (because its not necessary inside an APRS packet)
-			base91_encode(&pkt[6], pkt_base91, 174);
-			packet_t packet = aprs_encode_data_packet(conf->call, conf->path, 'I', pkt_base91);
-            if(packet == NULL) {
-              TRACE_WARN("IMG  > No free packet objects for transmission");
-              return false;
-            }
-            if(!transmitOnRadio(packet,
-                                conf->radio_conf.freq,
-                                0,
-                                0,
-                                conf->radio_conf.pwr,
-                                conf->radio_conf.mod,
-                                conf->radio_conf.cca)) {
+/*
+ * Encode an APRS/SSDV packet.
+ * Use the pre-encoded frame template when available.
+ */
+static packet_t encode_image_packet(img_app_conf_t* conf,
+                                    aprs_template_t *tpl,
+                                    uint8_t *pkt_base91) {
+  if(tpl != NULL)
+    return aprs_template_data_packet(tpl, 'I', pkt_base91);
+  return aprs_encode_data_packet(conf->call, conf->path, 'I', pkt_base91);
+}
 
-              TRACE_ERROR("IMG  > Unable to send image packet on radio");
-              return false;
-            }
-		}
+/*
+ * Send one stored packet of an image again.
+ * Return true if the packet was sent.
+ */
+static bool transmit_image_packet(img_app_conf_t* conf,
+                                  aprs_template_t *tpl,
+                                  uint8_t image_id,
+                                  uint16_t packet_id) {
+  uint8_t pkt[SSDV_PKT_SIZE];
+  uint8_t pkt_base91[256] = {0};
 
-		chThdSleep(TIME_MS2I(10)); // Leave other threads some time
+  if(!imgStoreGetPacket(image_id, packet_id, pkt)) {
+    TRACE_WARN("IMG  > Packet %i of image %i not in store",
+               packet_id, image_id);
+    return false;
+  }
 
-		i++;
-	}
+  // Sync byte, CRC and FEC of SSDV not transmitted (because its not necessary inside an APRS packet)
+  base91_encode(&pkt[6], pkt_base91, 174);
+  packet_t packet = encode_image_packet(conf, tpl, pkt_base91);
+  if(packet == NULL) {
+    TRACE_WARN("IMG  > No free packet objects for transmission");
+    return false;
+  }
+  if(!transmitServiceOnRadio(packet,
+                             conf->radio_conf.freq,
+                             0,
+                             0,
+                             conf->radio_conf.pwr,
+                             conf->radio_conf.mod,
+                             conf->radio_conf.cca,
+                             PKT_TX_SVC_IMAGE)) {
+    TRACE_ERROR("IMG  > Unable to send image packet on radio");
+    return false;
+  }
+  return true;
 }
 
 /*
  * Transmit image packets.
+ * The image is encoded once into the packet store and sent from there.
+ * The SSDV quality is chosen by the packet budget controller if given.
+ * A preview is encoded with the DC coefficients only.
  * Return true if no SSDV encoding error or false on encoding error.
  */
 static bool transmit_image_packets(const uint8_t *image,
                                    uint32_t image_len,
                                    img_app_conf_t* conf,
-                                   uint8_t image_id) {
+                                   aprs_template_t *tpl,
+                                   uint8_t image_id,
+                                   img_ctl_t *ctl,
+                                   bool preview) {
 
   uint8_t pkt[SSDV_PKT_SIZE];
   uint8_t pkt_base91[256] = {0};
@@ -902,19 +896,19 @@ static bool transmit_image_packets(const uint8_t *image,
   // Process redundant transmission from last cycle
   if(strlen((char*)pkt_base91)
       && conf->redundantTx) {
-    packet_t packet = aprs_encode_data_packet(conf->call, conf->path,
-                                              'I', pkt_base91);
+    packet_t packet = encode_image_packet(conf, tpl, pkt_base91);
     if(packet == NULL) {
       TRACE_ERROR("IMG  > No available packet for redundant"
           " image transmission");
     } else {
-      if(!transmitOnRadio(packet,
-                          conf->radio_conf.freq,
-                          0,
-                          0,
-                          conf->radio_conf.pwr,
-                          conf->radio_conf.mod,
-                          conf->radio_conf.cca)) {
+      if(!transmitServiceOnRadio(packet,
+                                 conf->radio_conf.freq,
+                                 0,
+                                 0,
+                                 conf->radio_conf.pwr,
+                                 conf->radio_conf.mod,
+                                 conf->radio_conf.cca,
+                                 PKT_TX_SVC_IMAGE)) {
         /* Packet has been released by transmit. */
         TRACE_ERROR("IMG  > Unable to send redundant image on radio");
       }
@@ -922,21 +916,24 @@ static bool transmit_image_packets(const uint8_t *image,
     chThdSleep(TIME_MS2I(10)); // Leave other threads some time
   }
 
-  /* Prepare for new image encode and send. */
-  ssdv_t ssdv;
-  const uint8_t *b;
-  uint32_t bi = 0;
-  uint8_t c = SSDV_OK;
-
-  /* Initialize SSDV, output buffer and input buffer. */
-  ssdv_enc_init(&ssdv, SSDV_TYPE_PADDING, "N0CALL", image_id, conf->quality);
-  ssdv_enc_set_buffer(&ssdv, pkt);
-  ssdv_enc_feed(&ssdv, image, 0);
+  /* Encode the image into the packet store (FEC at 2FSK, non FEC at APRS). */
+  uint8_t quality = (ctl != NULL)
+      ? imgCtlSelect(ctl, image, image_len) : conf->quality;
+  uint16_t count = imgStoreEncode(image, image_len, image_id,
+                                  SSDV_TYPE_PADDING, quality, preview);
+  if(count == 0) {
+    return false;
+  }
+  if(ctl != NULL)
+    imgCtlUpdate(ctl, count);
+  TRACE_INFO("SSDV > %s %i encoded to %i packets",
+             preview ? "Preview" : "Image", image_id, count);
 
-  while(c != SSDV_EOI) {
+  uint16_t packet_id = 0;
+  while(packet_id < count) {
 
     /*
-     * Next encode packets.
+     * Next send packets.
      * Packet burst send is available if redundant TX is not requested.
      */
     uint8_t buffers = fmin((NUMBER_COMMON_PKT_BUFFERS / 2),
@@ -951,24 +948,9 @@ static bool transmit_image_packets(const uint8_t *image,
     packet_t head = NULL;
     packet_t previous = NULL;
 
-    while(chain-- > 0) {
-      while((c = ssdv_enc_get_packet(&ssdv)) == SSDV_FEED_ME) {
-        b = &image[bi++];
-        if(bi > image_len) {
-          TRACE_ERROR("SSDV > Premature end of file");
-          if(head != NULL) {
-            pktReleaseBufferChain(head);
-          }
-          return false;
-        }
-        ssdv_enc_feed(&ssdv, b, 1);
-      }
-
-      if(c == SSDV_EOI) {
-        TRACE_INFO("SSDV > ssdv_enc_get_packet returned EOI");
-        break;
-      } else if(c != SSDV_OK) {
-        TRACE_ERROR("SSDV > ssdv_enc_get_packet failed: %i", c);
+    while(chain-- > 0 && packet_id < count) {
+      if(!imgStoreGetPacket(image_id, packet_id++, pkt)) {
+        TRACE_ERROR("IMG  > Image %i left the packet store", image_id);
         if(head != NULL) {
           pktReleaseBufferChain(head);
         }
@@ -981,8 +963,7 @@ static bool transmit_image_packets(const uint8_t *image,
        */
       base91_encode(&pkt[6], pkt_base91, 174);
 
-      packet_t packet = aprs_encode_data_packet(conf->call, conf->path,
-                                                'I', pkt_base91);
+      packet_t packet = encode_image_packet(conf, tpl, pkt_base91);
       if(packet == NULL) {
         TRACE_ERROR("IMG  > No available packet for image transmission");
         /* Error so release any linked packets. */
@@ -1003,13 +984,14 @@ static bool transmit_image_packets(const uint8_t *image,
 
     /* If we have some image packet(s) to transmit then do it. */
     if(head != NULL) {
-      if(!transmitOnRadio(head,
-                          conf->radio_conf.freq,
-                          0,
-                          0,
-                          conf->radio_conf.pwr,
-                          conf->radio_conf.mod,
-                          conf->radio_conf.cca)) {
+      if(!transmitServiceOnRadio(head,
+                                 conf->radio_conf.freq,
+                                 0,
+                                 0,
+                                 conf->radio_conf.pwr,
+                                 conf->radio_conf.mod,
+                                 conf->radio_conf.cca,
+                                 PKT_TX_SVC_IMAGE)) {
         TRACE_ERROR("IMG  > Unable to send image on radio");
         /* Transmit on radio will release the packet chain. */
       } else {
@@ -1019,17 +1001,25 @@ static bool transmit_image_packets(const uint8_t *image,
       }
     }
       chThdSleep(TIME_MS2I(10)); // Leave other threads some time
-  } /* End while(c!= SSDV_EOI) */
+  } /* End while(packet_id < count) */
 
-  // Repeat packets
+  // Repeat packets of any image still in the store
   for(uint8_t i=0; i<16; i++) {
-    if(packetRepeats[i].n_done && image_id == packetRepeats[i].image_id) {
-      if(!transmit_image_packet(image, image_len, conf,
-                                image_id, packetRepeats[i].packet_id)) {
-        TRACE_ERROR("IMG  > Failed re-send of image %i", image_id);
-      } else {
-        packetRepeats[i].n_done = false; // Set done
-      }
+    if(!packetRepeats[i].n_done)
+      continue;
+    uint16_t stored = imgStoreCount(packetRepeats[i].image_id);
+    if(stored == 0)
+      continue;
+    if(packetRepeats[i].packet_id >= stored) {
+      TRACE_WARN("IMG  > Repeat of packet %i beyond end of image %i",
+                 packetRepeats[i].packet_id, packetRepeats[i].image_id);
+      packetRepeats[i].n_done = false; // Nothing to send
+    } else if(!transmit_image_packet(conf, tpl, packetRepeats[i].image_id,
+                                     packetRepeats[i].packet_id)) {
+      TRACE_ERROR("IMG  > Failed re-send of image %i",
+                  packetRepeats[i].image_id);
+    } else {
+      packetRepeats[i].n_done = false; // Set done
     }
     chThdSleep(TIME_MS2I(10)); // Leave other threads some time
   }
@@ -1046,8 +1036,11 @@ static bool transmit_image_packets(const uint8_t *image,
 
 /**
   * Analyzes the image for JPEG errors. Returns true if the image is error free.
+  * The markers, tables and size are checked and the image data is decoded
+  * without being encoded to SSDV.
   */
-static bool analyze_image(uint8_t *image, uint32_t image_len) {
+static bool analyze_image(uint8_t *image, uint32_t image_len,
+                          resolution_t res) {
 
 #if !OV5640_USE_DMA_DBM
   if(image_len >= 65535) {
@@ -1057,36 +1050,18 @@ static bool analyze_image(uint8_t *image, uint32_t image_len) {
   }
 #endif
 
-  ssdv_t ssdv;
-  uint8_t pkt[SSDV_PKT_SIZE];
-  uint8_t *b;
-  uint32_t bi = 0;
-  uint32_t i = 0;
-  uint8_t c = SSDV_OK;
-
-  ssdv_enc_init(&ssdv, SSDV_TYPE_NOFEC, "", 0, 7);
-  ssdv_enc_set_buffer(&ssdv, pkt);
-
-  while(++i < image_len) {
-    while((c = ssdv_enc_get_packet(&ssdv)) == SSDV_FEED_ME) {
-      b = &image[bi++];
-      if(bi > image_len) {
-        TRACE_ERROR("CAM  > Error in image (Premature end of file %d)", i);
-        return false;
-      }
-      ssdv_enc_feed(&ssdv, b, 1);
-    }
+  /* Too large for the stack. Only used with the camera locked. */
+  static ssdv_t ssdv;
+  uint16_t width, height;
+  size_t offset;
 
-    if(c == SSDV_EOI) // End of image
-      return true;
-
-    if(c != SSDV_OK) {
-      TRACE_ERROR("CAM  > Error in image (ssdv_enc_get_packet failed: %d %d)", c, i);
-      return false;
-    }
-    chThdSleep(TIME_MS2I(5));
-  } /* End while. */
-  return false;
+  OV5640_getResolutionSize(res, &width, &height);
+  if(ssdv_jpeg_check(&ssdv, image, image_len, width, height,
+                     true, &offset) != SSDV_OK) {
+    TRACE_ERROR("CAM  > Error in image at offset %d of %d", offset, image_len);
+    return false;
+  }
+  return true;
 }
 
 /**
@@ -1137,7 +1112,7 @@ uint32_t takePicture(uint8_t* buffer, uint32_t size,
 			if(enableJpegValidation)
 			{
 				TRACE_INFO("CAM  > Validate integrity of JPEG");
-				jpegValid = analyze_image(buffer, size);
+				jpegValid = analyze_image(buffer, size_sampled, res);
 				TRACE_INFO("CAM  > JPEG image %s", jpegValid ? "valid" : "invalid");
 			} else {
 				jpegValid = true;
@@ -1173,6 +1148,15 @@ THD_FUNCTION(imgThread, arg) {
   // Create buffer
   //uint8_t buffer[conf->buf_size] __attribute__((aligned(DMA_FIFO_BURST_ALIGN)));
 
+  /* Pre-encoded APRS frames for this image identity. */
+  aprs_template_t *tpl = conf == &conf_sram.img_pri
+      ? &img_templates[0] : &img_templates[1];
+  aprs_template_init(tpl);
+
+  /* Packet budget control of quality and resolution. */
+  img_ctl_t ctl;
+  imgCtlInit(&ctl);
+
   sysinterval_t time = chVTGetSystemTime();
   while(true) {
     char code_s[100];
@@ -1185,6 +1169,10 @@ THD_FUNCTION(imgThread, arg) {
       chThdSleep(TIME_S2I(60));
       continue;
     }
+    /* Rebuild templates if the identity has been reconfigured. */
+    aprs_template_t *ptpl = aprs_template_update(tpl, conf->call,
+                                                 conf->path, 0)
+        ? tpl : NULL;
     uint32_t my_image_id = gimage_id++;
     /* Create image capture buffer. */
     uint8_t *buffer = chHeapAllocAligned(NULL, conf->buf_size,
@@ -1209,14 +1197,17 @@ THD_FUNCTION(imgThread, arg) {
     for(uint32_t i = 0; i < size ; i++)
         buffer[i] = 0;*/
     /* Take picture. */
+    resolution_t res = imgCtlStart(&ctl, conf->packet_budget,
+                                   conf->quality, conf->res);
     uint32_t size_sampled = takePicture(buffer, conf->buf_size,
-                                        conf->res, true);
+                                        res, true);
     /* Nothing captured? */
     if(size_sampled == 0) {
       TRACE_INFO("IMG  > Encode/Transmit SSDV (camera error) ID=%d",
                  my_image_id);
       if(!transmit_image_packets(noCameraFound, sizeof(noCameraFound),
-                                 conf, (uint8_t)(my_image_id))) {
+                                 conf, ptpl, (uint8_t)(my_image_id),
+                                 NULL, false)) {
         TRACE_ERROR("IMG  > Error in encoding dummy image %i"
             " - discarded", my_image_id);
       }
@@ -1255,10 +1246,26 @@ THD_FUNCTION(imgThread, arg) {
           TRACE_WARN("IMG  > Redundant TX disables 2FSK burst send mode");
         }
 
+        /*
+         * Send a preview first, as an SSDV image with its own ID.
+         * It is a fraction of the packets of the full image and is taken
+         * from the packet budget of the image.
+         */
+        if(conf->preview) {
+          uint32_t preview_id = gimage_id++;
+          TRACE_INFO("IMG  > Encode/Transmit SSDV preview ID=%d", preview_id);
+          if(!transmit_image_packets(buffer, size_sampled, conf, ptpl,
+                                     (uint8_t)(preview_id), NULL, true)) {
+            TRACE_ERROR("IMG  > Error in encoding preview image"
+                " %i - discarded", preview_id);
+          }
+          imgCtlReserve(&ctl, imgStoreCount((uint8_t)(preview_id)));
+        }
+
         /* Encode and transmit picture. */
         TRACE_INFO("IMG  > Encode/Transmit SSDV ID=%d", my_image_id);
-        if(!transmit_image_packets(buffer, size_sampled, conf,
-                                   (uint8_t)(my_image_id))) {
+        if(!transmit_image_packets(buffer, size_sampled, conf, ptpl,
+                                   (uint8_t)(my_image_id), &ctl, false)) {
           TRACE_ERROR("IMG  > Error in encoding snapshot image"
               " %i - discarded", my_image_id);
         }
@@ -0,0 +1,243 @@
+#include "ch.h"
+#include "hal.h"
+#include "debug.h"
+#include "ov5640.h"
+#include "ssdv.h"
+#include "imgctl.h"
+#include <math.h>
+#include <string.h>
+
+/* Payload of the SSDV packet type sent by the image threads. */
+#define IMG_CTL_PAYLOAD     (SSDV_PKT_SIZE - SSDV_PKT_SIZE_HEADER           \
+                             - SSDV_PKT_SIZE_CRC - SSDV_PKT_SIZE_PADDING)
+
+/*
+ * Packet model
+ *   packets = len / payload * exp(bias[q] + gain + slope * steps)
+ * where steps is the mean log2 of how much coarser the SSDV luma quantiser
+ * at quality q is than the camera's. Finer SSDV quantisers count as zero.
+ *
+ * The slope and biases are a least squares fit by comms/test/imgctl/fit.py
+ * over the 60 JPEGs recorded in comms/test/imgctl/fit.txt. Those are QVGA
+ * to UXGA crops of three sample images, some blurred or noisy, saved by
+ * libjpeg at quality 60 to 95 and encoded by ssdv.c at each quality.
+ * Quality 0 was not fitted and uses the quality 1 bias. The median error
+ * is 5 to 14% depending on quality, the learned gain corrects the rest.
+ */
+#define IMG_CTL_SLOPE       -0.378f
+
+static const float img_ctl_bias[8] = {
+  -0.07f, -0.07f, -0.02f, 0.06f, 0.04f, 0.06f, 0.15f, 0.57f
+};
+
+/* Resolutions the controller steps through, lowest first. */
+static const resolution_t img_ctl_res[] = {
+  RES_QQVGA, RES_QVGA, RES_VGA, RES_XGA, RES_UXGA
+};
+#define IMG_CTL_STEPS       (sizeof(img_ctl_res) / sizeof(img_ctl_res[0]))
+
+/**
+ * @brief   Find the step of the configured resolution.
+ *
+ * @return  the step.
+ * @retval  -1 if the resolution is not stepped.
+ */
+static int8_t imgCtlFindStep(resolution_t res) {
+  /* A snapshot at RES_MAX is taken at UXGA. */
+  if(res == RES_MAX)
+    res = RES_UXGA;
+  for(uint8_t i = 0; i < IMG_CTL_STEPS; i++) {
+    if(img_ctl_res[i] == res)
+      return i;
+  }
+  return -1;
+}
+
+/**
+ * @brief   Packets of the budget left for the image.
+ */
+static uint16_t imgCtlAvailable(img_ctl_t *ctl) {
+  return ctl->budget > ctl->reserved ? ctl->budget - ctl->reserved : 0;
+}
+
+static uint32_t imgCtlPixels(uint8_t step) {
+  uint16_t width, height;
+  OV5640_getResolutionSize(img_ctl_res[step], &width, &height);
+  return (uint32_t)width * height;
+}
+
+/**
+ * @brief   Predict the SSDV packets of an image.
+ *
+ * @param[in] cam       camera luma quantisation table or NULL if unknown.
+ * @param[in] len       JPEG image length.
+ * @param[in] quality   SSDV quality level.
+ * @param[in] gain      learned correction of the quality.
+ */
+static float imgCtlPredict(const uint8_t *cam, uint32_t len,
+                           uint8_t quality, float gain) {
+  float steps = 0;
+  if(cam != NULL) {
+    uint8_t dqt[64];
+    ssdv_enc_dqt(0, quality, dqt);
+    for(uint8_t i = 0; i < 64; i++) {
+      if(cam[i] != 0 && dqt[i] > cam[i])
+        steps += log2f((float)dqt[i] / cam[i]);
+    }
+    steps /= 64;
+  }
+  return (float)len / IMG_CTL_PAYLOAD
+      * expf(img_ctl_bias[quality] + gain + IMG_CTL_SLOPE * steps);
+}
+
+/**
+ * @brief   Initialize the controller of an image thread.
+ *
+ * @api
+ */
+void imgCtlInit(img_ctl_t *ctl) {
+  memset(ctl, 0, sizeof(img_ctl_t));
+}
+
+/**
+ * @brief   Get the resolution of the next capture.
+ * @notes   Control restarts from the configured resolution when the
+ *          configuration changes. The learned gain is kept.
+ *
+ * @param[in] ctl       controller.
+ * @param[in] budget    packets per image (0: no control).
+ * @param[in] quality   configured (highest) SSDV quality.
+ * @param[in] res       configured (highest) resolution.
+ *
+ * @return  the resolution to capture at.
+ *
+ * @api
+ */
+resolution_t imgCtlStart(img_ctl_t *ctl, uint16_t budget,
+                         uint8_t quality, resolution_t res) {
+  int8_t max = imgCtlFindStep(res);
+  if(budget != ctl->budget || quality != ctl->quality
+      || res != ctl->res_max) {
+    ctl->budget = budget;
+    ctl->quality = quality > 7 ? 7 : quality;
+    ctl->res_max = res;
+    ctl->step = max < 0 ? 0 : max;
+  }
+  ctl->reserved = 0;
+  if(budget == 0 || max < 0)
+    return res;
+  return img_ctl_res[ctl->step];
+}
+
+/**
+ * @brief   Count packets sent ahead of the captured image.
+ * @notes   A preview of the capture is taken from its budget.
+ *
+ * @param[in] ctl       controller.
+ * @param[in] packets   packets sent.
+ *
+ * @api
+ */
+void imgCtlReserve(img_ctl_t *ctl, uint16_t packets) {
+  if(ctl->budget == 0)
+    return;
+  ctl->reserved += packets;
+  TRACE_INFO("IMG  > %d of %d budget packets sent ahead of the image",
+             ctl->reserved, ctl->budget);
+}
+
+/**
+ * @brief   Choose the SSDV quality of a captured image.
+ * @notes   The highest quality predicted to fit the budget left after any
+ *          reserved packets is used. Otherwise the lowest quality is used.
+ *
+ * @param[in] ctl         controller.
+ * @param[in] image       JPEG image.
+ * @param[in] image_len   image length.
+ *
+ * @return  the SSDV quality.
+ *
+ * @api
+ */
+uint8_t imgCtlSelect(img_ctl_t *ctl, const uint8_t *image,
+                     uint32_t image_len) {
+  if(ctl->budget == 0)
+    return ctl->quality;
+
+  uint8_t dqt[64];
+  const uint8_t *cam = ssdv_jpeg_dqt(image, image_len, 0, dqt) == SSDV_OK
+      ? dqt : NULL;
+  uint8_t top = ctl->quality;
+  uint8_t low = top < IMG_CTL_QUALITY_MIN ? top : IMG_CTL_QUALITY_MIN;
+  uint16_t available = imgCtlAvailable(ctl);
+
+  ctl->at_max = imgCtlPredict(cam, image_len, top, ctl->gain[top]);
+  ctl->at_min = imgCtlPredict(cam, image_len, low, ctl->gain[low]);
+  ctl->chosen = low;
+  ctl->predicted = ctl->at_min;
+  for(uint8_t q = top; q > low; q--) {
+    float p = (q == top) ? ctl->at_max
+        : imgCtlPredict(cam, image_len, q, ctl->gain[q]);
+    if(p <= available * IMG_CTL_MARGIN) {
+      ctl->chosen = q;
+      ctl->predicted = p;
+      break;
+    }
+  }
+  TRACE_INFO("IMG  > Budget %d packets, JPEG %d bytes,"
+             " quality %d predicted %d packets", available, image_len,
+             ctl->chosen, (uint16_t)ctl->predicted);
+  if(cam == NULL) {
+    TRACE_WARN("IMG  > No camera quantisation table found");
+  }
+  return ctl->chosen;
+}
+
+/**
+ * @brief   Learn from the encoded packet count of an image.
+ * @notes   The resolution is lowered when the image was over budget at
+ *          the lowest quality. It is raised when the image would still
+ *          have fitted at the configured quality after scaling to the
+ *          next resolution.
+ *
+ * @param[in] ctl       controller.
+ * @param[in] packets   SSDV packets of the image.
+ *
+ * @api
+ */
+void imgCtlUpdate(img_ctl_t *ctl, uint16_t packets) {
+  if(ctl->budget == 0 || packets == 0 || ctl->predicted <= 0)
+    return;
+
+  /* Model error of this image. The quality used learns most of it. */
+  float fix = packets / ctl->predicted;
+  float err = logf(fix);
+  for(uint8_t q = 0; q < 8; q++) {
+    float rate = (q == ctl->chosen) ? IMG_CTL_LEARN_RATE
+        : IMG_CTL_LEARN_RATE / 2;
+    ctl->gain[q] += rate * err;
+    if(ctl->gain[q] > IMG_CTL_GAIN_LIMIT)
+      ctl->gain[q] = IMG_CTL_GAIN_LIMIT;
+    if(ctl->gain[q] < -IMG_CTL_GAIN_LIMIT)
+      ctl->gain[q] = -IMG_CTL_GAIN_LIMIT;
+  }
+  TRACE_INFO("IMG  > Quality %d gave %d packets, predicted %d, gain %.2f",
+             ctl->chosen, packets, (uint16_t)ctl->predicted,
+             ctl->gain[ctl->chosen]);
+
+  int8_t max = imgCtlFindStep(ctl->res_max);
+  if(max < 0)
+    return;
+  uint16_t available = imgCtlAvailable(ctl);
+  if(ctl->at_min * fix > available && ctl->step > 0) {
+    ctl->step--;
+    TRACE_INFO("IMG  > Over budget at quality %d, resolution lowered to %d",
+               ctl->quality < IMG_CTL_QUALITY_MIN ? ctl->quality
+                   : IMG_CTL_QUALITY_MIN, img_ctl_res[ctl->step]);
+  } else if(ctl->step < max && ctl->at_max * fix * imgCtlPixels(ctl->step + 1)
+      / imgCtlPixels(ctl->step) <= available) {
+    ctl->step++;
+    TRACE_INFO("IMG  > Within budget at quality %d, resolution raised to %d",
+               ctl->quality, img_ctl_res[ctl->step]);
+  }
+}
@@ -0,0 +1,47 @@
+#ifndef __IMGCTL_H__
+#define __IMGCTL_H__
+
+#include "ch.h"
+#include "hal.h"
+#include "types.h"
+
+/*
+ * Packet budget control of the image threads.
+ * The SSDV packet count of a capture is predicted from the JPEG size and
+ * the camera quantisation table. The highest SSDV quality fitting the
+ * budget is used, and the capture resolution follows when the quality
+ * range alone cannot meet it.
+ */
+#define IMG_CTL_QUALITY_MIN     1       /* Lowest SSDV quality used.    */
+#define IMG_CTL_MARGIN          0.95f   /* Part of the budget aimed at. */
+#define IMG_CTL_LEARN_RATE      0.25f   /* Weight of the last image.    */
+#define IMG_CTL_GAIN_LIMIT      1.0f    /* Bound of the learned gain.   */
+
+typedef struct {
+  uint16_t          budget;     /**< @brief Packets per image.          */
+  uint8_t           quality;    /**< @brief Highest SSDV quality.       */
+  resolution_t      res_max;    /**< @brief Highest resolution.         */
+  uint8_t           step;       /**< @brief Resolution of the capture.  */
+  uint8_t           chosen;     /**< @brief Quality of the capture.     */
+  uint16_t          reserved;   /**< @brief Packets sent ahead of it.   */
+  float             gain[8];    /**< @brief Learned correction per quality. */
+  float             predicted;  /**< @brief Packets at chosen quality.  */
+  float             at_min;     /**< @brief Packets at lowest quality.  */
+  float             at_max;     /**< @brief Packets at highest quality. */
+} img_ctl_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void          imgCtlInit(img_ctl_t *ctl);
+  resolution_t  imgCtlStart(img_ctl_t *ctl, uint16_t budget,
+                            uint8_t quality, resolution_t res);
+  uint8_t       imgCtlSelect(img_ctl_t *ctl, const uint8_t *image,
+                             uint32_t image_len);
+  void          imgCtlReserve(img_ctl_t *ctl, uint16_t packets);
+  void          imgCtlUpdate(img_ctl_t *ctl, uint16_t packets);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IMGCTL_H__ */
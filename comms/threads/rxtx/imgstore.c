@@ -0,0 +1,191 @@
+#include "ch.h"
+#include "hal.h"
+#include "debug.h"
+#include "ssdv.h"
+#include "imgstore.h"
+#include <string.h>
+
+#define IN_DRAM __attribute__((section(".ram7")))
+
+typedef struct {
+  uint8_t           image_id;
+  bool              valid;      /**< @brief Packets are complete.       */
+  bool              busy;       /**< @brief Packets are being encoded.  */
+  uint16_t          count;      /**< @brief Packets in the image.       */
+  uint32_t          used;       /**< @brief Stamp of the last access.   */
+} img_store_slot_t;
+
+/*
+ * Packet arrays are in SDRAM, which is not cleared at startup.
+ * The slot state is kept in internal RAM.
+ */
+static uint8_t img_store_packets[IMG_STORE_SLOTS][IMG_STORE_PACKETS]
+                                [SSDV_PKT_SIZE] IN_DRAM;
+static img_store_slot_t img_store_slots[IMG_STORE_SLOTS];
+static uint32_t img_store_clock;
+static MUTEX_DECL(img_store_mtx);
+
+/*
+ * The encoder state is too large for an image thread stack.
+ * One encoder is shared and image threads encode in turn.
+ */
+static ssdv_t img_store_ssdv;
+static MUTEX_DECL(img_store_enc_mtx);
+
+/**
+ * @brief   Find the slot of a complete image.
+ * @notes   Called with the store locked.
+ */
+static img_store_slot_t *imgStoreFind(uint8_t image_id) {
+  for(uint8_t i = 0; i < IMG_STORE_SLOTS; i++) {
+    img_store_slot_t *slot = &img_store_slots[i];
+    if(slot->valid && slot->image_id == image_id)
+      return slot;
+  }
+  return NULL;
+}
+
+/**
+ * @brief   Take a slot for a new image.
+ * @notes   An older image with the same ID is replaced first, then an
+ *          empty slot, then the least recently used image.
+ *          Called with the store locked.
+ *
+ * @return  the slot index.
+ * @retval  -1 if all slots are being encoded.
+ */
+static int8_t imgStoreTake(uint8_t image_id) {
+  int8_t take = -1;
+  for(uint8_t i = 0; i < IMG_STORE_SLOTS; i++) {
+    img_store_slot_t *slot = &img_store_slots[i];
+    if(slot->busy)
+      continue;
+    if(slot->valid && slot->image_id == image_id) {
+      take = i;
+      break;
+    }
+    if(take < 0 || (img_store_slots[take].valid
+        && (!slot->valid || slot->used < img_store_slots[take].used)))
+      take = i;
+  }
+  if(take >= 0) {
+    img_store_slot_t *slot = &img_store_slots[take];
+    slot->image_id = image_id;
+    slot->valid = false;
+    slot->busy = true;
+    slot->count = 0;
+  }
+  return take;
+}
+
+/**
+ * @brief   Encode an image into the store.
+ * @notes   The encoder runs once over the whole image. Packets are then
+ *          read from the store for transmission and repeat requests.
+ * @notes   Waits while another image is being encoded.
+ *
+ * @param[in] image       JPEG image.
+ * @param[in] image_len   image length.
+ * @param[in] image_id    SSDV image ID, also the store key.
+ * @param[in] type        SSDV packet type.
+ * @param[in] quality     SSDV quality level.
+ * @param[in] dc_only     encode a preview with DC coefficients only.
+ *
+ * @return  the number of packets.
+ * @retval  0 if the image could not be encoded or stored.
+ *
+ * @api
+ */
+uint16_t imgStoreEncode(const uint8_t *image, uint32_t image_len,
+                        uint8_t image_id, uint8_t type, uint8_t quality,
+                        bool dc_only) {
+  chMtxLock(&img_store_mtx);
+  int8_t n = imgStoreTake(image_id);
+  chMtxUnlock(&img_store_mtx);
+  if(n < 0) {
+    TRACE_ERROR("IMG  > No free packet store slot for image %i", image_id);
+    return 0;
+  }
+
+  ssdv_t *ssdv = &img_store_ssdv;
+  uint16_t count = 0;
+  char c;
+
+  chMtxLock(&img_store_enc_mtx);
+  ssdv_enc_init(ssdv, type, "N0CALL", image_id, quality);
+  ssdv_enc_set_dc_only(ssdv, dc_only);
+  ssdv_enc_set_buffer(ssdv, img_store_packets[n][0]);
+  ssdv_enc_set_input(ssdv, image, image_len);
+
+  while((c = ssdv_enc_get_packet(ssdv)) == SSDV_OK) {
+    count++;
+    if(ssdv->state == S_EOI)
+      break;
+    if(count == IMG_STORE_PACKETS) {
+      TRACE_ERROR("IMG  > Image %i has more than %i packets",
+                  image_id, IMG_STORE_PACKETS);
+      break;
+    }
+    ssdv_enc_set_buffer(ssdv, img_store_packets[n][count]);
+  }
+  if(c == SSDV_FEED_ME) {
+    TRACE_ERROR("SSDV > Premature end of file");
+  } else if(c != SSDV_OK) {
+    TRACE_ERROR("SSDV > ssdv_enc_get_packet failed: %i", c);
+  }
+
+  bool valid = (ssdv->state == S_EOI);
+  chMtxUnlock(&img_store_enc_mtx);
+
+  chMtxLock(&img_store_mtx);
+  img_store_slot_t *slot = &img_store_slots[n];
+  slot->valid = valid;
+  slot->busy = false;
+  slot->count = valid ? count : 0;
+  slot->used = ++img_store_clock;
+  chMtxUnlock(&img_store_mtx);
+
+  return valid ? count : 0;
+}
+
+/**
+ * @brief   Get the number of packets stored for an image.
+ *
+ * @return  the number of packets.
+ * @retval  0 if the image is not in the store.
+ *
+ * @api
+ */
+uint16_t imgStoreCount(uint8_t image_id) {
+  chMtxLock(&img_store_mtx);
+  img_store_slot_t *slot = imgStoreFind(image_id);
+  uint16_t count = (slot != NULL) ? slot->count : 0;
+  chMtxUnlock(&img_store_mtx);
+  return count;
+}
+
+/**
+ * @brief   Copy a stored packet.
+ *
+ * @param[in] image_id    SSDV image ID.
+ * @param[in] packet_id   SSDV packet ID.
+ * @param[out] pkt        buffer of SSDV_PKT_SIZE bytes.
+ *
+ * @return  status
+ * @retval  true    if the packet was copied.
+ * @retval  false   if the packet is not in the store.
+ *
+ * @api
+ */
+bool imgStoreGetPacket(uint8_t image_id, uint16_t packet_id, uint8_t *pkt) {
+  chMtxLock(&img_store_mtx);
+  img_store_slot_t *slot = imgStoreFind(image_id);
+  bool found = (slot != NULL && packet_id < slot->count);
+  if(found) {
+    memcpy(pkt, img_store_packets[slot - img_store_slots][packet_id],
+           SSDV_PKT_SIZE);
+    slot->used = ++img_store_clock;
+  }
+  chMtxUnlock(&img_store_mtx);
+  return found;
+}
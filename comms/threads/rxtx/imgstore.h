@@ -0,0 +1,28 @@
+#ifndef __IMGSTORE_H__
+#define __IMGSTORE_H__
+
+#include "ch.h"
+#include "hal.h"
+
+/*
+ * Encoded SSDV packets of recent images, kept in the external SDRAM.
+ * The camera buffer uses 6M of the 8M SDRAM so the store must fit in 2M.
+ * An image with more packets than a slot holds cannot be stored.
+ */
+#define IMG_STORE_SLOTS         3
+#define IMG_STORE_PACKETS       2048
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  uint16_t  imgStoreEncode(const uint8_t *image, uint32_t image_len,
+                           uint8_t image_id, uint8_t type, uint8_t quality,
+                           bool dc_only);
+  uint16_t  imgStoreCount(uint8_t image_id);
+  bool      imgStoreGetPacket(uint8_t image_id, uint16_t packet_id,
+                              uint8_t *pkt);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IMGSTORE_H__ */
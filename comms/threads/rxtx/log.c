@@ -61,13 +61,14 @@ THD_FUNCTION(logThread, arg)
 	              TRACE_WARN("LOG  > No free packet objects for log transmission");
 	            } else {
 				// Transmit packet
-                  transmitOnRadio(packet,
-                                  conf->radio_conf.freq,
-                                  0,
-                                  0,
-                                  conf->radio_conf.pwr,
-                                  conf->radio_conf.mod,
-                                  conf->radio_conf.cca);
+                  transmitServiceOnRadio(packet,
+                                         conf->radio_conf.freq,
+                                         0,
+                                         0,
+                                         conf->radio_conf.pwr,
+                                         conf->radio_conf.mod,
+                                         conf->radio_conf.cca,
+                                         PKT_TX_SVC_LOG);
 	            }
 			} else {
 				TRACE_INFO("LOG  > No log point in memory");
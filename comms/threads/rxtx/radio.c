@@ -7,6 +7,7 @@
 #include "aprs.h"
 #include "pktconf.h"
 #include "radio.h"
+#include "kiss.h"
 
 static void processPacket(uint8_t *buf, uint32_t len) {
 
@@ -36,10 +37,12 @@ static void processPacket(uint8_t *buf, uint32_t len) {
     pktReleasePacketBuffer(pp);
     return;
   }
-  /* Output packet as text. */
-  char serial_buf[512];
-  aprs_debug_getPacket(pp, serial_buf, sizeof(serial_buf));
-  TRACE_MON("RX   > %s", serial_buf);
+  /* Output packet as text only if there is a monitor consumer. */
+  if(TRACE_MON_ACTIVE()) {
+    char serial_buf[512];
+    aprs_debug_getPacket(pp, serial_buf, sizeof(serial_buf));
+    TRACE_MON("RX   > %s", serial_buf);
+  }
 
   if(pp->num_addr > 0) {
     aprs_decode_packet(pp);
@@ -57,29 +60,73 @@ void mapCallback(pkt_data_object_t *pkt_buff) {
 
   if(pktGetAX25FrameStatus(pkt_buff)) {
 
+  /* Copy to the KISS bridge if active. Frame is sent without CRC. */
+  if(frame_size > 2)
+    (void)kissSendFrame(frame_buffer, frame_size - 2);
+
   /* Perform the callback. */
   processPacket(frame_buffer, frame_size);
   } else {
     TRACE_INFO("RX   > Frame has bad CRC - dropped");
   }
 }
+/**
+ * Build the receive filter interest set from the configured identities.
+ */
+static void setupReceiveFilter(radio_unit_t radio) {
+  pkt_rx_filter_t filter = {0};
+
+  filter.enabled = conf_sram.aprs.filter;
+  filter.wide = conf_sram.aprs.digi;
+  filter.alias_re = alias_re;
+  filter.wide_re = wide_re;
+  /* Messages are only of interest if an app accepts them. */
+  filter.messages = conf_sram.aprs.aprs_msg
+      || conf_sram.pos_pri.aprs_msg
+      || conf_sram.pos_sec.aprs_msg;
+
+  const char *calls[] = {
+    conf_sram.aprs.rx.call,
+    conf_sram.aprs.tx.call,
+    conf_sram.pos_pri.call,
+    conf_sram.pos_sec.call
+  };
+  for(uint8_t i = 0; i < sizeof(calls) / sizeof(calls[0])
+                    && filter.num_calls < PKT_FILTER_MAX_CALLS; i++) {
+    if(calls[i][0] == 0)
+      continue;
+    strncpy(filter.call[filter.num_calls], calls[i], PKT_MAX_ADDR_LEN - 1);
+    strupr(filter.call[filter.num_calls++]);
+  }
+  (void)pktSetReceiveFilter(radio, &filter);
+}
+
 /**
  * TODO: Select a radio based on frequency and start that.
  */
 void start_aprs_threads(radio_unit_t radio, radio_freq_t base_freq,
                      channel_hz_t step,
-                     radio_ch_t chan, radio_squelch_t rssi) {
+                     radio_ch_t chan, radio_squelch_t rssi,
+                     mod_t mod) {
 
     if(base_freq == FREQ_RX_APRS) {
       TRACE_ERROR("RX   > Cannot specify FREQ_RX_APRS for receiver");
       return;
     }
 
+#if PKT_RX_USE_2FSK != TRUE
+    /* 2FSK receive is experimental. Receive AFSK unless it is enabled. */
+    if(mod == MOD_2FSK) {
+      TRACE_WARN("RX   > 2FSK receive not enabled, using AFSK");
+      mod = MOD_AFSK;
+    }
+#endif
+
     /* Open packet radio service.
      * TODO: The parameter should be channel not step.
      */
     msg_t omsg = pktOpenRadioReceive(radio,
-                         MOD_AFSK,
+                         mod,
                          base_freq,
                          step);
 
@@ -88,6 +135,8 @@ void start_aprs_threads(radio_unit_t radio, radio_freq_t base_freq,
       return;
     }
 
+    setupReceiveFilter(radio);
+
     /* Start the decoder. */
     msg_t smsg = pktEnableDataReception(radio,
                            chan,
@@ -106,6 +155,19 @@ bool transmitOnRadio(packet_t pp, const radio_freq_t base_freq,
                      const channel_hz_t step, radio_ch_t chan,
                      const radio_pwr_t pwr, const mod_t mod,
                      const radio_squelch_t cca) {
+  return transmitServiceOnRadio(pp, base_freq, step, chan, pwr, mod, cca,
+                                PKT_TX_SVC_OTHER);
+}
+
+/*
+ * Transmit on behalf of a service.
+ * The radio manager schedules airtime and bursts per service.
+ */
+bool transmitServiceOnRadio(packet_t pp, const radio_freq_t base_freq,
+                            const channel_hz_t step, radio_ch_t chan,
+                            const radio_pwr_t pwr, const mod_t mod,
+                            const radio_squelch_t cca,
+                            const pkt_tx_service_t svc) {
   /* Select a radio by frequency. */
   radio_unit_t radio = pktSelectRadioForFrequency(base_freq,
                                                   step,
@@ -157,10 +219,12 @@ bool transmitOnRadio(packet_t pp, const radio_freq_t base_freq,
             chan, pwr, getModulation(mod), cca, len
     );
 
-    /* TODO: Check size of buf. */
-    char buf[1024];
-    aprs_debug_getPacket(pp, buf, sizeof(buf));
-    TRACE_INFO("TX   > %s", buf);
+    if(TRACE_ACTIVE(3)) {
+      /* TODO: Check size of buf. */
+      char buf[1024];
+      aprs_debug_getPacket(pp, buf, sizeof(buf));
+      TRACE_INFO("TX   > %s", buf);
+    }
 
     /* The service object. */
     packet_svc_t *handler = pktGetServiceObject(radio);
@@ -178,6 +242,7 @@ bool transmitOnRadio(packet_t pp, const radio_freq_t base_freq,
     rt.tx_speed = (mod == MOD_2FSK ? 9600 : 1200);
     rt.squelch = cca;
     rt.packet_out = pp;
+    rt.tx_service = svc;
 
     /* Update the task mirror. */
     handler->radio_tx_config = rt;
@@ -20,10 +20,13 @@
 #define APRS_FREQ_BRAZIL			145575000
 
 void start_aprs_threads(radio_unit_t radio, radio_freq_t freq, channel_hz_t step,
-                     radio_ch_t chan, radio_squelch_t rssi);
+                     radio_ch_t chan, radio_squelch_t rssi, mod_t mod);
 bool transmitOnRadio(packet_t pp, radio_freq_t freq, channel_hz_t step,
                      radio_ch_t chan, radio_pwr_t pwr, mod_t mod,
                      radio_squelch_t rssi);
+bool transmitServiceOnRadio(packet_t pp, radio_freq_t freq, channel_hz_t step,
+                            radio_ch_t chan, radio_pwr_t pwr, mod_t mod,
+                            radio_squelch_t cca, pkt_tx_service_t svc);
 
 inline const char *getModulation(uint8_t key) {
     const char *val[] = {"NONE", "AFSK", "2FSK"};
@@ -53,7 +53,8 @@ void start_user_threads(void) {
 	                  conf_sram.aprs.rx.radio_conf.freq,
 	                  0,
 	                  0,
-	                  conf_sram.aprs.rx.radio_conf.rssi);
+	                  conf_sram.aprs.rx.radio_conf.rssi,
+	                  conf_sram.aprs.rx.radio_conf.mod);
 	}
 }
 
@@ -0,0 +1,64 @@
+/**
+ * @file    crc32.h
+ * @brief   Calculates CRC32 (IEEE 802.3).
+ * @notes   This is the reflected CRC used by SSDV, zlib and Ethernet.
+ *          The check value for "123456789" is 0xCBF43926.
+ */
+#ifndef __CRC32_H__
+#define __CRC32_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/* The options are set before ch.h is included. */
+#if !defined(FALSE)
+#define FALSE                   0
+#endif
+
+#if !defined(TRUE)
+#define TRUE                    1
+#endif
+
+/**
+ * @brief   Use the STM32 CRC peripheral (set in makefile UDEFS).
+ * @notes   The software kernel is used for running CRCs and short data.
+ */
+#ifndef CRC32_USE_HW
+#define CRC32_USE_HW            FALSE
+#endif
+
+/**
+ * @brief   Bytes processed per step of the software kernel, 4 or 8.
+ * @notes   The tables are 1K per byte in flash.
+ */
+#ifndef CRC32_SLICES
+#define CRC32_SLICES            8
+#endif
+
+/**
+ * @brief   Shortest data which is sent to the CRC peripheral.
+ */
+#define CRC32_HW_MIN            16
+
+#if CRC32_SLICES != 4 && CRC32_SLICES != 8
+#error "CRC32_SLICES must be 4 or 8"
+#endif
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  uint32_t crc32_update(uint32_t crc, const void *data, size_t length);
+  uint32_t crc32_calc(const void *data, size_t length);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CRC32_H__ */
@@ -14,6 +14,33 @@ static const uint8_t SI_CFG[] = RADIO_CONFIGURATION_DATA_ARRAY;
 //Time to wait for CTS in ms
 #define SI_TIMEOUT 2000
 
+// TX and RX FIFO size in bytes
+#define SI_FIFO_SIZE 64
+// FIFO almost empty (TX) and almost full (RX) threshold in bytes
+#define SI_FIFO_THRESHOLD 48
+// FIFO status poll interval while streaming a packet
+#define SI_FIFO_POLL TIME_US2I(500)
+// Packet length field (field 1) ahead of the payload (field 2)
+#define SI_LEN_FIELD_SIZE 2
+// Largest payload the packet handler can send or receive (13 bit length)
+#define SI_MAX_PACKET_LEN 8191
+
+// Packet handler interrupt bits (PH_PEND/PH_STATUS)
+#define SI_PH_PACKET_SENT			(0x01 << 5)
+#define SI_PH_PACKET_RX				(0x01 << 4)
+#define SI_PH_CRC_ERROR				(0x01 << 3)
+#define SI_PH_TX_FIFO_ALMOST_EMPTY	(0x01 << 1)
+#define SI_PH_RX_FIFO_ALMOST_FULL	(0x01 << 0)
+// Chip interrupt bits (CHIP_PEND)
+#define SI_CHIP_FIFO_ERROR			(0x01 << 5)
+
+// Received packets held for the application. Must be a power of 2
+#define SI_RX_RING_SIZE 8
+// Payload bytes kept per received packet. Longer payloads are truncated
+#define SI_RX_PACKET_SIZE 256
+// MODEM_RSSI_CONTROL: latch RSSI at sync word detect
+#define SI_RSSI_LATCH_SYNC 0x02
+
 #define SI_SSPORT GPIOA
 #define SI_SSPAD 15
 // Look at ./ChibiOS/os/hal/ports/STM32/LLD/SPIv2/hal_spi_lld.h for definition of struct/explanation of registers
@@ -30,6 +57,15 @@ static const SPIConfig SI_SPI_CFG = {
 // SPI driver for SI4464
 #define SI_SPID SPID6
 
+// Packet received by the RX service
+typedef struct si_rx_packet_t {
+	systime_t time;						// System time of reception
+	uint8_t rssi;						// RSSI latched at sync word
+	bool truncated;						// Payload longer than data
+	uint16_t len;						// Payload bytes in data
+	uint8_t data[SI_RX_PACKET_SIZE];
+} si_rx_packet_t;
+
 // Return code error flags
 typedef enum si_err_t {
 	SI_ERR_SUCCESS 	= 0x00,
@@ -49,11 +85,19 @@ si_err_t si_set_prop(si_prop_t prop, uint32_t value, size_t len);
 si_err_t si_get_prop(si_prop_t prop, uint32_t* value, size_t len);
 //Radio boot sequence
 si_err_t si_init(void);
-// Transmit buffer over radio
+// Transmit buffer over radio, up to SI_MAX_PACKET_LEN bytes
 si_err_t si_tx(uint8_t* buf, size_t max_buflen);
-// Read out rx into buf 
+// Read out rx into buf, up to SI_MAX_PACKET_LEN bytes
 si_err_t si_rx(uint8_t* buf, size_t maxbuflen, uint16_t* b_read);
 
 si_err_t si_check(void);
+// Keep the radio in RX and queue packets in the background
+// si_rx and si_tx must not be used while the service runs
+si_err_t si_rx_start(void);
+void si_rx_stop(void);
+// Take the oldest received packet without blocking
+bool si_rx_get(si_rx_packet_t* pkt);
+// Packets dropped because the ring was full
+uint32_t si_rx_dropped(void);
  
 #endif /* _SI_H__ */
@@ -35,15 +35,16 @@ si_err_t si_spi(const uint8_t* tx_buf, size_t tx_len, uint8_t* rx_buf, size_t rx
 	spiUnselect(&SI_SPID);
 	 
 	// Poll for CTS again, which will come when the rx buffer is full
+	// Most commands are done by the first poll so only sleep when busy
 	cts = 0;
 	for(unsigned int i = 0; i < SI_TIMEOUT; i++) {
-		chThdSleep(TIME_MS2I(1));
 		spiSelect(&SI_SPID);
 		spiExchange(&SI_SPID, 1, &rx_ready, &cts);
 		spiUnselect(&SI_SPID);
 		if(cts == 0xFF) {
 			break;
 		}
+		chThdSleep(TIME_MS2I(1));
 	}
 	if(cts != 0xFF) {
 		spiReleaseBus(&SI_SPID);
@@ -51,7 +52,6 @@ si_err_t si_spi(const uint8_t* tx_buf, size_t tx_len, uint8_t* rx_buf, size_t rx
     } 
 
 	for(unsigned int i = 0; i < SI_TIMEOUT; i++) {
-		chThdSleep(TIME_MS2I(1));
 		spiSelect(&SI_SPID);
 		//FIXME sktch af
 		uint8_t rx_extra[rx_len + 1];
@@ -69,6 +69,99 @@ si_err_t si_spi(const uint8_t* tx_buf, size_t tx_len, uint8_t* rx_buf, size_t rx
     return SI_ERR_SUCCESS;
 }
 
+static void si_tx_fill(const uint8_t* hdr, const uint8_t* buf, size_t* pos, size_t n) {
+	/*
+	Write the next n bytes of a packet into the TX FIFO.
+		@arg hdr	packet length field
+		@arg buf	payload
+		@arg pos	position in the packet, length field first. Advanced by n
+		@arg n		bytes to write, no more than the free FIFO space
+	*/
+	uint8_t write = SI_CMD_WRITE_TX_FIFO;
+	spiAcquireBus(&SI_SPID);
+	spiSelect(&SI_SPID);
+	spiSend(&SI_SPID, 1, &write);
+	while(n > 0) {
+		size_t k;
+		const uint8_t* src;
+		if(*pos < SI_LEN_FIELD_SIZE) {
+			src = &hdr[*pos];
+			k = SI_LEN_FIELD_SIZE - *pos;
+		} else {
+			src = &buf[*pos - SI_LEN_FIELD_SIZE];
+			k = n;
+		}
+		if(k > n) {
+			k = n;
+		}
+		spiSend(&SI_SPID, k, src);
+		*pos += k;
+		n -= k;
+	}
+	spiUnselect(&SI_SPID);
+	spiReleaseBus(&SI_SPID);
+}
+
+static void si_rx_drain(uint8_t* hdr, uint8_t* buf, size_t max_buflen, size_t* pos, size_t n) {
+	/*
+	Read the next n bytes of a packet from the RX FIFO.
+		@arg hdr		packet length field
+		@arg buf		payload
+		@arg max_buflen	payload bytes beyond this are read and dropped
+		@arg pos		position in the packet, length field first. Advanced by n
+		@arg n			bytes to read, no more than the FIFO holds
+	*/
+	uint8_t read = SI_CMD_READ_RX_FIFO;
+	uint8_t drop[SI_FIFO_SIZE];
+	spiAcquireBus(&SI_SPID);
+	spiSelect(&SI_SPID);
+	spiSend(&SI_SPID, 1, &read);
+	while(n > 0) {
+		size_t k;
+		uint8_t* dst;
+		if(*pos < SI_LEN_FIELD_SIZE) {
+			dst = &hdr[*pos];
+			k = SI_LEN_FIELD_SIZE - *pos;
+		} else if(*pos - SI_LEN_FIELD_SIZE < max_buflen) {
+			dst = &buf[*pos - SI_LEN_FIELD_SIZE];
+			k = max_buflen - (*pos - SI_LEN_FIELD_SIZE);
+		} else {
+			dst = drop;
+			k = sizeof(drop);
+		}
+		if(k > n) {
+			k = n;
+		}
+		spiReceive(&SI_SPID, k, dst);
+		*pos += k;
+		n -= k;
+	}
+	spiUnselect(&SI_SPID);
+	spiReleaseBus(&SI_SPID);
+}
+
+static size_t si_fifo_count(bool tx) {
+	/*
+	Returns the free TX FIFO space or the bytes waiting in the RX FIFO.
+	The FIFOs are not reset.
+	*/
+	uint8_t fifo_info[] = {SI_CMD_FIFO_INFO, 0x00};
+	uint8_t reply[3] = {0};
+	si_spi(fifo_info, 2, reply, 3);
+	return tx ? reply[2] : reply[1];
+}
+
+static si_err_t si_clear_int(void) {
+	/*
+	Clears all pending interrupts.
+	A FIFO threshold pend latched before a FIFO reset would otherwise be
+	taken for the new contents.
+	*/
+	uint8_t clear_int[4] = {SI_CMD_GET_INT_STATUS, 0x00, 0x00, 0x00};
+	uint8_t throw[9];
+	return si_spi(clear_int, 4, throw, 9);
+}
+
 si_err_t si_get_prop(si_prop_t prop, uint32_t* value, size_t len) {
 	/*
 	Get a config property on the SI4464.
@@ -147,7 +240,7 @@ si_err_t si_init(void) {
 	// Send data configuration array
 	uint8_t cts = 0;
 	uint8_t length = SI_CFG[0];
-	uint8_t* ptr = SI_CFG + 1;
+	const uint8_t* ptr = SI_CFG + 1;
 	while(length != 0) {
 		uint8_t tx[length];
 		for(int i = 0; i < length; i++) {
@@ -158,70 +251,111 @@ si_err_t si_init(void) {
 		length = *ptr;
 		ptr++;
 	}
+
+	// Variable length packets. Field 1 is the length, field 2 the payload.
+	// PKT_LEN: big endian 2 byte length kept in the RX FIFO, sizes field 2
+	uint8_t pkt_len[] = {
+		SI_CMD_SET_PROPERTY, SI_GRP(SI_PKT_LEN), 12, SI_PROP(SI_PKT_LEN),
+		0x3A,								// PKT_LEN
+		0x01,								// PKT_LEN_FIELD_SOURCE
+		0x00,								// PKT_LEN_ADJUST
+		SI_FIFO_THRESHOLD,					// PKT_TX_THRESHOLD
+		SI_FIFO_THRESHOLD,					// PKT_RX_THRESHOLD
+		0x00, SI_LEN_FIELD_SIZE,			// PKT_FIELD_1_LENGTH
+		0x04,								// PKT_FIELD_1_CONFIG
+		0x00,								// PKT_FIELD_1_CRC_CONFIG
+		SI_MAX_PACKET_LEN >> 8, SI_MAX_PACKET_LEN & 0xFF, // PKT_FIELD_2_LENGTH
+		0x00								// PKT_FIELD_2_CONFIG
+	};
+	err |= si_spi(pkt_len, sizeof(pkt_len), &cts, 1);
 	return err;
 }
 
 si_err_t si_rx(uint8_t* buf, size_t max_buflen, uint16_t* b_read) {
 	/* 
 		Enters RX mode and attempts to receive a packet and read it into the buffer.
+		The RX FIFO is drained each time it is almost full so packets may be
+		longer than the FIFO. The length comes from the packet length field.
 		Returns error. Loads bytes read into b_read
 	*/
 	si_err_t err = SI_ERR_SUCCESS;
+	*b_read = 0;
+	if(max_buflen > SI_MAX_PACKET_LEN) {
+		max_buflen = SI_MAX_PACKET_LEN;
+	}
 	 
 	//Clear RX FIFO
 	//TODO At higher bitrates, messages are captured in non-rx parts of the loop so we lose information
 	uint8_t fifo_info[] = {SI_CMD_FIFO_INFO, 0x02};
 	uint8_t throw[3];
 	err |= si_spi(fifo_info, 2, throw, 3);
+	err |= si_clear_int();
 	 
-	//Start RX Mode
+	//Start RX Mode, longest accepted payload in field 2
 	uint8_t cts = 0;
-	err |= si_set_prop(SI_PKT_FIELD_1_LENGTH, (uint32_t) max_buflen, 13);
+	err |= si_set_prop(SI_PKT_FIELD_2_LENGTH, (uint32_t) max_buflen, 13);
 	uint8_t start_rx[8] = { SI_CMD_START_RX, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00 };
 	err |= si_spi(start_rx, 8, &cts, 1);
-	chThdSleep(TIME_MS2I(10));
 	
-	//Check interrupt status (wait for packet to arrive)
+	//Drain the FIFO as it fills until the packet is received
 	uint8_t get_int_status[4] = {SI_CMD_GET_INT_STATUS, 0x00, 0x00, 0x00};
 	uint8_t int_status[9] = {0};
-	err |= si_spi(get_int_status, 4, int_status, 9);
-	uint8_t packet_rx_pend = 0;
-	uint8_t packet_rx = 0;
-	uint32_t q = 0;
-	while(!(packet_rx || packet_rx_pend) && q++ < SI_TIMEOUT) {
+	uint8_t hdr[SI_LEN_FIELD_SIZE] = {0};
+	size_t pos = 0;
+	bool received = false;
+	systime_t last = chVTGetSystemTimeX();
+	while(!received) {
 		err |= si_spi(get_int_status, 4, int_status, 9);
-		packet_rx_pend = (int_status[3] >> 4) & 0x01;
-		packet_rx = (int_status[4] >> 4) & 0x01;
+		//Packet events from PH_PEND, the FIFO level from PH_STATUS
+		uint8_t pend = int_status[3];
+		uint8_t status = int_status[4];
+		if((pend & SI_PH_CRC_ERROR) || (int_status[7] & SI_CHIP_FIFO_ERROR)) {
+			break;
+		}
+		if(pend & SI_PH_PACKET_RX) {
+			//Read the rest of the packet, length field first if still in the FIFO
+			if(pos < SI_LEN_FIELD_SIZE) {
+				si_rx_drain(hdr, buf, max_buflen, &pos, SI_LEN_FIELD_SIZE - pos);
+			}
+			size_t total = SI_LEN_FIELD_SIZE + (((hdr[0] << 8) | hdr[1]) & SI_MAX_PACKET_LEN);
+			if(total > pos) {
+				si_rx_drain(hdr, buf, max_buflen, &pos, total - pos);
+			}
+			received = true;
+			break;
+		}
+		if(status & SI_PH_RX_FIFO_ALMOST_FULL) {
+			si_rx_drain(hdr, buf, max_buflen, &pos, si_fifo_count(false));
+			last = chVTGetSystemTimeX();
+			continue;
+		}
+		if(!chVTIsSystemTimeWithinX(last, last + TIME_MS2I(SI_TIMEOUT))) {
+			break;
+		}
+		chThdSleep(SI_FIFO_POLL);
 	}
-	if(!(packet_rx || packet_rx_pend)) {
-		err |= SI_ERR_TXRX;
+	if(!received) {
+		return err | SI_ERR_TXRX;
 	}
 
-	//Get buffer from fifo
-	//check fifo
-	fifo_info[1] = 0x00;
-	err |= si_spi(fifo_info, 2, throw, 3);
-	//*b_read = throw[1] - 1;
-	*b_read = 8;
-	 
-	uint8_t read_rx_fifo = SI_CMD_READ_RX_FIFO;
-	spiSelect(&SI_SPID);
-	spiSend(&SI_SPID, 1, &read_rx_fifo);
-	spiReceive(&SI_SPID, *b_read, buf);
-	spiUnselect(&SI_SPID);
-	 
+	size_t len = ((hdr[0] << 8) | hdr[1]) & SI_MAX_PACKET_LEN;
+	if(len > max_buflen) {
+		//Payload did not fit and was truncated
+		err |= SI_ERR_TXRX;
+		len = max_buflen;
+	}
+	*b_read = (uint16_t) len;
 	return err;
 }
 
 si_err_t si_tx(uint8_t* buf, size_t buflen) {
 	/*
-	 
 		Transmits a variable-length buffer over radio
-		Uses Preamble + SYNC + CRC
+		Uses Preamble + SYNC + length field + payload
+		The TX FIFO is refilled each time it is almost empty so packets may be
+		longer than the FIFO.
 	*/
-	if (buflen > 62) {
-		// The tx fifo size max is 64
-		//TODO there should be a way to load longer payloads but I'm not sure how
+	if(buflen > SI_MAX_PACKET_LEN) {
 		return SI_ERR_INV_ARG;
 	}
 	si_err_t err = SI_ERR_SUCCESS;
@@ -229,37 +363,53 @@ si_err_t si_tx(uint8_t* buf, size_t buflen) {
 	uint8_t fifo_info[] = {SI_CMD_FIFO_INFO, 0x01};
 	uint8_t cts = 0;
 	err |= si_spi(fifo_info, 2, &cts, 1);
-	uint8_t write = SI_CMD_WRITE_TX_FIFO;
-	 
-	spiSelect(&SI_SPID);
-	spiSend(&SI_SPID, 1, &write);
-	spiSend(&SI_SPID, buflen, buf);
-	spiUnselect(&SI_SPID);
+
+	// Preload the FIFO with the length field and the start of the payload
+	uint8_t hdr[SI_LEN_FIELD_SIZE] = {(buflen >> 8) & 0x1F, buflen & 0xFF};
+	size_t total = SI_LEN_FIELD_SIZE + buflen;
+	size_t pos = 0;
+	si_tx_fill(hdr, buf, &pos, total < SI_FIFO_SIZE ? total : SI_FIFO_SIZE);
+	err |= si_clear_int();
+
 	//transmit the tx fifo buffer
 	//Returns to ready state after
+	//Packet length is taken from the field lengths
 	//						CMD					CHAN	COND	TX_LEN (UINT12)	
-	err |= si_set_prop(SI_PKT_FIELD_1_LENGTH, (uint32_t) buflen, 13);
+	err |= si_set_prop(SI_PKT_FIELD_2_LENGTH, (uint32_t) buflen, 13);
 	uint8_t start_tx[] = {	SI_CMD_START_TX,	0x00,	0x30,	0x00,	0x00};
 	cts = 0;
 	err |= si_spi(start_tx, 5, &cts, 1);
 
-	chThdSleep(TIME_MS2I(1));
-	//Check interrupt status
+	//Refill the FIFO as it drains until the packet is sent
 	uint8_t get_int_status[4] = {SI_CMD_GET_INT_STATUS, 0x00, 0x00, 0x00};
 	uint8_t int_status[9] = {0};
-	err |= si_spi(get_int_status, 4, int_status, 9);
-	uint8_t packet_sent_pend = 0x00;
-	uint8_t packet_sent = 0x00;
-	uint32_t i = 0;
-	while(!(packet_sent || packet_sent_pend) && i++ < SI_TIMEOUT) {
+	bool sent = false;
+	systime_t last = chVTGetSystemTimeX();
+	while(!sent) {
 		err |= si_spi(get_int_status, 4, int_status, 9);
-		packet_sent_pend = (int_status[3] >> 5) & 0x01;
-		packet_sent = (int_status[4] >> 5) & 0x01;
-		chThdSleep(TIME_MS2I(1));
-	}
-	if(packet_sent || packet_sent_pend) {
+		//Packet events from PH_PEND, the FIFO level from PH_STATUS
+		uint8_t pend = int_status[3];
+		uint8_t status = int_status[4];
+		if(pend & SI_PH_PACKET_SENT) {
+			sent = true;
+			break;
+		}
+		if(int_status[7] & SI_CHIP_FIFO_ERROR) {
+			break;
+		}
+		if((status & SI_PH_TX_FIFO_ALMOST_EMPTY) && pos < total) {
+			size_t n = total - pos;
+			size_t space = si_fifo_count(true);
+			si_tx_fill(hdr, buf, &pos, n < space ? n : space);
+			last = chVTGetSystemTimeX();
+			continue;
+		}
+		if(!chVTIsSystemTimeWithinX(last, last + TIME_MS2I(SI_TIMEOUT))) {
+			break;
+		}
+		chThdSleep(SI_FIFO_POLL);
 	}
-	else {
+	if(!sent) {
 		err |= SI_ERR_TXRX;
 	}
 	return err;
@@ -276,3 +426,192 @@ si_err_t si_check(void) {
 		return SI_ERR_SUCCESS;
 	} else return SI_ERR_INV_REPLY;
 }
+
+/*
+	RX service. The thread keeps the radio in RX and queues packets.
+	Single producer (thread) and single consumer (si_rx_get) ring.
+	Indexes are free running and masked on access.
+*/
+#define SI_RX_RING_MASK (SI_RX_RING_SIZE - 1)
+
+static si_rx_packet_t si_rx_ring[SI_RX_RING_SIZE];
+static volatile uint32_t si_rx_head;
+static volatile uint32_t si_rx_tail;
+static volatile uint32_t si_rx_drops;
+static thread_t* si_rx_thd;
+
+static si_err_t si_rx_arm(void) {
+	/*
+		Clear the RX FIFO and enter RX.
+		The radio re-arms itself after each valid or invalid packet.
+	*/
+	si_err_t err = SI_ERR_SUCCESS;
+	uint8_t fifo_info[] = {SI_CMD_FIFO_INFO, 0x02};
+	uint8_t throw[3];
+	err |= si_spi(fifo_info, 2, throw, 3);
+	err |= si_clear_int();
+	err |= si_set_prop(SI_PKT_FIELD_2_LENGTH, SI_MAX_PACKET_LEN, 13);
+	uint8_t start_rx[8] = { SI_CMD_START_RX, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x08 };
+	uint8_t cts = 0;
+	err |= si_spi(start_rx, 8, &cts, 1);
+	return err;
+}
+
+static uint8_t si_rx_rssi(void) {
+	/*
+		Returns the RSSI latched at the last sync word. Pending flags are kept.
+	*/
+	uint8_t modem_status[2] = {SI_CMD_GET_MODEM_STATUS, 0xFF};
+	uint8_t reply[5] = {0};
+	si_spi(modem_status, 2, reply, 5);
+	return reply[4];
+}
+
+static THD_WORKING_AREA(si_rx_wa, 512);
+static THD_FUNCTION(si_rx_fn, args) {
+	(void)args;
+	uint8_t get_int_status[4] = {SI_CMD_GET_INT_STATUS, 0x00, 0x00, 0x00};
+	uint8_t int_status[9] = {0};
+	uint8_t hdr[SI_LEN_FIELD_SIZE] = {0};
+	si_rx_packet_t* rec = NULL;
+	size_t room = 0;
+	uint8_t rssi = 0;
+	size_t pos = 0;
+	size_t total = 0;
+
+	si_rx_arm();
+	while(!chThdShouldTerminateX()) {
+		if(si_spi(get_int_status, 4, int_status, 9) != SI_ERR_SUCCESS) {
+			chThdSleep(SI_FIFO_POLL);
+			continue;
+		}
+		// Packet events from PH_PEND, the FIFO level from PH_STATUS
+		uint8_t pend = int_status[3];
+		uint8_t status = int_status[4];
+		if((pend & SI_PH_CRC_ERROR) || (int_status[7] & SI_CHIP_FIFO_ERROR)) {
+			// Drop the partial packet and restart from an empty FIFO
+			si_rx_arm();
+			pos = 0;
+			continue;
+		}
+		if(pos == 0 && ((pend & SI_PH_PACKET_RX) || (status & SI_PH_RX_FIFO_ALMOST_FULL))) {
+			// New packet. Read into the next free record or drop it
+			if(si_rx_head - si_rx_tail < SI_RX_RING_SIZE) {
+				rec = &si_rx_ring[si_rx_head & SI_RX_RING_MASK];
+				room = SI_RX_PACKET_SIZE;
+			} else {
+				rec = NULL;
+				room = 0;
+				si_rx_drops++;
+			}
+			total = 0;
+			// Latched at this packet's sync. The next sync overwrites it
+			rssi = si_rx_rssi();
+		}
+		if(pend & SI_PH_PACKET_RX) {
+			if(pos < SI_LEN_FIELD_SIZE) {
+				si_rx_drain(hdr, rec ? rec->data : NULL, room, &pos, SI_LEN_FIELD_SIZE - pos);
+			}
+			size_t len = ((hdr[0] << 8) | hdr[1]) & SI_MAX_PACKET_LEN;
+			total = SI_LEN_FIELD_SIZE + len;
+			if(total > pos) {
+				si_rx_drain(hdr, rec ? rec->data : NULL, room, &pos, total - pos);
+			}
+			if(rec != NULL) {
+				rec->time = chVTGetSystemTimeX();
+				rec->rssi = rssi;
+				rec->truncated = len > room;
+				rec->len = (uint16_t) (len > room ? room : len);
+				// Record contents must be visible before the index
+				__DMB();
+				si_rx_head++;
+			}
+			// The radio has re-armed. Next bytes are a new packet
+			pos = 0;
+			continue;
+		}
+		if(status & SI_PH_RX_FIFO_ALMOST_FULL) {
+			size_t n = si_fifo_count(false);
+			if(pos < SI_LEN_FIELD_SIZE) {
+				// Length field is at the head of the FIFO
+				si_rx_drain(hdr, rec ? rec->data : NULL, room, &pos, SI_LEN_FIELD_SIZE - pos);
+				n -= SI_LEN_FIELD_SIZE;
+				total = SI_LEN_FIELD_SIZE + (((hdr[0] << 8) | hdr[1]) & SI_MAX_PACKET_LEN);
+			}
+			// Stop at the packet end. Later bytes belong to the next packet
+			if(n > total - pos) {
+				n = total - pos;
+			}
+			if(n == 0) {
+				// Packet drained. Wait for PACKET_RX rather than spin
+				chThdSleep(SI_FIFO_POLL);
+				continue;
+			}
+			si_rx_drain(hdr, rec ? rec->data : NULL, room, &pos, n);
+			continue;
+		}
+		chThdSleep(SI_FIFO_POLL);
+	}
+
+	uint8_t ready[] = {SI_CMD_CHANGE_STATE, 0x03};
+	uint8_t cts = 0;
+	si_spi(ready, 2, &cts, 1);
+	chThdExit(MSG_OK);
+}
+
+/**
+* @brief	    Starts the RX service thread.
+*
+* @return	    SI_ERR_SUCCESS or SI_ERR_NOT_READY if already running.
+*/
+si_err_t si_rx_start(void) {
+	if(si_rx_thd != NULL) {
+		return SI_ERR_NOT_READY;
+	}
+	si_rx_head = 0;
+	si_rx_tail = 0;
+	si_rx_drops = 0;
+	si_err_t err = si_set_prop(SI_MODEM_RSSI_CONTROL, SI_RSSI_LATCH_SYNC, 8);
+	si_rx_thd = chThdCreateStatic(si_rx_wa, sizeof(si_rx_wa),
+		NORMALPRIO + 1, si_rx_fn, NULL);
+	return err;
+}
+
+/**
+* @brief	    Stops the RX service thread and leaves the radio in ready.
+*				Packets in the ring can still be read.
+*/
+void si_rx_stop(void) {
+	if(si_rx_thd == NULL) {
+		return;
+	}
+	chThdTerminate(si_rx_thd);
+	chThdWait(si_rx_thd);
+	si_rx_thd = NULL;
+}
+
+/**
+* @brief	    Takes the oldest received packet. Never blocks.
+*
+* @param[out]	pkt	copy of the packet record.
+*
+* @return	    true if a packet was taken.
+*/
+bool si_rx_get(si_rx_packet_t* pkt) {
+	uint32_t tail = si_rx_tail;
+	if(tail == si_rx_head) {
+		return false;
+	}
+	*pkt = si_rx_ring[tail & SI_RX_RING_MASK];
+	// Copy must complete before the record is handed back
+	__DMB();
+	si_rx_tail = tail + 1;
+	return true;
+}
+
+/**
+* @brief	    Returns the number of packets dropped because the ring was full.
+*/
+uint32_t si_rx_dropped(void) {
+	return si_rx_drops;
+}